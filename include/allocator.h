@@ -0,0 +1,81 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic allocator configuration enum values.
+ */
+enum AllocatorConfig
+{
+    /** @brief The size (in bytes) of the arena holding every object that lives as long as the app. */
+    APP_ARENA_CAPACITY = 1 << 20,
+
+    /** @brief The number of frames of uninterrupted play before allocations are treated as a regression. */
+    ALLOCATOR_WARM_UP_FRAMES = 120,
+};
+
+/**
+ * @brief A linear allocator. Allocations are only ever freed all at once, when the arena is destroyed.
+ */
+typedef struct Arena
+{
+    Uint8* memory;
+    size_t capacity;
+    size_t used;
+} Arena;
+
+/**
+ * @brief Allocate the memory for an arena.
+ *
+ * @param arena A pointer to the arena to initialise.
+ * @param capacity The size (in bytes) of the arena.
+ *
+ * @return True on success, false otherwise.
+ */
+bool ALLOC_ArenaInit(Arena* arena, size_t capacity);
+
+/**
+ * @brief Allocate zeroed memory from an arena, aligned for any type.
+ *
+ * @param arena A pointer to the arena to allocate from.
+ * @param size The size (in bytes) to allocate.
+ *
+ * @return A pointer to the memory, or NULL if the arena is full.
+ */
+void* ALLOC_ArenaAlloc(Arena* arena, size_t size);
+
+/**
+ * @brief Free an arena, and with it everything allocated from it.
+ *
+ * @param arena A pointer to the arena to destroy.
+ */
+void ALLOC_ArenaDestroy(Arena* arena);
+
+/**
+ * @brief Install SDL memory functions that count every allocation made through SDL (including by SDL itself).
+ *
+ * @note The hooks forward to SDL's original functions, so memory allocated before they were installed can still be
+ * freed safely. Allocations made while logging are not counted, as some platforms allocate to output each message.
+ *
+ * @return True on success, false otherwise.
+ */
+bool ALLOC_InstallHooks(void);
+
+/**
+ * @brief Finish a frame, checking that the render thread allocated nothing if the game has been in steady-state play
+ * for longer than the warm-up period. Only call this from the render thread, as only its allocations are checked.
+ *
+ * @param isSteadyState Whether the frame was uninterrupted play, i.e. rendered, not paused and not game over.
+ *
+ * @return The number of allocations the render thread made since the previous frame.
+ */
+int ALLOC_EndFrame(bool isSteadyState);
+
+/**
+ * @brief Restart the warm-up period, for events that are expected to allocate during play (e.g. a window resize).
+ */
+void ALLOC_ResetSteadyState(void);
+
+#endif //ALLOCATOR_H
@@ -0,0 +1,255 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "latency.h"
+
+/**
+ * @brief Generic audio configuration enum values.
+ */
+enum AudioConfig
+{
+    /** @brief The sample rate (in frames per second) everything is mixed at. */
+    AUDIO_SAMPLE_RATE = 48000,
+
+    /** @brief The number of channels everything is mixed in (stereo). */
+    AUDIO_CHANNELS = 2,
+
+    /** @brief The number of frames the device is asked to buffer, which bounds the latency of sound effects. */
+    AUDIO_DEVICE_FRAMES = 256,
+
+    /** @brief The most frames mixed in a single pass of the mixer. */
+    AUDIO_MIX_FRAMES = 1024,
+
+    /** @brief The number of frames of decoded music the ring buffer holds. This must be a power of two. */
+    AUDIO_MUSIC_RING_FRAMES = 16384,
+
+    /** @brief The number of frames of music decoded at a time. */
+    AUDIO_MUSIC_CHUNK_FRAMES = 1024,
+
+    /** @brief The time (in milliseconds) the music decoder sleeps between refills of the ring buffer. */
+    AUDIO_MUSIC_REFILL_INTERVAL_MS = 20,
+
+    /** @brief The number of sound effects that can play at once. */
+    AUDIO_VOICE_COUNT = 16,
+
+    /** @brief The number of sound effects that can be waiting to start. This must be a power of two. */
+    AUDIO_TRIGGER_CAPACITY = 64,
+
+    /** @brief The number of most recent trigger-to-output latency samples kept for calculating percentiles. */
+    AUDIO_LATENCY_SAMPLE_CAPACITY = 1024,
+};
+
+/**
+ * @brief The sound effects, each of which is decoded (or synthesised) once when the engine is opened.
+ */
+typedef enum AudioEffect
+{
+    AUDIO_EFFECT_MOVE,
+    AUDIO_EFFECT_ROTATE,
+    AUDIO_EFFECT_LOCK,
+    AUDIO_EFFECT_LINE_CLEAR,
+    AUDIO_EFFECT_LEVEL_UP,
+    AUDIO_EFFECT_COUNT,
+} AudioEffect;
+
+/**
+ * @brief A sound decoded into memory as interleaved stereo float frames at AUDIO_SAMPLE_RATE.
+ */
+typedef struct AudioClip
+{
+    float* samples;
+    int frames;
+} AudioClip;
+
+/**
+ * @brief A sound effect playing on the mixer.
+ */
+typedef struct AudioVoice
+{
+    /** @brief The clip being played, or NULL if the voice is free. */
+    const AudioClip* clip;
+
+    /** @brief The next frame of the clip to play. */
+    int position;
+
+    float gain;
+} AudioVoice;
+
+/**
+ * @brief A sound effect waiting to be started by the mixer.
+ */
+typedef struct AudioTrigger
+{
+    AudioEffect effect;
+    float gain;
+
+    /** @brief The time (in nanoseconds, from SDL_GetTicksNS) the effect was triggered. */
+    Uint64 timestampNS;
+} AudioTrigger;
+
+/**
+ * @brief The source the music is decoded from: a looping WAV file, or the built-in synthesised theme.
+ */
+typedef struct AudioMusic
+{
+    /** @brief The WAV file being streamed, or NULL to synthesise the theme. */
+    SDL_IOStream* file;
+
+    /** @brief Converts the file's samples to the mixer's format, a chunk at a time. */
+    SDL_AudioStream* converter;
+
+    /** @brief The offset and size (in bytes) of the file's sample data, and the number of bytes left to read. */
+    Sint64 dataStart;
+    Sint64 dataSize;
+    Sint64 dataRemaining;
+
+    /** @brief The size (in bytes) of a frame of the file's sample data. */
+    int frameBytes;
+
+    /** @brief The frame of the theme's loop to synthesise next, and the phase (in cycles) of its two voices. */
+    Uint64 songFrame;
+    float melodyPhase;
+    float bassPhase;
+} AudioMusic;
+
+/**
+ * @brief A summary of how the mixer has performed.
+ */
+typedef struct AudioStats
+{
+    /** @brief The time from a game event triggering an effect to the effect's first frame reaching the device. */
+    LatencyStats latency;
+
+    /** @brief The time spent mixing, as a percentage of the time the mixed audio lasts. */
+    double mixerLoadPercent;
+
+    /** @brief The longest time (in nanoseconds) the device callback took. */
+    Uint64 worstCallbackNS;
+
+    /** @brief The number of frames mixed, and the number of them that had no music because the decoder fell behind. */
+    Uint64 mixedFrames;
+    Uint64 musicUnderrunFrames;
+
+    /** @brief The number of effects dropped because the trigger queue was full. */
+    int droppedTriggers;
+} AudioStats;
+
+/**
+ * @brief A mixer playing streamed music and pre-decoded sound effects.
+ *
+ * @details The mixer runs in the audio device's callback, on SDL's audio thread, and only ever hands the device as
+ * many frames as it asks for, so the queued audio (and so the latency of effects) stays at the device's buffer. Music
+ * is decoded incrementally by a worker thread into a wait-free single producer, single consumer ring buffer holding
+ * about a third of a second, which the mixer reads from. Effects are triggered by game events on the simulation
+ * thread and passed to the mixer through another wait-free queue. Neither the render thread nor the simulation thread
+ * is ever waited on, so a stalled frame never starves the device.
+ */
+typedef struct AudioEngine
+{
+    /** @brief The device stream the mixer feeds. */
+    SDL_AudioStream* stream;
+
+    /** @brief The number of frames the device buffers, as reported once it was opened. */
+    int deviceFrames;
+
+    /** @brief The sound effects. */
+    AudioClip clips[AUDIO_EFFECT_COUNT];
+
+    /** @brief The sound effects playing, owned by the mixer. */
+    AudioVoice voices[AUDIO_VOICE_COUNT];
+
+    /** @brief The music source, owned by the decoder thread once it is running. */
+    AudioMusic music;
+
+    /** @brief Whether there is music at all. */
+    bool hasMusic;
+
+    /** @brief Decoded music waiting to be mixed. Only the decoder writes tail, and only the mixer head. */
+    float musicRing[AUDIO_MUSIC_RING_FRAMES * AUDIO_CHANNELS];
+    SDL_AtomicU32 musicHead;
+    SDL_AtomicU32 musicTail;
+
+    /** @brief Whether the music is held, such as while the game is paused or over. */
+    SDL_AtomicInt isMusicHeld;
+
+    /** @brief Effects waiting to be started. Only the game thread writes tail, and only the mixer head. */
+    AudioTrigger triggers[AUDIO_TRIGGER_CAPACITY];
+    SDL_AtomicInt triggerHead;
+    SDL_AtomicInt triggerTail;
+    SDL_AtomicInt droppedTriggers;
+
+    /** @brief A mixing buffer, owned by the mixer. */
+    float mixBuffer[AUDIO_MIX_FRAMES * AUDIO_CHANNELS];
+
+    /** @brief Trigger-to-output latency samples, owned by the mixer while the device is open. */
+    Uint64 latencies[AUDIO_LATENCY_SAMPLE_CAPACITY];
+    int latencyCount;
+    int nextLatency;
+
+    /** @brief Scratch space for sorting latency samples when calculating percentiles. */
+    Uint64 sortBuffer[AUDIO_LATENCY_SAMPLE_CAPACITY];
+
+    /** @brief Mixer timings, owned by the mixer while the device is open. */
+    Uint64 mixNS;
+    Uint64 worstCallbackNS;
+    Uint64 mixedFrames;
+    Uint64 musicUnderrunFrames;
+
+    /** @brief Signalled when the music ring buffer falls below half full, and when the decoder should stop. */
+    SDL_Semaphore* wake;
+
+    SDL_AtomicInt isStopping;
+    SDL_Thread* decoder;
+} AudioEngine;
+
+/**
+ * @brief Open the default playback device, decode every sound effect and start streaming the music.
+ *
+ * @details Each effect is loaded from resources/audio/NAME.wav if it exists (NAME being move, rotate, lock, line_clear
+ * or level_up) and synthesised otherwise.
+ *
+ * @param audio A pointer to the engine to open.
+ * @param musicPath The path of a WAV file to loop as music, NULL to synthesise the theme, or "none" for no music.
+ *
+ * @return True on success, false otherwise.
+ */
+bool AUDIO_Open(AudioEngine* audio, const char* musicPath);
+
+/**
+ * @brief Close the device, stop the music decoder and free every sound, then log how the mixer performed.
+ *
+ * @param audio A pointer to the engine to close.
+ */
+void AUDIO_Close(AudioEngine* audio);
+
+/**
+ * @brief Trigger the sound effect of a game event, if it has one, and hold or release the music as the game pauses,
+ * resumes, ends and restarts. This is a ::GameEventListener, to be added to a game with the engine as its user data
+ * (see GAME_AddEventListener). It never blocks or allocates.
+ *
+ * @param userData A pointer to the engine.
+ * @param event The event.
+ */
+void AUDIO_Listen(void* userData, const GameEvent* event);
+
+/**
+ * @brief Summarise how the mixer has performed. Only call this once the engine has been closed, or the figures may be
+ * torn.
+ *
+ * @param audio A pointer to the engine.
+ * @param stats The stats to write to.
+ */
+void AUDIO_GetStats(AudioEngine* audio, AudioStats* stats);
+
+/**
+ * @brief Log how the mixer has performed.
+ *
+ * @param stats The stats to log.
+ */
+void AUDIO_LogStats(const AudioStats* stats);
+
+#endif //AUDIO_H
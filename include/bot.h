@@ -0,0 +1,245 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "game.h"
+#include "transposition.h"
+
+/**
+ * @brief Generic bot configuration enum values.
+ */
+enum BotConfig
+{
+    /** @brief The most pieces the search bot may look ahead, including the dropping tetromino. */
+    BOT_MAX_DEPTH = 8,
+
+    /** @brief The most positions kept at each level of the beam search. */
+    BOT_MAX_BEAM_WIDTH = 512,
+
+    /** @brief The most placements a single tetromino can have (4 orientations by 12 columns, from -2 to 9). */
+    BOT_MAX_PLACEMENTS = 48,
+
+    /** @brief The maximum number of threads that expand the beam, including the one calling BOT_Search. */
+    BOT_MAX_THREADS = 64,
+
+    /** @brief The default number of pieces after the dropping tetromino that the bot is allowed to see. */
+    BOT_DEFAULT_PREVIEW = 5,
+
+    /** @brief The size of the transposition table used to cache expected evaluations, as a power of two. */
+    BOT_TRANSPOSITION_LOG2_ENTRIES = 18,
+};
+
+/**
+ * @brief A final resting place for the dropping tetromino, chosen by the bot.
+ */
+typedef struct BotPlacement
+{
+    /** @brief The x-coordinate the tetromino should be moved to before it is hard dropped. */
+    int x;
+
+    /** @brief The y-coordinate the tetromino should be moved to before it is hard dropped. */
+    int y;
+
+    /** @brief The orientation the tetromino should be rotated to before it is hard dropped. */
+    enum Orientation orientation;
+
+    /** @brief How good the arena looks after this placement, higher is better. */
+    float evaluation;
+} BotPlacement;
+
+/**
+ * @brief The settings of the search bot.
+ */
+typedef struct BotSearchSettings
+{
+    /** @brief How many pieces to look ahead, including the dropping tetromino, up to BOT_MAX_DEPTH. */
+    int depth;
+
+    /** @brief How many positions to keep at each level of the search, up to BOT_MAX_BEAM_WIDTH. */
+    int beamWidth;
+
+    /** @brief How many pieces of the next queue the bot may see, up to TETROMINO_QUEUE_LENGTH. */
+    int preview;
+
+    /** @brief The time (in nanoseconds) a single search may take, after which it returns its best result so far. */
+    Uint64 budgetNS;
+
+    /** @brief The number of threads to search with, or 0 for one per logical CPU core. */
+    int threads;
+} BotSearchSettings;
+
+/**
+ * @brief Totals across every search, for reporting how fast the search bot runs.
+ */
+typedef struct BotSearchStats
+{
+    /** @brief The number of searches run. */
+    Uint64 searches;
+
+    /** @brief The number of positions evaluated. */
+    Uint64 nodes;
+
+    /** @brief The total time (in nanoseconds) spent searching. */
+    Uint64 searchNS;
+
+    /** @brief The number of searches that ran out of time before reaching their full depth. */
+    Uint64 timeouts;
+} BotSearchStats;
+
+/**
+ * @brief A position in the beam: an arena after a sequence of placements, and the first placement of the sequence.
+ */
+typedef struct BotNode
+{
+    /** @brief One bitmask per arena row, where bit n is set if column n is filled. */
+    Uint16 rows[ARENA_HEIGHT];
+
+    /** @brief The Zobrist hash of the rows (see zobrist.h). */
+    Uint64 hash;
+
+    /** @brief The evaluation of the rows, including every line cleared to reach them, higher is better. */
+    float evaluation;
+
+    /** @brief The number of lines cleared by the sequence of placements. */
+    int linesCleared;
+
+    /** @brief The placement of the dropping tetromino this position was reached from. */
+    Sint8 firstX;
+    Sint8 firstY;
+    Uint8 firstOrientation;
+} BotNode;
+
+/**
+ * @brief The state of a thread expanding the beam, which keeps the best of the positions it creates.
+ */
+typedef struct BotWorker
+{
+    SDL_Thread* thread;
+    struct BotSearch* search;
+
+    /** @brief A min-heap of the best BotSearchSettings::beamWidth positions this worker has created in the level. */
+    BotNode* best;
+    int bestCount;
+
+    /** @brief The number of positions this worker evaluated in the level. */
+    Uint64 nodes;
+} BotWorker;
+
+/**
+ * @brief A beam search bot, which looks several pieces ahead using what it knows of the bag, and expands each level of
+ * the search in parallel.
+ *
+ * @details The dropping tetromino and the first BotSearchSettings::preview pieces of the next queue are known, so
+ * each level of the search places one of them in every way from each position in the beam, and keeps the best
+ * beamWidth new positions. Once the known pieces run out, the final positions are scored by the expected best
+ * placement of the next piece, which is equally likely to be any piece its bag has left unseen (or any piece, if it
+ * starts a new bag).
+ *
+ * @note Nothing is allocated while searching, so it can be used during steady-state play.
+ */
+typedef struct BotSearch
+{
+    BotSearchSettings settings;
+    BotSearchStats stats;
+
+    /** @brief Caches the expected evaluation of positions, which are often revisited on the next move. */
+    TranspositionTable table;
+
+    BotWorker workers[BOT_MAX_THREADS];
+    SDL_Semaphore* startSemaphore;
+    SDL_Semaphore* doneSemaphore;
+    bool isQuitting;
+
+    /** @brief The positions being expanded, and the positions they are expanded into. */
+    BotNode* beam;
+    BotNode* nextBeam;
+    int beamCount;
+
+    /** @brief Every worker's best positions merged together, and the hashes already taken from them. */
+    BotNode* candidates;
+    Uint64* seenHashes;
+    int seenHashMask;
+
+    /** @brief The expected evaluation of each position in the final beam. */
+    float* expectations;
+
+    /** @brief The tetromino being placed at the current level, or 0 if scoring the final beam by expectation. */
+    TetrominoIdentifier piece;
+
+    /** @brief Whether the current level places the dropping tetromino from the current arena. */
+    bool isRoot;
+
+    /** @brief The y-coordinate of the dropping tetromino, which the first level starts its drops from. */
+    int rootSpawnY;
+
+    /** @brief The tetrominoes that could come next once the known pieces run out, as a bitmask of identifiers. */
+    Uint32 unseenPieces;
+
+    /** @brief The XOR of the Zobrist keys of the unseen tetrominoes, which keys expectations in the table. */
+    Uint64 unseenKey;
+
+    /** @brief The index of the next position in the beam to expand, shared by every worker. */
+    SDL_AtomicInt nextNode;
+
+    /** @brief Set once the search has run past its deadline. */
+    SDL_AtomicInt hasTimedOut;
+
+    /** @brief Whether the current level must finish regardless of the deadline. */
+    bool isMandatory;
+
+    Uint64 deadline;
+} BotSearch;
+
+/**
+ * @brief Find the best placement for the dropping tetromino, by evaluating the arena after every possible hard drop.
+ *
+ * @note The arena is evaluated using aggregate height, holes, bumpiness and cleared lines, see
+ * https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/
+ *
+ * @param gameDataContext A struct containing the game data context.
+ * @param placement A pointer to the placement to write the result to.
+ *
+ * @return True if a placement was found, false if the tetromino cannot be placed anywhere.
+ */
+bool BOT_FindPlacement(const GameDataContext* gameDataContext, BotPlacement* placement);
+
+/**
+ * @brief Move the dropping tetromino to a placement and hard drop it.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ * @param placement A pointer to the placement to play.
+ */
+void BOT_PlayPlacement(GameDataContext* gameDataContext, const BotPlacement* placement);
+
+/**
+ * @brief Allocate the buffers of a search bot and start its threads.
+ *
+ * @param search A pointer to the zeroed search to initialise.
+ * @param settings The settings of the search, which are clamped to their limits.
+ *
+ * @return True on success, false otherwise.
+ */
+bool BOT_InitSearch(BotSearch* search, const BotSearchSettings* settings);
+
+/**
+ * @brief Stop the threads of a search bot and free its buffers.
+ *
+ * @param search A pointer to the search to destroy.
+ */
+void BOT_DestroySearch(BotSearch* search);
+
+/**
+ * @brief Search for the best placement for the dropping tetromino, looking ahead several pieces, within the time
+ * budget.
+ *
+ * @details If the budget runs out, the best placement from the deepest level that was completed is returned. Placing
+ * the dropping tetromino itself always completes, so a placement is found whenever one exists.
+ *
+ * @param search A pointer to an initialised search.
+ * @param gameDataContext A struct containing the game data context.
+ * @param placement A pointer to the placement to write the result to.
+ *
+ * @return True if a placement was found, false if the tetromino cannot be placed anywhere.
+ */
+bool BOT_Search(BotSearch* search, const GameDataContext* gameDataContext, BotPlacement* placement);
+
+#endif //BOT_H
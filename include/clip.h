@@ -0,0 +1,80 @@
+#ifndef CLIP_H
+#define CLIP_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic clip exporter configuration enum values.
+ */
+enum ClipConfig
+{
+    /** @brief The width (in pixels) of a frame at a scale of 1, which is 30 pixels per grid square. */
+    CLIP_BASE_WIDTH = 390,
+
+    /** @brief The height (in pixels) of a frame at a scale of 1, which is 30 pixels per grid square. */
+    CLIP_BASE_HEIGHT = 600,
+
+    /** @brief The frame rate of exported clips, which divides 100 so that GIF frame delays are exact. */
+    CLIP_FRAME_RATE = 25,
+
+    /** @brief The maximum number of worker threads used to render frames. */
+    CLIP_MAX_THREADS = 64,
+
+    /** @brief The number of consecutive frames each worker renders per batch. */
+    CLIP_FRAMES_PER_WORKER = 8,
+};
+
+/**
+ * @brief The options for exporting a replay as an animated GIF.
+ */
+typedef struct ClipOptions
+{
+    /** @brief The path of the replay to export. */
+    const char* replayPath;
+
+    /** @brief The path of the GIF to write. */
+    const char* outputPath;
+
+    /** @brief How many times faster than real time to play the replay. */
+    float speed;
+
+    /** @brief The size of the frames, relative to CLIP_BASE_WIDTH by CLIP_BASE_HEIGHT. */
+    float scale;
+
+    /** @brief The number of worker threads to render with, or 0 for one per logical CPU core. */
+    int threads;
+} ClipOptions;
+
+/**
+ * @brief The outcome of exporting a clip.
+ */
+typedef struct ClipResult
+{
+    /** @brief The number of frames written. */
+    Uint64 frames;
+
+    /** @brief The time (in nanoseconds) taken to export the clip. */
+    Uint64 elapsedNS;
+
+    /** @brief The length (in nanoseconds) of the replay that was exported. */
+    Uint64 replayNS;
+} ClipResult;
+
+/**
+ * @brief Play a replay back offscreen and write every frame to an animated GIF.
+ *
+ * @details The replay is split into batches of consecutive frames. Each worker thread renders its share of a batch
+ * with its own software renderer, and the batch is then encoded in order while the workers render the next one, so
+ * memory use depends only on the frame size and thread count, not on the length of the replay.
+ *
+ * @note This needs no window, display or GPU, only TTF_Init.
+ *
+ * @param options The export options.
+ * @param result A pointer to the result to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+bool CLIP_Export(const ClipOptions* options, ClipResult* result);
+
+#endif //CLIP_H
@@ -0,0 +1,278 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+/**
+ * @brief Generic position dataset configuration enum values.
+ */
+enum DatasetConfig
+{
+    /** @brief The value at the start of a dataset file, which reads "TDST" in little endian. */
+    DATASET_MAGIC = 0x54534454,
+
+    /** @brief The value at the start of each chunk, which reads "TCHK" in little endian. */
+    DATASET_CHUNK_MAGIC = 0x4B484354,
+
+    /** @brief The version of the file layout, bumped whenever it changes incompatibly. */
+    DATASET_VERSION = 1,
+
+    /** @brief The most records in a chunk. Each worker buffers a single chunk, so this bounds memory use. */
+    DATASET_CHUNK_RECORDS = 16384,
+
+    /** @brief The alignment (in bytes) of every chunk and every column in the file, so that columns can be read in place. */
+    DATASET_ALIGNMENT = 64,
+
+    /** @brief The size (in bytes) of a bit-packed board, one bit per arena cell. */
+    DATASET_BOARD_BYTES = (ARENA_HEIGHT * ARENA_WIDTH + 7) / 8,
+
+    /** @brief The number of upcoming tetrominoes recorded with each position. */
+    DATASET_QUEUE_LENGTH = 5,
+
+    /** @brief The number of tetrominoes a bot may lock in a game before it is cut short, as the bot rarely tops out. */
+    DATASET_MAX_PIECES = 1000,
+
+    /** @brief The most replays that can be exported at once. */
+    DATASET_MAX_REPLAYS = 64,
+
+    /** @brief The maximum number of worker threads used to play games. */
+    DATASET_MAX_THREADS = 64,
+};
+
+/**
+ * @brief The columns of a dataset, each holding one fixed-width value per record. Multi-byte values are little endian.
+ */
+typedef enum DatasetColumn
+{
+    /** @brief The game the position is from (Uint32): bot game n is n, and replay m follows the last bot game. */
+    DATASET_COLUMN_GAME,
+
+    /** @brief The number of tetrominoes locked in the game before this position (Uint16). */
+    DATASET_COLUMN_MOVE,
+
+    /**
+     * @brief Which arena cells are filled when the tetromino spawns (DATASET_BOARD_BYTES bytes). Cell (row, col) is bit
+     * (row * ARENA_WIDTH + col) % 8 of byte (row * ARENA_WIDTH + col) / 8, rows counting down from the top.
+     */
+    DATASET_COLUMN_BOARD,
+
+    /** @brief The ::TetrominoIdentifier of the tetromino to place (Uint8). */
+    DATASET_COLUMN_PIECE,
+
+    /** @brief The ::TetrominoIdentifier of each upcoming tetromino, three bits each with the next in the lowest (Uint16). */
+    DATASET_COLUMN_QUEUE,
+
+    /** @brief Where the tetromino locked: the x and y of its 4x4 matrix (Sint8 each) and its orientation (Uint8). */
+    DATASET_COLUMN_PLACEMENT,
+
+    /** @brief The number of rows the placement cleared (Uint8). */
+    DATASET_COLUMN_LINES,
+
+    /** @brief The score gained from the spawn to the lock and clear, including drops (Uint32). */
+    DATASET_COLUMN_REWARD,
+
+    /** @brief The ::DatasetFlag values of the record (Uint8). */
+    DATASET_COLUMN_FLAGS,
+
+    DATASET_COLUMN_COUNT,
+} DatasetColumn;
+
+/**
+ * @brief The flags of a record.
+ */
+typedef enum DatasetFlag
+{
+    /** @brief The game ended with this placement. */
+    DATASET_FLAG_GAME_OVER = 1 << 0,
+
+    /** @brief The position is from a replay of a player's game, rather than a game the bot played. */
+    DATASET_FLAG_REPLAY = 1 << 1,
+
+    /** @brief The game was cut short after this placement, having reached DATASET_MAX_PIECES. */
+    DATASET_FLAG_TRUNCATED = 1 << 2,
+} DatasetFlag;
+
+/**
+ * @brief How a column of a chunk is stored.
+ */
+typedef enum DatasetEncoding
+{
+    /** @brief The values as they are, which can be read straight from a mapping of the file. */
+    DATASET_ENCODING_RAW,
+
+    /**
+     * @brief Each value XORed with the value before it (the first with zero), then every run of zero bytes replaced
+     * by a zero byte and the run's length (1 to 255). Used whenever it is smaller than the raw values, which is almost
+     * always for the board, game and move columns, as consecutive positions differ in only a few bytes.
+     *
+     * @details To decode (see DATASET_DecodeColumn), read the stored bytes in order: a non-zero byte is output as it
+     * is, and a zero byte is followed by a count n, for which n zero bytes are output. This gives exactly
+     * recordCount * width bytes. Then, for each byte i from width onwards in order, XOR byte i - width into it, which
+     * turns the differences back into values.
+     */
+    DATASET_ENCODING_XOR_ZERO_RUNS,
+} DatasetEncoding;
+
+/**
+ * @brief The start of a dataset file.
+ *
+ * @details A file is this header, then the chunks (each starting with a ::DatasetChunkHeader) in the order they were
+ * finished, then the offset of every chunk (Uint64 each), then a ::DatasetTrailer. A reader maps the file, reads the
+ * trailer from its end to find the chunks, and reads raw columns in place. Every chunk and column is aligned to
+ * DATASET_ALIGNMENT bytes, and every field is little endian.
+ */
+typedef struct DatasetFileHeader
+{
+    Uint32 magic;
+    Uint32 version;
+
+    /** @brief The number of columns, and the width (in bytes) of each column's values, indexed by ::DatasetColumn. */
+    Uint32 columnCount;
+    Uint8 columnWidths[DATASET_COLUMN_COUNT];
+    Uint8 reserved[3];
+
+    /** @brief The seed of the first bot game. Bot game n is played with seed + n. */
+    Uint64 seed;
+
+    Uint8 padding[DATASET_ALIGNMENT - 4 * 3 - DATASET_COLUMN_COUNT - 3 - 8];
+} DatasetFileHeader;
+
+SDL_COMPILE_TIME_ASSERT(DatasetFileHeaderIsAligned, sizeof(DatasetFileHeader) == DATASET_ALIGNMENT);
+
+/**
+ * @brief Where a column of a chunk is, and how it is stored.
+ */
+typedef struct DatasetColumnEntry
+{
+    /** @brief The offset (in bytes) of the column from the start of its chunk. */
+    Uint64 offset;
+
+    /** @brief The size (in bytes) of the column as stored. */
+    Uint32 size;
+
+    /** @brief The ::DatasetEncoding of the column. */
+    Uint32 encoding;
+} DatasetColumnEntry;
+
+/**
+ * @brief The start of a chunk of records, stored column by column.
+ */
+typedef struct DatasetChunkHeader
+{
+    Uint32 magic;
+
+    /** @brief The number of records in the chunk. */
+    Uint32 recordCount;
+
+    /** @brief The size (in bytes) of the whole chunk, including this header and the padding after its last column. */
+    Uint64 size;
+
+    DatasetColumnEntry columns[DATASET_COLUMN_COUNT];
+} DatasetChunkHeader;
+
+/**
+ * @brief The end of a dataset file.
+ */
+typedef struct DatasetTrailer
+{
+    /** @brief The offset (in bytes) of the chunk offsets from the start of the file. */
+    Uint64 indexOffset;
+
+    Uint64 chunkCount;
+    Uint64 recordCount;
+
+    Uint32 magic;
+    Uint32 version;
+} DatasetTrailer;
+
+SDL_COMPILE_TIME_ASSERT(DatasetTrailerIsPacked, sizeof(DatasetTrailer) == 32);
+
+/**
+ * @brief The options for exporting a dataset.
+ */
+typedef struct DatasetOptions
+{
+    /** @brief The path of the dataset file to write. */
+    const char* outputPath;
+
+    /** @brief The number of games for the bot to play. */
+    int gameCount;
+
+    /** @brief The replays to export the positions of, after the bot's games. */
+    const char* replayPaths[DATASET_MAX_REPLAYS];
+    int replayCount;
+
+    /** @brief The seed of the first bot game. */
+    Uint64 seed;
+
+    /** @brief The number of worker threads to play games on, or 0 for one per logical CPU core. */
+    int threads;
+} DatasetOptions;
+
+/**
+ * @brief The outcome of exporting a dataset.
+ */
+typedef struct DatasetResult
+{
+    /** @brief The number of games (bot games and replays) exported. */
+    Uint64 games;
+
+    /** @brief The number of records and chunks written. */
+    Uint64 records;
+    Uint64 chunks;
+
+    /** @brief The size (in bytes) the columns would take unencoded, and the size of the whole file. */
+    Uint64 rawBytes;
+    Uint64 fileBytes;
+
+    /** @brief The wall-clock time (in nanoseconds) taken to export the dataset. */
+    Uint64 elapsedNS;
+} DatasetResult;
+
+/**
+ * @brief Play games with the bot and play replays back, writing every position (the board, the tetromino, the queue,
+ * where it was placed and what that gained) to a columnar dataset file.
+ *
+ * @details Games are shared out between worker threads as each finishes its last. Each worker records positions from
+ * the game's events into its own chunk, and when the chunk is full it encodes it and appends it to the file, so memory
+ * use depends only on the thread count, however many positions are written. Chunks from different workers are
+ * interleaved, so records are grouped by the game column rather than ordered.
+ *
+ * @param options The export options.
+ * @param result A pointer to the result to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+bool DATASET_Export(const DatasetOptions* options, DatasetResult* result);
+
+/**
+ * @brief Decode a column of a chunk into its raw values.
+ *
+ * @param data The column as stored.
+ * @param size The size (in bytes) of the column as stored.
+ * @param encoding The ::DatasetEncoding of the column.
+ * @param recordCount The number of records in the chunk.
+ * @param width The width (in bytes) of the column's values.
+ * @param values The buffer to write to, which must hold recordCount * width bytes.
+ *
+ * @return True on success, false if the column is malformed.
+ */
+bool DATASET_DecodeColumn(const Uint8* data, size_t size, DatasetEncoding encoding, int recordCount, int width, Uint8* values);
+
+/**
+ * @brief Read a dataset file back, decoding every column of every chunk and checking that encoding it again gives the
+ * same bytes, and that the chunks add up to the trailer.
+ *
+ * @note This reads one chunk at a time, so memory use does not depend on the size of the file.
+ *
+ * @param path The path of the dataset file.
+ * @param records A pointer to write the number of records read to.
+ *
+ * @return True if the file is well formed and every column round-trips, false otherwise.
+ */
+bool DATASET_Verify(const char* path, Uint64* records);
+
+#endif //DATASET_H
@@ -0,0 +1,225 @@
+#ifndef ENV_H
+#define ENV_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+/**
+ * @brief Generic reinforcement learning environment configuration enum values.
+ */
+enum EnvConfig
+{
+    /** @brief The version of the API and of the shared memory layout, bumped whenever either changes incompatibly. */
+    ENV_API_VERSION = 1,
+
+    /** @brief The value at the start of a shared memory region, which reads "TENV" in little endian. */
+    ENV_SHARED_MAGIC = 0x564E4554,
+
+    /** @brief The number of upcoming tetrominoes written to each observation. */
+    ENV_QUEUE_OBSERVED = 5,
+
+    /** @brief The game clock time (in nanoseconds) each step advances the game by, which is one 60Hz frame. */
+    ENV_STEP_NS = 1000000000 / 60,
+
+    /** @brief The maximum number of environments in a batch. */
+    ENV_MAX_BATCH = 65536,
+
+    /** @brief The number of times the shared memory server polls for a request before sleeping between polls. */
+    ENV_SHARED_SPIN_COUNT = 4096,
+
+    /** @brief The time (in nanoseconds) the shared memory server sleeps between polls once it has stopped spinning. */
+    ENV_SHARED_SLEEP_NS = 50000,
+};
+
+/**
+ * @brief The actions an agent can take each step. Every step also advances the game clock by ENV_STEP_NS.
+ */
+typedef enum EnvAction
+{
+    ENV_ACTION_NONE,
+    ENV_ACTION_LEFT,
+    ENV_ACTION_RIGHT,
+    ENV_ACTION_ROTATE_CW,
+    ENV_ACTION_ROTATE_CCW,
+    ENV_ACTION_SOFT_DROP,
+    ENV_ACTION_HARD_DROP,
+
+    /** @brief Start a new episode with the environment's next seed, without advancing the game. */
+    ENV_ACTION_RESET,
+
+    ENV_ACTION_COUNT,
+} EnvAction;
+
+/**
+ * @brief What an agent observes of a game, as a tightly packed array of bytes with no padding.
+ */
+typedef struct EnvObservation
+{
+    /** @brief Whether each arena cell is filled (1) or empty (0), row by row from the top. */
+    Uint8 board[ARENA_HEIGHT][ARENA_WIDTH];
+
+    /** @brief The height of each column's stack, i.e. the number of rows from its highest filled cell to the floor. */
+    Uint8 heights[ARENA_WIDTH];
+
+    /** @brief The ::TetrominoIdentifier of the dropping tetromino. */
+    Uint8 piece;
+
+    /** @brief The position of the dropping tetromino's 4x4 matrix in the arena, which may be partly outside it. */
+    Sint8 pieceX;
+    Sint8 pieceY;
+
+    /** @brief The orientation of the dropping tetromino. */
+    Uint8 pieceOrientation;
+
+    /** @brief The ::TetrominoIdentifier of each upcoming tetromino, in the order they will be drawn. */
+    Uint8 queue[ENV_QUEUE_OBSERVED];
+} EnvObservation;
+
+SDL_COMPILE_TIME_ASSERT(EnvObservationIsPacked, sizeof(EnvObservation) == ARENA_HEIGHT * ARENA_WIDTH + ARENA_WIDTH + 4 + ENV_QUEUE_OBSERVED);
+
+/**
+ * @brief The start of a shared memory region, which describes where everything else in it is.
+ *
+ * @details The region holds the header followed by the actions (one byte each), rewards (one float each), done flags
+ * (one byte each) and observations of every environment, each at the offset given here. A step is run as follows:
+ * 1. The trainer writes an ::EnvAction for every environment, then increments requestedSteps.
+ * 2. The server steps every environment and writes the rewards, done flags and observations, then sets completedSteps
+ * to requestedSteps.
+ * 3. The trainer waits for completedSteps to reach requestedSteps, then reads the results in place.
+ * The counters are 32-bit integers that must be accessed atomically. Either side may set isClosing to end the session,
+ * and the server sets it before it unmaps the region.
+ */
+typedef struct EnvSharedHeader
+{
+    Uint32 magic;
+    Uint32 version;
+
+    /** @brief The number of environments. */
+    Uint32 count;
+
+    /** @brief The size (in bytes) of an observation. */
+    Uint32 observationSize;
+
+    /** @brief The offset (in bytes) from the start of the region to each array. */
+    Uint32 actionsOffset;
+    Uint32 rewardsOffset;
+    Uint32 donesOffset;
+    Uint32 observationsOffset;
+
+    /** @brief The number of steps the trainer has requested. */
+    SDL_AtomicInt requestedSteps;
+
+    /** @brief The number of steps the server has completed. */
+    SDL_AtomicInt completedSteps;
+
+    /** @brief Set once either side ends the session. */
+    SDL_AtomicInt isClosing;
+} EnvSharedHeader;
+
+/**
+ * @brief A batch of environments, each a game an agent plays one step at a time.
+ *
+ * @details The layout is private, so that the API stays stable as the game changes. Environment i starts with seed
+ * seed + i, and every new episode adds the batch size to its seed, so every episode of every environment differs.
+ */
+typedef struct EnvBatch EnvBatch;
+
+/**
+ * @brief Create a batch of environments and reset each of them.
+ *
+ * @param count The number of environments, up to ENV_MAX_BATCH.
+ * @param seed The seed of the first environment's first episode.
+ *
+ * @return The batch, or NULL on failure.
+ */
+EnvBatch* ENV_Create(int count, Uint64 seed);
+
+/**
+ * @brief Create a batch of environments whose actions, rewards, done flags and observations live in a named shared
+ * memory region, so that a trainer in another process can read them without copying (see ::EnvSharedHeader).
+ *
+ * @param name The name of the region. On POSIX systems this should start with a '/'.
+ * @param count The number of environments, up to ENV_MAX_BATCH.
+ * @param seed The seed of the first environment's first episode.
+ *
+ * @return The batch, or NULL on failure.
+ */
+EnvBatch* ENV_CreateShared(const char* name, int count, Uint64 seed);
+
+/**
+ * @brief Destroy a batch of environments, unmapping and removing its shared memory region if it has one.
+ *
+ * @param batch The batch to destroy.
+ */
+void ENV_Destroy(EnvBatch* batch);
+
+/**
+ * @brief Get the number of environments in a batch.
+ *
+ * @param batch The batch.
+ *
+ * @return The number of environments.
+ */
+int ENV_GetCount(const EnvBatch* batch);
+
+/**
+ * @brief Start a new episode of an environment.
+ *
+ * @param batch The batch.
+ * @param index The index of the environment.
+ * @param seed The seed of the new episode.
+ */
+void ENV_Reset(EnvBatch* batch, int index, Uint64 seed);
+
+/**
+ * @brief Take a single action in an environment.
+ *
+ * @details The reward is the change in score, so it includes line clears (scored by level as ClearLines scores them)
+ * and drops. An environment that is done stays done until it is reset.
+ *
+ * @param batch The batch.
+ * @param index The index of the environment.
+ * @param action The action to take.
+ * @param done A pointer to write whether the game is over to.
+ *
+ * @return The reward.
+ */
+float ENV_Step(EnvBatch* batch, int index, EnvAction action, bool* done);
+
+/**
+ * @brief Take one action in every environment of a batch, writing the results straight into the given buffers.
+ *
+ * @details An environment whose game ends is reset to its next episode straight away, so its done flag is set but
+ * its observation is already of the new episode.
+ *
+ * @param batch The batch.
+ * @param actions The ::EnvAction of each environment, one byte each.
+ * @param rewards The buffer to write each environment's reward to.
+ * @param dones The buffer to write whether each environment's game ended to, one byte each.
+ * @param observations The buffer to write each environment's observation to, or NULL to not observe.
+ */
+void ENV_StepBatch(EnvBatch* batch, const Uint8* actions, float* rewards, Uint8* dones, EnvObservation* observations);
+
+/**
+ * @brief Write what the agent can see of an environment.
+ *
+ * @param batch The batch.
+ * @param index The index of the environment.
+ * @param observation A pointer to the observation to write to.
+ */
+void ENV_Observe(const EnvBatch* batch, int index, EnvObservation* observation);
+
+/**
+ * @brief Serve steps of a shared memory batch to a trainer in another process, until quit is set or the trainer sets
+ * the region's isClosing flag.
+ *
+ * @param batch A batch created by ENV_CreateShared.
+ * @param quit A flag that stops serving when set, or NULL to serve forever.
+ *
+ * @return The number of steps served, or -1 if the batch is not shared.
+ */
+Sint64 ENV_ServeShared(EnvBatch* batch, SDL_AtomicInt* quit);
+
+#endif //ENV_H
@@ -0,0 +1,166 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+/**
+ * @brief Generic event log configuration enum values.
+ */
+enum EventLogConfig
+{
+    /** @brief The first four bytes of a binary event log, "TEVT" when read as little endian. */
+    EVENTLOG_MAGIC = 0x54564554,
+
+    /** @brief The version of the binary event log format. */
+    EVENTLOG_VERSION = 1,
+
+    /** @brief The size (in bytes) of a binary event log's header. */
+    EVENTLOG_HEADER_SIZE = 8,
+
+    /** @brief The size (in bytes) of every record in a binary event log. */
+    EVENTLOG_RECORD_SIZE = 40,
+
+    /** @brief The maximum size (in bytes) of a line of an NDJSON event log, including its newline. */
+    EVENTLOG_LINE_SIZE = 256,
+
+    /** @brief The number of events the ring buffer can hold. This must be a power of two. */
+    EVENTLOG_RING_CAPACITY = 1024,
+
+    /** @brief The number of waiting events at which the game thread wakes the writer early. */
+    EVENTLOG_WAKE_THRESHOLD = EVENTLOG_RING_CAPACITY / 2,
+
+    /** @brief The most events encoded and written in a single write. */
+    EVENTLOG_BATCH_SIZE = 64,
+
+    /** @brief The time (in milliseconds) the writer sleeps between drains of the ring buffer. */
+    EVENTLOG_WRITE_INTERVAL_MS = 100,
+};
+
+/**
+ * @brief The formats an event log can be written in.
+ */
+typedef enum EventLogFormat
+{
+    /** @brief A header followed by fixed-size little endian records (see EVENTLOG_RECORD_SIZE). */
+    EVENTLOG_FORMAT_BINARY,
+
+    /** @brief One JSON object per line. */
+    EVENTLOG_FORMAT_NDJSON,
+} EventLogFormat;
+
+/**
+ * @brief How hard the writer pushes each batch towards the disk.
+ */
+typedef enum EventLogSyncPolicy
+{
+    /** @brief Leave batches in the stream's buffer until it fills or the log is closed, which is the cheapest. */
+    EVENTLOG_SYNC_NONE,
+
+    /** @brief Hand every batch to the operating system, so events survive the game crashing. */
+    EVENTLOG_SYNC_FLUSH,
+
+    /** @brief Force every batch onto the disk, so events survive the machine losing power. */
+    EVENTLOG_SYNC_FSYNC,
+} EventLogSyncPolicy;
+
+/**
+ * @brief An event waiting in the ring buffer, together with when it was emitted.
+ */
+typedef struct EventLogEntry
+{
+    GameEvent event;
+
+    /** @brief The time (in nanoseconds, from SDL_GetTicksNS) the event was emitted. */
+    Uint64 timestampNS;
+} EventLogEntry;
+
+/**
+ * @brief A log every event of a game is written to, for offline analysis.
+ *
+ * @details Events are pushed into a wait-free single producer, single consumer ring buffer by the thread stepping the
+ * game, which never blocks, allocates or makes a system call in doing so. A writer thread wakes every
+ * EVENTLOG_WRITE_INTERVAL_MS (or sooner once the ring is half full), encodes the waiting events in batches and writes
+ * each batch at once.
+ */
+typedef struct EventLog
+{
+    /** @brief The log, which only the writer thread may access while it is running. */
+    SDL_IOStream* stream;
+
+    EventLogFormat format;
+    EventLogSyncPolicy syncPolicy;
+
+    /** @brief The events waiting to be written. Only the game thread writes tail, and only the writer head. */
+    EventLogEntry ring[EVENTLOG_RING_CAPACITY];
+    SDL_AtomicInt head;
+    SDL_AtomicInt tail;
+
+    /** @brief The number of events dropped because the ring buffer was full. */
+    SDL_AtomicInt droppedEvents;
+
+    /** @brief The number of events and batches written, which only the writer thread may access while it is running. */
+    Uint64 writtenEvents;
+    Uint64 writtenBatches;
+
+    /** @brief The encoded batch being written, owned by the writer thread. */
+    char batch[EVENTLOG_BATCH_SIZE * EVENTLOG_LINE_SIZE];
+
+    /** @brief Signalled when the ring buffer fills past EVENTLOG_WAKE_THRESHOLD, and when the writer should stop. */
+    SDL_Semaphore* wake;
+
+    SDL_AtomicInt isStopping;
+    SDL_Thread* thread;
+} EventLog;
+
+/**
+ * @brief Create (or truncate) an event log and start its writer thread.
+ *
+ * @param log A pointer to the log to open.
+ * @param path The path of the log.
+ * @param format The format to write the log in.
+ * @param syncPolicy How hard to push each batch towards the disk.
+ *
+ * @return True on success, false otherwise.
+ */
+bool EVENTLOG_Open(EventLog* log, const char* path, EventLogFormat format, EventLogSyncPolicy syncPolicy);
+
+/**
+ * @brief Write every waiting event, stop the writer thread and close the log.
+ *
+ * @param log A pointer to the log to close.
+ */
+void EVENTLOG_Close(EventLog* log);
+
+/**
+ * @brief Push an event into a log's ring buffer. This is a ::GameEventListener, to be added to a game with the log as
+ * its user data (see GAME_AddEventListener). Only one game may be listened to by a log.
+ *
+ * @param userData A pointer to the log.
+ * @param event The event.
+ */
+void EVENTLOG_Listen(void* userData, const GameEvent* event);
+
+/**
+ * @brief Parse the name of a format, as given on the command line.
+ *
+ * @param name The name, "binary" or "ndjson".
+ * @param format A pointer to write the format to.
+ *
+ * @return True on success, false if the name is not recognised.
+ */
+bool EVENTLOG_ParseFormat(const char* name, EventLogFormat* format);
+
+/**
+ * @brief Parse the name of a sync policy, as given on the command line.
+ *
+ * @param name The name, "none", "flush" or "fsync".
+ * @param syncPolicy A pointer to write the sync policy to.
+ *
+ * @return True on success, false if the name is not recognised.
+ */
+bool EVENTLOG_ParseSyncPolicy(const char* name, EventLogSyncPolicy* syncPolicy);
+
+#endif //EVENTLOG_H
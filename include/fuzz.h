@@ -0,0 +1,127 @@
+#ifndef FUZZ_H
+#define FUZZ_H
+
+#include "game.h"
+
+/**
+ * @brief Generic fuzzer configuration enum values.
+ */
+enum FuzzConfig
+{
+    /** @brief The number of random operations applied to a game in a single fuzz case. */
+    FUZZ_CASE_OPERATIONS = 4096,
+
+    /** @brief The number of cases a worker claims at a time, so that workers rarely contend on the shared counter. */
+    FUZZ_CASES_PER_CLAIM = 64,
+
+    /** @brief The maximum number of worker threads used to run cases. */
+    FUZZ_MAX_THREADS = 64,
+
+    /** @brief How often (in milliseconds) progress is logged during a long run. */
+    FUZZ_PROGRESS_INTERVAL_MS = 10000,
+
+    /** @brief The game time (in milliseconds) that a single gravity operation advances the game clock by. */
+    FUZZ_ITERATION_MS = 50,
+};
+
+/**
+ * @brief A single operation applied to the game under test, written as the character used in reproduction strings.
+ */
+typedef enum FuzzOperation
+{
+    FUZZ_SHIFT_LEFT = 'L',
+    FUZZ_SHIFT_RIGHT = 'R',
+    FUZZ_ROTATE_CLOCKWISE = 'W',
+    FUZZ_ROTATE_ANTICLOCKWISE = 'A',
+    FUZZ_SOFT_DROP = 'S',
+    FUZZ_HARD_DROP = 'H',
+    FUZZ_TOGGLE_PAUSE = 'P',
+    FUZZ_RESET = 'X',
+
+    /** @brief Queue a single garbage row, which rises when the next tetromino locks, so that rows get cleared often. */
+    FUZZ_GARBAGE = 'G',
+
+    /** @brief Advance the game clock by FUZZ_ITERATION_MS, applying gravity and lock delay. */
+    FUZZ_ITERATE = 'I',
+} FuzzOperation;
+
+/**
+ * @brief A failing sequence of operations, minimised so that removing any single operation makes it pass.
+ */
+typedef struct FuzzFailure
+{
+    /** @brief The seed of the case, which seeds the game and every reset in it. */
+    Uint64 seed;
+
+    /** @brief The invariant that was broken. */
+    const char* invariant;
+
+    /** @brief The number of operations in the sequence. */
+    int operationCount;
+
+    /** @brief The operations, as a null terminated string of ::FuzzOperation characters. */
+    char operations[FUZZ_CASE_OPERATIONS + 1];
+} FuzzFailure;
+
+/**
+ * @brief The aggregated outcome of a fuzz run.
+ */
+typedef struct FuzzResult
+{
+    /** @brief The number of cases run. */
+    Uint64 cases;
+
+    /** @brief The total number of operations applied across every case. */
+    Uint64 operations;
+
+    /** @brief The wall-clock time (in nanoseconds) taken to run every case. */
+    Uint64 elapsedNS;
+
+    /** @brief Whether any case broke an invariant, in which case failure holds the first one found, minimised. */
+    bool hasFailed;
+
+    FuzzFailure failure;
+} FuzzResult;
+
+/**
+ * @brief Apply a sequence of operations to a fresh game, checking every invariant after each one.
+ *
+ * @details The invariants are that the dropping tetromino lies within the arena and does not overlap the stack
+ * (unless the game is over), the arena only holds valid ::TetrominoIdentifier values and has no filled rows left in
+ * it, the incremental arena hash matches one computed from scratch, no more than four rows are cleared by a single
+ * operation, the score never decreases between resets, and the next queue always holds at least two bags.
+ *
+ * @param seed The seed of the game. The nth reset in the sequence uses seed + n, so a sequence always plays the same.
+ * @param operations The operations, as ::FuzzOperation characters.
+ * @param operationCount The number of operations.
+ * @param failedOperation A pointer to write the index of the operation that broke an invariant to, or NULL.
+ *
+ * @return The name of the broken invariant, or NULL if every invariant held.
+ */
+const char* FUZZ_RunOperations(Uint64 seed, const char* operations, int operationCount, int* failedOperation);
+
+/**
+ * @brief Shrink a failing sequence of operations, keeping it failing on the same invariant.
+ *
+ * @details The sequence is first cut short after the failing operation, and then ever smaller chunks of operations are
+ * removed for as long as the sequence still fails, until no single operation can be removed.
+ *
+ * @param failure A pointer to the failure to minimise in place.
+ */
+void FUZZ_Minimise(FuzzFailure* failure);
+
+/**
+ * @brief Run random fuzz cases, split across worker threads, until they are all done or one breaks an invariant.
+ *
+ * @note Case n is generated from seed + n, so a run can be reproduced regardless of the thread count.
+ *
+ * @param caseCount The number of cases to run.
+ * @param threadCount The number of worker threads to use, or 0 to use one per logical CPU core.
+ * @param seed The seed of the first case.
+ * @param result A pointer to the result to write to, including the minimised failure if any.
+ *
+ * @return True if every case passed, false otherwise.
+ */
+bool FUZZ_Run(Uint64 caseCount, int threadCount, Uint64 seed, FuzzResult* result);
+
+#endif //FUZZ_H
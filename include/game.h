@@ -16,8 +16,129 @@ enum GameConfig
 
     /** @brief The maximum level the player can reach. */
     MAX_LEVEL = 20,
+
+    /** @brief The maximum number of separate garbage attacks that can be waiting to be inserted into the arena. */
+    GARBAGE_QUEUE_SIZE = 16,
+
+    /**
+     * @brief The time (in nanoseconds) per row at or below which gravity is 20G, i.e. the tetromino falls the whole
+     * arena height every 60Hz frame, which is treated as landing as soon as it spawns.
+     */
+    GRAVITY_20G_NS = 1000000000 / (60 * ARENA_HEIGHT),
+
+    /** @brief The maximum number of listeners a game can report its events to. */
+    GAME_MAX_EVENT_LISTENERS = 4,
 };
 
+/**
+ * @brief The gameplay events a game reports to its listeners.
+ */
+typedef enum GameEventType
+{
+    /** @brief A new game was started. */
+    GAME_EVENT_START,
+
+    /** @brief A tetromino spawned at the top of the arena. */
+    GAME_EVENT_SPAWN,
+
+    /** @brief The dropping tetromino locked into the arena, before any rows it filled were cleared. */
+    GAME_EVENT_LOCK,
+
+    /** @brief Filled rows were cleared, whose number (adjacent or not) gives the clear type (single up to tetris). */
+    GAME_EVENT_LINE_CLEAR,
+
+    GAME_EVENT_LEVEL_UP,
+    GAME_EVENT_PAUSE,
+    GAME_EVENT_RESUME,
+    GAME_EVENT_GAME_OVER,
+
+    /** @brief The dropping tetromino was hard dropped, just before it locked where it landed. */
+    GAME_EVENT_HARD_DROP,
+
+    /** @brief The dropping tetromino was shifted one column left or right. */
+    GAME_EVENT_MOVE,
+
+    /** @brief The dropping tetromino was rotated, after any wall kick. */
+    GAME_EVENT_ROTATE,
+
+    GAME_EVENT_COUNT,
+} GameEventType;
+
+/**
+ * @brief A single gameplay event, together with the state of the game when it happened.
+ */
+typedef struct GameEvent
+{
+    GameEventType type;
+
+    /** @brief The game clock (in nanoseconds) when the event happened. */
+    Uint64 clockNS;
+
+    /** @brief The seed of the game, which tells apart events from different games. */
+    Uint64 seed;
+
+    /** @brief The tetromino spawned, moved, rotated, locked or hard dropped, and its pose, or 0 for other events. */
+    TetrominoIdentifier piece;
+    int x;
+    int y;
+    int orientation;
+
+    /**
+     * @brief The number of rows cleared, and the lowest of them, for GAME_EVENT_LINE_CLEAR. For GAME_EVENT_HARD_DROP,
+     * lines is the number of rows the tetromino fell.
+     */
+    int lines;
+    int row;
+
+    /** @brief The rows cleared for GAME_EVENT_LINE_CLEAR, with bit n set if row n was, as they need not be adjacent. */
+    Uint32 rowMask;
+
+    /** @brief The level and score after the event. */
+    int level;
+    int score;
+} GameEvent;
+
+/**
+ * @brief A function told about every event of a game, on whichever thread steps the game. It must return quickly, as
+ * it runs in the middle of a game step.
+ *
+ * @param userData The pointer the listener was added with.
+ * @param event The event.
+ */
+typedef void (*GameEventListener)(void* userData, const GameEvent* event);
+
+/**
+ * @brief A single attack of garbage rows sent by an opponent.
+ *
+ * @note See "Garbage": https://tetris.wiki/Garbage
+ */
+typedef struct GarbageAttack
+{
+    /** @brief The number of garbage rows in this attack. */
+    int lines;
+
+    /** @brief The column of the single hole shared by every row in this attack. */
+    int holeColumn;
+} GarbageAttack;
+
+/**
+ * @brief A ring buffer of incoming garbage attacks waiting to be inserted when the next tetromino locks.
+ */
+typedef struct GarbageQueue
+{
+    /** @brief The queued attacks, starting at index head. */
+    GarbageAttack attacks[GARBAGE_QUEUE_SIZE];
+
+    /** @brief The index of the oldest queued attack. */
+    int head;
+
+    /** @brief The number of queued attacks. */
+    int count;
+
+    /** @brief The total number of garbage rows across every queued attack. */
+    int lines;
+} GarbageQueue;
+
 /** 
  *  @brief A struct that holds the current game state: score, level, arena and currently dropping tetromino.
  *
@@ -43,18 +164,65 @@ typedef struct GameDataContext
     /** @brief The state the of the tetris arena, where each cell is either empty or has a ::TetrominoIdentifier value. */
     TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH];
 
-    /** @brief A pointer to the state of the currently dropping tetromino. */
+    /** @brief The Zobrist hash of which arena cells are filled, kept up to date as the arena changes (see zobrist.h). */
+    Uint64 arenaHash;
+
+    /** @brief A pointer to the state of the currently dropping tetromino. This is allocated on reset if it is NULL. */
     DroppingTetromino* droppingTetromino;
 
 
     /** @brief The 'bag' containing the possible tetrominoes. */
     TetrominoBag tetrominoBag;
 
+    /** @brief The seed the current game was started with. */
+    Uint64 seed;
+
+    /** @brief The state of the random number generator used to pick garbage hole columns. */
+    Uint64 garbageRandomState;
+
+    /** @brief The number of lines cleared since the last level increase. */
+    int levelLinesCleared;
+
+    /** @brief The total number of lines cleared in the current game. */
+    int linesCleared;
+
+    /** @brief The number of tetrominoes locked in the current game. */
+    int piecesLocked;
+
+    /** @brief The time (in nanoseconds) gravity takes to drop the tetromino one row at the current level. */
+    Uint64 gravityNS;
+
+    /** @brief The game clock time (in nanoseconds) that has passed since gravity last dropped the tetromino a row. */
+    Uint64 gravityAccumulatorNS;
+
+    /**
+     * @brief The game clock (in nanoseconds), which only advances while the game is being played.
+     * @details All game timing (gravity and lock down) uses this rather than the system clock, so that it is
+     * unaffected by how often the game is iterated, i.e. by the frame rate.
+     */
+    Uint64 clockNS;
+
+    /** @brief Garbage received from the opponent, inserted into the arena when the next tetromino locks. */
+    GarbageQueue incomingGarbage;
+
+    /** @brief The total number of garbage rows sent to the opponent in the current game. */
+    int garbageSent;
+
+    /** @brief A pointer to the opponent's game, which receives the garbage we send, or NULL in single player. */
+    struct GameDataContext* opponent;
+
+    /** @brief The listeners told about every event, with the pointer each was added with (see GAME_AddEventListener). */
+    GameEventListener eventListeners[GAME_MAX_EVENT_LISTENERS];
+    void* eventListenerData[GAME_MAX_EVENT_LISTENERS];
+    int eventListenerCount;
+
 } GameDataContext;
 
 /**
  * @brief Initialises the gameDataContext values.
  *
+ * @note The context must be zeroed, or have droppingTetromino pointing to memory provided by the caller.
+ *
  * @param gameDataContext A struct containing the game data to initialise.
  *
  * @return True on success, false otherwise.
@@ -70,6 +238,18 @@ bool GAME_Init(GameDataContext* gameDataContext);
  */
 bool GAME_Reset(GameDataContext* gameDataContext);
 
+/**
+ * @brief Reset the current game state, using a given seed for every random decision made during the game.
+ *
+ * @note Two games reset with the same seed will receive the same sequence of tetrominoes.
+ *
+ * @param gameDataContext A struct containing the game data to initialise.
+ * @param seed The seed for the game's random number generators.
+ *
+ * @return True on success, false otherwise.
+ */
+bool GAME_ResetWithSeed(GameDataContext* gameDataContext, Uint64 seed);
+
 /**
  * @brief Restart the game.
  *
@@ -79,6 +259,26 @@ bool GAME_Reset(GameDataContext* gameDataContext);
  */
 void GAME_Restart(void* data);
 
+/**
+ * @brief Add a listener to be told about every event of a game, from then on.
+ *
+ * @param gameDataContext A struct containing the game data.
+ * @param listener The listener.
+ * @param userData A pointer passed to the listener with each event.
+ *
+ * @return True on success, false if the game already has GAME_MAX_EVENT_LISTENERS listeners.
+ */
+bool GAME_AddEventListener(GameDataContext* gameDataContext, GameEventListener listener, void* userData);
+
+/**
+ * @brief Get the name of a type of event, for logging.
+ *
+ * @param type The type of event.
+ *
+ * @return The name, in lower case.
+ */
+const char* GAME_GetEventName(GameEventType type);
+
 /**
  * @brief Pause/resume the game.
  *
@@ -97,11 +297,12 @@ void GAME_TogglePause(void* data);
 void GAME_Quit(void* data);
 
 /**
- * @brief The method handling all the game logic that should happen each frame.
- * 
+ * @brief The method handling all the game logic that should happen each simulation tick.
+ *
  * @param gameDataContext A struct containing the game data context.
+ * @param elapsedNS The time (in nanoseconds) to advance the game clock by, unless the game is paused or over.
  */
-void GAME_Iteration(GameDataContext* gameDataContext);
+void GAME_Iteration(GameDataContext* gameDataContext, Uint64 elapsedNS);
 
 
 /**
@@ -114,12 +315,13 @@ void GAME_Iteration(GameDataContext* gameDataContext);
  *
  * @return True if the tetromino would collide, false otherwise.
  */
-bool WillDroppingTetrominoCollide(GameDataContext* gameDataContext, int translationX, int translationY, int rotationAmount);
+bool WillDroppingTetrominoCollide(const GameDataContext* gameDataContext, int translationX, int translationY, int rotationAmount);
 
 
 /**
- * @brief Scan the board for rows that should be cleared, clear them, increment the score by an appropriate amount, and
- * then return the number of lines that were cleared.
+ * @brief Scan the board for rows that should be cleared, clear them all at once (adjacent or not), increment the score
+ * by an appropriate amount for the total, send garbage to the opponent (if any), and then return the number of lines
+ * that were cleared.
  * 
  * @param gameDataContext A struct containing the game data context.
  * 
@@ -128,17 +330,18 @@ bool WillDroppingTetrominoCollide(GameDataContext* gameDataContext, int translat
 int ClearLines(GameDataContext* gameDataContext);
 
 /**
- * @brief Drops every row in the arena above dropToRow by dropAmount.
+ * @brief Queue incoming garbage rows, to be inserted into the arena when the next tetromino locks.
+ *
+ * @note Every row of a single attack shares the same hole column. See "Garbage": https://tetris.wiki/Garbage
  *
- * @param arena The matrix representation of the tetris arena.
- * @param dropToRow The row to drop to.
- * @param dropAmount The amount to drop the rows by.
+ * @param gameDataContext A struct containing the game data context of the player receiving the garbage.
+ * @param lines The number of garbage rows to queue.
  */
-static void DropRows(TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH], int dropToRow, int dropAmount);
+void GAME_QueueGarbage(GameDataContext* gameDataContext, int lines);
 
 /**
- * @brief Writes the location of the dropping tetromino onto the arena, and then resets it's attributes,
- * essentially "spawning" a new one.
+ * @brief Writes the location of the dropping tetromino onto the arena, clears any filled rows, inserts any queued
+ * garbage, and then resets it's attributes, essentially "spawning" a new one.
  *
  * @param gameDataContext A struct containing the game data context.
  */
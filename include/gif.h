@@ -0,0 +1,113 @@
+#ifndef GIF_H
+#define GIF_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic GIF encoder configuration enum values.
+ */
+enum GifConfig
+{
+    /** @brief The number of red levels in the fixed palette. */
+    GIF_PALETTE_RED_LEVELS = 6,
+
+    /** @brief The number of green levels in the fixed palette, which has one more as the eye is most sensitive to it. */
+    GIF_PALETTE_GREEN_LEVELS = 7,
+
+    /** @brief The number of blue levels in the fixed palette. */
+    GIF_PALETTE_BLUE_LEVELS = 6,
+
+    /** @brief The number of entries in the colour table, of which the fixed palette uses the first 252. */
+    GIF_COLOR_TABLE_SIZE = 256,
+
+    /** @brief The bits per pixel of the image data, and so the LZW minimum code size. */
+    GIF_MIN_CODE_SIZE = 8,
+
+    /** @brief The largest LZW code, after which the dictionary is cleared. */
+    GIF_MAX_CODE = 4095,
+
+    /** @brief The size of the LZW dictionary hash table, a prime somewhat larger than the number of codes. */
+    GIF_HASH_SIZE = 5003,
+
+    /** @brief The maximum length of a GIF data sub-block. */
+    GIF_SUB_BLOCK_SIZE = 255,
+};
+
+/**
+ * @brief An animated GIF being written one frame at a time, so that only the current frame is ever held in memory.
+ *
+ * @details Every frame uses the same fixed palette, so frames can be quantised in parallel and in any order before
+ * being written in order.
+ */
+typedef struct GifEncoder
+{
+    SDL_IOStream* stream;
+    int width;
+    int height;
+
+    /** @brief The time between frames, in hundredths of a second. */
+    Uint16 delay;
+
+    /** @brief The number of frames written. */
+    Uint64 frameCount;
+
+    /** @brief The key (prefix code and next index) held in each slot of the LZW dictionary hash table, or -1. */
+    Sint32 hashKeys[GIF_HASH_SIZE];
+
+    /** @brief The code of each key in the LZW dictionary hash table. */
+    Uint16 hashCodes[GIF_HASH_SIZE];
+
+    /** @brief Bits waiting to be written, least significant first. */
+    Uint32 bitBuffer;
+    int bitCount;
+
+    /** @brief The data sub-block being filled. */
+    Uint8 subBlock[GIF_SUB_BLOCK_SIZE];
+    int subBlockLength;
+
+    /** @brief Whether any write has failed. */
+    bool hasFailed;
+} GifEncoder;
+
+/**
+ * @brief Open a GIF file and write its header, palette and looping extension.
+ *
+ * @param encoder A pointer to the encoder to initialise.
+ * @param path The path of the GIF file to write.
+ * @param width The width (in pixels) of every frame.
+ * @param height The height (in pixels) of every frame.
+ * @param delay The time between frames, in hundredths of a second.
+ *
+ * @return True on success, false otherwise.
+ */
+bool GIF_Begin(GifEncoder* encoder, const char* path, int width, int height, Uint16 delay);
+
+/**
+ * @brief Map every pixel of a frame to its nearest colour in the fixed palette. This is thread safe.
+ *
+ * @param frame The frame, in SDL_PIXELFORMAT_RGBA32.
+ * @param indices The palette index of each pixel, width * height bytes, to write to.
+ */
+void GIF_QuantizeFrame(const SDL_Surface* frame, Uint8* indices);
+
+/**
+ * @brief Compress and write a quantised frame.
+ *
+ * @param encoder A pointer to the encoder.
+ * @param indices The palette index of each pixel, as written by GIF_QuantizeFrame.
+ *
+ * @return True on success, false otherwise.
+ */
+bool GIF_WriteFrame(GifEncoder* encoder, const Uint8* indices);
+
+/**
+ * @brief Write the trailer and close the file.
+ *
+ * @param encoder A pointer to the encoder.
+ *
+ * @return True if every write succeeded, false otherwise.
+ */
+bool GIF_End(GifEncoder* encoder);
+
+#endif //GIF_H
@@ -0,0 +1,64 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic golden image test configuration enum values.
+ */
+enum GoldenConfig
+{
+    /** @brief The width (in pixels) of every rendered frame, which is 30 pixels per grid square. */
+    GOLDEN_FRAME_WIDTH = 390,
+
+    /** @brief The height (in pixels) of every rendered frame, which is 30 pixels per grid square. */
+    GOLDEN_FRAME_HEIGHT = 600,
+
+    /** @brief The largest difference in any colour channel for two pixels to still be considered the same. */
+    GOLDEN_CHANNEL_TOLERANCE = 8,
+
+    /** @brief The number of pixels per million that may differ by more than the tolerance before a frame fails. */
+    GOLDEN_MAX_DIFFERENT_PIXELS_PER_MILLION = 1000,
+
+    /** @brief The number of times each scene is rendered to measure throughput. */
+    GOLDEN_BENCHMARK_FRAMES = 200,
+
+    /** @brief The maximum length of a golden image path. */
+    GOLDEN_MAX_PATH_LENGTH = 512,
+};
+
+/**
+ * @brief The outcome of a golden image test run.
+ */
+typedef struct GoldenResult
+{
+    /** @brief The number of scenes rendered. */
+    int scenes;
+
+    /** @brief The number of scenes that matched their golden image, or that had their golden image written. */
+    int passed;
+
+    /** @brief The number of frames rendered while measuring throughput. */
+    Uint64 benchmarkFrames;
+
+    /** @brief The time (in nanoseconds) taken to render the benchmark frames. */
+    Uint64 benchmarkNS;
+} GoldenResult;
+
+/**
+ * @brief Render every scripted scene offscreen and compare each frame against its golden PNG, then measure how many
+ * frames per second the renderer can produce.
+ *
+ * @note This needs no window, display or GPU, only TTF_Init. A frame that does not match is written next to its golden
+ * image as '<scene>.actual.png'.
+ *
+ * @param directory The directory containing the golden images, named '<scene>.png'.
+ * @param isUpdating Whether to overwrite the golden images with the rendered frames rather than compare them.
+ * @param result A pointer to the result to write to.
+ *
+ * @return True if every scene matched (or was written), false otherwise.
+ */
+bool GOLDEN_Run(const char* directory, bool isUpdating, GoldenResult* result);
+
+#endif //GOLDEN_H
@@ -16,8 +16,43 @@ enum GraphicsConfig
 
     /** @brief How many (dynamic resizable) unit grid alignment squares high the window is. */
     WINDOW_GRID_HEIGHT = 20,
+
+    /** @brief The maximum number of lines of text in a text overlay. */
+    OVERLAY_MAX_LINES = 12,
+
+    /** @brief The first character in a glyph atlas (space), which holds the printable ASCII characters. */
+    GLYPH_ATLAS_FIRST_CHARACTER = 32,
+
+    /** @brief The number of characters in a glyph atlas. */
+    GLYPH_ATLAS_CHARACTER_COUNT = 95,
+
+    /** @brief The number of glyphs in each row of a glyph atlas texture. */
+    GLYPH_ATLAS_COLUMNS = 16,
+
+    /** @brief The number of upcoming tetrominoes shown in the sidebar. */
+    NEXT_QUEUE_PREVIEW_COUNT = 5,
+
+    /** @brief The size (in pixels) of each block in the block atlas texture. */
+    BLOCK_ATLAS_CELL_SIZE = 32,
 };
 
+/**
+ * @brief A texture containing every printable ASCII character of a font, rendered in white.
+ *
+ * @details Used for text that changes often (e.g. the score), as drawing from the atlas never creates textures.
+ */
+typedef struct GlyphAtlas
+{
+    /** @brief The texture containing every glyph. */
+    SDL_Texture* texture;
+
+    /** @brief The location of each glyph in the texture. A glyph's width is also how far it advances the text. */
+    SDL_FRect glyphs[GLYPH_ATLAS_CHARACTER_COUNT];
+
+    /** @brief The height (in pixels) of every glyph. */
+    float lineHeight;
+} GlyphAtlas;
+
 /**
  * @brief A struct containing fonts.
  */
@@ -25,6 +60,9 @@ typedef struct Fonts
 {
     TTF_Font* mainFont;
     TTF_Font* secondaryFont;
+
+    /** @brief A glyph atlas of the secondary font, used for dynamic text. */
+    GlyphAtlas secondaryFontAtlas;
 } Fonts;
 
 /**
@@ -39,6 +77,22 @@ typedef struct FGridRect
 
 } FGridRect;
 
+/**
+ * @brief An alignment grid placed anywhere on the screen, at any scale.
+ *
+ * @details The window's own grid is the scaled grid at the origin with squares of size gridSquareSize. Others are used
+ * to lay out many boards at once, each on its own smaller grid.
+ */
+typedef struct ScaledGrid
+{
+    /** @brief The position (in pixels) of the grid's upper left corner. */
+    float x;
+    float y;
+
+    /** @brief The size (in pixels) of a single grid square. */
+    float squareSize;
+} ScaledGrid;
+
 /**
  * @brief A struct containing cache data for some text
  *
@@ -56,6 +110,24 @@ typedef struct TextCache
     bool valid;
 } TextCache;
 
+/**
+ * @brief A struct containing lines of text drawn over the top of the game, such as debug statistics.
+ */
+typedef struct TextOverlay
+{
+    /** @brief The bounds of the overlay on the alignment grid. Each line takes an equal share of the height. */
+    FGridRect gridRect;
+
+    /** @brief The number of lines of text to draw. */
+    int lineCount;
+
+    /** @brief The lines of text to draw. */
+    char lines[OVERLAY_MAX_LINES][MAX_STRING_LENGTH];
+
+    /** @brief The tick at which the lines were last updated, so that they are not regenerated every frame. */
+    Uint64 lastUpdateTick;
+} TextOverlay;
+
 /**
  * @brief The function to callback when a button is clicked.
  */
@@ -100,6 +172,9 @@ typedef struct SidebarUI
 
 } SidebarUI;
 
+struct ScoreStore;
+struct ParticleSystem;
+
 /**
  *  @brief A struct that holds the current graphics state: renderer, window and gridSquareSize.
  *
@@ -110,18 +185,46 @@ typedef struct GraphicsDataContext
     /** @brief A pointer to the SDL renderer used for GPU calls. */
     SDL_Renderer* renderer;
 
-    /** @brief A pointer to the SDL window object. */
+    /** @brief A pointer to the SDL window object, or NULL when rendering headless. */
     SDL_Window* window;
 
+    /** @brief The surface rendered into when rendering headless, or NULL when rendering to a window. */
+    SDL_Surface* targetSurface;
+
     /**
      * @brief The current size (in pixels) of a single unit grid square.
      * @details We devise pixel-coordinates for all draw calls using this value, as it changes relative to the window size.
      */
     float gridSquareSize;
 
-    /** @brief A pointer to a sidebar UI struct. */
+    /** @brief A pointer to a sidebar UI struct. This is allocated by GFX_Init if it is NULL. */
     SidebarUI* sidebarUI;
 
+    /**
+     * @brief The texture of each block, indexed by ::TetrominoIdentifier, including GARBAGE for garbage blocks.
+     * @details Textures belong to a renderer, so each graphics context loads its own.
+     */
+    SDL_Texture* blockTextures[GARBAGE + 1];
+
+    /**
+     * @brief Every block side by side in a single texture, or NULL if it has not been built (see BuildBlockAtlas).
+     * @details The block of each ::TetrominoIdentifier is in the cell of the same index, and the first cell is solid
+     * white, so that a whole batch of blocks and plain coloured quads can be drawn with a single draw call.
+     */
+    SDL_Texture* blockAtlas;
+
+    /** @brief The cached texture of the sidebar title. */
+    TextCache sidebarTitleCache;
+
+    /** @brief The cached texture of the game over title. */
+    TextCache gameOverTitleCache;
+
+    /** @brief The store whose high scores the game over screen shows, or NULL to show only the title. */
+    struct ScoreStore* scoreStore;
+
+    /** @brief The line clear and hard drop effects drawn over the arena, or NULL to draw none. */
+    struct ParticleSystem* particles;
+
 } GraphicsDataContext;
 
 /**
@@ -136,7 +239,20 @@ typedef struct GraphicsDataContext
 bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts);
 
 /**
- * @brief Loads resources into memory, including tetromino square textures
+ * @brief Initialises the graphicsData values to render into an offscreen software surface, with no window or display.
+ *
+ * @param graphicsDataContext A struct containing the graphics data to initialise.
+ * @param gameDataContext A struct containing the game data context.
+ * @param fonts A pointer to the fonts struct to load the fonts to.
+ * @param width The width (in pixels) of the surface.
+ * @param height The height (in pixels) of the surface.
+ *
+ * @return True on success, false otherwise.
+ */
+bool GFX_InitHeadless(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts, int width, int height);
+
+/**
+ * @brief Loads resources into memory, including tetromino and garbage square textures
  * 
  * @param graphicsDataContext A struct containing the graphics data context.
  *
@@ -213,6 +329,20 @@ bool DrawDroppingTetrominoGhost(GraphicsDataContext* graphicsDataContext, GameDa
  */
 bool DrawSidebar(GraphicsDataContext* graphicsDataContext, Fonts* fonts, GameDataContext* gameDataContext);
 
+/**
+ * @brief Draw the upcoming tetrominoes, one above the other, each centred in an equal share of an area.
+ *
+ * @details The blocks are drawn with the cached block textures, scaled so that the widest tetromino fits, so nothing
+ * is created or allocated.
+ *
+ * @param graphicsDataContext A struct containing the graphics data context.
+ * @param gameDataContext A struct containing the game data context.
+ * @param gridRect The area to draw the tetrominoes in.
+ *
+ * @return True on success, false otherwise.
+ */
+bool DrawNextQueue(GraphicsDataContext* graphicsDataContext, const GameDataContext* gameDataContext, FGridRect gridRect);
+
 /**
  * @brief Render a game over screen.
  * 
@@ -224,6 +354,17 @@ bool DrawSidebar(GraphicsDataContext* graphicsDataContext, Fonts* fonts, GameDat
  */
 bool DrawGameOverScreen(GraphicsDataContext* graphicsDataContext, Fonts* fonts, GameDataContext* gameDataContext);
 
+/**
+ * @brief Draw a text overlay on top of the game.
+ *
+ * @param graphicsDataContext A struct containing the graphics data context.
+ * @param fonts A pointer to a struct of fonts to use.
+ * @param overlay A pointer to the overlay to draw.
+ *
+ * @return True on success, false otherwise.
+ */
+bool DrawTextOverlay(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, TextOverlay* overlay);
+
 /**
  * @brief Resizes the grid square (used as a standard alignment unit) based on what would fit in the given window size.
  *
@@ -251,26 +392,65 @@ bool ResizeGridSquares(GraphicsDataContext* graphicsDataContext, Sint32 windowWi
 bool RenderText(GraphicsDataContext* graphicsDataContext, FGridRect gridRect, float margin, char* text, TextCache* cache, TTF_Font* font, SDL_Color color);
 
 /**
- * @brief Render a button object onto the screen.
+ * @brief Render frequently changing text centered within given bounds (specified in grid squares), using a glyph atlas.
+ *
+ * @details Unlike RenderText, this never creates a texture, and draws the whole string with a single draw call.
+ * Characters that are not printable ASCII are drawn as '?'.
  *
  * @param graphicsDataContext A struct containing the graphics data context.
- * @param button A pointer to the button to render.
+ * @param gridRect A rectangle representing the bounds of the text on the alignment grid
+ * @param margin The margin of the generated text.
+ * @param text The text to draw.
+ * @param atlas The glyph atlas of the font to draw the text in.
+ * @param color The color to draw the text in.
  *
  * @return True if success, false otherwise.
  */
-bool RenderButton(GraphicsDataContext* graphicsDataContext, Button* button);
+bool RenderDynamicText(GraphicsDataContext* graphicsDataContext, FGridRect gridRect, float margin, const char* text, const GlyphAtlas* atlas, SDL_Color color);
+
+/**
+ * @brief Build a quad (four vertices, clockwise from the upper left) for each glyph of some text, fitted and centred
+ * inside a rectangle, so that it can be drawn with other text in a single batch.
+ *
+ * @param atlas The glyph atlas of the font to draw the text in.
+ * @param bounds The bounds (in pixels) of the text.
+ * @param text The text to draw. Only the first MAX_STRING_LENGTH characters are used.
+ * @param color The color to draw the text in.
+ * @param vertices The array to write the quads to, which must have space for MAX_STRING_LENGTH quads.
+ *
+ * @return The number of quads written.
+ */
+int BuildTextGeometry(const GlyphAtlas* atlas, SDL_FRect bounds, const char* text, SDL_Color color, SDL_Vertex* vertices);
+
+/**
+ * @brief Render every printable ASCII character of a font into a glyph atlas texture.
+ *
+ * @param graphicsDataContext A struct containing the graphics data context.
+ * @param font The font to render.
+ * @param atlas A pointer to the atlas to build.
+ *
+ * @return True if success, false otherwise.
+ */
+bool BuildGlyphAtlas(GraphicsDataContext* graphicsDataContext, TTF_Font* font, GlyphAtlas* atlas);
 
 /**
- * @brief Handle events pertaining to a given button object.
+ * @brief Load every block into the block atlas texture (see GraphicsDataContext::blockAtlas).
  *
- * @details This method will update the button states given the correct event has taken place, such as hovering or
- * pressing.
+ * @param graphicsDataContext A struct containing the graphics data context.
+ *
+ * @return True if success, false otherwise.
+ */
+bool BuildBlockAtlas(GraphicsDataContext* graphicsDataContext);
+
+/**
+ * @brief Render a button object onto the screen.
  *
  * @param graphicsDataContext A struct containing the graphics data context.
- * @param event The event to be handled.
- * @param button A pointer to the button to handle events for.
+ * @param button A pointer to the button to render.
+ *
+ * @return True if success, false otherwise.
  */
-void HandleButtonEvent(GraphicsDataContext* graphicsDataContext, SDL_Event* event, Button* button);
+bool RenderButton(GraphicsDataContext* graphicsDataContext, Button* button);
 
 /**
  * @brief Generate an SDL_FRect object based on a grid system that abstracts alignment and resizing.
@@ -283,7 +463,29 @@ void HandleButtonEvent(GraphicsDataContext* graphicsDataContext, SDL_Event* even
  *
  * @return An SDL_FRect object
  */
-SDL_FRect FGridRectToFRect(GraphicsDataContext* graphicsDataContext, FGridRect gridRect, float margin);
+SDL_FRect FGridRectToFRect(const GraphicsDataContext* graphicsDataContext, FGridRect gridRect, float margin);
+
+/**
+ * @brief Generate an SDL_FRect object based on a scaled grid. FGridRectToFRect is this on the window's grid.
+ *
+ * @param grid The grid.
+ * @param gridRect A rectangle on the grid.
+ * @param margin A margin to include within the newly generated FRect within the grid aligned rect.
+ *
+ * @return An SDL_FRect object
+ */
+SDL_FRect ScaledGridRectToFRect(ScaledGrid grid, FGridRect gridRect, float margin);
+
+/**
+ * @brief Place a grid of a given size (in grid squares) as large as possible inside a rectangle, centred.
+ *
+ * @param bounds The rectangle (in pixels) to fit the grid inside.
+ * @param gridWidth The width (in grid squares) of the grid.
+ * @param gridHeight The height (in grid squares) of the grid.
+ *
+ * @return The scaled grid.
+ */
+ScaledGrid FitScaledGrid(SDL_FRect bounds, float gridWidth, float gridHeight);
 
 /**
  * @public
@@ -302,4 +504,14 @@ SDL_FRect FGridRectToFRect(GraphicsDataContext* graphicsDataContext, FGridRect g
  */
 SDL_Texture* GenerateTextTexture(GraphicsDataContext* graphicsDataContext, char* text, TextCache* cache, TTF_Font* font, SDL_Color color);
 
+/**
+ * @public
+ * @brief Estimate the GPU memory used by a texture, assuming 4 bytes per pixel.
+ *
+ * @param texture The texture to measure, or NULL.
+ *
+ * @return The estimated size of the texture in bytes, or 0 if the texture is NULL.
+ */
+Sint64 GetTextureBytes(const SDL_Texture* texture);
+
 #endif //GRAPHICS_H
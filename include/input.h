@@ -0,0 +1,101 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <SDL3/SDL.h>
+
+#include "game.h"
+
+/**
+ * @brief The actions that repeat automatically while their key is held.
+ */
+typedef enum InputAction
+{
+    INPUT_ACTION_LEFT,
+    INPUT_ACTION_RIGHT,
+    INPUT_ACTION_SOFT_DROP,
+    INPUT_ACTION_COUNT,
+} InputAction;
+
+/**
+ * @brief The player's key repeat settings.
+ *
+ * @note See "DAS": https://tetris.wiki/DAS
+ */
+typedef struct InputSettings
+{
+    /** @brief Delayed Auto Shift, the time (in nanoseconds) a shift key must be held before it starts repeating. */
+    Uint64 delayedAutoShiftNS;
+
+    /** @brief Auto Repeat Rate, the time (in nanoseconds) between repeated shifts, where 0 shifts instantly to the wall. */
+    Uint64 autoRepeatRateNS;
+
+    /** @brief The time (in nanoseconds) between repeated soft drops, where 0 drops instantly to the floor. */
+    Uint64 softDropRateNS;
+} InputSettings;
+
+/**
+ * @brief The state of a single held action key.
+ */
+typedef struct HeldKey
+{
+    /** @brief Whether the key is currently held. */
+    bool isHeld;
+
+    /** @brief The event timestamp (in nanoseconds) from which repeats are measured. */
+    Uint64 pressTimestamp;
+
+    /** @brief The number of repeats that have already been applied since pressTimestamp. */
+    Uint64 repeatsApplied;
+} HeldKey;
+
+/**
+ * @brief A struct that holds the current input state: settings and held keys.
+ *
+ * @details It is designed for runtime state tracking.
+ */
+typedef struct InputState
+{
+    /** @brief The player's key repeat settings. */
+    InputSettings settings;
+
+    /** @brief The state of each action key. */
+    HeldKey keys[INPUT_ACTION_COUNT];
+
+    /** @brief The most recently pressed shift action, which takes priority when both shift keys are held. */
+    InputAction activeShift;
+} InputState;
+
+/**
+ * @brief Initialises the input state values.
+ *
+ * @param inputState A struct containing the input state to initialise.
+ * @param settings The player's key repeat settings.
+ */
+void INPUT_Init(InputState* inputState, const InputSettings* settings);
+
+/**
+ * @brief Handle a key press or release of an action key, ignoring the operating system's own key repeats.
+ *
+ * @details A press applies its action immediately. A release first applies any repeats that were due before the
+ * release timestamp, so that a key released between frames repeats exactly as often as it was held for.
+ *
+ * @param inputState A struct containing the input state.
+ * @param gameDataContext A struct containing the game data context.
+ * @param event The key event to handle.
+ *
+ * @return True if the key is an action key and the event was handled, false otherwise.
+ */
+bool INPUT_HandleKeyEvent(InputState* inputState, GameDataContext* gameDataContext, const SDL_KeyboardEvent* event);
+
+/**
+ * @brief Apply every repeat of the held action keys that has become due by a given time.
+ *
+ * @note The number of repeats is calculated from the key event timestamps, so it does not depend on the frame rate.
+ *
+ * @param inputState A struct containing the input state.
+ * @param gameDataContext A struct containing the game data context.
+ * @param timestamp The current time (in nanoseconds, on the same clock as SDL event timestamps).
+ */
+void INPUT_Update(InputState* inputState, GameDataContext* gameDataContext, Uint64 timestamp);
+
+#endif //INPUT_H
@@ -0,0 +1,133 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic latency instrumentation configuration enum values.
+ */
+enum LatencyConfig
+{
+    /** @brief The maximum number of inputs that can be waiting for their frame to be presented. */
+    LATENCY_PENDING_CAPACITY = 64,
+
+    /** @brief The number of most recent latency samples kept for calculating percentiles. */
+    LATENCY_SAMPLE_CAPACITY = 2048,
+};
+
+/**
+ * @brief An input that has been tagged, but whose resulting frame has not yet been presented.
+ */
+typedef struct PendingInput
+{
+    /** @brief The SDL timestamp (in nanoseconds) of the input event. */
+    Uint64 eventTimestamp;
+
+    /** @brief The time (in nanoseconds) the resulting state change was applied, or 0 if it has not been yet. */
+    Uint64 appliedTimestamp;
+} PendingInput;
+
+/**
+ * @brief A summary of a set of latency samples, in nanoseconds.
+ */
+typedef struct LatencyStats
+{
+    int count;
+    Uint64 p50;
+    Uint64 p90;
+    Uint64 p99;
+    Uint64 max;
+} LatencyStats;
+
+/**
+ * @brief A struct that tracks the latency from input events to the presentation of the frames they changed.
+ *
+ * @details Samples are kept in fixed size ring buffers, so tracking never allocates.
+ */
+typedef struct LatencyTracker
+{
+    /** @brief Whether latency instrumentation is enabled. If false, every call is a no-op. */
+    bool isEnabled;
+
+    /** @brief Tagged inputs waiting for their frame to be presented, in event order. */
+    PendingInput pending[LATENCY_PENDING_CAPACITY];
+    int pendingCount;
+
+    /** @brief The latency from each input event to its state change being applied. */
+    Uint64 appliedLatencies[LATENCY_SAMPLE_CAPACITY];
+
+    /** @brief The latency from each input event to the frame containing its state change being presented. */
+    Uint64 presentedLatencies[LATENCY_SAMPLE_CAPACITY];
+
+    /** @brief The number of valid samples, up to LATENCY_SAMPLE_CAPACITY. */
+    int sampleCount;
+
+    /** @brief The index the next sample is written to. */
+    int nextSample;
+
+    /** @brief Scratch space for sorting samples when calculating percentiles. */
+    Uint64 sortBuffer[LATENCY_SAMPLE_CAPACITY];
+} LatencyTracker;
+
+/**
+ * @brief Initialises the latency tracker values.
+ *
+ * @param latencyTracker A struct containing the latency tracker to initialise.
+ * @param isEnabled Whether latency instrumentation is enabled.
+ */
+void LATENCY_Init(LatencyTracker* latencyTracker, bool isEnabled);
+
+/**
+ * @brief Tag an input event, so its latency is measured once its frame is presented.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ * @param eventTimestamp The SDL timestamp (in nanoseconds) of the input event.
+ */
+void LATENCY_TagInput(LatencyTracker* latencyTracker, Uint64 eventTimestamp);
+
+/**
+ * @brief Mark every tagged input, up to and including a given event, whose state change has not yet been applied as
+ * applied.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ * @param lastEventTimestamp The SDL timestamp (in nanoseconds) of the latest input event that has been applied.
+ * @param timestamp The time (in nanoseconds) the state change was applied.
+ */
+void LATENCY_MarkApplied(LatencyTracker* latencyTracker, Uint64 lastEventTimestamp, Uint64 timestamp);
+
+/**
+ * @brief Record a sample for every applied input, as the frame containing its state change has been presented.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ * @param timestamp The time (in nanoseconds) the frame was submitted by SDL_RenderPresent.
+ */
+void LATENCY_MarkPresented(LatencyTracker* latencyTracker, Uint64 timestamp);
+
+/**
+ * @brief Calculate percentiles of the recorded latency samples.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ * @param applied The stats to write the input-to-applied latency to.
+ * @param presented The stats to write the input-to-present latency to.
+ */
+void LATENCY_GetStats(LatencyTracker* latencyTracker, LatencyStats* applied, LatencyStats* presented);
+
+/**
+ * @brief Calculate percentiles of a set of samples.
+ *
+ * @param samples The samples.
+ * @param count The number of samples.
+ * @param sortBuffer Scratch space of at least count values.
+ * @param stats The stats to write to.
+ */
+void LATENCY_CalculateStats(const Uint64* samples, int count, Uint64* sortBuffer, LatencyStats* stats);
+
+/**
+ * @brief Log percentiles of the recorded latency samples.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ */
+void LATENCY_LogStats(LatencyTracker* latencyTracker);
+
+#endif //LATENCY_H
@@ -0,0 +1,230 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "game.h"
+
+/**
+ * @brief Generic lockstep board configuration enum values.
+ */
+enum LockstepConfig
+{
+    /**
+     * @brief The number of boards stored together in a group. Row r of every board in a group is held as sixteen
+     * 16-bit masks side by side, which fill one AVX2 register or two SSE2 registers.
+     */
+    LOCKSTEP_GROUP_SIZE = 16,
+
+    /** @brief The row mask of a row with every column filled. */
+    LOCKSTEP_FULL_ROW = (1 << ARENA_WIDTH) - 1,
+
+    /** @brief The number of implementations (see ::LockstepImplementation). */
+    LOCKSTEP_IMPLEMENTATION_COUNT = 3,
+
+    /** @brief The number of pieces the self-check places in each game by default. */
+    LOCKSTEP_CHECK_ROUNDS = 1000,
+
+    /** @brief The number of random placements the self-check tries for each piece, keeping the one that lands lowest. */
+    LOCKSTEP_CHECK_CANDIDATES = 4,
+};
+
+/**
+ * @brief The instruction sets the lockstep kernels can be run with. Every implementation gives the same results.
+ */
+typedef enum LockstepImplementation
+{
+    LOCKSTEP_SCALAR,
+    LOCKSTEP_SSE2,
+    LOCKSTEP_AVX2,
+} LockstepImplementation;
+
+/**
+ * @brief A group of LOCKSTEP_GROUP_SIZE boards in struct-of-arrays form, where each board is a lane.
+ *
+ * @details A board only tracks which arena cells are filled, as a mask per row with bit c set when column c is
+ * filled, which is all that collision, locking and line clearing depend on. Every array is indexed by lane last, so
+ * that the same field of every board in the group can be loaded into a vector register at once.
+ */
+typedef struct LockstepGroup
+{
+    /** @brief The row masks of each board's arena, from the top row down. */
+    Uint16 rows[ARENA_HEIGHT][LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The row masks of each board's dropping tetromino, from the top of its matrix, shifted to its column. */
+    Uint16 pieceRows[TETROMINO_MAX_SIZE][LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The position of each board's dropping tetromino (see ::DroppingTetromino). */
+    Sint16 x[LOCKSTEP_GROUP_SIZE];
+    Sint16 y[LOCKSTEP_GROUP_SIZE];
+
+    /** @brief 0xFFFF for each board still being played, or 0 for a board whose game is over or an unused lane. */
+    Uint16 isPlaying[LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The total number of lines each board has cleared. */
+    Uint16 linesCleared[LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The ::TetrominoIdentifier and orientation of each board's dropping tetromino. */
+    Uint8 identifier[LOCKSTEP_GROUP_SIZE];
+    Uint8 orientation[LOCKSTEP_GROUP_SIZE];
+} LockstepGroup;
+
+/**
+ * @brief Any number of boards, stepped in lockstep so that every operation runs on all of them at once.
+ *
+ * @details Operations mirror the game's own: LOCKSTEP_WillCollide matches WillDroppingTetrominoCollide, and
+ * LOCKSTEP_Lock matches ResetDroppingTetromino (and through it ClearLines) for games without garbage. The results are
+ * bit-identical for any arena reachable by play, where no empty row ever lies below a filled one.
+ */
+typedef struct LockstepBoards
+{
+    /** @brief The number of boards. */
+    int count;
+
+    /** @brief The number of groups, the last of which may have unused lanes. */
+    int groupCount;
+
+    /** @brief The groups, aligned to 32 bytes. */
+    LockstepGroup* groups;
+
+    /** @brief The instruction set the kernels run with. */
+    LockstepImplementation implementation;
+
+    /** @brief The 4-bit row masks of every tetromino, indexed by ::TetrominoIdentifier, orientation and row. */
+    Uint8 shapeRows[TETROMINO_COUNT + 1][4][TETROMINO_MAX_SIZE];
+} LockstepBoards;
+
+/**
+ * @brief The outcome of a differential self-check of every available implementation against the game's own rules.
+ */
+typedef struct LockstepCheckResult
+{
+    /** @brief The number of pieces locked on each implementation, and by the reference games. */
+    Uint64 pieces;
+
+    /** @brief The total number of lines cleared by the reference games. */
+    Uint64 linesCleared;
+
+    /** @brief The time (in nanoseconds) spent dropping and locking pieces with each implementation. */
+    Uint64 implementationNS[LOCKSTEP_IMPLEMENTATION_COUNT];
+
+    /** @brief The time (in nanoseconds) spent dropping and locking pieces in GameDataContext instances. */
+    Uint64 referenceNS;
+
+    /** @brief Whether each implementation was checked, as not every CPU supports every instruction set. */
+    bool isChecked[LOCKSTEP_IMPLEMENTATION_COUNT];
+
+    /** @brief What differed first, or NULL if every implementation matched the reference throughout. */
+    const char* mismatch;
+
+    /** @brief The implementation, board and round of the first mismatch. */
+    LockstepImplementation mismatchImplementation;
+    int mismatchBoard;
+    int mismatchRound;
+} LockstepCheckResult;
+
+/**
+ * @brief Get the fastest implementation the CPU supports.
+ *
+ * @return The implementation.
+ */
+LockstepImplementation LOCKSTEP_GetBestImplementation(void);
+
+/**
+ * @brief Get the name of an implementation, for logging.
+ *
+ * @param implementation The implementation.
+ *
+ * @return The name.
+ */
+const char* LOCKSTEP_GetImplementationName(LockstepImplementation implementation);
+
+/**
+ * @brief Allocate a set of boards, each with an empty arena and no game in play until one is loaded.
+ *
+ * @param boards A pointer to the boards to initialise.
+ * @param count The number of boards.
+ * @param implementation The instruction set to run the kernels with, which the CPU must support.
+ *
+ * @return True on success, false otherwise.
+ */
+bool LOCKSTEP_Init(LockstepBoards* boards, int count, LockstepImplementation implementation);
+
+/**
+ * @brief Free a set of boards.
+ *
+ * @param boards A pointer to the boards to destroy.
+ */
+void LOCKSTEP_Destroy(LockstepBoards* boards);
+
+/**
+ * @brief Copy a game's arena, dropping tetromino, lines cleared and whether it is over into a board.
+ *
+ * @param boards A pointer to the boards.
+ * @param index The index of the board.
+ * @param gameDataContext A struct containing the game data to copy.
+ */
+void LOCKSTEP_LoadGame(LockstepBoards* boards, int index, const GameDataContext* gameDataContext);
+
+/**
+ * @brief Get the row masks of a board's arena.
+ *
+ * @param boards A pointer to the boards.
+ * @param index The index of the board.
+ * @param rows The array to write the row masks to, from the top row down.
+ */
+void LOCKSTEP_GetRows(const LockstepBoards* boards, int index, Uint16 rows[ARENA_HEIGHT]);
+
+/**
+ * @brief Move a board's dropping tetromino, without checking whether it fits.
+ *
+ * @param boards A pointer to the boards.
+ * @param index The index of the board.
+ * @param x The new x-coordinate.
+ * @param y The new y-coordinate.
+ * @param orientation The new orientation.
+ */
+void LOCKSTEP_SetPiece(LockstepBoards* boards, int index, int x, int y, int orientation);
+
+/**
+ * @brief Check whether each board's dropping tetromino would collide with its arena bounds or stack if moved and
+ * rotated by the same amounts, as WillDroppingTetrominoCollide does for a single game.
+ *
+ * @param boards A pointer to the boards.
+ * @param translationX How far to move each tetromino horizontally.
+ * @param translationY How far to move each tetromino vertically.
+ * @param rotationAmount How many quarter turns clockwise to rotate each tetromino.
+ * @param collisions An array of one byte per board, to write whether each would collide to.
+ */
+void LOCKSTEP_WillCollide(const LockstepBoards* boards, int translationX, int translationY, int rotationAmount, Uint8* collisions);
+
+/**
+ * @brief Move the dropping tetromino of every board in play down until it would collide, stepping every board down
+ * one row at a time until none can move.
+ *
+ * @param boards A pointer to the boards.
+ */
+void LOCKSTEP_HardDrop(LockstepBoards* boards);
+
+/**
+ * @brief Lock the dropping tetromino of every board in play into its arena, clear any filled rows and spawn the next
+ * tetromino, as ResetDroppingTetromino does for a single game. A board whose next tetromino collides on spawning is
+ * over, and is left untouched by every later operation until it is loaded again.
+ *
+ * @param boards A pointer to the boards.
+ * @param nextIdentifiers The ::TetrominoIdentifier of the tetromino to spawn on each board, one byte per board.
+ */
+void LOCKSTEP_Lock(LockstepBoards* boards, const Uint8* nextIdentifiers);
+
+/**
+ * @brief Play games with random placements on every available implementation and in GameDataContext instances side
+ * by side, checking after every step that collisions, drops, locks, line clears and spawns all match.
+ *
+ * @param boardCount The number of games played at once.
+ * @param rounds The number of pieces placed in each game.
+ * @param seed The seed of the first game. Game n uses seed + n, and each new game after a loss adds boardCount.
+ * @param result A pointer to the result to write to.
+ *
+ * @return True if every implementation matched the reference, false otherwise.
+ */
+bool LOCKSTEP_RunSelfCheck(int boardCount, int rounds, Uint64 seed, LockstepCheckResult* result);
+
+#endif //LOCKSTEP_H
@@ -0,0 +1,131 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Monotonic event counters. Each thread counts into its own block, and blocks are summed when read.
+ */
+typedef enum MetricCounter
+{
+    METRIC_COLLISION_CHECKS,
+    METRIC_ROTATIONS,
+    METRIC_WALL_KICK_ATTEMPTS,
+    METRIC_SINGLES,
+    METRIC_DOUBLES,
+    METRIC_TRIPLES,
+    METRIC_TETRISES,
+    METRIC_TEXT_CACHE_HITS,
+    METRIC_TEXT_CACHE_MISSES,
+    METRIC_DRAW_CALLS,
+    METRIC_FRAMES_RENDERED,
+
+    /** @brief Frames where rendering was skipped because the window was minimised or occluded. */
+    METRIC_FRAMES_SKIPPED,
+
+    METRIC_PIECES_LOCKED,
+
+    /** @brief Allocations made through SDL, counted at the end of each frame. */
+    METRIC_ALLOCATIONS,
+
+    /** @brief Lookups in a search transposition table, and how many of them found the position. */
+    METRIC_TRANSPOSITION_PROBES,
+    METRIC_TRANSPOSITION_HITS,
+
+    METRIC_COUNTER_COUNT,
+} MetricCounter;
+
+/**
+ * @brief Gauges, which can go up and down. Each thread's value is summed when read.
+ */
+typedef enum MetricGauge
+{
+    /** @brief The estimated GPU memory used by every texture currently loaded. */
+    METRIC_GAUGE_TEXTURE_BYTES,
+
+    METRIC_GAUGE_COLLISION_CHECKS_LAST_FRAME,
+    METRIC_GAUGE_DRAW_CALLS_LAST_FRAME,
+
+    /** @brief The number of live particle effect particles. */
+    METRIC_GAUGE_LIVE_PARTICLES,
+
+    METRIC_GAUGE_COUNT,
+} MetricGauge;
+
+/**
+ * @brief The merged value of every counter and gauge, along with rates derived from them.
+ */
+typedef struct MetricsSnapshot
+{
+    Uint64 counters[METRIC_COUNTER_COUNT];
+    Sint64 gauges[METRIC_GAUGE_COUNT];
+
+    /** @brief The time (in nanoseconds) since the metrics were initialised. */
+    Uint64 elapsedNS;
+
+    double piecesPerMinute;
+    double wallKickAttemptsPerRotation;
+    double collisionChecksPerFrame;
+    double drawCallsPerFrame;
+} MetricsSnapshot;
+
+/**
+ * @brief Start the clock used for rates such as pieces per minute.
+ */
+void METRICS_Init(void);
+
+/**
+ * @brief Add to a counter on the calling thread.
+ *
+ * @param counter The counter to add to.
+ * @param amount The amount to add.
+ */
+void METRICS_Add(MetricCounter counter, Uint64 amount);
+
+/**
+ * @brief Add to (or, with a negative amount, subtract from) a gauge on the calling thread.
+ *
+ * @param gauge The gauge to change.
+ * @param amount The amount to add.
+ */
+void METRICS_AddGauge(MetricGauge gauge, Sint64 amount);
+
+/**
+ * @brief Publish the calling thread's counters and gauges, so that METRICS_Read sees them. Long-running threads call
+ * this once per unit of work (e.g. a simulation step). A thread's final values are published when it exits.
+ */
+void METRICS_Flush(void);
+
+/**
+ * @brief Finish a frame on the render thread, updating the frame counters and the last frame gauges (which count the
+ * events of every thread since the previous frame), then publish the thread's values.
+ *
+ * @param isRendered Whether the frame was rendered, or skipped.
+ */
+void METRICS_EndFrame(bool isRendered);
+
+/**
+ * @brief Merge every thread's counters and gauges.
+ *
+ * @note Counters from other threads that are still running are as of their last METRICS_Flush.
+ *
+ * @param snapshot A pointer to the snapshot to write to.
+ */
+void METRICS_Read(MetricsSnapshot* snapshot);
+
+/**
+ * @brief Log every counter, gauge and derived rate.
+ */
+void METRICS_Log(void);
+
+/**
+ * @brief Write every counter, gauge and derived rate to a JSON file.
+ *
+ * @param path The path of the JSON file to write.
+ *
+ * @return True on success, false otherwise.
+ */
+bool METRICS_WriteJSON(const char* path);
+
+#endif //METRICS_H
@@ -0,0 +1,143 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "graphics.h"
+
+/**
+ * @brief Generic particle system configuration enum values.
+ */
+enum ParticlesConfig
+{
+    /** @brief The maximum number of live particles. This must be a multiple of 4, the width of the update step. */
+    PARTICLES_CAPACITY = 4096,
+
+    /** @brief The number of effects that can be waiting to be spawned. This must be a power of two. */
+    PARTICLES_TRIGGER_CAPACITY = 64,
+
+    /** @brief The number of particles spawned from each cell of a cleared row. */
+    PARTICLES_PER_CLEARED_CELL = 12,
+
+    /** @brief The number of particles spawned from each block of a hard dropped tetromino. */
+    PARTICLES_PER_DROPPED_BLOCK = 24,
+
+    /** @brief The time (in nanoseconds) spawning, updating and drawing particles may take each frame. */
+    PARTICLES_BUDGET_NS = 500000,
+
+    /** @brief The longest time (in nanoseconds) a single update advances particles by, so a stall does not teleport them. */
+    PARTICLES_MAX_STEP_NS = 50000000,
+};
+
+/**
+ * @brief A fixed-capacity pool of particles for line clear and hard drop effects, owned by the render thread.
+ *
+ * @details Particles are stored as a struct of arrays, so the update step advances four of them at once with SSE2 (or
+ * one at a time without it), and a dead particle is replaced by the last live one so the live particles stay packed.
+ * Every live particle is drawn as a quad in a single SDL_RenderGeometry call. Effects are triggered by game events,
+ * which arrive on the simulation thread, so they are passed over through a wait-free single producer, single consumer
+ * queue and spawned on the next update. Nothing is allocated after PARTICLES_Init.
+ *
+ * While the last frame's particle work went over PARTICLES_BUDGET_NS, each new effect spawns fewer particles, so the
+ * cost of effects stays within the budget however many are triggered at once.
+ */
+typedef struct ParticleSystem
+{
+    /** @brief The position and velocity of each particle, in grid squares and grid squares per second. */
+    float* x;
+    float* y;
+    float* velocityX;
+    float* velocityY;
+
+    /** @brief The time (in seconds) each particle has left to live. */
+    float* life;
+
+    /** @brief The reciprocal of each particle's lifetime, so that life * fade goes from 1 down to 0. */
+    float* fade;
+
+    /** @brief The colour of each particle, as an index into the palette. */
+    Uint8* color;
+
+    /** @brief The number of live particles, which are always the first count in every array. */
+    int count;
+
+    /** @brief The vertices of the particles' quads, rebuilt each frame, and their indices, built once. */
+    SDL_Vertex* vertices;
+    int* indices;
+
+    /** @brief The effects waiting to be spawned. Only the game thread writes tail, and only the render thread head. */
+    GameEvent triggers[PARTICLES_TRIGGER_CAPACITY];
+    SDL_AtomicInt triggerHead;
+    SDL_AtomicInt triggerTail;
+
+    /** @brief The number of effects dropped because the queue was full, or particles because the pool was full. */
+    SDL_AtomicInt droppedTriggers;
+    Uint64 droppedParticles;
+
+    /** @brief The fraction of each effect's particles that are spawned, lowered while particles go over budget. */
+    float spawnScale;
+
+    /** @brief The time (in nanoseconds) spent on particles in the last frame. */
+    Uint64 lastCostNS;
+
+    /** @brief The time (in nanoseconds, from SDL_GetTicksNS) of the last update, or 0 before the first. */
+    Uint64 lastUpdateNS;
+
+    /** @brief The time (in nanoseconds, from SDL_GetTicksNS) the current frame's particle work started. */
+    Uint64 frameStartNS;
+
+    /** @brief The state of the random number generator used to scatter particles. */
+    Uint64 randomState;
+
+    /** @brief Whether the CPU supports SSE2, checked once. */
+    bool hasSSE2;
+} ParticleSystem;
+
+/**
+ * @brief Allocate a particle pool, with no live particles.
+ *
+ * @param particles A pointer to the particle system to initialise.
+ * @param seed The seed used to scatter particles.
+ *
+ * @return True on success, false otherwise.
+ */
+bool PARTICLES_Init(ParticleSystem* particles, Uint64 seed);
+
+/**
+ * @brief Free a particle pool.
+ *
+ * @param particles A pointer to the particle system to destroy.
+ */
+void PARTICLES_Destroy(ParticleSystem* particles);
+
+/**
+ * @brief Queue the effect of a game event, if it has one. This is a ::GameEventListener, to be added to a game with
+ * the particle system as its user data (see GAME_AddEventListener). It never blocks or allocates.
+ *
+ * @param userData A pointer to the particle system.
+ * @param event The event.
+ */
+void PARTICLES_Listen(void* userData, const GameEvent* event);
+
+/**
+ * @brief Spawn every queued effect, then advance every particle and remove those that have died. Only call this from
+ * the render thread, once per frame before PARTICLES_Draw.
+ *
+ * @param particles A pointer to the particle system.
+ * @param nowNS The current time (in nanoseconds, from SDL_GetTicksNS).
+ */
+void PARTICLES_Update(ParticleSystem* particles, Uint64 nowNS);
+
+/**
+ * @brief Draw every live particle over the arena in a single SDL_RenderGeometry call.
+ *
+ * @param particles A pointer to the particle system.
+ * @param graphicsDataContext A struct containing the graphics data context.
+ *
+ * @return True on success, false otherwise.
+ */
+bool PARTICLES_Draw(ParticleSystem* particles, GraphicsDataContext* graphicsDataContext);
+
+#endif //PARTICLES_H
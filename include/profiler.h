@@ -0,0 +1,119 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "graphics.h"
+
+/**
+ * @brief Generic profiler configuration enum values.
+ */
+enum ProfilerConfig
+{
+    /** @brief The number of most recent frames kept in the profiler's ring buffers. */
+    PROFILER_FRAME_CAPACITY = 240,
+};
+
+/**
+ * @brief The stages of a frame that are timed by the profiler.
+ */
+typedef enum ProfilerStage
+{
+    /** @brief The longest simulation step in the drawn snapshot, which is timed on the simulation thread. */
+    PROFILER_STAGE_GAME_ITERATION,
+    PROFILER_STAGE_DRAW_ARENA,
+    PROFILER_STAGE_DRAW_DROPPING_TETROMINO,
+    PROFILER_STAGE_DRAW_DROPPING_TETROMINO_GHOST,
+    PROFILER_STAGE_DRAW_SIDEBAR,
+    PROFILER_STAGE_TEXT_CACHE_MISS,
+    PROFILER_STAGE_RENDER_PRESENT,
+
+    /** @brief Spawning, updating and drawing particle effects. */
+    PROFILER_STAGE_DRAW_EFFECTS,
+
+    /** @brief The whole frame, from the start of one frame to the start of the next. */
+    PROFILER_STAGE_FRAME,
+
+    PROFILER_STAGE_COUNT,
+} ProfilerStage;
+
+/**
+ * @brief A summary of a stage's timings over the frames in the ring buffer, in nanoseconds.
+ */
+typedef struct ProfilerStats
+{
+    Uint64 min;
+    Uint64 average;
+    Uint64 p99;
+
+    /** @brief The number of frames over the stage's budget, or 0 if it has none (see PROFILER_SetStageBudget). */
+    int overBudget;
+} ProfilerStats;
+
+/**
+ * @brief Start a new frame, closing the previous one.
+ */
+void PROFILER_BeginFrame(void);
+
+/**
+ * @brief Start timing a stage of the current frame.
+ *
+ * @param stage The stage to time.
+ */
+void PROFILER_BeginStage(ProfilerStage stage);
+
+/**
+ * @brief Stop timing a stage of the current frame, adding the elapsed time to the stage's total for the frame.
+ *
+ * @note A stage may be timed several times in one frame, such as multiple text cache misses.
+ *
+ * @param stage The stage to stop timing.
+ */
+void PROFILER_EndStage(ProfilerStage stage);
+
+/**
+ * @brief Record the time of a stage that was timed elsewhere (e.g. on another thread) for the current frame.
+ *
+ * @param stage The stage.
+ * @param timeNS The time (in nanoseconds) to add to the stage's total for the frame.
+ */
+void PROFILER_RecordStage(ProfilerStage stage, Uint64 timeNS);
+
+/**
+ * @brief Count a draw call made by the current frame.
+ */
+void PROFILER_CountDrawCall(void);
+
+/**
+ * @brief Calculate the min, average and 99th percentile timings of a stage over the frames in the ring buffer.
+ *
+ * @param stage The stage.
+ * @param stats A pointer to the stats to write to.
+ */
+void PROFILER_GetStageStats(ProfilerStage stage, ProfilerStats* stats);
+
+/**
+ * @brief Set the time a stage may take each frame. The overlay shows the budget, and how many frames went over it.
+ *
+ * @param stage The stage.
+ * @param budgetNS The budget (in nanoseconds), or 0 for none.
+ */
+void PROFILER_SetStageBudget(ProfilerStage stage, Uint64 budgetNS);
+
+/**
+ * @brief Toggle whether the profiler overlay is visible.
+ */
+void PROFILER_ToggleOverlay(void);
+
+/**
+ * @brief Draw the profiler overlay, a rolling frame time graph and per-stage timings, if it is visible.
+ *
+ * @param graphicsDataContext A struct containing the graphics data context.
+ * @param fonts A pointer to a struct of fonts to use.
+ *
+ * @return True on success, false otherwise.
+ */
+bool PROFILER_DrawOverlay(GraphicsDataContext* graphicsDataContext, const Fonts* fonts);
+
+#endif //PROFILER_H
@@ -0,0 +1,160 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "input.h"
+#include "simulation.h"
+
+/**
+ * @brief Generic replay configuration enum values.
+ */
+enum ReplayConfig
+{
+    /** @brief The first four bytes of a replay file, "TTRP" when read as little endian. */
+    REPLAY_MAGIC = 0x50525454,
+
+    /** @brief The version of the replay file format. */
+    REPLAY_VERSION = 1,
+};
+
+/**
+ * @brief Everything needed to play a replay back, other than its commands.
+ */
+typedef struct ReplayHeader
+{
+    /** @brief The tick rate the replay was recorded at, which must match SIM_TICK_RATE to play it back. */
+    Uint32 tickRate;
+
+    /** @brief The number of commands in the replay. */
+    Uint32 eventCount;
+
+    /** @brief The seed of the first game. Each restart records the seed of the next game. */
+    Uint64 seed;
+
+    /** @brief The number of ticks the replay lasts. */
+    Uint64 tickCount;
+
+    /** @brief The player's key repeat settings, which change how held keys are applied. */
+    InputSettings inputSettings;
+
+    /** @brief The score at the end of the recording, to check that playing it back gives the same game. */
+    Uint32 finalScore;
+} ReplayHeader;
+
+/**
+ * @brief A command, and the tick it was applied before.
+ */
+typedef struct ReplayEvent
+{
+    Uint64 tick;
+    SimCommand command;
+} ReplayEvent;
+
+/**
+ * @brief A replay being recorded, which streams every command to a file as it is applied.
+ */
+typedef struct ReplayRecorder
+{
+    SDL_IOStream* stream;
+    ReplayHeader header;
+} ReplayRecorder;
+
+/**
+ * @brief A replay loaded into memory.
+ */
+typedef struct Replay
+{
+    ReplayHeader header;
+
+    /** @brief The commands, in the order they were applied. */
+    ReplayEvent* events;
+} Replay;
+
+/**
+ * @brief A game being played back from a replay.
+ */
+typedef struct ReplayPlayer
+{
+    const Replay* replay;
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+    InputState inputState;
+
+    /** @brief The number of ticks played back so far. */
+    Uint64 tick;
+
+    /** @brief The index of the next command to apply. */
+    Uint32 nextEvent;
+} ReplayPlayer;
+
+/**
+ * @brief Open a replay file and write its header. Commands are then written as they are recorded.
+ *
+ * @param recorder A pointer to the recorder to initialise.
+ * @param path The path of the replay file to write.
+ * @param seed The seed of the game being recorded.
+ * @param inputSettings The player's key repeat settings.
+ *
+ * @return True on success, false otherwise.
+ */
+bool REPLAY_BeginRecording(ReplayRecorder* recorder, const char* path, Uint64 seed, const InputSettings* inputSettings);
+
+/**
+ * @brief Write a command to the replay file. This never allocates, so it can be called during play.
+ *
+ * @param recorder A pointer to the recorder.
+ * @param tick The tick the command was applied before.
+ * @param command The command, as it was applied.
+ */
+void REPLAY_RecordCommand(ReplayRecorder* recorder, Uint64 tick, const SimCommand* command);
+
+/**
+ * @brief Finish the replay file, filling in its length and final score, and close it.
+ *
+ * @param recorder A pointer to the recorder.
+ * @param tickCount The number of ticks recorded.
+ * @param finalScore The score at the end of the recording.
+ *
+ * @return True on success, false otherwise.
+ */
+bool REPLAY_EndRecording(ReplayRecorder* recorder, Uint64 tickCount, int finalScore);
+
+/**
+ * @brief Load a replay file into memory.
+ *
+ * @param replay A pointer to the replay to load into.
+ * @param path The path of the replay file.
+ *
+ * @return True on success, false otherwise.
+ */
+bool REPLAY_Load(Replay* replay, const char* path);
+
+/**
+ * @brief Free a replay loaded with REPLAY_Load.
+ *
+ * @param replay A pointer to the replay.
+ */
+void REPLAY_Destroy(Replay* replay);
+
+/**
+ * @brief Start playing a replay back from its first tick.
+ *
+ * @param player A pointer to the player to initialise.
+ * @param replay The replay to play back, which must outlive the player.
+ *
+ * @return True on success, false otherwise.
+ */
+bool REPLAY_StartPlayback(ReplayPlayer* player, const Replay* replay);
+
+/**
+ * @brief Play a replay forward until a given number of ticks have been played. Playback never goes backwards.
+ *
+ * @param player A pointer to the player.
+ * @param tick The number of ticks to have played, which is clamped to the length of the replay.
+ */
+void REPLAY_AdvanceTo(ReplayPlayer* player, Uint64 tick);
+
+#endif //REPLAY_H
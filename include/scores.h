@@ -0,0 +1,212 @@
+#ifndef SCORES_H
+#define SCORES_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+/**
+ * @brief Generic score store configuration enum values.
+ */
+enum ScoresConfig
+{
+    /** @brief The first four bytes of a score log, "TSCR" when read as little endian. */
+    SCORES_MAGIC = 0x52435354,
+
+    /** @brief The version of the score log format. */
+    SCORES_VERSION = 1,
+
+    /** @brief The size (in bytes) of the log's header. */
+    SCORES_HEADER_SIZE = 8,
+
+    /** @brief The size (in bytes) of every record in the log, including its trailing CRC-32. */
+    SCORES_RECORD_SIZE = 64,
+
+    /** @brief The number of best games kept in the high score table. */
+    SCORES_TOP_COUNT = 10,
+
+    /** @brief The number of most recent games whose records compaction keeps, on top of the high scores. */
+    SCORES_KEEP_RECENT = 65536,
+
+    /** @brief The number of records the log may hold before it is compacted. */
+    SCORES_COMPACT_RECORDS = 2 * SCORES_KEEP_RECENT,
+
+    /** @brief The number of finished games that can be waiting to be written. This must be a power of two. */
+    SCORES_QUEUE_CAPACITY = 64,
+
+    /** @brief The number of tables in the triple buffer. */
+    SCORES_TABLE_COUNT = 3,
+
+    /** @brief The flag set on the shared table index when it holds a table the render thread has not seen. */
+    SCORES_TABLE_FRESH = 4,
+};
+
+/**
+ * @brief The kinds of record in the log.
+ */
+typedef enum ScoreRecordKind
+{
+    /** @brief A single finished game. */
+    SCORES_RECORD_GAME = 1,
+
+    /** @brief The totals of every game compaction has removed from the log, of which there is at most one. */
+    SCORES_RECORD_TOTALS = 2,
+} ScoreRecordKind;
+
+/**
+ * @brief The statistics of a single finished game.
+ */
+typedef struct ScoreRecord
+{
+    Uint32 score;
+    Uint32 level;
+    Uint32 lines;
+    Uint32 pieces;
+
+    /** @brief The game clock time (in nanoseconds) the game lasted, which excludes time spent paused. */
+    Uint64 durationNS;
+
+    /** @brief The seed the game was started with, so that it can be told apart from others with the same score. */
+    Uint64 seed;
+
+    /** @brief The time the game ended, as an ::SDL_Time. */
+    Sint64 finishedAt;
+} ScoreRecord;
+
+/**
+ * @brief Statistics summed across many games.
+ */
+typedef struct ScoreTotals
+{
+    Uint64 games;
+    Uint64 lines;
+    Uint64 pieces;
+    Uint64 durationNS;
+} ScoreTotals;
+
+/**
+ * @brief An immutable copy of the high score table, published by the writer thread for the render thread.
+ */
+typedef struct ScoreTable
+{
+    /** @brief The best games, highest score first, where earlier games rank above later ones with the same score. */
+    ScoreRecord top[SCORES_TOP_COUNT];
+
+    /** @brief The number of games in top. */
+    int topCount;
+
+    /** @brief The totals across every game ever recorded, including those compaction has removed from the log. */
+    ScoreTotals totals;
+} ScoreTable;
+
+/**
+ * @brief A persistent store of finished games, written to an append-only log of checksummed records.
+ *
+ * @details Finished games are handed over through a wait-free single producer, single consumer queue, and a writer
+ * thread appends them to the log, so the game never waits on the disk. Each record is flushed as soon as it is
+ * written, and a record cut short by a crash fails its checksum, so reopening the log keeps every game before it. The
+ * writer keeps the high score table indexed as games arrive and publishes it through a triple buffer, so reading it
+ * costs nothing however many games have been recorded.
+ */
+typedef struct ScoreStore
+{
+    /** @brief The path of the log. */
+    char path[1024];
+
+    /** @brief The log, opened for appending, which only the writer thread may access while it is running. */
+    SDL_IOStream* stream;
+
+    /** @brief The number of records in the log, which only the writer thread may access while it is running. */
+    int recordCount;
+
+    /** @brief The totals of the games compaction has removed from the log. */
+    ScoreTotals compactedTotals;
+
+    /** @brief The table being kept up to date by the writer thread. */
+    ScoreTable table;
+
+    /** @brief The finished games waiting to be written. Only the game thread writes tail, and only the writer head. */
+    ScoreRecord queue[SCORES_QUEUE_CAPACITY];
+    SDL_AtomicInt head;
+    SDL_AtomicInt tail;
+
+    /** @brief The number of finished games dropped because the queue was full. */
+    SDL_AtomicInt droppedRecords;
+
+    /** @brief The triple buffer of tables. */
+    ScoreTable tables[SCORES_TABLE_COUNT];
+
+    /** @brief The index of the table shared between the threads, with SCORES_TABLE_FRESH set if it is new. */
+    SDL_AtomicInt sharedTable;
+
+    /** @brief The index of the table being written, owned by the writer thread. */
+    int backTable;
+
+    /** @brief The index of the table being read, owned by the render thread. */
+    int frontTable;
+
+    /** @brief Signalled once for every game queued, and when the writer thread should stop. */
+    SDL_Semaphore* pending;
+
+    SDL_AtomicInt isStopping;
+    SDL_Thread* thread;
+} ScoreStore;
+
+/**
+ * @brief Open a score log, creating it if needed, index its games and start the writer thread.
+ *
+ * @details The log is memory-mapped and read once. Reading stops at the first record that is cut short or fails its
+ * checksum, in which case the log is compacted straight away to drop the damaged tail.
+ *
+ * @param store A pointer to the store to open.
+ * @param path The path of the log.
+ *
+ * @return True on success, false otherwise.
+ */
+bool SCORES_Open(ScoreStore* store, const char* path);
+
+/**
+ * @brief Write every queued game, stop the writer thread and close the log.
+ *
+ * @param store A pointer to the store to close.
+ */
+void SCORES_Close(ScoreStore* store);
+
+/**
+ * @brief Queue a finished game to be written. This never blocks or allocates, so it can be called from the game
+ * thread. Only one thread may submit games to a store.
+ *
+ * @param store A pointer to the store.
+ * @param gameDataContext A struct containing the game data of the finished game.
+ *
+ * @return True on success, false if the queue was full and the game was dropped.
+ */
+bool SCORES_Submit(ScoreStore* store, const GameDataContext* gameDataContext);
+
+/**
+ * @brief Get the latest high score table, without blocking. Only call this from the render (main) thread.
+ *
+ * @note The table remains valid, and unchanged, until the next call.
+ *
+ * @param store A pointer to the store.
+ *
+ * @return A pointer to the latest table.
+ */
+const ScoreTable* SCORES_AcquireTable(ScoreStore* store);
+
+/**
+ * @brief Rewrite the log to hold only the high scores, the SCORES_KEEP_RECENT most recent games and a single record
+ * of the totals of every other game. The new log is written beside the old one and then renamed over it, so a crash
+ * part way through leaves the old log as it was.
+ *
+ * @note This is called by the writer thread once the log reaches SCORES_COMPACT_RECORDS records, and must not be
+ * called while the writer thread is running.
+ *
+ * @param store A pointer to the store.
+ *
+ * @return True on success, false otherwise.
+ */
+bool SCORES_Compact(ScoreStore* store);
+
+#endif //SCORES_H
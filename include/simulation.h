@@ -0,0 +1,257 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "input.h"
+
+/**
+ * @brief Generic simulation configuration enum values.
+ */
+enum SimulationConfig
+{
+    /** @brief The number of times per second the simulation thread steps the game. */
+    SIM_TICK_RATE = 240,
+
+    /** @brief The time (in nanoseconds) between ticks, which is also how far the simulation's own timeline moves per tick. */
+    SIM_TICK_NS = 1000000000 / SIM_TICK_RATE,
+
+    /** @brief The maximum number of ticks the simulation runs back-to-back to catch up after falling behind. */
+    SIM_MAX_CATCH_UP_TICKS = 24,
+
+    /** @brief The number of commands the input queue can hold. This must be a power of two. */
+    SIM_INPUT_QUEUE_CAPACITY = 256,
+
+    /** @brief The number of snapshots in the triple buffer. */
+    SIM_SNAPSHOT_COUNT = 3,
+
+    /** @brief The flag set on the shared snapshot index when it holds a snapshot the render thread has not seen. */
+    SIM_SNAPSHOT_FRESH = 4,
+};
+
+/**
+ * @brief The types of command sent from the main thread to the simulation thread.
+ */
+typedef enum SimCommandType
+{
+    /** @brief A key press or release, which is mapped to a game action on the simulation thread. */
+    SIM_COMMAND_KEY,
+    SIM_COMMAND_TOGGLE_PAUSE,
+    SIM_COMMAND_RESTART,
+    SIM_COMMAND_QUIT,
+} SimCommandType;
+
+/**
+ * @brief A command sent from the main thread to the simulation thread.
+ */
+typedef struct SimCommand
+{
+    SimCommandType type;
+
+    /**
+     * @brief The time (in nanoseconds) of the command, which is the event timestamp for key commands.
+     * @details Once applied, this is moved onto the simulation's own timeline, where tick n is at n * SIM_TICK_NS.
+     */
+    Uint64 timestamp;
+
+    /** @brief The key event, for SIM_COMMAND_KEY. */
+    SDL_KeyboardEvent key;
+
+    /** @brief The seed of the new game, for SIM_COMMAND_RESTART. This is chosen when the command is applied. */
+    Uint64 seed;
+} SimCommand;
+
+struct ReplayRecorder;
+struct BotSearch;
+struct ScoreStore;
+struct SpectateServer;
+
+/**
+ * @brief A wait-free single producer, single consumer ring buffer of commands.
+ *
+ * @details Only the main thread writes tail, and only the simulation thread writes head, so neither ever waits on
+ * the other. The indices increase forever and are wrapped when used.
+ */
+typedef struct InputQueue
+{
+    SimCommand commands[SIM_INPUT_QUEUE_CAPACITY];
+    SDL_AtomicInt head;
+    SDL_AtomicInt tail;
+} InputQueue;
+
+/**
+ * @brief An immutable copy of the game state, published by the simulation thread for the render thread.
+ */
+typedef struct GameSnapshot
+{
+    /** @brief A copy of the game, whose droppingTetromino points to the copy below and whose opponent is NULL. */
+    GameDataContext game;
+
+    /** @brief A copy of the dropping tetromino. */
+    DroppingTetromino droppingTetromino;
+
+    /** @brief The number of ticks the simulation had run when the snapshot was published. */
+    Uint64 tick;
+
+    /** @brief The event timestamp (in nanoseconds) of the latest input applied to this snapshot, or 0 if none. */
+    Uint64 lastInputTimestamp;
+
+    /** @brief The time (in nanoseconds) the snapshot was published. */
+    Uint64 publishTimestamp;
+
+    /** @brief The longest time (in nanoseconds) a step took since the previous snapshot was published. */
+    Uint64 worstStepNS;
+} GameSnapshot;
+
+/**
+ * @brief A game running on its own thread at a fixed tick rate.
+ *
+ * @details The simulation thread owns the game and input state. The main thread only ever pushes commands into the
+ * input queue and reads snapshots from the triple buffer, so neither thread blocks the other: a slow frame can delay
+ * when a snapshot is drawn, but never when the game steps.
+ */
+typedef struct Simulation
+{
+    /** @brief The game, which only the simulation thread may access while it is running. */
+    GameDataContext* game;
+
+    /** @brief The input state, which only the simulation thread may access while it is running. */
+    InputState* inputState;
+
+    InputQueue inputQueue;
+
+    /** @brief The triple buffer of snapshots. */
+    GameSnapshot snapshots[SIM_SNAPSHOT_COUNT];
+
+    /** @brief The index of the snapshot shared between the threads, with SIM_SNAPSHOT_FRESH set if it is new. */
+    SDL_AtomicInt sharedSnapshot;
+
+    /** @brief The index of the snapshot being written, owned by the simulation thread. */
+    int backSnapshot;
+
+    /** @brief The index of the snapshot being read, owned by the render thread. */
+    int frontSnapshot;
+
+    /** @brief The number of ticks run so far. */
+    Uint64 tick;
+
+    /** @brief The event timestamp (in nanoseconds) of the latest input applied. */
+    Uint64 lastInputTimestamp;
+
+    /** @brief The longest time (in nanoseconds) a step has taken since the last snapshot was published. */
+    Uint64 worstStepNS;
+
+    /** @brief The number of commands dropped because the input queue was full. */
+    SDL_AtomicInt droppedCommands;
+
+    /** @brief The recorder every applied command is written to, or NULL to not record. Set this before starting. */
+    struct ReplayRecorder* recorder;
+
+    /** @brief The search bot that plays the game once per tick, or NULL for the player to play. Set this before starting. */
+    struct BotSearch* bot;
+
+    /** @brief The store each finished game is submitted to, or NULL to not keep scores. Set this before starting. */
+    struct ScoreStore* scores;
+
+    /** @brief The server each tick's changes are broadcast to, or NULL to not broadcast. Set this before starting. */
+    struct SpectateServer* spectate;
+
+    /** @brief Whether the game was over after the previous tick, so that each finished game is submitted once. */
+    bool wasGameOver;
+
+    SDL_AtomicInt isStopping;
+    SDL_Thread* thread;
+} Simulation;
+
+/**
+ * @brief Publish the initial snapshot and start the simulation thread.
+ *
+ * @param simulation A pointer to the simulation to start.
+ * @param gameDataContext The game to simulate, which must already be initialised.
+ * @param inputState The input state, which must already be initialised.
+ *
+ * @return True on success, false otherwise.
+ */
+bool SIM_Start(Simulation* simulation, GameDataContext* gameDataContext, InputState* inputState);
+
+/**
+ * @brief Stop the simulation thread, waiting for it to finish.
+ *
+ * @param simulation A pointer to the simulation to stop.
+ */
+void SIM_Stop(Simulation* simulation);
+
+/**
+ * @brief Apply a command to a game, as the simulation thread does before each tick. This is also used to play back
+ * replays, so it must only depend on the command and the game.
+ *
+ * @param gameDataContext The game to apply the command to.
+ * @param inputState The game's input state.
+ * @param command The command, whose timestamp is on the simulation's own timeline.
+ */
+void SIM_ApplyCommand(GameDataContext* gameDataContext, InputState* inputState, const SimCommand* command);
+
+/**
+ * @brief Step a game by a single tick, after the tick's commands have been applied.
+ *
+ * @param gameDataContext The game to step.
+ * @param inputState The game's input state.
+ * @param tick The index of the tick, from which its time on the simulation's own timeline is derived.
+ */
+void SIM_Tick(GameDataContext* gameDataContext, InputState* inputState, Uint64 tick);
+
+/**
+ * @brief Send a key event to the simulation thread. Only call this from the main thread.
+ *
+ * @param simulation A pointer to the simulation.
+ * @param event The key event.
+ *
+ * @return True on success, false if the input queue was full and the event was dropped.
+ */
+bool SIM_PushKeyEvent(Simulation* simulation, const SDL_KeyboardEvent* event);
+
+/**
+ * @brief Send a command to the simulation thread. Only call this from the main thread.
+ *
+ * @param simulation A pointer to the simulation.
+ * @param type The type of command, which must not be SIM_COMMAND_KEY.
+ *
+ * @return True on success, false if the input queue was full and the command was dropped.
+ */
+bool SIM_PushCommand(Simulation* simulation, SimCommandType type);
+
+/**
+ * @brief Get the latest snapshot, without blocking. Only call this from the render (main) thread.
+ *
+ * @note The snapshot remains valid, and unchanged, until the next call.
+ *
+ * @param simulation A pointer to the simulation.
+ *
+ * @return A pointer to the latest snapshot.
+ */
+GameSnapshot* SIM_AcquireSnapshot(Simulation* simulation);
+
+/**
+ * @brief A ButtonCallback that restarts the game.
+ *
+ * @param data A pointer to the simulation.
+ */
+void SIM_Restart(void* data);
+
+/**
+ * @brief A ButtonCallback that pauses or resumes the game.
+ *
+ * @param data A pointer to the simulation.
+ */
+void SIM_TogglePause(void* data);
+
+/**
+ * @brief A ButtonCallback that quits the game.
+ *
+ * @param data A pointer to the simulation.
+ */
+void SIM_Quit(void* data);
+
+#endif //SIMULATION_H
@@ -0,0 +1,128 @@
+#ifndef SPECTATE_H
+#define SPECTATE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "simulation.h"
+
+/**
+ * @brief Generic spectator stream configuration enum values.
+ */
+enum SpectateConfig
+{
+    /** @brief The most spectators that can watch a broadcast at once. */
+    SPECTATE_MAX_CLIENTS = 32,
+
+    /** @brief The number of ticks between keyframes, which resync every spectator (once a second). */
+    SPECTATE_KEYFRAME_INTERVAL_TICKS = SIM_TICK_RATE,
+
+    /** @brief The number of encoded frames that can be waiting to be sent. This must be a power of two. */
+    SPECTATE_FRAME_QUEUE_CAPACITY = 256,
+
+    /** @brief The largest encoded frame, which is a keyframe: a header, the piece pose, the HUD and every arena row. */
+    SPECTATE_MAX_FRAME_BYTES = 128,
+
+    /** @brief The number of bytes each spectator can fall behind by before it is disconnected. */
+    SPECTATE_CLIENT_BUFFER_BYTES = 16384,
+
+    /** @brief The time (in milliseconds) the sender thread sleeps between sending the queued frames. */
+    SPECTATE_SEND_INTERVAL_MS = 2,
+
+    /** @brief The time (in milliseconds) a viewer waits for its first keyframe before giving up. */
+    SPECTATE_CONNECT_TIMEOUT_MS = 2000,
+};
+
+/**
+ * @brief The types of frame in a spectator stream.
+ */
+typedef enum SpectateFrameType
+{
+    /** @brief Every arena row, from which a spectator can start watching. */
+    SPECTATE_FRAME_KEYFRAME = 1,
+
+    /** @brief Only the arena rows that changed since the previous frame. */
+    SPECTATE_FRAME_DELTA = 2,
+} SpectateFrameType;
+
+/**
+ * @brief A broadcast of a live game to spectators, over a Unix domain socket or loopback TCP.
+ *
+ * @details The simulation thread encodes a frame each tick the game changes (see SPECTATE_Publish) into a wait-free
+ * single producer, single consumer queue, and a sender thread owns every socket, so the game is never held up by a
+ * spectator. Each frame is little-endian and starts with its size (Uint16), type (::SpectateFrameType) and tick
+ * (Uint32), followed by a mask of the arena rows it carries (Uint32, bit n for row n), the game's state (flags,
+ * piece identifier and orientation, piece x and y, score, level, lines and the next queue) and then each carried row
+ * with two cells packed per byte.
+ */
+typedef struct SpectateServer SpectateServer;
+
+/**
+ * @brief A spectator watching a broadcast, which decodes the stream into a game that can be drawn as normal.
+ */
+typedef struct SpectateViewer SpectateViewer;
+
+/**
+ * @brief Start broadcasting, listening for spectators on an address.
+ *
+ * @param address Either "tcp:PORT" to listen on the loopback interface, or the path of a Unix domain socket.
+ *
+ * @return The server, or NULL on failure.
+ */
+SpectateServer* SPECTATE_CreateServer(const char* address);
+
+/**
+ * @brief Disconnect every spectator, stop the sender thread and free the server, then log how the broadcast went.
+ *
+ * @note The simulation thread must have stopped publishing first.
+ *
+ * @param server A pointer to the server.
+ */
+void SPECTATE_DestroyServer(SpectateServer* server);
+
+/**
+ * @brief Encode the changes to a game since the last frame, and queue them to be sent to every spectator. Only call
+ * this from the simulation thread, after each tick. It never blocks or allocates, and queues nothing if the game has
+ * not changed.
+ *
+ * @param server A pointer to the server.
+ * @param gameDataContext The game.
+ * @param tick The number of ticks the simulation has run.
+ */
+void SPECTATE_Publish(SpectateServer* server, const GameDataContext* gameDataContext, Uint64 tick);
+
+/**
+ * @brief Connect to a broadcast, waiting for its first keyframe.
+ *
+ * @param address The address the broadcast is listening on (see SPECTATE_CreateServer).
+ *
+ * @return The viewer, or NULL on failure.
+ */
+SpectateViewer* SPECTATE_Connect(const char* address);
+
+/**
+ * @brief Disconnect from a broadcast and free the viewer.
+ *
+ * @param viewer A pointer to the viewer.
+ */
+void SPECTATE_Disconnect(SpectateViewer* viewer);
+
+/**
+ * @brief Apply every frame that has arrived to the viewer's game, without waiting for more. Once the broadcast ends,
+ * the game stops running.
+ *
+ * @param viewer A pointer to the viewer.
+ *
+ * @return The viewer's game, which is valid until the viewer is disconnected.
+ */
+GameDataContext* SPECTATE_Receive(SpectateViewer* viewer);
+
+/**
+ * @brief Stop watching, so that the viewer's game stops running. This is a button callback.
+ *
+ * @param data A pointer to the viewer.
+ */
+void SPECTATE_StopViewing(void* data);
+
+#endif //SPECTATE_H
@@ -14,6 +14,12 @@ enum TetrominoConfig
 
     /** @brief The maximum dimension of a tetromino block (i.e. how big the square matrix representation of a tetromino is). */
     TETROMINO_MAX_SIZE = 4,
+
+    /** @brief The fewest upcoming tetrominoes the next queue holds, which is two whole bags. */
+    TETROMINO_QUEUE_LENGTH = 2 * TETROMINO_COUNT,
+
+    /** @brief The number of tetrominoes the next queue's ring buffer can hold. This must be a power of two. */
+    TETROMINO_QUEUE_CAPACITY = 32,
 };
 
 /**
@@ -39,19 +45,19 @@ typedef enum TetrominoIdentifier
     S = 5,
     L = 6,
     J = 7,
+
+    /** @brief A garbage block received from an opponent. This is not a tetromino shape, it only ever appears in the arena. */
+    GARBAGE = 8,
 } TetrominoIdentifier;
 
 /**
- * @brief A struct that represents a tetromino's shape and texture.
+ * @brief A struct that represents a tetromino's shape.
  */
 typedef struct TetrominoShape
 {
     /** @brief The identifier for this shape */
     TetrominoIdentifier identifier;
 
-    /** @brief A pointer to the texture that belongs to this shape. */
-    SDL_Texture* texture;
-
     /** @brief A matrix containing four orientations (of the same shape) representing this tetromino in 2D space. */
     bool coordinates[4][TETROMINO_MAX_SIZE][TETROMINO_MAX_SIZE];
 
@@ -77,7 +83,7 @@ typedef struct DroppingTetromino
     /** @brief A pointer to the tetromino shape object that contains details unique to each tetromino. **/
     const TetrominoShape* shape;
 
-    /** @brief The tick at which the dropping tetromino was marked for termination, or 0 if not marked for termination.**/
+    /** @brief The game clock time (in nanoseconds) at which the dropping tetromino was marked for termination, or 0 if not marked for termination.**/
     Uint64 terminationTick;
 
     // TODO Possibly implement tracker for number of moves, so we can limit the number of rotations to 15 before
@@ -85,16 +91,40 @@ typedef struct DroppingTetromino
 } DroppingTetromino;
 
 /**
- * @brief The 'bag' containing the set of possible tetrominoes.
+ * @brief The 'bag' containing the set of possible tetrominoes, and the queue of upcoming tetrominoes drawn from it.
+ *
+ * @details The queue is a ring buffer that is refilled a whole shuffled bag at a time, so that it always holds at
+ * least TETROMINO_QUEUE_LENGTH upcoming tetrominoes. Every tetromino is written twice, TETROMINO_QUEUE_CAPACITY apart,
+ * so the upcoming tetrominoes can always be read as one contiguous array, however the ring has wrapped. The counts
+ * increase forever and are wrapped when used.
  */
 typedef struct TetrominoBag
 {
-    int dropCount;
-    TetrominoIdentifier bag[TETROMINO_COUNT];
+    /** @brief The ring buffer of upcoming tetrominoes, followed by a mirror of it. */
+    TetrominoIdentifier queue[2 * TETROMINO_QUEUE_CAPACITY];
+
+    /** @brief The number of tetrominoes drawn from the queue so far. */
+    Uint32 drawCount;
+
+    /** @brief The number of tetrominoes added to the queue so far, which is always a whole number of bags. */
+    Uint32 queuedCount;
+
+    /** @brief The state of the random number generator used to shuffle this bag, so that each game can be seeded. */
+    Uint64 randomState;
 } TetrominoBag;
 
 /**
- * @brief Initialise and shuffle a tetromino bag.
+ * @brief Seed the random number generator of a tetromino bag, then initialise and shuffle it.
+ *
+ * @note Two bags seeded with the same value will produce the same sequence of tetrominoes.
+ *
+ * @param bag A pointer to the TetrominoBag state.
+ * @param seed The seed for the random number generator.
+ */
+void SeedTetrominoBag(TetrominoBag* bag, Uint64 seed);
+
+/**
+ * @brief Empty the next queue of a tetromino bag, then fill it with shuffled bags.
  *
  * @note The "random" selection is done using the tetris guidelines Random Generator, wherein a "bag" of the possible
  * tetrominoes is generated and dished out one by one until the bag is empty, at which point it is reshuffled.
@@ -102,7 +132,7 @@ typedef struct TetrominoBag
 void InitTetrominoBag(TetrominoBag* bag);
 
 /**
- * @brief Draw the next tetromino shape from the bag.
+ * @brief Draw the next tetromino shape from the queue, refilling it with another shuffled bag if it runs short.
  *
  * @param bag A pointer to the TetrominoBag state.
  * @return A readonly TetrominoShape.
@@ -110,15 +140,31 @@ void InitTetrominoBag(TetrominoBag* bag);
 const TetrominoShape* NextTetrominoFromBag(TetrominoBag* bag);
 
 /**
- * @brief Return a pointer to a tetromino shape object using its identifier.
+ * @brief Look at the upcoming tetrominoes without drawing them, or copying them out of the queue.
+ *
+ * @param bag A pointer to the TetrominoBag state.
+ * @param count A pointer to write the number of upcoming tetrominoes to, which is at least TETROMINO_QUEUE_LENGTH.
+ *
+ * @return The upcoming tetrominoes in the order they will be drawn, which stay valid until the next draw.
+ */
+const TetrominoIdentifier* PeekTetrominoQueue(const TetrominoBag* bag, int* count);
+
+/**
+ * @brief Get how many tetrominoes have been drawn from the bag the next tetromino comes from.
  *
- * @note This should be treated as a READONLY object, the only reason it is not is so we can initialise
- * the shape textures
+ * @param bag A pointer to the TetrominoBag state.
+ *
+ * @return A number from 0 (a new bag starts with the next tetromino) to TETROMINO_COUNT - 1.
+ */
+int GetTetrominoBagPosition(const TetrominoBag* bag);
+
+/**
+ * @brief Return a pointer to a tetromino shape object using its identifier.
  *
  * @param identifier
  * @return A TetrominoShape object.
  */
-TetrominoShape* GetTetrominoShapeByIdentifier(TetrominoIdentifier identifier);
+const TetrominoShape* GetTetrominoShapeByIdentifier(TetrominoIdentifier identifier);
 
 /**
  * @brief Rotate a given dropping tetromino either left or right.
@@ -135,7 +181,8 @@ void RotateDroppingTetromino(DroppingTetromino* droppingTetromino, int rotationA
  *
  * @param array A pointer to an integer array.
  * @param n The size of the array.
+ * @param randomState A pointer to the state of the random number generator to use.
  */
-static void Shuffle(int* array, size_t n);
+static void Shuffle(int* array, size_t n, Uint64* randomState);
 
 #endif //TETROMINO_H
\ No newline at end of file
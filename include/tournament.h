@@ -0,0 +1,155 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "game.h"
+#include "graphics.h"
+#include "replay.h"
+#include "simulation.h"
+
+/**
+ * @brief Generic tournament wall configuration enum values.
+ */
+enum TournamentConfig
+{
+    /** @brief The fewest boards a wall shows. */
+    TOURNAMENT_MIN_BOARDS = 1,
+
+    /** @brief The most boards a wall shows. */
+    TOURNAMENT_MAX_BOARDS = 64,
+
+    /** @brief The number of ticks between each bot's moves (a quarter of a second), so that their games can be followed. */
+    TOURNAMENT_BOT_MOVE_TICKS = SIM_TICK_RATE / 4,
+
+    /** @brief The number of ticks a finished game is shown for before its board starts the next one. */
+    TOURNAMENT_GAME_OVER_TICKS = SIM_TICK_RATE * 2,
+
+    /** @brief The width (in grid squares) of the space each board takes up: its arena and half a square either side. */
+    TOURNAMENT_BOARD_GRID_WIDTH = ARENA_WIDTH + 1,
+
+    /** @brief The height (in grid squares) of the space each board takes up: its arena, its label and the padding. */
+    TOURNAMENT_BOARD_GRID_HEIGHT = ARENA_HEIGHT + 2,
+
+    /**
+     * @brief The number of quads drawn for each board: its background, every cell, and the four blocks of both the
+     * ghost and the dropping tetromino.
+     */
+    TOURNAMENT_BOARD_QUADS = 1 + ARENA_HEIGHT * ARENA_WIDTH + 2 * 4,
+};
+
+/**
+ * @brief A board on the wall, which is a game played by the bot or played back from a replay.
+ */
+typedef struct TournamentBoard
+{
+    /** @brief The replay played back on this board, or NULL if the bot plays it. */
+    const Replay* replay;
+
+    /** @brief The replay being played back, if there is one. Its game is the board's game. */
+    ReplayPlayer player;
+
+    /** @brief The bot's game, if there is no replay. */
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+
+    /** @brief The wall tick the current game started on. */
+    Uint64 startTick;
+
+    /** @brief The wall tick the bot next moves on, or that a finished game is replaced on. */
+    Uint64 nextMoveTick;
+
+    /** @brief The number of games this board has started, used to give each bot game its own seed. */
+    Uint64 games;
+} TournamentBoard;
+
+/**
+ * @brief A wall of boards, all running at once on the render thread and drawn in a handful of draw calls.
+ *
+ * @details Every board is advanced in whole simulation ticks, so replays play back exactly as they were recorded,
+ * and the bots (which use BOT_FindPlacement) move at a fixed rate, staggered so that their moves spread across frames.
+ * Each board is laid out on its own ScaledGrid, and every block of every board is drawn from the block atlas with a
+ * single SDL_RenderGeometry call (the labels take one more, from the glyph atlas). Nothing is allocated after
+ * TOURNAMENT_Init.
+ */
+typedef struct TournamentWall
+{
+    TournamentBoard boards[TOURNAMENT_MAX_BOARDS];
+    int boardCount;
+
+    /** @brief The replays played back on the first boards. */
+    Replay replays[TOURNAMENT_MAX_BOARDS];
+    int replayCount;
+
+    /** @brief The seed of the first bot game. Bot board i starts with seed + i, and each new game adds the board count. */
+    Uint64 seed;
+
+    /** @brief The number of ticks the wall has run, and the time (in nanoseconds, from SDL_GetTicksNS) of the last. */
+    Uint64 tick;
+    Uint64 lastTickNS;
+
+    /** @brief The vertices of every board's quads, rebuilt each frame, and their indices, built once. */
+    SDL_Vertex* vertices;
+    int* indices;
+
+    /** @brief The vertices of every board's label, rebuilt each frame. Their indices are the first of the board quads'. */
+    SDL_Vertex* labelVertices;
+
+    /** @brief The output size (in pixels) the layout was last worked out for, and the number of columns of boards. */
+    int layoutWidth;
+    int layoutHeight;
+    int columns;
+
+    /** @brief The grid of the whole wall, from which each board's grid is offset. */
+    ScaledGrid wallGrid;
+
+    /** @brief The number of games finished across every board, and the best score and total lines of them. */
+    Uint64 finishedGames;
+    int bestScore;
+    Uint64 linesCleared;
+} TournamentWall;
+
+/**
+ * @brief Allocate a wall's draw buffers, load its replays and start every board's first game.
+ *
+ * @param wall A pointer to the zeroed wall to initialise.
+ * @param boardCount The number of boards, from TOURNAMENT_MIN_BOARDS to TOURNAMENT_MAX_BOARDS.
+ * @param replayPaths The paths of the replays to play back on the first boards. The rest are played by the bot.
+ * @param replayCount The number of replay paths, which must not be more than the number of boards.
+ * @param seed The seed of the first bot game.
+ *
+ * @return True on success, false otherwise.
+ */
+bool TOURNAMENT_Init(TournamentWall* wall, int boardCount, const char* const* replayPaths, int replayCount, Uint64 seed);
+
+/**
+ * @brief Free a wall's draw buffers and replays, then log how its games went.
+ *
+ * @param wall A pointer to the wall.
+ */
+void TOURNAMENT_Destroy(TournamentWall* wall);
+
+/**
+ * @brief Advance every board by the whole ticks that have passed since the last update, moving the bots that are due
+ * and starting the next game on boards whose game has been over for long enough. Only call this from the render thread.
+ *
+ * @param wall A pointer to the wall.
+ * @param nowNS The current time (in nanoseconds, from SDL_GetTicksNS).
+ */
+void TOURNAMENT_Update(TournamentWall* wall, Uint64 nowNS);
+
+/**
+ * @brief Clear the screen and draw every board, with its label, filling the render output.
+ *
+ * @note The block atlas must have been built (see BuildBlockAtlas).
+ *
+ * @param wall A pointer to the wall.
+ * @param graphicsDataContext A struct containing the graphics data context.
+ * @param fonts A pointer to the fonts, whose glyph atlas the labels are drawn from.
+ *
+ * @return True on success, false otherwise.
+ */
+bool TOURNAMENT_Render(TournamentWall* wall, GraphicsDataContext* graphicsDataContext, const Fonts* fonts);
+
+#endif //TOURNAMENT_H
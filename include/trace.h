@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic trace configuration enum values.
+ */
+enum TraceConfig
+{
+    /** @brief The number of events each thread can record between flushes before further events are dropped. */
+    TRACE_BUFFER_CAPACITY = 1 << 17,
+};
+
+/**
+ * @brief Whether tracing is enabled. This is checked inline by the trace macros, so disabled tracing costs one branch.
+ */
+extern bool traceEnabled;
+
+#ifdef TETRIS_DISABLE_TRACE
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#else
+/** @brief Mark the start of a scope. The name must be a string literal, as only the pointer is stored. */
+#define TRACE_BEGIN(name) do { if (traceEnabled) TRACE_Begin(name); } while (0)
+
+/** @brief Mark the end of a scope started with TRACE_BEGIN. */
+#define TRACE_END(name) do { if (traceEnabled) TRACE_End(name); } while (0)
+#endif
+
+/**
+ * @brief Enable tracing, opening a Chrome Trace Event JSON file that events are appended to whenever the trace is
+ * flushed.
+ *
+ * @note The file can be opened in chrome://tracing or https://ui.perfetto.dev
+ *
+ * @param path The path of the JSON file to write.
+ *
+ * @return True on success, false otherwise.
+ */
+bool TRACE_Init(const char* path);
+
+/**
+ * @brief Record the start of a scope on the calling thread. Prefer the TRACE_BEGIN macro.
+ *
+ * @param name The name of the scope, which must outlive the trace (i.e. a string literal).
+ */
+void TRACE_Begin(const char* name);
+
+/**
+ * @brief Record the end of a scope on the calling thread. Prefer the TRACE_END macro.
+ *
+ * @param name The name of the scope, which must outlive the trace (i.e. a string literal).
+ */
+void TRACE_End(const char* name);
+
+/**
+ * @brief Name the calling thread in the trace viewer.
+ *
+ * @param name The name of the thread, which must outlive the trace (i.e. a string literal).
+ */
+void TRACE_NameThread(const char* name);
+
+/**
+ * @brief Append every event recorded since the last flush, on every thread, to the trace file, emptying each thread's
+ * buffer. Threads that exit write their remaining events themselves.
+ *
+ * @note This may be called while other threads are still recording; events recorded after the call starts may be
+ * missing from the file, but will be included in the next flush.
+ *
+ * @return True on success, false otherwise.
+ */
+bool TRACE_Flush(void);
+
+#endif //TRACE_H
@@ -0,0 +1,114 @@
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+/**
+ * @brief Generic transposition table configuration enum values.
+ */
+enum TranspositionConfig
+{
+    /** @brief The default size of a table, as a power of two number of entries (16 bytes each, so 16 MiB). */
+    TRANSPOSITION_DEFAULT_LOG2_ENTRIES = 20,
+
+    /** @brief The largest allowed size of a table, as a power of two number of entries. */
+    TRANSPOSITION_MAX_LOG2_ENTRIES = 28,
+};
+
+/**
+ * @brief What a search learned about a position, packed into 64 bits so that it can be stored in a single slot.
+ */
+typedef struct TranspositionEntry
+{
+    /** @brief The evaluation of the position, higher is better. */
+    float evaluation;
+
+    /** @brief The x-coordinate of the best placement found from the position. */
+    Sint8 x;
+
+    /** @brief The y-coordinate of the best placement found from the position. */
+    Sint8 y;
+
+    /** @brief The orientation of the best placement found from the position. */
+    Uint8 orientation;
+
+    /** @brief How many pieces deep the position was searched, where deeper results are worth more. */
+    Uint8 depth;
+} TranspositionEntry;
+
+/**
+ * @brief A single slot of the table, holding an entry and the hash of its position XORed with it.
+ */
+typedef struct TranspositionSlot
+{
+    volatile Uint64 check;
+    volatile Uint64 data;
+} TranspositionSlot;
+
+/**
+ * @brief A fixed-size hash table of searched positions, keyed by their Zobrist hash, which any number of search
+ * threads can read and write at once without locking.
+ *
+ * @details Each slot stores the entry alongside the position hash XORed with the entry. Two threads writing the
+ * same slot at once may leave it with one thread's check and the other's data, but then the check no longer decodes
+ * to the hash being probed, so a torn slot reads as a miss rather than as a wrong entry.
+ *
+ * @note See "Shared Hash Table": https://www.chessprogramming.org/Shared_Hash_Table#Lockless
+ */
+typedef struct TranspositionTable
+{
+    TranspositionSlot* slots;
+
+    /** @brief The number of slots minus one, to turn a hash into a slot index. */
+    Uint64 mask;
+} TranspositionTable;
+
+/**
+ * @brief Allocate an empty transposition table.
+ *
+ * @param table A pointer to the table to initialise.
+ * @param log2Entries The number of slots, as a power of two, or 0 for TRANSPOSITION_DEFAULT_LOG2_ENTRIES.
+ *
+ * @return True on success, false otherwise.
+ */
+bool TT_Init(TranspositionTable* table, int log2Entries);
+
+/**
+ * @brief Free a transposition table.
+ *
+ * @param table A pointer to the table to destroy.
+ */
+void TT_Destroy(TranspositionTable* table);
+
+/**
+ * @brief Empty a transposition table. This must not be called while other threads are using it.
+ *
+ * @param table A pointer to the table.
+ */
+void TT_Clear(TranspositionTable* table);
+
+/**
+ * @brief Look up a position. This is thread safe.
+ *
+ * @param table A pointer to the table.
+ * @param hash The Zobrist hash of the position.
+ * @param entry A pointer to write the entry to if it is found.
+ *
+ * @return True if the position was found, false otherwise.
+ */
+bool TT_Probe(const TranspositionTable* table, Uint64 hash, TranspositionEntry* entry);
+
+/**
+ * @brief Store what was learned about a position. This is thread safe.
+ *
+ * @details A slot holding a different position is always replaced, as recent positions are the most likely to be
+ * revisited, but a slot holding the same position is only replaced by a result searched at least as deep.
+ *
+ * @param table A pointer to the table.
+ * @param hash The Zobrist hash of the position.
+ * @param entry The entry to store.
+ */
+void TT_Store(TranspositionTable* table, Uint64 hash, const TranspositionEntry* entry);
+
+#endif //TRANSPOSITION_H
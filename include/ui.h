@@ -0,0 +1,111 @@
+#ifndef UI_H
+#define UI_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "graphics.h"
+
+/**
+ * @brief Generic UI configuration enum values.
+ */
+enum UIConfig
+{
+    /** @brief The maximum number of widgets in a registry. */
+    UI_MAX_WIDGETS = 16,
+
+    /** @brief The widget index used when no widget is hovered, pressed or hit. */
+    UI_NO_WIDGET = -1,
+};
+
+/**
+ * @brief A registry of the interactive widgets on screen, with their bounds precomputed for hit testing.
+ *
+ * @details Each alignment grid cell stores which widgets touch it, so a hit test is a single lookup (plus a bounds
+ * check of each widget in the cell, usually just one) no matter how many widgets are registered. Mouse motion is coalesced, so only the latest position is hit
+ * tested, once per frame.
+ */
+typedef struct WidgetRegistry
+{
+    /** @brief The registered widgets. */
+    Button* widgets[UI_MAX_WIDGETS];
+
+    /** @brief The bounds (in pixels) of each widget, as of the last layout update. */
+    SDL_FRect bounds[UI_MAX_WIDGETS];
+
+    /** @brief The number of registered widgets. */
+    int widgetCount;
+
+    /** @brief The widgets touching each alignment grid cell, as a mask with bit n set for widget n. */
+    Uint16 cellWidgets[WINDOW_GRID_HEIGHT][WINDOW_GRID_WIDTH];
+
+    /** @brief The grid square size (in pixels) the bounds were computed with. */
+    float gridSquareSize;
+
+    /** @brief The latest mouse position that has not been hit tested yet. */
+    SDL_FPoint pendingMotion;
+
+    /** @brief Whether there is a mouse position waiting to be hit tested. */
+    bool hasPendingMotion;
+
+    /** @brief The index of the widget under the mouse, or UI_NO_WIDGET. */
+    int hoveredWidget;
+
+    /** @brief The index of the widget the mouse button was pressed on, or UI_NO_WIDGET. */
+    int pressedWidget;
+} WidgetRegistry;
+
+SDL_COMPILE_TIME_ASSERT(CellWidgetsHoldEveryWidget, UI_MAX_WIDGETS <= sizeof(Uint16) * 8);
+
+/**
+ * @brief Initialise an empty widget registry.
+ *
+ * @param registry A pointer to the registry to initialise.
+ */
+void UI_Init(WidgetRegistry* registry);
+
+/**
+ * @brief Add a button to the registry. The layout must be updated before the button can be hit.
+ *
+ * @param registry A pointer to the registry.
+ * @param button A pointer to the button, which must outlive the registry.
+ *
+ * @return True on success, false if the registry is full.
+ */
+bool UI_RegisterButton(WidgetRegistry* registry, Button* button);
+
+/**
+ * @brief Recompute the bounds of every widget and the grid lookup, e.g. after the window has been resized.
+ *
+ * @param registry A pointer to the registry.
+ * @param graphicsDataContext A struct containing the graphics data context.
+ */
+void UI_UpdateLayout(WidgetRegistry* registry, const GraphicsDataContext* graphicsDataContext);
+
+/**
+ * @brief Find the widget at a point.
+ *
+ * @param registry A pointer to the registry.
+ * @param point The point (in pixels) to test.
+ *
+ * @return The index of the widget, the last registered if several overlap at the point, or UI_NO_WIDGET.
+ */
+int UI_HitTest(const WidgetRegistry* registry, SDL_FPoint point);
+
+/**
+ * @brief Handle a mouse event. Motion is only recorded, to be hit tested by UI_Update, while button presses and
+ * releases are handled immediately.
+ *
+ * @param registry A pointer to the registry.
+ * @param event The event to be handled.
+ */
+void UI_HandleEvent(WidgetRegistry* registry, const SDL_Event* event);
+
+/**
+ * @brief Hit test the latest mouse position (if it has moved), updating which widget is hovered. Call once per frame.
+ *
+ * @param registry A pointer to the registry.
+ */
+void UI_Update(WidgetRegistry* registry);
+
+#endif //UI_H
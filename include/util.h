@@ -3,6 +3,15 @@
 
 #include <stdbool.h>
 
+/**
+ * @brief Give each thread its own instance of a static variable, which is faster to reach than SDL_GetTLS.
+ */
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
 /* Constants */
 enum MainConfig
 {
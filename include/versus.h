@@ -0,0 +1,95 @@
+#ifndef VERSUS_H
+#define VERSUS_H
+
+#include "game.h"
+
+/**
+ * @brief Generic versus configuration enum values.
+ */
+enum VersusConfig
+{
+    /** @brief The number of players in a versus match. */
+    VERSUS_PLAYER_COUNT = 2,
+
+    /** @brief The number of tetrominoes each player may lock before a headless game is declared a draw. */
+    VERSUS_MAX_PIECES = 500,
+
+    /** @brief The maximum number of worker threads used to play headless games. */
+    VERSUS_MAX_THREADS = 64,
+};
+
+/**
+ * @brief A struct holding two games that send garbage to each other.
+ */
+typedef struct VersusMatch
+{
+    /** @brief The game of each player, whose opponent pointers reference each other. */
+    GameDataContext players[VERSUS_PLAYER_COUNT];
+} VersusMatch;
+
+/**
+ * @brief The aggregated outcome of a set of headless versus games.
+ */
+typedef struct VersusResult
+{
+    /** @brief The number of games played. */
+    int games;
+
+    /** @brief The number of games won by each player. */
+    int wins[VERSUS_PLAYER_COUNT];
+
+    /** @brief The number of games that reached VERSUS_MAX_PIECES without a winner. */
+    int draws;
+
+    /** @brief The total number of tetrominoes locked across every game. */
+    Uint64 pieces;
+
+    /** @brief The total number of garbage rows sent across every game. */
+    Uint64 garbageSent;
+
+    /** @brief The wall-clock time (in nanoseconds) taken to play every game. */
+    Uint64 elapsedNS;
+} VersusResult;
+
+/**
+ * @brief Initialise both games of a versus match and link them as each other's opponent.
+ *
+ * @param match A pointer to the match to initialise.
+ *
+ * @return True on success, false otherwise.
+ */
+bool VS_Init(VersusMatch* match);
+
+/**
+ * @brief Free the resources owned by a versus match.
+ *
+ * @param match A pointer to the match to destroy.
+ */
+void VS_Destroy(VersusMatch* match);
+
+/**
+ * @brief Play a single bot-vs-bot game to completion without rendering anything.
+ *
+ * @details The players take turns locking one tetromino each, until one of them tops out.
+ *
+ * @param match A pointer to an initialised match.
+ * @param seed The seed of the game, from which each player's seed is derived.
+ * @param result A pointer to the result to accumulate the outcome into.
+ */
+void VS_PlayHeadlessGame(VersusMatch* match, Uint64 seed, VersusResult* result);
+
+/**
+ * @brief Play many bot-vs-bot games, split across worker threads, and aggregate the results.
+ *
+ * @note Game n is played with seed + n, so a run can be reproduced regardless of the thread count.
+ *
+ * @param gameCount The number of games to play.
+ * @param threadCount The number of worker threads to use, or 0 to use one per logical CPU core.
+ * @param seed The seed of the first game.
+ * @param result A pointer to the result to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+bool VS_RunHeadless(int gameCount, int threadCount, Uint64 seed, VersusResult* result);
+
+#endif //VERSUS_H
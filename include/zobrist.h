@@ -0,0 +1,75 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "game.h"
+
+/**
+ * @brief Get the key of a single arena row, where each distinct row and occupancy has its own random key.
+ *
+ * @details The arena hash is the XOR of every row's key, so changing a row only needs its old key XORed out and its
+ * new key XORed in. An empty row has a key of zero, so an empty arena hashes to zero. Keys are derived from the row
+ * and mask with a mixing function rather than read from a table, as a table of every row occupancy would not fit in
+ * cache, and it needs no initialisation before it can be used from any thread.
+ *
+ * @note See "Zobrist Hashing": https://www.chessprogramming.org/Zobrist_Hashing
+ *
+ * @param row The index of the row in the arena.
+ * @param mask The occupancy of the row, where bit n is set if column n is filled.
+ *
+ * @return The key of the row.
+ */
+Uint64 ZOBRIST_RowKey(int row, Uint16 mask);
+
+/**
+ * @brief Get the key of a row of the arena, from which cells are filled.
+ *
+ * @param arena The matrix representation of the tetris arena.
+ * @param row The index of the row.
+ *
+ * @return The key of the row.
+ */
+Uint64 ZOBRIST_ArenaRowKey(const TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH], int row);
+
+/**
+ * @brief Hash the occupancy of the whole arena from scratch.
+ *
+ * @note This is the same value as GameDataContext::arenaHash, which is kept up to date incrementally.
+ *
+ * @param arena The matrix representation of the tetris arena.
+ *
+ * @return The arena hash.
+ */
+Uint64 ZOBRIST_HashArena(const TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH]);
+
+/**
+ * @brief Get the key of the dropping tetromino's shape and orientation.
+ *
+ * @param identifier The identifier of the tetromino shape.
+ * @param orientation The orientation of the tetromino.
+ *
+ * @return The key of the tetromino.
+ */
+Uint64 ZOBRIST_PieceKey(TetrominoIdentifier identifier, enum Orientation orientation);
+
+/**
+ * @brief Get the key of the bag position, covering every tetromino still to be drawn from the current bag.
+ *
+ * @param bag A pointer to the tetromino bag.
+ *
+ * @return The key of the bag.
+ */
+Uint64 ZOBRIST_BagKey(const TetrominoBag* bag);
+
+/**
+ * @brief Hash the whole position the next decision is made from: the arena, the dropping tetromino's shape and
+ * orientation, and the bag position.
+ *
+ * @note The game has no hold piece, so there is no hold state to hash.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ *
+ * @return The position hash.
+ */
+Uint64 ZOBRIST_HashPosition(const GameDataContext* gameDataContext);
+
+#endif //ZOBRIST_H
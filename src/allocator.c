@@ -0,0 +1,166 @@
+#include "allocator.h"
+
+#include "util.h"
+
+/**
+ * @brief The alignment of every arena allocation, which is enough for any type.
+ */
+#define ARENA_ALIGNMENT 16
+
+/**
+ * @brief The state of the allocation hooks.
+ */
+typedef struct AllocationHooks
+{
+    SDL_malloc_func malloc;
+    SDL_calloc_func calloc;
+    SDL_realloc_func realloc;
+    SDL_free_func free;
+
+    SDL_LogOutputFunction logOutput;
+    void* logOutputUserData;
+
+    /** @brief The number of consecutive frames of steady-state play. Only used by the main thread. */
+    int steadyStateFrames;
+} AllocationHooks;
+
+static AllocationHooks hooks = { 0 };
+
+/**
+ * @brief The number of allocations the calling thread has made since it last ended a frame. Only the render thread's
+ * count is ever read, so work on background threads (the simulation, audio, event log and so on) does not trip the
+ * steady-state check.
+ */
+static THREAD_LOCAL int threadAllocations = 0;
+
+/** @brief The depth of log output on the calling thread, whose allocations are not counted while it is non-zero. */
+static THREAD_LOCAL int loggingDepth = 0;
+
+bool ALLOC_ArenaInit(Arena* arena, const size_t capacity)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    arena->memory = SDL_calloc(1, capacity);
+    arena->capacity = arena->memory ? capacity : 0;
+    arena->used = 0;
+
+    return arena->memory != NULL;
+}
+
+void* ALLOC_ArenaAlloc(Arena* arena, const size_t size)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    const size_t offset = (arena->used + (ARENA_ALIGNMENT - 1)) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (offset > arena->capacity || size > arena->capacity - offset)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Arena is full, failed to allocate %zu bytes (%zu of %zu used)!", size, arena->used, arena->capacity);
+        return NULL;
+    }
+
+    arena->used = offset + size;
+    return arena->memory + offset;
+}
+
+void ALLOC_ArenaDestroy(Arena* arena)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Destroying arena (%zu of %zu bytes used)...", arena->used, arena->capacity);
+
+    SDL_free(arena->memory);
+    *arena = (Arena){ 0 };
+}
+
+/**
+ * @brief Count an allocation on the calling thread, unless it was made while the thread was outputting a log message.
+ */
+static void CountAllocation(void)
+{
+    if (loggingDepth == 0) threadAllocations++;
+}
+
+/** @brief An SDL_malloc_func that counts the allocation. */
+static void* SDLCALL CountingMalloc(const size_t size)
+{
+    CountAllocation();
+    return hooks.malloc(size);
+}
+
+/** @brief An SDL_calloc_func that counts the allocation. */
+static void* SDLCALL CountingCalloc(const size_t count, const size_t size)
+{
+    CountAllocation();
+    return hooks.calloc(count, size);
+}
+
+/** @brief An SDL_realloc_func that counts the allocation. */
+static void* SDLCALL CountingRealloc(void* memory, const size_t size)
+{
+    CountAllocation();
+    return hooks.realloc(memory, size);
+}
+
+/** @brief An SDL_free_func that forwards to the original. Freeing is not counted. */
+static void SDLCALL ForwardingFree(void* memory)
+{
+    hooks.free(memory);
+}
+
+/**
+ * @brief An SDL_LogOutputFunction that outputs with the original function, without counting its allocations.
+ */
+static void SDLCALL UncountedLogOutput(void* userData, const int category, const SDL_LogPriority priority, const char* message)
+{
+    (void)userData;
+
+    loggingDepth++;
+    hooks.logOutput(hooks.logOutputUserData, category, priority, message);
+    loggingDepth--;
+}
+
+bool ALLOC_InstallHooks(void)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_GetOriginalMemoryFunctions(&hooks.malloc, &hooks.calloc, &hooks.realloc, &hooks.free);
+    if (!SDL_SetMemoryFunctions(CountingMalloc, CountingCalloc, CountingRealloc, ForwardingFree)) return false;
+
+    SDL_GetLogOutputFunction(&hooks.logOutput, &hooks.logOutputUserData);
+    SDL_SetLogOutputFunction(UncountedLogOutput, NULL);
+
+    return true;
+}
+
+int ALLOC_EndFrame(const bool isSteadyState)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    const int allocations = threadAllocations;
+    threadAllocations = 0;
+
+    if (!isSteadyState)
+    {
+        hooks.steadyStateFrames = 0;
+        return allocations;
+    }
+
+    if (hooks.steadyStateFrames < ALLOCATOR_WARM_UP_FRAMES)
+    {
+        hooks.steadyStateFrames++;
+        return allocations;
+    }
+
+    if (allocations > 0)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d allocations were made during a steady-state frame!", allocations);
+    }
+    SDL_assert(allocations == 0 && "Nothing should be allocated during steady-state play");
+
+    return allocations;
+}
+
+void ALLOC_ResetSteadyState(void)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    hooks.steadyStateFrames = 0;
+}
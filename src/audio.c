@@ -0,0 +1,767 @@
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "audio.h"
+
+#include "trace.h"
+
+/** @brief The size (in bytes) of a frame of mixed audio. */
+#define AUDIO_FRAME_BYTES ((int)sizeof(float) * AUDIO_CHANNELS)
+
+/** @brief The gain applied to the music, and to every sound effect, before they are mixed. */
+static const float MUSIC_GAIN = 0.25f;
+static const float EFFECT_GAIN = 0.6f;
+
+/** @brief The name of each sound effect, which is also its file name (without .wav) in resources/audio. */
+static const char* EFFECT_NAMES[AUDIO_EFFECT_COUNT] = { "move", "rotate", "lock", "line_clear", "level_up" };
+
+/** @brief The number of frames in an eighth note of the theme, which is played at 150 beats per minute. */
+static const int THEME_EIGHTH_FRAMES = AUDIO_SAMPLE_RATE / 5;
+
+/** @brief The number of eighth notes in a loop of the theme. */
+static const int THEME_EIGHTHS = 64;
+
+/** @brief The melody of the theme (Korobeiniki), as pairs of MIDI note (0 for a rest) and length in eighth notes. */
+static const Uint8 THEME_MELODY[][2] = {
+    { 76, 2 }, { 71, 1 }, { 72, 1 }, { 74, 2 }, { 72, 1 }, { 71, 1 },
+    { 69, 2 }, { 69, 1 }, { 72, 1 }, { 76, 2 }, { 74, 1 }, { 72, 1 },
+    { 71, 3 }, { 72, 1 }, { 74, 2 }, { 76, 2 },
+    { 72, 2 }, { 69, 2 }, { 69, 2 }, { 0, 2 },
+    { 0, 1 }, { 74, 2 }, { 77, 1 }, { 81, 2 }, { 79, 1 }, { 77, 1 },
+    { 76, 3 }, { 72, 1 }, { 76, 2 }, { 74, 1 }, { 72, 1 },
+    { 71, 2 }, { 71, 1 }, { 72, 1 }, { 74, 2 }, { 76, 2 },
+    { 72, 2 }, { 69, 2 }, { 69, 2 }, { 0, 2 },
+};
+
+/** @brief The root of the bass line in each bar of the theme, as a MIDI note. The bass alternates root and octave. */
+static const Uint8 THEME_BASS[] = { 40, 45, 40, 45, 38, 36, 40, 45 };
+
+/** @brief The format everything is mixed in. */
+static const SDL_AudioSpec MIX_SPEC = { SDL_AUDIO_F32, AUDIO_CHANNELS, AUDIO_SAMPLE_RATE };
+
+/**
+ * @brief Get the frequency of a MIDI note.
+ *
+ * @param note The MIDI note, where 69 is A4.
+ *
+ * @return The frequency (in Hz).
+ */
+static float NoteToFrequency(const int note)
+{
+    return 440.0f * SDL_powf(2.0f, (float)(note - 69) / 12.0f);
+}
+
+/**
+ * @brief Add a decaying tone, sweeping from one frequency to another, to a clip.
+ *
+ * @param clip The clip, whose samples are added to.
+ * @param startSeconds The time (in seconds) into the clip the tone starts.
+ * @param seconds The length (in seconds) of the tone, which is cut short at the end of the clip.
+ * @param startHz The frequency the tone starts at.
+ * @param endHz The frequency the tone ends at.
+ * @param gain The peak amplitude of the tone.
+ * @param decay How quickly (per second) the tone fades.
+ * @param noise The fraction of the tone that is white noise rather than a sine wave.
+ * @param randomState The state of the random number generator used for noise.
+ */
+static void AddTone(AudioClip* clip, const float startSeconds, const float seconds, const float startHz, const float endHz, const float gain, const float decay, const float noise, Uint64* randomState)
+{
+    const int startFrame = (int)(startSeconds * AUDIO_SAMPLE_RATE);
+    const int frames = SDL_min((int)(seconds * AUDIO_SAMPLE_RATE), clip->frames - startFrame);
+
+    float phase = 0;
+    for (int i = 0; i < frames; i++)
+    {
+        const float t = (float)i / AUDIO_SAMPLE_RATE;
+
+        // A short attack avoids a click at the start of the tone
+        const float envelope = gain * SDL_min(t / 0.002f, 1.0f) * SDL_expf(-t * decay);
+        const float hz = startHz + (endHz - startHz) * (float)i / (float)frames;
+        phase += hz / AUDIO_SAMPLE_RATE;
+        phase -= SDL_floorf(phase);
+
+        const float tone = SDL_sinf(2.0f * SDL_PI_F * phase) * (1.0f - noise) + (SDL_randf_r(randomState) * 2.0f - 1.0f) * noise;
+        float* frame = &clip->samples[(startFrame + i) * AUDIO_CHANNELS];
+        for (int channel = 0; channel < AUDIO_CHANNELS; channel++) frame[channel] += tone * envelope;
+    }
+}
+
+/**
+ * @brief Synthesise a sound effect, for when there is no file to load it from.
+ *
+ * @param effect The effect.
+ * @param clip The clip to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool SynthesiseEffect(const AudioEffect effect, AudioClip* clip)
+{
+    static const float LENGTHS[AUDIO_EFFECT_COUNT] = { 0.04f, 0.07f, 0.12f, 0.45f, 0.6f };
+
+    // The semitones above the root of each note of a major arpeggio
+    static const int ARPEGGIO[] = { 0, 4, 7, 12, 16 };
+
+    clip->frames = (int)(LENGTHS[effect] * AUDIO_SAMPLE_RATE);
+    clip->samples = SDL_calloc((size_t)clip->frames * AUDIO_CHANNELS, sizeof(float));
+    if (!clip->samples) return false;
+
+    Uint64 randomState = 1;
+    switch (effect)
+    {
+    case AUDIO_EFFECT_MOVE:
+        AddTone(clip, 0, 0.04f, 900, 700, 0.35f, 90, 0, &randomState);
+        break;
+    case AUDIO_EFFECT_ROTATE:
+        AddTone(clip, 0, 0.07f, 500, 1000, 0.35f, 40, 0, &randomState);
+        break;
+    case AUDIO_EFFECT_LOCK:
+        AddTone(clip, 0, 0.12f, 140, 60, 0.7f, 30, 0, &randomState);
+        AddTone(clip, 0, 0.03f, 0, 0, 0.25f, 120, 1, &randomState);
+        break;
+    case AUDIO_EFFECT_LINE_CLEAR:
+        // A C major arpeggio, from C6
+        for (int i = 0; i < 3; i++)
+        {
+            const float hz = NoteToFrequency(84 + ARPEGGIO[i]);
+            AddTone(clip, 0.07f * (float)i, 0.3f, hz, hz, 0.3f, 10, 0, &randomState);
+        }
+        break;
+    case AUDIO_EFFECT_LEVEL_UP:
+        // A rising C major arpeggio over two octaves, from C5
+        for (int i = 0; i < 5; i++)
+        {
+            const float hz = NoteToFrequency(72 + ARPEGGIO[i]);
+            AddTone(clip, 0.08f * (float)i, 0.25f, hz, hz, 0.3f, 8, 0, &randomState);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Load a sound effect from resources/audio, converted to the mixer's format, or synthesise it if there is no
+ * file for it.
+ *
+ * @param effect The effect.
+ * @param clip The clip to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool LoadEffect(const AudioEffect effect, AudioClip* clip)
+{
+    char path[256];
+    SDL_snprintf(path, sizeof(path), "resources/audio/%s.wav", EFFECT_NAMES[effect]);
+
+    SDL_AudioSpec spec;
+    Uint8* wav = NULL;
+    Uint32 wavLength = 0;
+    if (!SDL_LoadWAV(path, &spec, &wav, &wavLength))
+    {
+        SDL_LogDebug(SDL_LOG_CATEGORY_AUDIO, "No sound effect at '%s', synthesising it...", path);
+        return SynthesiseEffect(effect, clip);
+    }
+
+    Uint8* samples = NULL;
+    int length = 0;
+    const bool success = SDL_ConvertAudioSamples(&spec, wav, (int)wavLength, &MIX_SPEC, &samples, &length);
+    SDL_free(wav);
+    if (!success)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to convert sound effect '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    clip->samples = (float*)samples;
+    clip->frames = length / AUDIO_FRAME_BYTES;
+    return true;
+}
+
+/**
+ * @brief Read the header of a WAV file, up to the start of its sample data.
+ *
+ * @param file The file, which is left at the start of the sample data.
+ * @param spec The spec to write the format of the samples to.
+ * @param dataSize The size (in bytes) to write the sample data's size to.
+ *
+ * @return True on success, false if the file is not a WAV file of a supported format.
+ */
+static bool ReadWAVHeader(SDL_IOStream* file, SDL_AudioSpec* spec, Sint64* dataSize)
+{
+    Uint32 riff, riffSize, wave;
+    if (!SDL_ReadU32LE(file, &riff) || !SDL_ReadU32LE(file, &riffSize) || !SDL_ReadU32LE(file, &wave)) return false;
+    if (riff != 0x46464952 || wave != 0x45564157) return false;
+
+    bool hasFormat = false;
+    for (;;)
+    {
+        Uint32 chunkId, chunkSize;
+        if (!SDL_ReadU32LE(file, &chunkId) || !SDL_ReadU32LE(file, &chunkSize)) return false;
+
+        // "data", which must come after "fmt "
+        if (chunkId == 0x61746164)
+        {
+            *dataSize = chunkSize;
+            return hasFormat;
+        }
+
+        const Sint64 nextChunk = SDL_TellIO(file) + chunkSize + (chunkSize & 1);
+
+        // "fmt "
+        if (chunkId == 0x20746D66)
+        {
+            Uint16 formatTag, channels, blockAlign, bits;
+            Uint32 rate, byteRate;
+            if (!SDL_ReadU16LE(file, &formatTag) || !SDL_ReadU16LE(file, &channels) || !SDL_ReadU32LE(file, &rate) ||
+                !SDL_ReadU32LE(file, &byteRate) || !SDL_ReadU16LE(file, &blockAlign) || !SDL_ReadU16LE(file, &bits)) return false;
+
+            // WAVE_FORMAT_EXTENSIBLE keeps the real format tag at the start of its sub-format GUID
+            if (formatTag == 0xFFFE && chunkSize >= 40)
+            {
+                Uint16 extensionSize, validBits;
+                Uint32 channelMask;
+                if (!SDL_ReadU16LE(file, &extensionSize) || !SDL_ReadU16LE(file, &validBits) ||
+                    !SDL_ReadU32LE(file, &channelMask) || !SDL_ReadU16LE(file, &formatTag)) return false;
+            }
+
+            if (formatTag == 1 && bits == 8) spec->format = SDL_AUDIO_U8;
+            else if (formatTag == 1 && bits == 16) spec->format = SDL_AUDIO_S16LE;
+            else if (formatTag == 1 && bits == 32) spec->format = SDL_AUDIO_S32LE;
+            else if (formatTag == 3 && bits == 32) spec->format = SDL_AUDIO_F32LE;
+            else return false;
+
+            spec->channels = channels;
+            spec->freq = (int)rate;
+            hasFormat = (channels > 0 && rate > 0);
+        }
+
+        if (SDL_SeekIO(file, nextChunk, SDL_IO_SEEK_SET) < 0) return false;
+    }
+}
+
+/**
+ * @brief Open a WAV file to be streamed as music.
+ *
+ * @param music The music source to open the file into.
+ * @param path The path of the file.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool OpenMusicFile(AudioMusic* music, const char* path)
+{
+    music->file = SDL_IOFromFile(path, "rb");
+    if (!music->file) return false;
+
+    SDL_AudioSpec spec = { 0 };
+    Sint64 dataSize = 0;
+    if (ReadWAVHeader(music->file, &spec, &dataSize)) music->converter = SDL_CreateAudioStream(&spec, &MIX_SPEC);
+
+    // Only whole frames are read, and there must be at least one
+    music->frameBytes = SDL_AUDIO_FRAMESIZE(spec);
+    music->dataStart = SDL_TellIO(music->file);
+    music->dataSize = (music->frameBytes > 0) ? dataSize - dataSize % music->frameBytes : 0;
+    music->dataRemaining = music->dataSize;
+
+    if (!music->converter || music->dataSize <= 0)
+    {
+        if (music->converter) SDL_DestroyAudioStream(music->converter);
+        SDL_CloseIO(music->file);
+        music->converter = NULL;
+        music->file = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decode the next frames of a WAV file, looping back to its start at the end.
+ *
+ * @param music The music source.
+ * @param out The buffer to write the frames to.
+ * @param frames The number of frames to decode.
+ *
+ * @return True on success, false if the file could not be read.
+ */
+static bool StreamMusicFile(AudioMusic* music, float* out, const int frames)
+{
+    const int bytes = frames * AUDIO_FRAME_BYTES;
+    Uint8 chunk[4096];
+    const Sint64 chunkBytes = (Sint64)(sizeof(chunk) / (size_t)music->frameBytes) * music->frameBytes;
+
+    while (SDL_GetAudioStreamAvailable(music->converter) < bytes)
+    {
+        const bool isLooping = (music->dataRemaining <= 0);
+        if (isLooping)
+        {
+            if (SDL_SeekIO(music->file, music->dataStart, SDL_IO_SEEK_SET) < 0) return false;
+            music->dataRemaining = music->dataSize;
+        }
+
+        const size_t read = SDL_ReadIO(music->file, chunk, (size_t)SDL_min(chunkBytes, music->dataRemaining));
+
+        // A file that is shorter than its header says loops early, but one with no samples left at all is broken
+        if (read == 0 && isLooping) return false;
+        music->dataRemaining = (read == 0) ? 0 : music->dataRemaining - (Sint64)read;
+        if (read > 0 && !SDL_PutAudioStreamData(music->converter, chunk, (int)read)) return false;
+    }
+
+    return SDL_GetAudioStreamData(music->converter, out, bytes) == bytes;
+}
+
+/**
+ * @brief Find the note of the theme's melody playing at an eighth note of the loop.
+ *
+ * @param eighth The eighth note of the loop.
+ * @param startEighth The eighth note to write the start of the note to.
+ * @param length The number of eighth notes to write the note's length to.
+ *
+ * @return The MIDI note, or 0 for a rest.
+ */
+static int FindMelodyNote(const int eighth, int* startEighth, int* length)
+{
+    int start = 0;
+    for (size_t i = 0; i < SDL_arraysize(THEME_MELODY); i++)
+    {
+        if (eighth < start + THEME_MELODY[i][1])
+        {
+            *startEighth = start;
+            *length = THEME_MELODY[i][1];
+            return THEME_MELODY[i][0];
+        }
+        start += THEME_MELODY[i][1];
+    }
+
+    *startEighth = eighth;
+    *length = 1;
+    return 0;
+}
+
+/**
+ * @brief Synthesise the next frames of the theme: a pulse wave melody over a triangle wave bass.
+ *
+ * @param music The music source.
+ * @param out The buffer to write the frames to.
+ * @param frames The number of frames to synthesise.
+ */
+static void SynthesiseTheme(AudioMusic* music, float* out, int frames)
+{
+    while (frames > 0)
+    {
+        // Each eighth note is synthesised in one run, as no note changes part way through it
+        const int eighth = (int)(music->songFrame / (Uint64)THEME_EIGHTH_FRAMES);
+        const int frameInEighth = (int)(music->songFrame % (Uint64)THEME_EIGHTH_FRAMES);
+        const int count = SDL_min(frames, THEME_EIGHTH_FRAMES - frameInEighth);
+
+        int noteStart, noteLength;
+        const int note = FindMelodyNote(eighth, &noteStart, &noteLength);
+        const float melodyStep = (note != 0) ? NoteToFrequency(note) / AUDIO_SAMPLE_RATE : 0;
+        const float melodyFrames = (float)(noteLength * THEME_EIGHTH_FRAMES);
+        const int melodyAge = (eighth - noteStart) * THEME_EIGHTH_FRAMES + frameInEighth;
+
+        const int bassNote = THEME_BASS[eighth / 8] + ((eighth & 1) ? 12 : 0);
+        const float bassStep = NoteToFrequency(bassNote) / AUDIO_SAMPLE_RATE;
+
+        for (int i = 0; i < count; i++)
+        {
+            float sample = 0;
+
+            if (note != 0)
+            {
+                // A quarter duty cycle pulse, fading over the note and released just before the next one
+                const float t = (float)(melodyAge + i) / melodyFrames;
+                const float envelope = (1.0f - 0.6f * t) * SDL_min((1.0f - t) * 20.0f, 1.0f);
+                sample += ((music->melodyPhase < 0.25f) ? 0.5f : -0.5f) * envelope;
+                music->melodyPhase += melodyStep;
+                music->melodyPhase -= SDL_floorf(music->melodyPhase);
+            }
+
+            const float bassT = (float)(frameInEighth + i) / (float)THEME_EIGHTH_FRAMES;
+            sample += (4.0f * SDL_fabsf(music->bassPhase - 0.5f) - 1.0f) * 0.6f * (1.0f - 0.5f * bassT);
+            music->bassPhase += bassStep;
+            music->bassPhase -= SDL_floorf(music->bassPhase);
+
+            for (int channel = 0; channel < AUDIO_CHANNELS; channel++) out[i * AUDIO_CHANNELS + channel] = sample;
+        }
+
+        out += count * AUDIO_CHANNELS;
+        frames -= count;
+        music->songFrame = (music->songFrame + (Uint64)count) % ((Uint64)THEME_EIGHTHS * (Uint64)THEME_EIGHTH_FRAMES);
+    }
+}
+
+/**
+ * @brief Close the music file, if there is one, so the theme is synthesised instead.
+ *
+ * @param music The music source.
+ */
+static void CloseMusicFile(AudioMusic* music)
+{
+    if (music->converter) SDL_DestroyAudioStream(music->converter);
+    if (music->file) SDL_CloseIO(music->file);
+    music->converter = NULL;
+    music->file = NULL;
+}
+
+/**
+ * @brief Decode music into the ring buffer until it is full, a chunk at a time.
+ *
+ * @param audio A pointer to the engine.
+ */
+static void RefillMusic(AudioEngine* audio)
+{
+    Uint32 tail = SDL_GetAtomicU32(&audio->musicTail);
+    Uint32 freeFrames = AUDIO_MUSIC_RING_FRAMES - (tail - SDL_GetAtomicU32(&audio->musicHead));
+
+    while (freeFrames >= AUDIO_MUSIC_CHUNK_FRAMES)
+    {
+        // Frames the mixer has read are free to be overwritten, so decode straight into the ring
+        const Uint32 index = tail & (AUDIO_MUSIC_RING_FRAMES - 1);
+        const int frames = (int)SDL_min((Uint32)AUDIO_MUSIC_CHUNK_FRAMES, AUDIO_MUSIC_RING_FRAMES - index);
+        float* out = &audio->musicRing[index * AUDIO_CHANNELS];
+
+        if (audio->music.file && !StreamMusicFile(&audio->music, out, frames))
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_AUDIO, "Failed to read music, so playing the theme instead: %s", SDL_GetError());
+            CloseMusicFile(&audio->music);
+        }
+        if (!audio->music.file) SynthesiseTheme(&audio->music, out, frames);
+
+        tail += (Uint32)frames;
+        freeFrames -= (Uint32)frames;
+        SDL_SetAtomicU32(&audio->musicTail, tail);
+    }
+}
+
+/**
+ * @brief The music decoder thread, which keeps the ring buffer full until stopped.
+ *
+ * @param data A pointer to the engine.
+ *
+ * @return Zero.
+ */
+static int SDLCALL AudioDecoderThread(void* data)
+{
+    AudioEngine* audio = data;
+    TRACE_NameThread("AudioDecoder");
+
+    while (!SDL_GetAtomicInt(&audio->isStopping))
+    {
+        TRACE_BEGIN("RefillMusic");
+        RefillMusic(audio);
+        TRACE_END("RefillMusic");
+        SDL_WaitSemaphoreTimeout(audio->wake, AUDIO_MUSIC_REFILL_INTERVAL_MS);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Start a voice for every triggered effect, recording how long each will have taken to be heard.
+ *
+ * @param audio A pointer to the engine.
+ * @param outputNS The time (in nanoseconds, from SDL_GetTicksNS) the first frame mixed now will reach the device.
+ */
+static void StartTriggeredVoices(AudioEngine* audio, const Uint64 outputNS)
+{
+    int head = SDL_GetAtomicInt(&audio->triggerHead);
+    const int tail = SDL_GetAtomicInt(&audio->triggerTail);
+
+    for (; head != tail; head++)
+    {
+        const AudioTrigger* trigger = &audio->triggers[head & (AUDIO_TRIGGER_CAPACITY - 1)];
+
+        // Use a free voice, or else steal the one nearest its end
+        AudioVoice* voice = &audio->voices[0];
+        for (int i = 0; i < AUDIO_VOICE_COUNT; i++)
+        {
+            if (!audio->voices[i].clip)
+            {
+                voice = &audio->voices[i];
+                break;
+            }
+            if (audio->voices[i].clip->frames - audio->voices[i].position < voice->clip->frames - voice->position) voice = &audio->voices[i];
+        }
+
+        *voice = (AudioVoice){ &audio->clips[trigger->effect], 0, trigger->gain };
+
+        audio->latencies[audio->nextLatency] = (outputNS > trigger->timestampNS) ? outputNS - trigger->timestampNS : 0;
+        audio->nextLatency = (audio->nextLatency + 1) % AUDIO_LATENCY_SAMPLE_CAPACITY;
+        if (audio->latencyCount < AUDIO_LATENCY_SAMPLE_CAPACITY) audio->latencyCount++;
+    }
+
+    SDL_SetAtomicInt(&audio->triggerHead, head);
+}
+
+/**
+ * @brief Mix frames of music and every playing voice into the mixing buffer.
+ *
+ * @param audio A pointer to the engine.
+ * @param frames The number of frames to mix, up to AUDIO_MIX_FRAMES.
+ */
+static void MixFrames(AudioEngine* audio, const int frames)
+{
+    float* out = audio->mixBuffer;
+    int musicFrames = 0;
+
+    // Held music is left in the ring buffer, to carry on from where it stopped
+    if (audio->hasMusic && !SDL_GetAtomicInt(&audio->isMusicHeld))
+    {
+        const Uint32 head = SDL_GetAtomicU32(&audio->musicHead);
+        const Uint32 available = SDL_GetAtomicU32(&audio->musicTail) - head;
+        musicFrames = (int)SDL_min((Uint32)frames, available);
+
+        for (int i = 0; i < musicFrames; i++)
+        {
+            const float* in = &audio->musicRing[((head + (Uint32)i) & (AUDIO_MUSIC_RING_FRAMES - 1)) * AUDIO_CHANNELS];
+            for (int channel = 0; channel < AUDIO_CHANNELS; channel++) out[i * AUDIO_CHANNELS + channel] = in[channel] * MUSIC_GAIN;
+        }
+
+        SDL_SetAtomicU32(&audio->musicHead, head + (Uint32)musicFrames);
+        audio->musicUnderrunFrames += (Uint64)(frames - musicFrames);
+    }
+    SDL_memset(&out[musicFrames * AUDIO_CHANNELS], 0, (size_t)(frames - musicFrames) * AUDIO_FRAME_BYTES);
+
+    for (int v = 0; v < AUDIO_VOICE_COUNT; v++)
+    {
+        AudioVoice* voice = &audio->voices[v];
+        if (!voice->clip) continue;
+
+        const int count = SDL_min(frames, voice->clip->frames - voice->position);
+        const float* in = &voice->clip->samples[voice->position * AUDIO_CHANNELS];
+        const float gain = voice->gain * EFFECT_GAIN;
+        for (int i = 0; i < count * AUDIO_CHANNELS; i++) out[i] += in[i] * gain;
+
+        voice->position += count;
+        if (voice->position >= voice->clip->frames) voice->clip = NULL;
+    }
+
+    for (int i = 0; i < frames * AUDIO_CHANNELS; i++) out[i] = SDL_clamp(out[i], -1.0f, 1.0f);
+}
+
+/**
+ * @brief The audio device callback, which mixes exactly as many frames as the device asks for.
+ *
+ * @param userData A pointer to the engine.
+ * @param stream The device stream.
+ * @param additionalAmount The number of bytes the device needs.
+ * @param totalAmount The number of bytes the device could use, of which the rest are already queued.
+ */
+static void SDLCALL AudioMixCallback(void* userData, SDL_AudioStream* stream, const int additionalAmount, const int totalAmount)
+{
+    (void)totalAmount;
+
+    AudioEngine* audio = userData;
+    const Uint64 startNS = SDL_GetTicksNS();
+    int frames = additionalAmount / AUDIO_FRAME_BYTES;
+    if (frames <= 0) return;
+
+    // Effects start on the first frame mixed now, which is heard once everything queued ahead of it has been played
+    const int aheadFrames = SDL_GetAudioStreamQueued(stream) / AUDIO_FRAME_BYTES + audio->deviceFrames;
+    StartTriggeredVoices(audio, startNS + (Uint64)aheadFrames * SDL_NS_PER_SECOND / AUDIO_SAMPLE_RATE);
+
+    while (frames > 0)
+    {
+        const int count = SDL_min(frames, AUDIO_MIX_FRAMES);
+        MixFrames(audio, count);
+        SDL_PutAudioStreamData(stream, audio->mixBuffer, count * AUDIO_FRAME_BYTES);
+        frames -= count;
+        audio->mixedFrames += (Uint64)count;
+    }
+
+    if (audio->hasMusic && SDL_GetAtomicU32(&audio->musicTail) - SDL_GetAtomicU32(&audio->musicHead) < AUDIO_MUSIC_RING_FRAMES / 2)
+    {
+        SDL_SignalSemaphore(audio->wake);
+    }
+
+    const Uint64 elapsedNS = SDL_GetTicksNS() - startNS;
+    audio->mixNS += elapsedNS;
+    if (elapsedNS > audio->worstCallbackNS) audio->worstCallbackNS = elapsedNS;
+}
+
+/**
+ * @brief Free every sound and close the music source.
+ *
+ * @param audio A pointer to the engine.
+ */
+static void FreeSounds(AudioEngine* audio)
+{
+    for (int effect = 0; effect < AUDIO_EFFECT_COUNT; effect++)
+    {
+        SDL_free(audio->clips[effect].samples);
+        audio->clips[effect] = (AudioClip){ 0 };
+    }
+
+    CloseMusicFile(&audio->music);
+}
+
+bool AUDIO_Open(AudioEngine* audio, const char* musicPath)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_AUDIO, "Calling %s...", __func__);
+
+    SDL_zerop(audio);
+
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to initialise audio: %s", SDL_GetError());
+        return false;
+    }
+
+    for (int effect = 0; effect < AUDIO_EFFECT_COUNT; effect++)
+    {
+        if (!LoadEffect((AudioEffect)effect, &audio->clips[effect]))
+        {
+            FreeSounds(audio);
+            SDL_QuitSubSystem(SDL_INIT_AUDIO);
+            return false;
+        }
+    }
+
+    audio->hasMusic = !(musicPath && !SDL_strcmp(musicPath, "none"));
+    if (audio->hasMusic && musicPath && !OpenMusicFile(&audio->music, musicPath))
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_AUDIO, "Failed to open music '%s', so playing the theme instead!", musicPath);
+    }
+
+    // Fill the ring buffer before the device starts, so the music starts straight away
+    if (audio->hasMusic) RefillMusic(audio);
+
+    // Ask for a small device buffer, as it is the bulk of the latency of effects
+    char deviceFrames[16];
+    SDL_snprintf(deviceFrames, sizeof(deviceFrames), "%d", AUDIO_DEVICE_FRAMES);
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES, deviceFrames);
+
+    audio->stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &MIX_SPEC, AudioMixCallback, audio);
+    if (!audio->stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to open audio device: %s", SDL_GetError());
+        AUDIO_Close(audio);
+        return false;
+    }
+
+    SDL_AudioSpec deviceSpec;
+    if (!SDL_GetAudioDeviceFormat(SDL_GetAudioStreamDevice(audio->stream), &deviceSpec, &audio->deviceFrames)) audio->deviceFrames = AUDIO_DEVICE_FRAMES;
+
+    if (audio->hasMusic)
+    {
+        audio->wake = SDL_CreateSemaphore(0);
+        if (audio->wake) audio->decoder = SDL_CreateThread(AudioDecoderThread, "AudioDecoder", audio);
+        if (!audio->decoder)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to create music decoder thread: %s", SDL_GetError());
+            AUDIO_Close(audio);
+            return false;
+        }
+    }
+
+    if (!SDL_ResumeAudioStreamDevice(audio->stream))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_AUDIO, "Failed to start audio device: %s", SDL_GetError());
+        AUDIO_Close(audio);
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_AUDIO, "Playing audio at %d Hz with a %d frame (%.1fms) device buffer, music: %s", AUDIO_SAMPLE_RATE,
+        audio->deviceFrames, (double)audio->deviceFrames * 1000.0 / AUDIO_SAMPLE_RATE, !audio->hasMusic ? "none" : audio->music.file ? musicPath : "theme");
+    return true;
+}
+
+void AUDIO_Close(AudioEngine* audio)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_AUDIO, "Calling %s...", __func__);
+
+    // Destroying the stream closes the device, after which the mixer never runs again
+    const bool wasPlaying = (audio->stream != NULL);
+    if (audio->stream)
+    {
+        SDL_DestroyAudioStream(audio->stream);
+        audio->stream = NULL;
+    }
+
+    if (audio->decoder)
+    {
+        SDL_SetAtomicInt(&audio->isStopping, 1);
+        SDL_SignalSemaphore(audio->wake);
+        SDL_WaitThread(audio->decoder, NULL);
+        audio->decoder = NULL;
+    }
+
+    if (audio->wake)
+    {
+        SDL_DestroySemaphore(audio->wake);
+        audio->wake = NULL;
+    }
+
+    FreeSounds(audio);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+
+    if (wasPlaying)
+    {
+        AudioStats stats;
+        AUDIO_GetStats(audio, &stats);
+        AUDIO_LogStats(&stats);
+    }
+}
+
+void AUDIO_Listen(void* userData, const GameEvent* event)
+{
+    AudioEngine* audio = userData;
+
+    AudioEffect effect;
+    float gain = 1.0f;
+    switch (event->type)
+    {
+    case GAME_EVENT_MOVE: effect = AUDIO_EFFECT_MOVE; gain = 0.5f; break;
+    case GAME_EVENT_ROTATE: effect = AUDIO_EFFECT_ROTATE; gain = 0.6f; break;
+    case GAME_EVENT_LOCK: effect = AUDIO_EFFECT_LOCK; gain = 0.8f; break;
+    case GAME_EVENT_LINE_CLEAR: effect = AUDIO_EFFECT_LINE_CLEAR; gain = 0.6f + 0.1f * (float)event->lines; break;
+    case GAME_EVENT_LEVEL_UP: effect = AUDIO_EFFECT_LEVEL_UP; break;
+
+    // The music is held while the game is not being played
+    case GAME_EVENT_PAUSE:
+    case GAME_EVENT_GAME_OVER:
+        SDL_SetAtomicInt(&audio->isMusicHeld, 1);
+        return;
+    case GAME_EVENT_RESUME:
+    case GAME_EVENT_START:
+        SDL_SetAtomicInt(&audio->isMusicHeld, 0);
+        return;
+    default:
+        return;
+    }
+
+    const int tail = SDL_GetAtomicInt(&audio->triggerTail);
+    if (tail - SDL_GetAtomicInt(&audio->triggerHead) >= AUDIO_TRIGGER_CAPACITY)
+    {
+        SDL_AddAtomicInt(&audio->droppedTriggers, 1);
+        return;
+    }
+
+    audio->triggers[tail & (AUDIO_TRIGGER_CAPACITY - 1)] = (AudioTrigger){ effect, gain, SDL_GetTicksNS() };
+    SDL_SetAtomicInt(&audio->triggerTail, tail + 1);
+}
+
+void AUDIO_GetStats(AudioEngine* audio, AudioStats* stats)
+{
+    *stats = (AudioStats){ 0 };
+    LATENCY_CalculateStats(audio->latencies, audio->latencyCount, audio->sortBuffer, &stats->latency);
+
+    const double mixedNS = (double)audio->mixedFrames * (double)SDL_NS_PER_SECOND / AUDIO_SAMPLE_RATE;
+    stats->mixerLoadPercent = (mixedNS > 0) ? (double)audio->mixNS * 100.0 / mixedNS : 0;
+    stats->worstCallbackNS = audio->worstCallbackNS;
+    stats->mixedFrames = audio->mixedFrames;
+    stats->musicUnderrunFrames = audio->musicUnderrunFrames;
+    stats->droppedTriggers = SDL_GetAtomicInt(&audio->droppedTriggers);
+}
+
+void AUDIO_LogStats(const AudioStats* stats)
+{
+    SDL_Log("Audio mixed %.1fs: mixer load %.3f%%, worst callback %.3fms, %" SDL_PRIu64 " music underrun frames, %d dropped effects",
+        (double)stats->mixedFrames / AUDIO_SAMPLE_RATE, stats->mixerLoadPercent, (double)stats->worstCallbackNS / SDL_NS_PER_MS,
+        stats->musicUnderrunFrames, stats->droppedTriggers);
+    SDL_Log("  trigger->output over %d effects (ms): p50=%.3f p90=%.3f p99=%.3f max=%.3f", stats->latency.count,
+        (double)stats->latency.p50 / SDL_NS_PER_MS, (double)stats->latency.p90 / SDL_NS_PER_MS,
+        (double)stats->latency.p99 / SDL_NS_PER_MS, (double)stats->latency.max / SDL_NS_PER_MS);
+}
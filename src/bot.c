@@ -0,0 +1,818 @@
+#include "bot.h"
+
+#include "game.h"
+#include "metrics.h"
+#include "tetromino.h"
+#include "trace.h"
+#include "zobrist.h"
+
+/** @brief A row mask with every column in the arena filled. */
+#define FULL_ROW_MASK ((Uint16)((1u << ARENA_WIDTH) - 1))
+
+/** @brief The weight of each cleared line in an evaluation. */
+#define LINES_CLEARED_WEIGHT 0.760666f
+
+/** @brief The evaluation of a position where the next tetromino cannot be placed, which is worse than any other. */
+#define LOST_EVALUATION (-1000000.0f)
+
+/**
+ * @brief A way to place a tetromino, found by PlacePiece.
+ */
+typedef struct PiecePlacement
+{
+    Uint16 pieceRows[TETROMINO_MAX_SIZE];
+    int x;
+
+    /** @brief The y-coordinate the tetromino is moved to before it is hard dropped. */
+    int startY;
+
+    /** @brief The y-coordinate the tetromino lands at. */
+    int y;
+
+    enum Orientation orientation;
+} PiecePlacement;
+
+/**
+ * @brief Count the number of set bits in a row mask.
+ *
+ * @param mask The row mask.
+ *
+ * @return The number of set bits.
+ */
+static int CountSetBits(Uint16 mask)
+{
+    int count = 0;
+    while (mask)
+    {
+        mask &= (Uint16)(mask - 1);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Find the index of the lowest set bit in a (non-zero) row mask.
+ *
+ * @param mask The row mask.
+ *
+ * @return The index of the lowest set bit.
+ */
+static int CountTrailingZeros(Uint16 mask)
+{
+    int count = 0;
+    while (!(mask & 1u))
+    {
+        mask >>= 1;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Convert the arena into one bitmask per row, where bit n is set if column n is filled.
+ *
+ * @param arena The matrix representation of the tetris arena.
+ * @param rows The row masks to write to.
+ */
+static void BuildRowMasks(const TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH], Uint16 rows[ARENA_HEIGHT])
+{
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        rows[row] = 0;
+        for (int col = 0; col < ARENA_WIDTH; col++)
+        {
+            if (arena[row][col] != 0) rows[row] |= (Uint16)(1u << col);
+        }
+    }
+}
+
+/**
+ * @brief Convert a tetromino orientation into one bitmask per row of its matrix representation.
+ *
+ * @param shape The tetromino shape.
+ * @param orientation The orientation of the tetromino.
+ * @param pieceRows The row masks to write to.
+ */
+static void BuildPieceMasks(const TetrominoShape* shape, const enum Orientation orientation, Uint16 pieceRows[TETROMINO_MAX_SIZE])
+{
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        pieceRows[i] = 0;
+        for (int j = 0; j < TETROMINO_MAX_SIZE; j++)
+        {
+            if (shape->coordinates[orientation][i][j]) pieceRows[i] |= (Uint16)(1u << j);
+        }
+    }
+}
+
+/**
+ * @brief The row mask equivalent of WillDroppingTetrominoCollide, checking whether a tetromino fits at a position.
+ *
+ * @param rows The arena row masks.
+ * @param pieceRows The tetromino row masks.
+ * @param x The x-coordinate of the tetromino.
+ * @param y The y-coordinate of the tetromino.
+ *
+ * @return True if the tetromino fits without colliding with the arena bounds or the stack, false otherwise.
+ */
+static bool PieceFits(const Uint16 rows[ARENA_HEIGHT], const Uint16 pieceRows[TETROMINO_MAX_SIZE], const int x, const int y)
+{
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        if (!pieceRows[i]) continue;
+
+        const int row = y + i;
+        if (row < 0 || row >= ARENA_HEIGHT) return false;
+
+        Uint32 shifted;
+        if (x >= 0)
+        {
+            shifted = (Uint32)pieceRows[i] << x;
+            if (shifted & ~(Uint32)FULL_ROW_MASK) return false;
+        }
+        else
+        {
+            if (pieceRows[i] & ((1u << -x) - 1)) return false;
+            shifted = (Uint32)pieceRows[i] >> -x;
+        }
+
+        if (rows[row] & shifted) return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Lock a tetromino into the arena row masks, and then clear any filled rows.
+ *
+ * @param rows The arena row masks, which are left unmodified.
+ * @param pieceRows The tetromino row masks.
+ * @param x The x-coordinate of the tetromino.
+ * @param y The y-coordinate of the tetromino.
+ * @param result The row masks to write the resulting arena to.
+ *
+ * @return The number of lines cleared.
+ */
+static int LockPiece(const Uint16 rows[ARENA_HEIGHT], const Uint16 pieceRows[TETROMINO_MAX_SIZE], const int x, const int y, Uint16 result[ARENA_HEIGHT])
+{
+    memcpy(result, rows, sizeof(Uint16) * ARENA_HEIGHT);
+
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        if (!pieceRows[i]) continue;
+        result[y + i] |= (Uint16)((x >= 0) ? (pieceRows[i] << x) : (pieceRows[i] >> -x));
+    }
+
+    // Compact the arena from the bottom upwards, skipping filled rows
+    int linesCleared = 0;
+    int writeRow = ARENA_HEIGHT - 1;
+    for (int row = ARENA_HEIGHT - 1; row >= 0; row--)
+    {
+        if (result[row] == FULL_ROW_MASK)
+        {
+            linesCleared++;
+            continue;
+        }
+        result[writeRow--] = result[row];
+    }
+    while (writeRow >= 0) result[writeRow--] = 0;
+
+    return linesCleared;
+}
+
+/**
+ * @brief Score an arena.
+ *
+ * @param rows The arena row masks.
+ * @param linesCleared The number of lines cleared to reach the arena.
+ *
+ * @return The evaluation of the arena, higher is better.
+ */
+static float EvaluateRows(const Uint16 rows[ARENA_HEIGHT], const int linesCleared)
+{
+    // Scan downwards from the highest block, tracking which columns have been covered by a block so far. Every
+    // covered column that is empty in a lower row is a hole.
+    int topRow = 0;
+    while (topRow < ARENA_HEIGHT && !rows[topRow]) topRow++;
+
+    int heights[ARENA_WIDTH] = { 0 };
+    int holes = 0;
+    Uint16 covered = 0;
+    for (int row = topRow; row < ARENA_HEIGHT; row++)
+    {
+        Uint16 newlyCovered = rows[row] & (Uint16)~covered;
+        while (newlyCovered)
+        {
+            const int col = CountTrailingZeros(newlyCovered);
+            heights[col] = ARENA_HEIGHT - row;
+            newlyCovered &= (Uint16)(newlyCovered - 1);
+        }
+
+        holes += CountSetBits(covered & (Uint16)~rows[row]);
+        covered |= rows[row];
+    }
+
+    int aggregateHeight = heights[0];
+    int bumpiness = 0;
+    for (int col = 1; col < ARENA_WIDTH; col++)
+    {
+        aggregateHeight += heights[col];
+        bumpiness += (heights[col] > heights[col - 1]) ? heights[col] - heights[col - 1] : heights[col - 1] - heights[col];
+    }
+
+    return -0.510066f * (float)aggregateHeight
+         + LINES_CLEARED_WEIGHT * (float)linesCleared
+         - 0.35663f * (float)holes
+         - 0.184483f * (float)bumpiness;
+}
+
+/**
+ * @brief Lock a tetromino into the arena row masks, clear any filled rows, and then score the resulting arena.
+ *
+ * @param rows The arena row masks, which are left unmodified.
+ * @param pieceRows The tetromino row masks.
+ * @param x The x-coordinate of the tetromino.
+ * @param y The y-coordinate of the tetromino.
+ *
+ * @return The evaluation of the arena, higher is better.
+ */
+static float EvaluatePlacement(const Uint16 rows[ARENA_HEIGHT], const Uint16 pieceRows[TETROMINO_MAX_SIZE], const int x, const int y)
+{
+    Uint16 result[ARENA_HEIGHT];
+    const int linesCleared = LockPiece(rows, pieceRows, x, y, result);
+    return EvaluateRows(result, linesCleared);
+}
+
+/**
+ * @brief Find every way a tetromino can be hard dropped into an arena.
+ *
+ * @param rows The arena row masks.
+ * @param shape The tetromino shape.
+ * @param spawnY The y-coordinate the tetromino starts at.
+ * @param placements The BOT_MAX_PLACEMENTS placements to write to.
+ *
+ * @return The number of placements found.
+ */
+static int PlacePiece(const Uint16 rows[ARENA_HEIGHT], const TetrominoShape* shape, const int spawnY, PiecePlacement placements[BOT_MAX_PLACEMENTS])
+{
+    int count = 0;
+
+    for (int orientation = NORTH; orientation <= WEST; orientation++)
+    {
+        // The O-piece looks the same in every orientation
+        if (shape->identifier == O && orientation != NORTH) break;
+
+        Uint16 pieceRows[TETROMINO_MAX_SIZE];
+        BuildPieceMasks(shape, (enum Orientation)orientation, pieceRows);
+
+        for (int x = -TETROMINO_MAX_SIZE / 2; x < ARENA_WIDTH; x++)
+        {
+            // Rotating at the top of the arena may need the tetromino to be nudged down, as a wall kick would
+            int startY = spawnY;
+            while (startY <= spawnY + 2 && !PieceFits(rows, pieceRows, x, startY)) startY++;
+            if (startY > spawnY + 2) continue;
+
+            int y = startY;
+            while (PieceFits(rows, pieceRows, x, y + 1)) y++;
+
+            PiecePlacement* placement = &placements[count++];
+            memcpy(placement->pieceRows, pieceRows, sizeof(pieceRows));
+            placement->x = x;
+            placement->startY = startY;
+            placement->y = y;
+            placement->orientation = (enum Orientation)orientation;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Get the y-coordinate a tetromino spawns at, as ResetDroppingTetromino places it.
+ *
+ * @param identifier The identifier of the tetromino.
+ *
+ * @return The spawn y-coordinate.
+ */
+static int GetSpawnY(const TetrominoIdentifier identifier)
+{
+    return (identifier == I) ? -1 : 0;
+}
+
+bool BOT_FindPlacement(const GameDataContext* gameDataContext, BotPlacement* placement)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    Uint16 rows[ARENA_HEIGHT];
+    BuildRowMasks(gameDataContext->arena, rows);
+
+    PiecePlacement placements[BOT_MAX_PLACEMENTS];
+    const int count = PlacePiece(rows, gameDataContext->droppingTetromino->shape, gameDataContext->droppingTetromino->y, placements);
+
+    for (int i = 0; i < count; i++)
+    {
+        const float evaluation = EvaluatePlacement(rows, placements[i].pieceRows, placements[i].x, placements[i].y);
+        if (i == 0 || evaluation > placement->evaluation)
+        {
+            *placement = (BotPlacement){ placements[i].x, placements[i].startY, placements[i].orientation, evaluation };
+        }
+    }
+
+    return count > 0;
+}
+
+void BOT_PlayPlacement(GameDataContext* gameDataContext, const BotPlacement* placement)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    gameDataContext->droppingTetromino->x = placement->x;
+    gameDataContext->droppingTetromino->y = placement->y;
+    gameDataContext->droppingTetromino->orientation = placement->orientation;
+    HardDropTetromino(gameDataContext);
+}
+
+/**
+ * @brief Hash a set of arena row masks from scratch.
+ *
+ * @param rows The arena row masks.
+ *
+ * @return The same hash as ZOBRIST_HashArena gives for the arena.
+ */
+static Uint64 HashRows(const Uint16 rows[ARENA_HEIGHT])
+{
+    Uint64 hash = 0;
+    for (int row = 0; row < ARENA_HEIGHT; row++) hash ^= ZOBRIST_RowKey(row, rows[row]);
+    return hash;
+}
+
+/**
+ * @brief Add a position to a worker's best positions, if it is better than the worst of them.
+ *
+ * @details The best positions are kept as a min-heap on evaluation, so the worst is always at the root.
+ *
+ * @param worker A pointer to the worker.
+ * @param beamWidth The number of positions to keep.
+ * @param node The position to add.
+ */
+static void KeepBestNode(BotWorker* worker, const int beamWidth, const BotNode* node)
+{
+    BotNode* heap = worker->best;
+    int index;
+
+    if (worker->bestCount < beamWidth)
+    {
+        // Sift the new position up from the end
+        index = worker->bestCount++;
+        while (index > 0 && heap[(index - 1) / 2].evaluation > node->evaluation)
+        {
+            heap[index] = heap[(index - 1) / 2];
+            index = (index - 1) / 2;
+        }
+        heap[index] = *node;
+        return;
+    }
+
+    if (node->evaluation <= heap[0].evaluation) return;
+
+    // Replace the worst position, and sift the new one down from the root
+    index = 0;
+    for (;;)
+    {
+        int child = index * 2 + 1;
+        if (child >= worker->bestCount) break;
+        if (child + 1 < worker->bestCount && heap[child + 1].evaluation < heap[child].evaluation) child++;
+        if (heap[child].evaluation >= node->evaluation) break;
+
+        heap[index] = heap[child];
+        index = child;
+    }
+    heap[index] = *node;
+}
+
+/**
+ * @brief Place the current level's tetromino in every way from a position, keeping the best new positions.
+ *
+ * @param worker A pointer to the worker.
+ * @param node The position to expand.
+ * @param isRoot Whether the position is the current arena, so the placements are of the dropping tetromino.
+ */
+static void ExpandNode(BotWorker* worker, const BotNode* node, const bool isRoot)
+{
+    const BotSearch* search = worker->search;
+    const TetrominoShape* shape = GetTetrominoShapeByIdentifier(search->piece);
+
+    PiecePlacement placements[BOT_MAX_PLACEMENTS];
+    const int count = PlacePiece(node->rows, shape, isRoot ? search->rootSpawnY : GetSpawnY(search->piece), placements);
+
+    for (int i = 0; i < count; i++)
+    {
+        const PiecePlacement* placement = &placements[i];
+
+        BotNode child;
+        const int linesCleared = LockPiece(node->rows, placement->pieceRows, placement->x, placement->y, child.rows);
+        child.linesCleared = node->linesCleared + linesCleared;
+        child.evaluation = EvaluateRows(child.rows, child.linesCleared);
+
+        // Without a line clear only the rows the tetromino landed in have changed, so only they are re-keyed
+        if (linesCleared == 0)
+        {
+            child.hash = node->hash;
+            for (int row = SDL_max(placement->y, 0); row < SDL_min(placement->y + TETROMINO_MAX_SIZE, ARENA_HEIGHT); row++)
+            {
+                if (child.rows[row] != node->rows[row]) child.hash ^= ZOBRIST_RowKey(row, node->rows[row]) ^ ZOBRIST_RowKey(row, child.rows[row]);
+            }
+        }
+        else
+        {
+            child.hash = HashRows(child.rows);
+        }
+
+        if (isRoot)
+        {
+            child.firstX = (Sint8)placement->x;
+            child.firstY = (Sint8)placement->startY;
+            child.firstOrientation = (Uint8)placement->orientation;
+        }
+        else
+        {
+            child.firstX = node->firstX;
+            child.firstY = node->firstY;
+            child.firstOrientation = node->firstOrientation;
+        }
+
+        KeepBestNode(worker, search->settings.beamWidth, &child);
+    }
+
+    worker->nodes += (Uint64)count;
+}
+
+/**
+ * @brief Score a final position by the expected evaluation after the best placement of the next, unknown, piece.
+ *
+ * @param worker A pointer to the worker.
+ * @param node The position to score.
+ *
+ * @return The expected evaluation.
+ */
+static float ExpectNode(BotWorker* worker, const BotNode* node)
+{
+    BotSearch* search = worker->search;
+
+    // Evaluations are linear in the lines cleared, so the cached value leaves out those cleared to reach the position,
+    // and is the same however the position was reached
+    const Uint64 key = node->hash ^ search->unseenKey;
+    const float linesClearedScore = LINES_CLEARED_WEIGHT * (float)node->linesCleared;
+
+    TranspositionEntry entry;
+    if (TT_Probe(&search->table, key, &entry)) return entry.evaluation + linesClearedScore;
+
+    float total = 0;
+    int pieceCount = 0;
+    for (TetrominoIdentifier piece = I; piece <= J; piece++)
+    {
+        if (!(search->unseenPieces & (1u << piece))) continue;
+
+        PiecePlacement placements[BOT_MAX_PLACEMENTS];
+        const int count = PlacePiece(node->rows, GetTetrominoShapeByIdentifier(piece), GetSpawnY(piece), placements);
+
+        // A piece that cannot be placed anywhere means the game is lost
+        float best = LOST_EVALUATION;
+        for (int i = 0; i < count; i++)
+        {
+            Uint16 result[ARENA_HEIGHT];
+            const int linesCleared = LockPiece(node->rows, placements[i].pieceRows, placements[i].x, placements[i].y, result);
+            const float evaluation = EvaluateRows(result, linesCleared);
+            if (i == 0 || evaluation > best) best = evaluation;
+        }
+
+        total += best;
+        pieceCount++;
+        worker->nodes += (Uint64)count;
+    }
+
+    entry = (TranspositionEntry){ .evaluation = total / (float)pieceCount, .depth = 1 };
+    TT_Store(&search->table, key, &entry);
+    return entry.evaluation + linesClearedScore;
+}
+
+/**
+ * @brief Work through the positions of the current level until they are all taken, or the deadline has passed.
+ *
+ * @param worker A pointer to the worker.
+ */
+static void WorkLevel(BotWorker* worker)
+{
+    BotSearch* search = worker->search;
+
+    for (;;)
+    {
+        const int index = SDL_AddAtomicInt(&search->nextNode, 1);
+        if (index >= search->beamCount) break;
+
+        if (!search->isMandatory && (SDL_GetAtomicInt(&search->hasTimedOut) || SDL_GetTicksNS() > search->deadline))
+        {
+            SDL_SetAtomicInt(&search->hasTimedOut, 1);
+            break;
+        }
+
+        if (search->piece) ExpandNode(worker, &search->beam[index], search->isRoot);
+        else search->expectations[index] = ExpectNode(worker, &search->beam[index]);
+    }
+}
+
+/**
+ * @brief The entry point of a search worker thread, which works through one level each time it is started.
+ *
+ * @param data A pointer to the BotWorker.
+ *
+ * @return Zero.
+ */
+static int SDLCALL BotWorkerThread(void* data)
+{
+    BotWorker* worker = data;
+    BotSearch* search = worker->search;
+    TRACE_NameThread("BotWorker");
+
+    for (;;)
+    {
+        SDL_WaitSemaphore(search->startSemaphore);
+        if (search->isQuitting) break;
+
+        TRACE_BEGIN("BOT_WorkLevel");
+        WorkLevel(worker);
+        TRACE_END("BOT_WorkLevel");
+        METRICS_Flush();
+
+        SDL_SignalSemaphore(search->doneSemaphore);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Run one level of the search across every thread.
+ *
+ * @param search A pointer to the search.
+ * @param piece The tetromino to place from every position in the beam, or 0 to score the beam by expectation.
+ * @param isRoot Whether the beam is the current arena.
+ *
+ * @return True if every position was worked through, false if the deadline passed first.
+ */
+static bool RunLevel(BotSearch* search, const TetrominoIdentifier piece, const bool isRoot)
+{
+    search->piece = piece;
+    search->isRoot = isRoot;
+    search->isMandatory = isRoot;
+    SDL_SetAtomicInt(&search->nextNode, 0);
+
+    for (int i = 0; i < search->settings.threads; i++)
+    {
+        search->workers[i].bestCount = 0;
+        search->workers[i].nodes = 0;
+    }
+
+    // The calling thread works through the level alongside the others
+    for (int i = 1; i < search->settings.threads; i++) SDL_SignalSemaphore(search->startSemaphore);
+    WorkLevel(&search->workers[0]);
+    for (int i = 1; i < search->settings.threads; i++) SDL_WaitSemaphore(search->doneSemaphore);
+
+    for (int i = 0; i < search->settings.threads; i++) search->stats.nodes += search->workers[i].nodes;
+
+    return !SDL_GetAtomicInt(&search->hasTimedOut);
+}
+
+/**
+ * @brief Compare two positions so that the best comes first.
+ *
+ * @param a A pointer to the first BotNode.
+ * @param b A pointer to the second BotNode.
+ *
+ * @return A negative value if a is better, positive if b is better, and zero if they are equal.
+ */
+static int SDLCALL CompareNodes(const void* a, const void* b)
+{
+    const float evaluationA = ((const BotNode*)a)->evaluation;
+    const float evaluationB = ((const BotNode*)b)->evaluation;
+    return (evaluationA < evaluationB) - (evaluationA > evaluationB);
+}
+
+/**
+ * @brief Merge every worker's best positions into the next beam, keeping only the best way to reach each arena.
+ *
+ * @param search A pointer to the search.
+ */
+static void MergeLevel(BotSearch* search)
+{
+    int candidateCount = 0;
+    for (int i = 0; i < search->settings.threads; i++)
+    {
+        memcpy(&search->candidates[candidateCount], search->workers[i].best, sizeof(BotNode) * (size_t)search->workers[i].bestCount);
+        candidateCount += search->workers[i].bestCount;
+    }
+
+    SDL_qsort(search->candidates, (size_t)candidateCount, sizeof(BotNode), CompareNodes);
+
+    // Different orders of placements often reach the same arena, and only the best of them is worth expanding
+    memset(search->seenHashes, 0, sizeof(Uint64) * (size_t)(search->seenHashMask + 1));
+    search->beamCount = 0;
+    for (int i = 0; i < candidateCount && search->beamCount < search->settings.beamWidth; i++)
+    {
+        const Uint64 hash = search->candidates[i].hash | 1;
+        int slot = (int)(hash & (Uint64)search->seenHashMask);
+        while (search->seenHashes[slot] && search->seenHashes[slot] != hash) slot = (slot + 1) & search->seenHashMask;
+        if (search->seenHashes[slot]) continue;
+
+        search->seenHashes[slot] = hash;
+        search->nextBeam[search->beamCount++] = search->candidates[i];
+    }
+
+    BotNode* swap = search->beam;
+    search->beam = search->nextBeam;
+    search->nextBeam = swap;
+}
+
+bool BOT_InitSearch(BotSearch* search, const BotSearchSettings* settings)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    search->settings = *settings;
+    if (search->settings.threads <= 0) search->settings.threads = SDL_GetNumLogicalCPUCores();
+    search->settings.threads = SDL_clamp(search->settings.threads, 1, BOT_MAX_THREADS);
+    search->settings.depth = SDL_clamp(search->settings.depth, 1, BOT_MAX_DEPTH);
+    search->settings.beamWidth = SDL_clamp(search->settings.beamWidth, 1, BOT_MAX_BEAM_WIDTH);
+    search->settings.preview = SDL_clamp(search->settings.preview, 0, TETROMINO_QUEUE_LENGTH);
+
+    const int threads = search->settings.threads;
+    const size_t beamWidth = (size_t)search->settings.beamWidth;
+
+    // Room for twice as many hashes as there are candidates, so that probing stays short
+    int seenHashCount = 1;
+    while (seenHashCount < 2 * threads * (int)beamWidth) seenHashCount *= 2;
+    search->seenHashMask = seenHashCount - 1;
+
+    search->beam = SDL_malloc(sizeof(BotNode) * beamWidth);
+    search->nextBeam = SDL_malloc(sizeof(BotNode) * beamWidth);
+    search->candidates = SDL_malloc(sizeof(BotNode) * beamWidth * (size_t)threads);
+    search->seenHashes = SDL_malloc(sizeof(Uint64) * (size_t)seenHashCount);
+    search->expectations = SDL_malloc(sizeof(float) * beamWidth);
+    search->startSemaphore = SDL_CreateSemaphore(0);
+    search->doneSemaphore = SDL_CreateSemaphore(0);
+    bool success = search->beam && search->nextBeam && search->candidates && search->seenHashes && search->expectations &&
+        search->startSemaphore && search->doneSemaphore && TT_Init(&search->table, BOT_TRANSPOSITION_LOG2_ENTRIES);
+
+    for (int i = 0; success && i < threads; i++)
+    {
+        BotWorker* worker = &search->workers[i];
+        worker->search = search;
+        worker->best = SDL_malloc(sizeof(BotNode) * beamWidth);
+        success = worker->best != NULL;
+
+        // The first worker is the thread calling BOT_Search
+        if (success && i > 0)
+        {
+            worker->thread = SDL_CreateThread(BotWorkerThread, "BotWorker", worker);
+            if (!worker->thread)
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create bot worker thread: %s", SDL_GetError());
+                success = false;
+            }
+        }
+    }
+
+    if (!success)
+    {
+        BOT_DestroySearch(search);
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Search bot looking %d pieces ahead with a beam of %d on %d threads, within %.1fms per move.",
+        search->settings.depth, search->settings.beamWidth, threads, (double)search->settings.budgetNS / SDL_NS_PER_MS);
+    return true;
+}
+
+void BOT_DestroySearch(BotSearch* search)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    // Every thread takes exactly one start signal before it sees that it should quit
+    search->isQuitting = true;
+    for (int i = 1; i < BOT_MAX_THREADS; i++)
+    {
+        if (search->workers[i].thread) SDL_SignalSemaphore(search->startSemaphore);
+    }
+    for (int i = 0; i < BOT_MAX_THREADS; i++)
+    {
+        if (search->workers[i].thread) SDL_WaitThread(search->workers[i].thread, NULL);
+        SDL_free(search->workers[i].best);
+        search->workers[i] = (BotWorker){ 0 };
+    }
+
+    if (search->startSemaphore) SDL_DestroySemaphore(search->startSemaphore);
+    if (search->doneSemaphore) SDL_DestroySemaphore(search->doneSemaphore);
+    SDL_free(search->beam);
+    SDL_free(search->nextBeam);
+    SDL_free(search->candidates);
+    SDL_free(search->seenHashes);
+    SDL_free(search->expectations);
+    TT_Destroy(&search->table);
+
+    const BotSearchStats stats = search->stats;
+    *search = (BotSearch){ 0 };
+    search->stats = stats;
+}
+
+bool BOT_Search(BotSearch* search, const GameDataContext* gameDataContext, BotPlacement* placement)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+    TRACE_BEGIN("BOT_Search");
+
+    const Uint64 startTicks = SDL_GetTicksNS();
+    search->deadline = startTicks + search->settings.budgetNS;
+    SDL_SetAtomicInt(&search->hasTimedOut, 0);
+
+    // The dropping tetromino and the first pieces of the next queue are known
+    const TetrominoBag* bag = &gameDataContext->tetrominoBag;
+    int queueCount;
+    const TetrominoIdentifier* queue = PeekTetrominoQueue(bag, &queueCount);
+
+    TetrominoIdentifier knownPieces[BOT_MAX_DEPTH];
+    int knownCount = 0;
+    knownPieces[knownCount++] = gameDataContext->droppingTetromino->shape->identifier;
+    for (int i = 0; i < queueCount && i < search->settings.preview && knownCount < search->settings.depth; i++)
+    {
+        knownPieces[knownCount++] = queue[i];
+    }
+
+    // Whatever comes after is equally likely to be any piece its bag has left after the known ones, or any piece if
+    // it starts a new bag
+    const int unseenStart = knownCount - 1;
+    const int unseenPosition = (GetTetrominoBagPosition(bag) + unseenStart) % TETROMINO_COUNT;
+    search->unseenPieces = 0;
+    if (unseenPosition == 0)
+    {
+        for (TetrominoIdentifier piece = I; piece <= J; piece++) search->unseenPieces |= 1u << piece;
+    }
+    else
+    {
+        for (int i = unseenStart; i < unseenStart + TETROMINO_COUNT - unseenPosition; i++) search->unseenPieces |= 1u << queue[i];
+    }
+
+    // Expectations depend on which pieces could come next as well as on the arena, so the set is part of their key
+    search->unseenKey = 0;
+    for (TetrominoIdentifier piece = I; piece <= J; piece++)
+    {
+        if (search->unseenPieces & (1u << piece)) search->unseenKey ^= ZOBRIST_PieceKey(piece, WEST);
+    }
+
+    BotNode* root = &search->beam[0];
+    BuildRowMasks(gameDataContext->arena, root->rows);
+    root->hash = gameDataContext->arenaHash;
+    root->evaluation = 0;
+    root->linesCleared = 0;
+    search->beamCount = 1;
+    search->rootSpawnY = gameDataContext->droppingTetromino->y;
+
+    // Each level places one known piece, and a level that runs out of time is thrown away, so the beam always holds a
+    // complete level
+    bool isComplete = true;
+    for (int level = 0; level < knownCount; level++)
+    {
+        if (!RunLevel(search, knownPieces[level], level == 0))
+        {
+            isComplete = false;
+            break;
+        }
+
+        MergeLevel(search);
+        if (search->beamCount == 0) break;
+    }
+
+    // Look one piece further than the known pieces by expectation, if the search is meant to go that deep
+    const bool hasExpectations = isComplete && search->beamCount > 0 && knownCount < search->settings.depth && RunLevel(search, 0, false);
+    if (!isComplete || (knownCount < search->settings.depth && !hasExpectations)) search->stats.timeouts++;
+
+    int best = -1;
+    float bestEvaluation = 0;
+    for (int i = 0; i < search->beamCount; i++)
+    {
+        const float evaluation = hasExpectations ? search->expectations[i] : search->beam[i].evaluation;
+        if (best < 0 || evaluation > bestEvaluation)
+        {
+            best = i;
+            bestEvaluation = evaluation;
+        }
+    }
+
+    // The first level always completes, so an empty beam means the dropping tetromino has nowhere to go
+    if (best >= 0)
+    {
+        const BotNode* node = &search->beam[best];
+        *placement = (BotPlacement){ node->firstX, node->firstY, (enum Orientation)node->firstOrientation, bestEvaluation };
+    }
+
+    search->stats.searches++;
+    search->stats.searchNS += SDL_GetTicksNS() - startTicks;
+
+    TRACE_END("BOT_Search");
+    return best >= 0;
+}
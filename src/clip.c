@@ -0,0 +1,307 @@
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "clip.h"
+
+#include "gif.h"
+#include "graphics.h"
+#include "replay.h"
+#include "trace.h"
+
+/**
+ * @brief The parts of an export shared by every worker, which do not change once it starts.
+ */
+typedef struct ClipJob
+{
+    const Replay* replay;
+    int width;
+    int height;
+    float speed;
+
+    /** @brief The total number of frames in the clip. */
+    Uint64 frameCount;
+
+    /** @brief The number of worker threads. */
+    int threadCount;
+} ClipJob;
+
+/**
+ * @brief The state of a single worker, which plays its own copy of the replay forward and renders with its own
+ * software renderer, so workers share nothing while rendering.
+ */
+typedef struct ClipWorker
+{
+    SDL_Thread* thread;
+    const ClipJob* job;
+    ReplayPlayer player;
+    GraphicsDataContext graphicsDataContext;
+    SidebarUI sidebarUI;
+    Fonts fonts;
+
+    /** @brief The quantised frames of two batches, so that one can be encoded while the next is rendered. */
+    Uint8* frames[2];
+
+    /** @brief The first frame to render in the current batch. */
+    Uint64 firstFrame;
+
+    /** @brief The number of frames to render in the current batch. */
+    int frameCount;
+
+    /** @brief Which of the two frame buffers the current batch is rendered into. */
+    int buffer;
+
+    bool success;
+} ClipWorker;
+
+/**
+ * @brief Get the replay tick shown in a frame.
+ *
+ * @param job The export job.
+ * @param frame The index of the frame.
+ *
+ * @return The number of ticks played before the frame.
+ */
+static Uint64 GetFrameTick(const ClipJob* job, const Uint64 frame)
+{
+    return (Uint64)((double)frame * (double)job->speed * SIM_TICK_RATE / CLIP_FRAME_RATE);
+}
+
+/**
+ * @brief Get the consecutive frames a worker renders in a batch.
+ *
+ * @param job The export job.
+ * @param batchStart The first frame of the batch.
+ * @param workerIndex The index of the worker.
+ * @param firstFrame A pointer to write the worker's first frame to.
+ *
+ * @return The number of frames the worker renders, which may be 0 in the last batch.
+ */
+static int GetWorkerFrames(const ClipJob* job, const Uint64 batchStart, const int workerIndex, Uint64* firstFrame)
+{
+    *firstFrame = batchStart + (Uint64)workerIndex * CLIP_FRAMES_PER_WORKER;
+    if (*firstFrame >= job->frameCount) return 0;
+
+    const Uint64 remaining = job->frameCount - *firstFrame;
+    return (remaining < CLIP_FRAMES_PER_WORKER) ? (int)remaining : CLIP_FRAMES_PER_WORKER;
+}
+
+/**
+ * @brief A worker thread, which renders and quantises its frames of the current batch.
+ *
+ * @param data A pointer to the worker.
+ *
+ * @return Zero.
+ */
+static int SDLCALL ClipWorkerThread(void* data)
+{
+    ClipWorker* worker = data;
+    const ClipJob* job = worker->job;
+    const size_t frameSize = (size_t)job->width * (size_t)job->height;
+
+    TRACE_NameThread("ClipWorker");
+    TRACE_BEGIN("ClipWorker_RenderBatch");
+
+    worker->success = true;
+    for (int i = 0; i < worker->frameCount; i++)
+    {
+        REPLAY_AdvanceTo(&worker->player, GetFrameTick(job, worker->firstFrame + (Uint64)i));
+
+        if (!GFX_RenderGame(&worker->graphicsDataContext, &worker->player.game, &worker->fonts) ||
+            !SDL_FlushRenderer(worker->graphicsDataContext.renderer))
+        {
+            worker->success = false;
+            break;
+        }
+
+        // The software renderer draws straight into the RGBA target surface, so there is nothing to read back
+        GIF_QuantizeFrame(worker->graphicsDataContext.targetSurface, worker->frames[worker->buffer] + (size_t)i * frameSize);
+    }
+
+    TRACE_END("ClipWorker_RenderBatch");
+    return 0;
+}
+
+/**
+ * @brief Set up a worker's replay player, renderer and frame buffers.
+ *
+ * @param worker A pointer to the zeroed worker.
+ * @param job The export job.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool InitWorker(ClipWorker* worker, const ClipJob* job)
+{
+    worker->job = job;
+    if (!REPLAY_StartPlayback(&worker->player, job->replay)) return false;
+
+    worker->graphicsDataContext.sidebarUI = &worker->sidebarUI;
+    if (!GFX_InitHeadless(&worker->graphicsDataContext, &worker->player.game, &worker->fonts, job->width, job->height)) return false;
+    if (!GFX_LoadTetrominoTextures(&worker->graphicsDataContext)) return false;
+
+    const size_t batchSize = (size_t)CLIP_FRAMES_PER_WORKER * (size_t)job->width * (size_t)job->height;
+    worker->frames[0] = SDL_malloc(batchSize);
+    worker->frames[1] = SDL_malloc(batchSize);
+    return worker->frames[0] && worker->frames[1];
+}
+
+/**
+ * @brief Free everything a worker created.
+ *
+ * @param worker A pointer to the worker.
+ */
+static void DestroyWorker(ClipWorker* worker)
+{
+    if (worker->graphicsDataContext.renderer) SDL_DestroyRenderer(worker->graphicsDataContext.renderer);
+    if (worker->graphicsDataContext.targetSurface) SDL_DestroySurface(worker->graphicsDataContext.targetSurface);
+    if (worker->fonts.mainFont) TTF_CloseFont(worker->fonts.mainFont);
+    if (worker->fonts.secondaryFont) TTF_CloseFont(worker->fonts.secondaryFont);
+    SDL_free(worker->frames[0]);
+    SDL_free(worker->frames[1]);
+}
+
+/**
+ * @brief Start every worker on its frames of a batch.
+ *
+ * @param workers The workers.
+ * @param job The export job.
+ * @param batchStart The first frame of the batch.
+ * @param buffer Which of the two frame buffers to render into.
+ *
+ * @return True if every worker with frames to render was started, false otherwise.
+ */
+static bool StartBatch(ClipWorker* workers, const ClipJob* job, const Uint64 batchStart, const int buffer)
+{
+    bool success = true;
+
+    for (int i = 0; i < job->threadCount; i++)
+    {
+        ClipWorker* worker = &workers[i];
+        worker->frameCount = GetWorkerFrames(job, batchStart, i, &worker->firstFrame);
+        worker->buffer = buffer;
+        worker->thread = NULL;
+        if (worker->frameCount == 0) continue;
+
+        worker->thread = SDL_CreateThread(ClipWorkerThread, "ClipWorker", worker);
+        if (!worker->thread)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create clip worker thread: %s", SDL_GetError());
+            success = false;
+        }
+    }
+
+    return success;
+}
+
+/**
+ * @brief Wait for every worker to finish its frames of the current batch.
+ *
+ * @param workers The workers.
+ * @param job The export job.
+ *
+ * @return True if every worker succeeded, false otherwise.
+ */
+static bool WaitBatch(ClipWorker* workers, const ClipJob* job)
+{
+    bool success = true;
+
+    for (int i = 0; i < job->threadCount; i++)
+    {
+        if (!workers[i].thread) continue;
+        SDL_WaitThread(workers[i].thread, NULL);
+        workers[i].thread = NULL;
+        success &= workers[i].success;
+    }
+
+    return success;
+}
+
+bool CLIP_Export(const ClipOptions* options, ClipResult* result)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *result = (ClipResult){ 0 };
+    const Uint64 startTimestamp = SDL_GetTicksNS();
+
+    if (options->speed <= 0 || options->scale <= 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Clip speed and scale must be positive!");
+        return false;
+    }
+
+    Replay replay;
+    if (!REPLAY_Load(&replay, options->replayPath)) return false;
+
+    int threadCount = (options->threads > 0) ? options->threads : SDL_GetNumLogicalCPUCores();
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > CLIP_MAX_THREADS) threadCount = CLIP_MAX_THREADS;
+
+    ClipJob job = {
+        .replay = &replay,
+        .width = SDL_max(1, (int)((float)CLIP_BASE_WIDTH * options->scale)),
+        .height = SDL_max(1, (int)((float)CLIP_BASE_HEIGHT * options->scale)),
+        .speed = options->speed,
+        .frameCount = 0,
+        .threadCount = threadCount,
+    };
+
+    // Every frame up to and including the end of the replay
+    while (GetFrameTick(&job, job.frameCount) <= replay.header.tickCount) job.frameCount++;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Exporting %" SDL_PRIu64 " frames at %dx%d with %d threads...", job.frameCount, job.width, job.height, threadCount);
+
+    ClipWorker* workers = SDL_calloc((size_t)threadCount, sizeof(ClipWorker));
+    GifEncoder* encoder = SDL_calloc(1, sizeof(GifEncoder));
+    bool success = workers && encoder;
+
+    for (int i = 0; success && i < threadCount; i++) success = InitWorker(&workers[i], &job);
+    success = success && GIF_Begin(encoder, options->outputPath, job.width, job.height, 100 / CLIP_FRAME_RATE);
+
+    const Uint64 batchFrames = (Uint64)threadCount * CLIP_FRAMES_PER_WORKER;
+    const size_t frameSize = (size_t)job.width * (size_t)job.height;
+
+    success = success && StartBatch(workers, &job, 0, 0);
+
+    for (Uint64 batchStart = 0; success && batchStart < job.frameCount; batchStart += batchFrames)
+    {
+        const int buffer = (int)((batchStart / batchFrames) % 2);
+        success = WaitBatch(workers, &job);
+
+        // Render the next batch into the other buffers while this one is encoded
+        const Uint64 nextBatchStart = batchStart + batchFrames;
+        if (success && nextBatchStart < job.frameCount) success = StartBatch(workers, &job, nextBatchStart, buffer ^ 1);
+
+        TRACE_BEGIN("CLIP_EncodeBatch");
+        for (int i = 0; success && i < threadCount; i++)
+        {
+            Uint64 firstFrame;
+            const int frameCount = GetWorkerFrames(&job, batchStart, i, &firstFrame);
+            for (int frame = 0; success && frame < frameCount; frame++)
+            {
+                success = GIF_WriteFrame(encoder, workers[i].frames[buffer] + (size_t)frame * frameSize);
+                result->frames++;
+            }
+        }
+        TRACE_END("CLIP_EncodeBatch");
+    }
+
+    if (workers) WaitBatch(workers, &job);
+    if (encoder && encoder->stream) success &= GIF_End(encoder);
+
+    // Playing to the end should reproduce the recorded game exactly, so a different score means the replay desynced
+    if (success)
+    {
+        REPLAY_AdvanceTo(&workers[0].player, replay.header.tickCount);
+        if ((Uint32)workers[0].player.game.score != replay.header.finalScore)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Replay desynced: final score %d, but %u was recorded!", workers[0].player.game.score, replay.header.finalScore);
+        }
+    }
+
+    for (int i = 0; workers && i < threadCount; i++) DestroyWorker(&workers[i]);
+    SDL_free(workers);
+    SDL_free(encoder);
+    REPLAY_Destroy(&replay);
+
+    result->replayNS = replay.header.tickCount * SIM_TICK_NS;
+    result->elapsedNS = SDL_GetTicksNS() - startTimestamp;
+    return success;
+}
@@ -0,0 +1,754 @@
+#include "dataset.h"
+
+#include "bot.h"
+#include "replay.h"
+#include "tetromino.h"
+#include "trace.h"
+
+/**
+ * @brief The width (in bytes) of each column's values, indexed by ::DatasetColumn.
+ */
+static const Uint8 COLUMN_WIDTHS[DATASET_COLUMN_COUNT] = {
+    sizeof(Uint32),
+    sizeof(Uint16),
+    DATASET_BOARD_BYTES,
+    sizeof(Uint8),
+    sizeof(Uint16),
+    3 * sizeof(Uint8),
+    sizeof(Uint8),
+    sizeof(Uint32),
+    sizeof(Uint8),
+};
+
+/**
+ * @brief The parts of an export shared by every worker. Only the file fields change once it starts, under the lock.
+ */
+typedef struct DatasetJob
+{
+    const DatasetOptions* options;
+
+    /** @brief The replays being exported, loaded before the workers start. */
+    const Replay* replays;
+
+    /** @brief The number of games (bot games then replays) to export, and the next one a worker should take. */
+    int gameCount;
+    SDL_AtomicInt nextGame;
+
+    /** @brief Held while a chunk is appended to the file. */
+    SDL_Mutex* lock;
+
+    SDL_IOStream* stream;
+
+    /** @brief The offset (in bytes) the next chunk is written at. */
+    Uint64 fileOffset;
+
+    /** @brief The offset of every chunk written so far, which is written at the end of the file. */
+    Uint64* chunkOffsets;
+    Uint64 chunkCount;
+    Uint64 chunkCapacity;
+
+    Uint64 records;
+    Uint64 rawBytes;
+    bool hasFailed;
+} DatasetJob;
+
+/**
+ * @brief The position a worker has recorded for the dropping tetromino, which is written once it has been placed.
+ */
+typedef struct DatasetPosition
+{
+    bool hasPosition;
+    bool hasPlacement;
+    Uint8 board[DATASET_BOARD_BYTES];
+    Uint8 piece;
+    Uint16 queue;
+    Uint16 move;
+    Sint8 placementX;
+    Sint8 placementY;
+    Uint8 orientation;
+    Uint8 lines;
+    int scoreAtSpawn;
+    int score;
+} DatasetPosition;
+
+/**
+ * @brief The state of a single worker thread, which plays or plays back one game at a time and records its positions
+ * into a chunk of its own.
+ */
+typedef struct DatasetWorker
+{
+    SDL_Thread* thread;
+    DatasetJob* job;
+
+    /** @brief The game the bot plays, and the player that plays replays back. */
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+    ReplayPlayer player;
+
+    /** @brief The game whose events are being recorded. */
+    const GameDataContext* observed;
+
+    /** @brief The game number and flags of the records being written. */
+    Uint32 gameNumber;
+    Uint8 flags;
+
+    /** @brief The position waiting for its placement. */
+    DatasetPosition position;
+
+    /** @brief The records of the current chunk, column by column, and the number of them. */
+    Uint8* columns[DATASET_COLUMN_COUNT];
+    int recordCount;
+
+    /** @brief The number of records of the current game, the last of which is always still in the chunk. */
+    int gameRecordCount;
+
+    /** @brief Space to encode a whole chunk into before it is written. */
+    Uint8* chunk;
+    size_t chunkCapacity;
+
+    Uint64 games;
+    bool success;
+} DatasetWorker;
+
+/**
+ * @brief Round a size up to the alignment of chunks and columns.
+ *
+ * @param size The size (in bytes).
+ *
+ * @return The size, rounded up to a multiple of DATASET_ALIGNMENT.
+ */
+static Uint64 AlignSize(const Uint64 size)
+{
+    return (size + DATASET_ALIGNMENT - 1) & ~(Uint64)(DATASET_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Encode a column with DATASET_ENCODING_XOR_ZERO_RUNS, if that makes it smaller.
+ *
+ * @param values The column's values.
+ * @param count The number of values.
+ * @param width The width (in bytes) of each value.
+ * @param output The buffer to write to, which must hold at least count * width bytes.
+ *
+ * @return The size of the encoded column, or 0 if it would be no smaller than the raw values.
+ */
+static size_t EncodeXorZeroRuns(const Uint8* values, const int count, const int width, Uint8* output)
+{
+    const size_t rawSize = (size_t)count * (size_t)width;
+    size_t size = 0;
+    int zeroRun = 0;
+
+    for (size_t i = 0; i < rawSize; i++)
+    {
+        const Uint8 byte = values[i] ^ ((i >= (size_t)width) ? values[i - (size_t)width] : 0);
+
+        // Each run of zeros (and each literal) is flushed only once it ends, so there must be room for both
+        if (byte == 0 && ++zeroRun < 255) continue;
+        if (size + 3 > rawSize) return 0;
+
+        if (zeroRun > 0)
+        {
+            output[size++] = 0;
+            output[size++] = (Uint8)zeroRun;
+            zeroRun = 0;
+        }
+        if (byte != 0) output[size++] = byte;
+    }
+
+    if (zeroRun > 0)
+    {
+        if (size + 2 >= rawSize) return 0;
+        output[size++] = 0;
+        output[size++] = (Uint8)zeroRun;
+    }
+
+    return (size < rawSize) ? size : 0;
+}
+
+/**
+ * @brief Encode a worker's chunk and append it to the file, then start a new chunk.
+ *
+ * @param worker A pointer to the worker.
+ */
+static void FlushChunk(DatasetWorker* worker)
+{
+    if (worker->recordCount == 0) return;
+
+    TRACE_BEGIN("FlushChunk");
+    DatasetJob* job = worker->job;
+    DatasetChunkHeader* header = (DatasetChunkHeader*)worker->chunk;
+    SDL_zerop(header);
+
+    // Encoding happens on the worker, so only the write itself is serialised
+    Uint64 offset = AlignSize(sizeof(DatasetChunkHeader));
+    Uint64 rawBytes = 0;
+    for (int c = 0; c < DATASET_COLUMN_COUNT; c++)
+    {
+        Uint8* output = worker->chunk + offset;
+        const size_t rawSize = (size_t)worker->recordCount * COLUMN_WIDTHS[c];
+        size_t size = EncodeXorZeroRuns(worker->columns[c], worker->recordCount, COLUMN_WIDTHS[c], output);
+        const DatasetEncoding encoding = (size > 0) ? DATASET_ENCODING_XOR_ZERO_RUNS : DATASET_ENCODING_RAW;
+        if (size == 0)
+        {
+            SDL_memcpy(output, worker->columns[c], rawSize);
+            size = rawSize;
+        }
+
+        // The padding between columns is zeroed, so that a file's bytes depend only on its records
+        const Uint64 end = AlignSize(offset + size);
+        SDL_memset(worker->chunk + offset + size, 0, (size_t)(end - offset - size));
+
+        header->columns[c].offset = SDL_Swap64LE(offset);
+        header->columns[c].size = SDL_Swap32LE((Uint32)size);
+        header->columns[c].encoding = SDL_Swap32LE((Uint32)encoding);
+        offset = end;
+        rawBytes += rawSize;
+    }
+
+    header->magic = SDL_Swap32LE(DATASET_CHUNK_MAGIC);
+    header->recordCount = SDL_Swap32LE((Uint32)worker->recordCount);
+    header->size = SDL_Swap64LE(offset);
+
+    SDL_LockMutex(job->lock);
+    if (job->chunkCount == job->chunkCapacity)
+    {
+        const Uint64 capacity = (job->chunkCapacity > 0) ? job->chunkCapacity * 2 : 256;
+        Uint64* chunkOffsets = SDL_realloc(job->chunkOffsets, (size_t)capacity * sizeof(Uint64));
+        if (chunkOffsets)
+        {
+            job->chunkOffsets = chunkOffsets;
+            job->chunkCapacity = capacity;
+        }
+    }
+
+    if (job->chunkCount < job->chunkCapacity && SDL_WriteIO(job->stream, worker->chunk, (size_t)offset) == offset)
+    {
+        job->chunkOffsets[job->chunkCount++] = job->fileOffset;
+        job->fileOffset += offset;
+        job->records += (Uint64)worker->recordCount;
+        job->rawBytes += rawBytes;
+    }
+    else if (!job->hasFailed)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write dataset chunk: %s", SDL_GetError());
+        job->hasFailed = true;
+    }
+    SDL_UnlockMutex(job->lock);
+
+    worker->recordCount = 0;
+    TRACE_END("FlushChunk");
+}
+
+/**
+ * @brief Write a worker's position as a record, if the tetromino has been placed, and forget it.
+ *
+ * @param worker A pointer to the worker.
+ * @param flags The ::DatasetFlag values to add to the record's.
+ */
+static void CommitPosition(DatasetWorker* worker, const Uint8 flags)
+{
+    DatasetPosition* position = &worker->position;
+    if (!position->hasPosition || !position->hasPlacement)
+    {
+        position->hasPosition = false;
+        return;
+    }
+    position->hasPosition = false;
+
+    // The chunk is flushed before a record is added rather than after, so that the last record can still be flagged
+    if (worker->recordCount == DATASET_CHUNK_RECORDS) FlushChunk(worker);
+
+    const int i = worker->recordCount++;
+    const Uint32 gameNumber = SDL_Swap32LE(worker->gameNumber);
+    const Uint16 move = SDL_Swap16LE(position->move);
+    const Uint16 queue = SDL_Swap16LE(position->queue);
+    const Uint32 reward = SDL_Swap32LE((Uint32)SDL_max(position->score - position->scoreAtSpawn, 0));
+    const Uint8 placement[3] = { (Uint8)position->placementX, (Uint8)position->placementY, position->orientation };
+
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_GAME][i * sizeof(Uint32)], &gameNumber, sizeof(Uint32));
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_MOVE][i * sizeof(Uint16)], &move, sizeof(Uint16));
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_BOARD][i * DATASET_BOARD_BYTES], position->board, DATASET_BOARD_BYTES);
+    worker->columns[DATASET_COLUMN_PIECE][i] = position->piece;
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_QUEUE][i * sizeof(Uint16)], &queue, sizeof(Uint16));
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_PLACEMENT][i * sizeof(placement)], placement, sizeof(placement));
+    worker->columns[DATASET_COLUMN_LINES][i] = position->lines;
+    SDL_memcpy(&worker->columns[DATASET_COLUMN_REWARD][i * sizeof(Uint32)], &reward, sizeof(Uint32));
+    worker->columns[DATASET_COLUMN_FLAGS][i] = worker->flags | flags;
+
+    worker->gameRecordCount++;
+}
+
+/**
+ * @brief Record the position of the tetromino that has just spawned in the observed game.
+ *
+ * @param worker A pointer to the worker.
+ * @param piece The tetromino that spawned.
+ * @param score The score when it spawned.
+ */
+static void BeginPosition(DatasetWorker* worker, const TetrominoIdentifier piece, const int score)
+{
+    const GameDataContext* game = worker->observed;
+    DatasetPosition* position = &worker->position;
+
+    SDL_zerop(position);
+    position->hasPosition = true;
+    position->piece = (Uint8)piece;
+    position->move = (Uint16)SDL_min(game->piecesLocked, 0xFFFF);
+    position->scoreAtSpawn = score;
+    position->score = score;
+
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        for (int col = 0; col < ARENA_WIDTH; col++)
+        {
+            if (!game->arena[row][col]) continue;
+            const int bit = row * ARENA_WIDTH + col;
+            position->board[bit / 8] |= (Uint8)(1 << (bit % 8));
+        }
+    }
+
+    int count = 0;
+    const TetrominoIdentifier* queue = PeekTetrominoQueue(&game->tetrominoBag, &count);
+    for (int i = 0; i < DATASET_QUEUE_LENGTH && i < count; i++) position->queue |= (Uint16)((queue[i] & 7) << (i * 3));
+}
+
+/**
+ * @brief Finish the observed game, forgetting the position waiting for a placement and flagging the game's last record,
+ * unless it already ended the game.
+ *
+ * @param worker A pointer to the worker.
+ * @param flags The ::DatasetFlag values to add to the last record.
+ */
+static void EndGame(DatasetWorker* worker, const Uint8 flags)
+{
+    worker->position.hasPosition = false;
+
+    if (worker->gameRecordCount > 0 && worker->recordCount > 0)
+    {
+        Uint8* lastFlags = &worker->columns[DATASET_COLUMN_FLAGS][worker->recordCount - 1];
+        if (!(*lastFlags & DATASET_FLAG_GAME_OVER)) *lastFlags |= flags;
+    }
+
+    worker->gameRecordCount = 0;
+}
+
+/**
+ * @brief Record positions from the events of the observed game. This is a ::GameEventListener.
+ *
+ * @param userData A pointer to the worker.
+ * @param event The event.
+ */
+static void DatasetListen(void* userData, const GameEvent* event)
+{
+    DatasetWorker* worker = userData;
+    DatasetPosition* position = &worker->position;
+
+    switch (event->type)
+    {
+    case GAME_EVENT_START:
+        // A replay may restart a game that was not over, which cuts it short
+        EndGame(worker, DATASET_FLAG_TRUNCATED);
+        break;
+
+    case GAME_EVENT_SPAWN:
+        CommitPosition(worker, 0);
+        BeginPosition(worker, event->piece, event->score);
+        break;
+
+    case GAME_EVENT_LOCK:
+        if (!position->hasPosition) break;
+        position->hasPlacement = true;
+        position->placementX = (Sint8)event->x;
+        position->placementY = (Sint8)event->y;
+        position->orientation = (Uint8)event->orientation;
+        position->score = event->score;
+        break;
+
+    case GAME_EVENT_LINE_CLEAR:
+        position->lines = (Uint8)(position->lines + event->lines);
+        position->score = event->score;
+        break;
+
+    case GAME_EVENT_GAME_OVER:
+        CommitPosition(worker, DATASET_FLAG_GAME_OVER);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Let the bot play a game, recording every position, until it tops out or reaches DATASET_MAX_PIECES.
+ *
+ * @param worker A pointer to the worker.
+ * @param index The index of the game.
+ */
+static void PlayBotGame(DatasetWorker* worker, const int index)
+{
+    GameDataContext* game = &worker->game;
+    worker->observed = game;
+    worker->gameNumber = (Uint32)index;
+    worker->flags = 0;
+
+    if (!GAME_ResetWithSeed(game, worker->job->options->seed + (Uint64)index)) return;
+    game->isRunning = true;
+
+    for (int piece = 0; piece < DATASET_MAX_PIECES && !game->isGameOver; piece++)
+    {
+        BotPlacement placement;
+        if (BOT_FindPlacement(game, &placement)) BOT_PlayPlacement(game, &placement);
+        else game->isGameOver = true;
+    }
+
+    EndGame(worker, game->isGameOver ? DATASET_FLAG_GAME_OVER : DATASET_FLAG_TRUNCATED);
+}
+
+/**
+ * @brief Play a replay back to its end, recording every position.
+ *
+ * @param worker A pointer to the worker.
+ * @param index The index of the game, which is after every bot game.
+ * @param replay The replay.
+ */
+static void PlayReplay(DatasetWorker* worker, const int index, const Replay* replay)
+{
+    ReplayPlayer* player = &worker->player;
+    worker->observed = &player->game;
+    worker->gameNumber = (Uint32)index;
+    worker->flags = DATASET_FLAG_REPLAY;
+
+    if (!REPLAY_StartPlayback(player, replay)) return;
+
+    // Starting playback resets the game's listeners, and its first tetromino has already spawned
+    GAME_AddEventListener(&player->game, DatasetListen, worker);
+    BeginPosition(worker, player->game.droppingTetromino->shape->identifier, player->game.score);
+
+    REPLAY_AdvanceTo(player, replay->header.tickCount);
+    EndGame(worker, DATASET_FLAG_TRUNCATED);
+}
+
+/**
+ * @brief The entry point of a worker thread, which takes games until there are none left.
+ *
+ * @param data A pointer to the DatasetWorker.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int SDLCALL DatasetWorkerThread(void* data)
+{
+    DatasetWorker* worker = (DatasetWorker*)data;
+    DatasetJob* job = worker->job;
+    TRACE_NameThread("DatasetWorker");
+
+    worker->game.droppingTetromino = &worker->droppingTetromino;
+    if (!GAME_AddEventListener(&worker->game, DatasetListen, worker)) return 1;
+
+    for (int index = SDL_AddAtomicInt(&job->nextGame, 1); index < job->gameCount; index = SDL_AddAtomicInt(&job->nextGame, 1))
+    {
+        TRACE_BEGIN("DatasetGame");
+        if (index < job->options->gameCount) PlayBotGame(worker, index);
+        else PlayReplay(worker, index, &job->replays[index - job->options->gameCount]);
+        TRACE_END("DatasetGame");
+
+        worker->games++;
+    }
+
+    FlushChunk(worker);
+    worker->success = true;
+    return 0;
+}
+
+/**
+ * @brief Write the start of a dataset file.
+ *
+ * @param job The export job.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool WriteFileHeader(DatasetJob* job)
+{
+    DatasetFileHeader header = { 0 };
+    header.magic = SDL_Swap32LE(DATASET_MAGIC);
+    header.version = SDL_Swap32LE(DATASET_VERSION);
+    header.columnCount = SDL_Swap32LE(DATASET_COLUMN_COUNT);
+    SDL_memcpy(header.columnWidths, COLUMN_WIDTHS, sizeof(COLUMN_WIDTHS));
+    header.seed = SDL_Swap64LE(job->options->seed);
+
+    job->fileOffset = sizeof(header);
+    return SDL_WriteIO(job->stream, &header, sizeof(header)) == sizeof(header);
+}
+
+/**
+ * @brief Write the end of a dataset file: the offset of every chunk, then the trailer.
+ *
+ * @param job The export job.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool WriteFileIndex(DatasetJob* job)
+{
+    bool success = true;
+    for (Uint64 i = 0; i < job->chunkCount; i++) success &= SDL_WriteU64LE(job->stream, job->chunkOffsets[i]);
+
+    success &= SDL_WriteU64LE(job->stream, job->fileOffset);
+    success &= SDL_WriteU64LE(job->stream, job->chunkCount);
+    success &= SDL_WriteU64LE(job->stream, job->records);
+    success &= SDL_WriteU32LE(job->stream, DATASET_MAGIC);
+    success &= SDL_WriteU32LE(job->stream, DATASET_VERSION);
+    return success;
+}
+
+bool DATASET_Export(const DatasetOptions* options, DatasetResult* result)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *result = (DatasetResult){ 0 };
+    const Uint64 startTicks = SDL_GetTicksNS();
+
+    DatasetJob job = { 0 };
+    job.options = options;
+    job.gameCount = options->gameCount + options->replayCount;
+
+    Replay* replays = SDL_calloc((size_t)SDL_max(options->replayCount, 1), sizeof(Replay));
+    bool success = replays != NULL && options->gameCount >= 0 && job.gameCount > 0;
+    int loadedReplays = 0;
+    for (; success && loadedReplays < options->replayCount; loadedReplays++)
+    {
+        success = REPLAY_Load(&replays[loadedReplays], options->replayPaths[loadedReplays]);
+    }
+    if (!success) loadedReplays--;
+    job.replays = replays;
+
+    if (success) success = (job.lock = SDL_CreateMutex()) != NULL;
+    if (success && !(job.stream = SDL_IOFromFile(options->outputPath, "wb")))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open dataset file '%s': %s", options->outputPath, SDL_GetError());
+        success = false;
+    }
+    if (success) success = WriteFileHeader(&job);
+
+    int threadCount = (options->threads > 0) ? options->threads : SDL_GetNumLogicalCPUCores();
+    if (threadCount > DATASET_MAX_THREADS) threadCount = DATASET_MAX_THREADS;
+    if (threadCount > job.gameCount) threadCount = job.gameCount;
+    if (threadCount < 1) threadCount = 1;
+
+    // Every worker's chunk (as recorded and as encoded) is allocated up front, which is all the memory the export uses
+    size_t recordBytes = 0;
+    size_t chunkCapacity = AlignSize(sizeof(DatasetChunkHeader));
+    for (int c = 0; c < DATASET_COLUMN_COUNT; c++)
+    {
+        recordBytes += COLUMN_WIDTHS[c];
+        chunkCapacity += AlignSize((Uint64)DATASET_CHUNK_RECORDS * COLUMN_WIDTHS[c]);
+    }
+
+    DatasetWorker* workers = SDL_calloc((size_t)threadCount, sizeof(DatasetWorker));
+    success = success && workers != NULL;
+    for (int i = 0; success && i < threadCount; i++)
+    {
+        DatasetWorker* worker = &workers[i];
+        worker->job = &job;
+        worker->chunkCapacity = chunkCapacity;
+        worker->chunk = SDL_malloc(chunkCapacity);
+        worker->columns[0] = SDL_malloc(recordBytes * DATASET_CHUNK_RECORDS);
+        success = worker->chunk && worker->columns[0];
+        for (int c = 1; success && c < DATASET_COLUMN_COUNT; c++)
+        {
+            worker->columns[c] = worker->columns[c - 1] + (size_t)COLUMN_WIDTHS[c - 1] * DATASET_CHUNK_RECORDS;
+        }
+    }
+
+    if (success)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Exporting %d bot games and %d replays to '%s' on %d threads (seed=%" SDL_PRIu64 ")...",
+            options->gameCount, options->replayCount, options->outputPath, threadCount, options->seed);
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            workers[i].thread = SDL_CreateThread(DatasetWorkerThread, "DatasetWorker", &workers[i]);
+            if (!workers[i].thread) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create dataset worker thread: %s", SDL_GetError());
+        }
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            if (!workers[i].thread)
+            {
+                success = false;
+                continue;
+            }
+
+            SDL_WaitThread(workers[i].thread, NULL);
+            success = success && workers[i].success;
+            result->games += workers[i].games;
+        }
+
+        success = success && !job.hasFailed && WriteFileIndex(&job);
+    }
+
+    for (int i = 0; workers && i < threadCount; i++)
+    {
+        SDL_free(workers[i].chunk);
+        SDL_free(workers[i].columns[0]);
+    }
+    SDL_free(workers);
+
+    result->records = job.records;
+    result->chunks = job.chunkCount;
+    result->rawBytes = job.rawBytes;
+    result->fileBytes = job.fileOffset + job.chunkCount * sizeof(Uint64) + sizeof(DatasetTrailer);
+
+    if (job.stream && !SDL_CloseIO(job.stream))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to close dataset file '%s': %s", options->outputPath, SDL_GetError());
+        success = false;
+    }
+    if (job.lock) SDL_DestroyMutex(job.lock);
+    SDL_free(job.chunkOffsets);
+    for (int i = 0; i < loadedReplays; i++) REPLAY_Destroy(&replays[i]);
+    SDL_free(replays);
+
+    result->elapsedNS = SDL_GetTicksNS() - startTicks;
+    return success;
+}
+
+bool DATASET_DecodeColumn(const Uint8* data, const size_t size, const DatasetEncoding encoding, const int recordCount, const int width, Uint8* values)
+{
+    const size_t rawSize = (size_t)recordCount * (size_t)width;
+
+    if (encoding == DATASET_ENCODING_RAW)
+    {
+        if (size != rawSize) return false;
+        SDL_memcpy(values, data, rawSize);
+        return true;
+    }
+    if (encoding != DATASET_ENCODING_XOR_ZERO_RUNS) return false;
+
+    size_t length = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] != 0)
+        {
+            if (length == rawSize) return false;
+            values[length++] = data[i];
+            continue;
+        }
+
+        if (i + 1 == size || data[i + 1] == 0 || data[i + 1] > rawSize - length) return false;
+        SDL_memset(values + length, 0, data[i + 1]);
+        length += data[++i];
+    }
+    if (length != rawSize) return false;
+
+    for (size_t i = (size_t)width; i < rawSize; i++) values[i] ^= values[i - (size_t)width];
+    return true;
+}
+
+/**
+ * @brief Check that a chunk read from a dataset file is well formed, and that each column round-trips.
+ *
+ * @param chunk The chunk, as read from the file.
+ * @param chunkSize The size (in bytes) of the chunk.
+ * @param values Space for a decoded column, which must hold DATASET_CHUNK_RECORDS values of the widest column.
+ * @param encoded Space to encode a column into, which must be as large as values.
+ *
+ * @return True if the chunk is valid, false otherwise.
+ */
+static bool VerifyChunk(const Uint8* chunk, const Uint64 chunkSize, Uint8* values, Uint8* encoded)
+{
+    const DatasetChunkHeader* header = (const DatasetChunkHeader*)chunk;
+    const int recordCount = (int)SDL_Swap32LE(header->recordCount);
+    if (SDL_Swap32LE(header->magic) != DATASET_CHUNK_MAGIC || recordCount < 1 || recordCount > DATASET_CHUNK_RECORDS) return false;
+
+    for (int c = 0; c < DATASET_COLUMN_COUNT; c++)
+    {
+        const Uint64 offset = SDL_Swap64LE(header->columns[c].offset);
+        const size_t size = SDL_Swap32LE(header->columns[c].size);
+        const DatasetEncoding encoding = (DatasetEncoding)SDL_Swap32LE(header->columns[c].encoding);
+        if (offset % DATASET_ALIGNMENT != 0 || offset > chunkSize || size > chunkSize - offset) return false;
+
+        const Uint8* data = chunk + offset;
+        if (!DATASET_DecodeColumn(data, size, encoding, recordCount, COLUMN_WIDTHS[c], values)) return false;
+
+        // The encoder picks the encoding, so encoding the values again must give back exactly what was stored
+        const size_t encodedSize = EncodeXorZeroRuns(values, recordCount, COLUMN_WIDTHS[c], encoded);
+        if (encoding == DATASET_ENCODING_XOR_ZERO_RUNS && (encodedSize != size || SDL_memcmp(encoded, data, size) != 0)) return false;
+        if (encoding == DATASET_ENCODING_RAW && encodedSize != 0) return false;
+    }
+
+    return true;
+}
+
+bool DATASET_Verify(const char* path, Uint64* records)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *records = 0;
+    SDL_IOStream* stream = SDL_IOFromFile(path, "rb");
+    if (!stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open dataset file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    DatasetFileHeader fileHeader;
+    DatasetTrailer trailer;
+    const Sint64 fileSize = SDL_GetIOSize(stream);
+    bool success = fileSize >= (Sint64)(sizeof(fileHeader) + sizeof(trailer)) && SDL_ReadIO(stream, &fileHeader, sizeof(fileHeader)) == sizeof(fileHeader);
+    success = success && SDL_SeekIO(stream, fileSize - (Sint64)sizeof(trailer), SDL_IO_SEEK_SET) >= 0;
+    success = success && SDL_ReadU64LE(stream, &trailer.indexOffset) && SDL_ReadU64LE(stream, &trailer.chunkCount) && SDL_ReadU64LE(stream, &trailer.recordCount);
+    success = success && SDL_ReadU32LE(stream, &trailer.magic) && SDL_ReadU32LE(stream, &trailer.version);
+
+    success = success && SDL_Swap32LE(fileHeader.magic) == DATASET_MAGIC && SDL_Swap32LE(fileHeader.version) == DATASET_VERSION;
+    success = success && SDL_Swap32LE(fileHeader.columnCount) == DATASET_COLUMN_COUNT && SDL_memcmp(fileHeader.columnWidths, COLUMN_WIDTHS, sizeof(COLUMN_WIDTHS)) == 0;
+    success = success && trailer.magic == DATASET_MAGIC && trailer.version == DATASET_VERSION;
+    success = success && trailer.indexOffset + trailer.chunkCount * sizeof(Uint64) + sizeof(trailer) == (Uint64)fileSize;
+
+    // A chunk is never larger than a worker's encoding space, which holds every column raw
+    size_t chunkCapacity = AlignSize(sizeof(DatasetChunkHeader));
+    size_t valuesCapacity = 0;
+    for (int c = 0; c < DATASET_COLUMN_COUNT; c++)
+    {
+        chunkCapacity += AlignSize((Uint64)DATASET_CHUNK_RECORDS * COLUMN_WIDTHS[c]);
+        valuesCapacity = SDL_max(valuesCapacity, (size_t)DATASET_CHUNK_RECORDS * COLUMN_WIDTHS[c]);
+    }
+    Uint8* chunk = SDL_malloc(chunkCapacity);
+    Uint8* values = SDL_malloc(valuesCapacity);
+    Uint8* encoded = SDL_malloc(valuesCapacity);
+    success = success && chunk && values && encoded;
+
+    Uint64 expectedOffset = sizeof(fileHeader);
+    for (Uint64 i = 0; success && i < trailer.chunkCount; i++)
+    {
+        Uint64 offset;
+        success = SDL_SeekIO(stream, (Sint64)(trailer.indexOffset + i * sizeof(Uint64)), SDL_IO_SEEK_SET) >= 0 && SDL_ReadU64LE(stream, &offset);
+
+        // Chunks are written back to back, in the order of the index
+        DatasetChunkHeader* header = (DatasetChunkHeader*)chunk;
+        success = success && offset == expectedOffset && SDL_SeekIO(stream, (Sint64)offset, SDL_IO_SEEK_SET) >= 0;
+        success = success && SDL_ReadIO(stream, header, sizeof(*header)) == sizeof(*header);
+
+        const Uint64 chunkSize = success ? SDL_Swap64LE(header->size) : 0;
+        success = success && chunkSize >= sizeof(*header) && chunkSize <= chunkCapacity && offset + chunkSize <= trailer.indexOffset;
+        success = success && SDL_ReadIO(stream, chunk + sizeof(*header), (size_t)chunkSize - sizeof(*header)) == chunkSize - sizeof(*header);
+        success = success && VerifyChunk(chunk, chunkSize, values, encoded);
+
+        if (success)
+        {
+            *records += SDL_Swap32LE(header->recordCount);
+            expectedOffset = offset + chunkSize;
+        }
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Dataset chunk %" SDL_PRIu64 " of '%s' is malformed!", i, path);
+        }
+    }
+
+    success = success && expectedOffset == trailer.indexOffset && *records == trailer.recordCount;
+    if (!success) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Dataset file '%s' failed verification!", path);
+
+    SDL_free(chunk);
+    SDL_free(values);
+    SDL_free(encoded);
+    SDL_CloseIO(stream);
+    return success;
+}
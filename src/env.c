@@ -0,0 +1,333 @@
+#include "env.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief A single environment: a game and the dropping tetromino it points to.
+ */
+typedef struct Env
+{
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+
+    /** @brief The seed of the current episode. */
+    Uint64 seed;
+} Env;
+
+struct EnvBatch
+{
+    int count;
+    Env* envs;
+
+    /** @brief The shared memory region, or NULL if the batch is not shared. */
+    EnvSharedHeader* shared;
+    size_t sharedSize;
+    char sharedName[256];
+
+#ifdef _WIN32
+    HANDLE sharedMapping;
+#endif
+};
+
+/**
+ * @brief Round a size up to a multiple of 64 bytes, so that each shared array starts on its own cache line.
+ *
+ * @param size The size.
+ *
+ * @return The rounded size.
+ */
+static size_t AlignToCacheLine(const size_t size)
+{
+    return (size + 63) & ~(size_t)63;
+}
+
+/**
+ * @brief Allocate a batch and reset each of its environments.
+ *
+ * @param count The number of environments.
+ * @param seed The seed of the first environment's first episode.
+ *
+ * @return The batch, or NULL on failure.
+ */
+static EnvBatch* CreateBatch(const int count, const Uint64 seed)
+{
+    if (count <= 0 || count > ENV_MAX_BATCH)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid environment count %d (1 to %d)!", count, ENV_MAX_BATCH);
+        return NULL;
+    }
+
+    EnvBatch* batch = SDL_calloc(1, sizeof(EnvBatch));
+    if (!batch) return NULL;
+
+    batch->count = count;
+    batch->envs = SDL_calloc((size_t)count, sizeof(Env));
+    if (!batch->envs)
+    {
+        SDL_free(batch);
+        return NULL;
+    }
+
+    for (int i = 0; i < count; i++) ENV_Reset(batch, i, seed + (Uint64)i);
+    return batch;
+}
+
+/**
+ * @brief Map a named shared memory region, creating it if needed.
+ *
+ * @param batch The batch to store the mapping in.
+ * @param name The name of the region.
+ * @param size The size (in bytes) of the region.
+ *
+ * @return The start of the region, or NULL on failure.
+ */
+static void* MapSharedMemory(EnvBatch* batch, const char* name, const size_t size)
+{
+#ifdef _WIN32
+    batch->sharedMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((Uint64)size >> 32), (DWORD)size, name);
+    if (!batch->sharedMapping) return NULL;
+
+    void* memory = MapViewOfFile(batch->sharedMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!memory)
+    {
+        CloseHandle(batch->sharedMapping);
+        batch->sharedMapping = NULL;
+    }
+    return memory;
+#else
+    (void)batch;
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd < 0) return NULL;
+
+    if (ftruncate(fd, (off_t)size) != 0)
+    {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    // The mapping keeps the region alive, so the descriptor is not needed once it is mapped
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        shm_unlink(name);
+        return NULL;
+    }
+    return memory;
+#endif
+}
+
+/**
+ * @brief Unmap and remove a batch's shared memory region.
+ *
+ * @param batch The batch.
+ */
+static void UnmapSharedMemory(EnvBatch* batch)
+{
+#ifdef _WIN32
+    UnmapViewOfFile(batch->shared);
+    CloseHandle(batch->sharedMapping);
+    batch->sharedMapping = NULL;
+#else
+    munmap(batch->shared, batch->sharedSize);
+    shm_unlink(batch->sharedName);
+#endif
+    batch->shared = NULL;
+}
+
+EnvBatch* ENV_Create(const int count, const Uint64 seed)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    return CreateBatch(count, seed);
+}
+
+EnvBatch* ENV_CreateShared(const char* name, const int count, const Uint64 seed)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    EnvBatch* batch = CreateBatch(count, seed);
+    if (!batch) return NULL;
+
+    const size_t actionsOffset = AlignToCacheLine(sizeof(EnvSharedHeader));
+    const size_t rewardsOffset = actionsOffset + AlignToCacheLine((size_t)count * sizeof(Uint8));
+    const size_t donesOffset = rewardsOffset + AlignToCacheLine((size_t)count * sizeof(float));
+    const size_t observationsOffset = donesOffset + AlignToCacheLine((size_t)count * sizeof(Uint8));
+    batch->sharedSize = observationsOffset + (size_t)count * sizeof(EnvObservation);
+    SDL_strlcpy(batch->sharedName, name, sizeof(batch->sharedName));
+
+    EnvSharedHeader* shared = MapSharedMemory(batch, name, batch->sharedSize);
+    if (!shared)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map shared memory '%s' of %zu bytes!", name, batch->sharedSize);
+        ENV_Destroy(batch);
+        return NULL;
+    }
+
+    SDL_memset(shared, 0, batch->sharedSize);
+    shared->version = ENV_API_VERSION;
+    shared->count = (Uint32)count;
+    shared->observationSize = (Uint32)sizeof(EnvObservation);
+    shared->actionsOffset = (Uint32)actionsOffset;
+    shared->rewardsOffset = (Uint32)rewardsOffset;
+    shared->donesOffset = (Uint32)donesOffset;
+    shared->observationsOffset = (Uint32)observationsOffset;
+    batch->shared = shared;
+
+    // The first observations are there before any step, and the magic is written last so that a trainer that finds
+    // it can trust the rest of the header
+    EnvObservation* observations = (EnvObservation*)((Uint8*)shared + observationsOffset);
+    for (int i = 0; i < count; i++) ENV_Observe(batch, i, &observations[i]);
+    SDL_MemoryBarrierRelease();
+    shared->magic = ENV_SHARED_MAGIC;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Sharing %d environments in '%s' (%zu bytes).", count, name, batch->sharedSize);
+    return batch;
+}
+
+void ENV_Destroy(EnvBatch* batch)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!batch) return;
+
+    if (batch->shared)
+    {
+        SDL_SetAtomicInt(&batch->shared->isClosing, 1);
+        UnmapSharedMemory(batch);
+    }
+
+    SDL_free(batch->envs);
+    SDL_free(batch);
+}
+
+int ENV_GetCount(const EnvBatch* batch)
+{
+    return batch->count;
+}
+
+void ENV_Reset(EnvBatch* batch, const int index, const Uint64 seed)
+{
+    Env* env = &batch->envs[index];
+    env->game.droppingTetromino = &env->droppingTetromino;
+    env->game.isRunning = true;
+    env->game.isPaused = false;
+    env->seed = seed;
+    GAME_ResetWithSeed(&env->game, seed);
+}
+
+float ENV_Step(EnvBatch* batch, const int index, const EnvAction action, bool* done)
+{
+    Env* env = &batch->envs[index];
+    GameDataContext* game = &env->game;
+
+    if (action == ENV_ACTION_RESET)
+    {
+        ENV_Reset(batch, index, env->seed + (Uint64)batch->count);
+        *done = false;
+        return 0;
+    }
+
+    const int previousScore = game->score;
+
+    switch (action)
+    {
+    case ENV_ACTION_LEFT: ShiftTetromino(game, -1); break;
+    case ENV_ACTION_RIGHT: ShiftTetromino(game, 1); break;
+    case ENV_ACTION_ROTATE_CW: WallKickDroppingTetromino(game, 1); break;
+    case ENV_ACTION_ROTATE_CCW: WallKickDroppingTetromino(game, -1); break;
+    case ENV_ACTION_SOFT_DROP: SoftDropTetromino(game); break;
+    case ENV_ACTION_HARD_DROP: HardDropTetromino(game); break;
+    default: break;
+    }
+
+    GAME_Iteration(game, ENV_STEP_NS);
+
+    *done = game->isGameOver;
+    return (float)(game->score - previousScore);
+}
+
+void ENV_StepBatch(EnvBatch* batch, const Uint8* actions, float* rewards, Uint8* dones, EnvObservation* observations)
+{
+    for (int i = 0; i < batch->count; i++)
+    {
+        bool done;
+        const EnvAction action = (actions[i] < ENV_ACTION_COUNT) ? (EnvAction)actions[i] : ENV_ACTION_NONE;
+        rewards[i] = ENV_Step(batch, i, action, &done);
+        dones[i] = done;
+
+        if (done) ENV_Reset(batch, i, batch->envs[i].seed + (Uint64)batch->count);
+        if (observations) ENV_Observe(batch, i, &observations[i]);
+    }
+}
+
+void ENV_Observe(const EnvBatch* batch, const int index, EnvObservation* observation)
+{
+    const GameDataContext* game = &batch->envs[index].game;
+
+    // Heights are found top down, so a column's first filled cell sets its height
+    SDL_memset(observation->heights, 0, sizeof(observation->heights));
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        for (int col = 0; col < ARENA_WIDTH; col++)
+        {
+            const Uint8 isFilled = game->arena[row][col] != 0;
+            observation->board[row][col] = isFilled;
+            if (isFilled && observation->heights[col] == 0) observation->heights[col] = (Uint8)(ARENA_HEIGHT - row);
+        }
+    }
+
+    const DroppingTetromino* droppingTetromino = game->droppingTetromino;
+    observation->piece = (Uint8)droppingTetromino->shape->identifier;
+    observation->pieceX = (Sint8)droppingTetromino->x;
+    observation->pieceY = (Sint8)droppingTetromino->y;
+    observation->pieceOrientation = (Uint8)droppingTetromino->orientation;
+
+    int queueCount;
+    const TetrominoIdentifier* queue = PeekTetrominoQueue(&game->tetrominoBag, &queueCount);
+    for (int i = 0; i < ENV_QUEUE_OBSERVED; i++) observation->queue[i] = (Uint8)queue[i];
+}
+
+Sint64 ENV_ServeShared(EnvBatch* batch, SDL_AtomicInt* quit)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    EnvSharedHeader* shared = batch->shared;
+    if (!shared) return -1;
+
+    Uint8* region = (Uint8*)shared;
+    const Uint8* actions = region + shared->actionsOffset;
+    float* rewards = (float*)(region + shared->rewardsOffset);
+    Uint8* dones = region + shared->donesOffset;
+    EnvObservation* observations = (EnvObservation*)(region + shared->observationsOffset);
+
+    Sint64 steps = 0;
+    int idlePolls = 0;
+    while (!(quit && SDL_GetAtomicInt(quit)) && !SDL_GetAtomicInt(&shared->isClosing))
+    {
+        const int requestedSteps = SDL_GetAtomicInt(&shared->requestedSteps);
+        if (requestedSteps == SDL_GetAtomicInt(&shared->completedSteps))
+        {
+            // Spin briefly, as a trainer usually requests the next step straight away, then back off to save the core
+            if (++idlePolls < ENV_SHARED_SPIN_COUNT) SDL_CPUPauseInstruction();
+            else SDL_DelayNS(ENV_SHARED_SLEEP_NS);
+            continue;
+        }
+
+        idlePolls = 0;
+        SDL_MemoryBarrierAcquire();
+        ENV_StepBatch(batch, actions, rewards, dones, observations);
+        SDL_MemoryBarrierRelease();
+        SDL_SetAtomicInt(&shared->completedSteps, requestedSteps);
+        steps++;
+    }
+
+    return steps;
+}
@@ -0,0 +1,305 @@
+#include "eventlog.h"
+
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Write a 32-bit value as little endian.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void PutU32(Uint8* bytes, const Uint32 value)
+{
+    for (int i = 0; i < 4; i++) bytes[i] = (Uint8)(value >> (8 * i));
+}
+
+/**
+ * @brief Write a 64-bit value as little endian.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void PutU64(Uint8* bytes, const Uint64 value)
+{
+    for (int i = 0; i < 8; i++) bytes[i] = (Uint8)(value >> (8 * i));
+}
+
+/**
+ * @brief Encode an event as a binary record.
+ *
+ * @details The record holds the timestamp (u64), game clock (u64) and seed (u64), then the event type, tetromino,
+ * x (signed), y (signed), orientation, lines cleared (or rows hard dropped), lowest row cleared and level as a byte each,
+ * then the score (u32).
+ *
+ * @param entry The event.
+ * @param bytes The record to write to.
+ */
+static void EncodeBinary(const EventLogEntry* entry, Uint8 bytes[EVENTLOG_RECORD_SIZE])
+{
+    const GameEvent* event = &entry->event;
+    PutU64(bytes, entry->timestampNS);
+    PutU64(bytes + 8, event->clockNS);
+    PutU64(bytes + 16, event->seed);
+    bytes[24] = (Uint8)event->type;
+    bytes[25] = (Uint8)event->piece;
+    bytes[26] = (Uint8)(Sint8)event->x;
+    bytes[27] = (Uint8)(Sint8)event->y;
+    bytes[28] = (Uint8)event->orientation;
+    bytes[29] = (Uint8)event->lines;
+    bytes[30] = (Uint8)event->row;
+    bytes[31] = (Uint8)event->level;
+    PutU32(bytes + 32, (Uint32)event->score);
+    PutU32(bytes + 36, 0);
+}
+
+/**
+ * @brief Encode an event as a line of JSON, with only the fields that mean something for its type.
+ *
+ * @param entry The event.
+ * @param line The buffer to write the line to, of EVENTLOG_LINE_SIZE bytes.
+ *
+ * @return The length of the line, including its newline.
+ */
+static int EncodeNDJSON(const EventLogEntry* entry, char* line)
+{
+    // Indexed by ::TetrominoIdentifier
+    static const char PIECE_NAMES[] = "?IOTZSLJ";
+    static const char* CLEAR_NAMES[] = { "none", "single", "double", "triple", "tetris" };
+
+    const GameEvent* event = &entry->event;
+    int length = SDL_snprintf(line, EVENTLOG_LINE_SIZE, "{\"t\":%" SDL_PRIu64 ",\"clock\":%" SDL_PRIu64 ",\"seed\":%" SDL_PRIu64 ",\"event\":\"%s\"",
+        entry->timestampNS, event->clockNS, event->seed, GAME_GetEventName(event->type));
+
+    switch (event->type)
+    {
+    case GAME_EVENT_SPAWN:
+    case GAME_EVENT_LOCK:
+    case GAME_EVENT_HARD_DROP:
+    case GAME_EVENT_MOVE:
+    case GAME_EVENT_ROTATE:
+        if (event->type == GAME_EVENT_HARD_DROP) length += SDL_snprintf(line + length, EVENTLOG_LINE_SIZE - length, ",\"distance\":%d", event->lines);
+        length += SDL_snprintf(line + length, EVENTLOG_LINE_SIZE - length, ",\"piece\":\"%c\",\"x\":%d,\"y\":%d,\"orientation\":%d",
+            (event->piece > 0 && (int)event->piece <= TETROMINO_COUNT) ? PIECE_NAMES[event->piece] : '?', event->x, event->y, event->orientation);
+        break;
+    case GAME_EVENT_LINE_CLEAR:
+        length += SDL_snprintf(line + length, EVENTLOG_LINE_SIZE - length, ",\"lines\":%d,\"clear\":\"%s\",\"row\":%d",
+            event->lines, CLEAR_NAMES[SDL_clamp(event->lines, 0, 4)], event->row);
+        break;
+    default:
+        break;
+    }
+
+    length += SDL_snprintf(line + length, EVENTLOG_LINE_SIZE - length, ",\"level\":%d,\"score\":%d}\n", event->level, event->score);
+    return SDL_min(length, EVENTLOG_LINE_SIZE - 1);
+}
+
+/**
+ * @brief Force everything written to a stream onto the disk.
+ *
+ * @param stream The stream, which must be a file.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool SyncStream(SDL_IOStream* stream)
+{
+    if (!SDL_FlushIO(stream)) return false;
+
+#ifdef _WIN32
+    HANDLE handle = SDL_GetPointerProperty(SDL_GetIOProperties(stream), SDL_PROP_IOSTREAM_WINDOWS_HANDLE_POINTER, NULL);
+    return handle && FlushFileBuffers(handle);
+#else
+    const int fd = (int)SDL_GetNumberProperty(SDL_GetIOProperties(stream), SDL_PROP_IOSTREAM_FILE_DESCRIPTOR_NUMBER, -1);
+    return fd >= 0 && fsync(fd) == 0;
+#endif
+}
+
+/**
+ * @brief Encode and write every event waiting in the ring buffer, a batch at a time. Only called from the writer thread.
+ *
+ * @param log A pointer to the log.
+ *
+ * @return The number of events written.
+ */
+static int DrainRing(EventLog* log)
+{
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&log->tail);
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&log->head);
+    int written = 0;
+
+    while (head != tail)
+    {
+        TRACE_BEGIN("EVENTLOG_WriteBatch");
+
+        size_t size = 0;
+        const Uint32 batchEnd = head + SDL_min(tail - head, (Uint32)EVENTLOG_BATCH_SIZE);
+        for (; head != batchEnd; head++)
+        {
+            const EventLogEntry* entry = &log->ring[head & (EVENTLOG_RING_CAPACITY - 1)];
+            if (log->format == EVENTLOG_FORMAT_BINARY)
+            {
+                EncodeBinary(entry, (Uint8*)log->batch + size);
+                size += EVENTLOG_RECORD_SIZE;
+            }
+            else size += (size_t)EncodeNDJSON(entry, log->batch + size);
+            written++;
+        }
+
+        // The slots are only handed back once they have been encoded
+        SDL_SetAtomicInt(&log->head, (int)head);
+
+        if (SDL_WriteIO(log->stream, log->batch, size) != size) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write event log: %s", SDL_GetError());
+        log->writtenBatches++;
+
+        TRACE_END("EVENTLOG_WriteBatch");
+    }
+
+    log->writtenEvents += (Uint64)written;
+    return written;
+}
+
+/**
+ * @brief The writer thread, which drains the ring buffer into the log until stopped.
+ *
+ * @param data A pointer to the log.
+ *
+ * @return Zero.
+ */
+static int SDLCALL EventLogWriterThread(void* data)
+{
+    EventLog* log = data;
+    TRACE_NameThread("EventLogWriter");
+
+    for (;;)
+    {
+        SDL_WaitSemaphoreTimeout(log->wake, EVENTLOG_WRITE_INTERVAL_MS);
+
+        // The stop flag is read before draining, so that every event pushed before it was set is written
+        const bool isStopping = SDL_GetAtomicInt(&log->isStopping);
+
+        if (DrainRing(log) > 0)
+        {
+            if (log->syncPolicy == EVENTLOG_SYNC_FLUSH) SDL_FlushIO(log->stream);
+            else if (log->syncPolicy == EVENTLOG_SYNC_FSYNC && !SyncStream(log->stream)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to sync event log: %s", SDL_GetError());
+        }
+
+        if (isStopping) break;
+    }
+
+    return 0;
+}
+
+bool EVENTLOG_Open(EventLog* log, const char* path, const EventLogFormat format, const EventLogSyncPolicy syncPolicy)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_zerop(log);
+    log->format = format;
+    log->syncPolicy = syncPolicy;
+
+    log->stream = SDL_IOFromFile(path, "wb");
+    if (!log->stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create event log '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    if (format == EVENTLOG_FORMAT_BINARY)
+    {
+        Uint8 header[EVENTLOG_HEADER_SIZE];
+        PutU32(header, EVENTLOG_MAGIC);
+        PutU32(header + 4, EVENTLOG_VERSION);
+        if (SDL_WriteIO(log->stream, header, sizeof(header)) != sizeof(header))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write event log header: %s", SDL_GetError());
+            EVENTLOG_Close(log);
+            return false;
+        }
+    }
+
+    log->wake = SDL_CreateSemaphore(0);
+    if (log->wake) log->thread = SDL_CreateThread(EventLogWriterThread, "EventLogWriter", log);
+    if (!log->thread)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create event log writer thread: %s", SDL_GetError());
+        EVENTLOG_Close(log);
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Logging game events to '%s'.", path);
+    return true;
+}
+
+void EVENTLOG_Close(EventLog* log)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (log->thread)
+    {
+        SDL_SetAtomicInt(&log->isStopping, 1);
+        SDL_SignalSemaphore(log->wake);
+        SDL_WaitThread(log->thread, NULL);
+        log->thread = NULL;
+    }
+
+    if (log->wake)
+    {
+        SDL_DestroySemaphore(log->wake);
+        log->wake = NULL;
+    }
+
+    if (log->stream)
+    {
+        SDL_CloseIO(log->stream);
+        log->stream = NULL;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote %" SDL_PRIu64 " game events in %" SDL_PRIu64 " batches.", log->writtenEvents, log->writtenBatches);
+    const int droppedEvents = SDL_GetAtomicInt(&log->droppedEvents);
+    if (droppedEvents > 0) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d game events were dropped because the event log ring buffer was full!", droppedEvents);
+}
+
+void EVENTLOG_Listen(void* userData, const GameEvent* event)
+{
+    EventLog* log = userData;
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&log->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&log->tail);
+
+    // Logging from here would add the very jitter the ring buffer avoids, so a full ring is only counted
+    if (tail - head >= EVENTLOG_RING_CAPACITY)
+    {
+        SDL_AddAtomicInt(&log->droppedEvents, 1);
+        return;
+    }
+
+    // The event must be written before the tail is published, which the atomic set guarantees
+    EventLogEntry* entry = &log->ring[tail & (EVENTLOG_RING_CAPACITY - 1)];
+    entry->event = *event;
+    entry->timestampNS = SDL_GetTicksNS();
+    SDL_SetAtomicInt(&log->tail, (int)(tail + 1));
+
+    // Waking the writer is a system call, so it is only done when the ring starts to fill faster than it is drained
+    if (tail + 1 - head == EVENTLOG_WAKE_THRESHOLD) SDL_SignalSemaphore(log->wake);
+}
+
+bool EVENTLOG_ParseFormat(const char* name, EventLogFormat* format)
+{
+    if (!SDL_strcmp(name, "binary")) *format = EVENTLOG_FORMAT_BINARY;
+    else if (!SDL_strcmp(name, "ndjson")) *format = EVENTLOG_FORMAT_NDJSON;
+    else return false;
+    return true;
+}
+
+bool EVENTLOG_ParseSyncPolicy(const char* name, EventLogSyncPolicy* syncPolicy)
+{
+    if (!SDL_strcmp(name, "none")) *syncPolicy = EVENTLOG_SYNC_NONE;
+    else if (!SDL_strcmp(name, "flush")) *syncPolicy = EVENTLOG_SYNC_FLUSH;
+    else if (!SDL_strcmp(name, "fsync")) *syncPolicy = EVENTLOG_SYNC_FSYNC;
+    else return false;
+    return true;
+}
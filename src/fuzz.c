@@ -0,0 +1,442 @@
+#include "fuzz.h"
+
+#include "trace.h"
+#include "zobrist.h"
+
+/**
+ * @brief A game under test, together with the state needed to check its invariants between operations.
+ */
+typedef struct FuzzGame
+{
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+
+    /** @brief The seed of the case, from which the seed of every reset is derived. */
+    Uint64 seed;
+
+    /** @brief The number of resets so far. */
+    Uint64 resets;
+
+    /** @brief The score after the previous operation. */
+    int previousScore;
+
+    /** @brief The number of lines cleared after the previous operation. */
+    int previousLinesCleared;
+
+    /** @brief The arena after the previous operation, so that it is only checked again once it changes. */
+    TetrominoIdentifier previousArena[ARENA_HEIGHT][ARENA_WIDTH];
+
+    /** @brief The hash of previousArena, computed from scratch rather than incrementally as the game does. */
+    Uint64 expectedArenaHash;
+} FuzzGame;
+
+/**
+ * @brief The state of the whole run, shared by every worker.
+ */
+typedef struct FuzzJob
+{
+    Uint64 caseCount;
+    Uint64 seed;
+
+    /** @brief The number of blocks of FUZZ_CASES_PER_CLAIM cases claimed so far. */
+    SDL_AtomicInt nextClaim;
+
+    /** @brief Set once any worker finds a failure, so that the others stop early. */
+    SDL_AtomicInt hasFailed;
+
+    /** @brief The number of workers that have finished. */
+    SDL_AtomicInt finishedWorkers;
+} FuzzJob;
+
+/**
+ * @brief The state of a single worker thread.
+ */
+typedef struct FuzzWorker
+{
+    SDL_Thread* thread;
+    FuzzJob* job;
+    FuzzGame fuzzGame;
+    Uint64 cases;
+    Uint64 operations;
+
+    /** @brief The index of the first failing case found by this worker, valid when hasFailed is set. */
+    Uint64 failedCase;
+    bool hasFailed;
+    FuzzFailure failure;
+} FuzzWorker;
+
+/**
+ * @brief Start a new game for the next reset of a case.
+ *
+ * @param fuzzGame A pointer to the game under test.
+ */
+static void ResetGame(FuzzGame* fuzzGame)
+{
+    fuzzGame->game.droppingTetromino = &fuzzGame->droppingTetromino;
+    GAME_ResetWithSeed(&fuzzGame->game, fuzzGame->seed + fuzzGame->resets++);
+    fuzzGame->game.isRunning = true;
+    fuzzGame->previousScore = 0;
+    fuzzGame->previousLinesCleared = 0;
+    SDL_memset(fuzzGame->previousArena, 0, sizeof(fuzzGame->previousArena));
+    fuzzGame->expectedArenaHash = 0;
+}
+
+/**
+ * @brief Apply a single operation to the game under test.
+ *
+ * @param fuzzGame A pointer to the game under test.
+ * @param operation The operation to apply.
+ */
+static void ApplyOperation(FuzzGame* fuzzGame, const char operation)
+{
+    GameDataContext* game = &fuzzGame->game;
+
+    switch (operation)
+    {
+    case FUZZ_SHIFT_LEFT: ShiftTetromino(game, -1); break;
+    case FUZZ_SHIFT_RIGHT: ShiftTetromino(game, 1); break;
+    case FUZZ_ROTATE_CLOCKWISE: WallKickDroppingTetromino(game, 1); break;
+    case FUZZ_ROTATE_ANTICLOCKWISE: WallKickDroppingTetromino(game, -1); break;
+    case FUZZ_SOFT_DROP: SoftDropTetromino(game); break;
+    case FUZZ_HARD_DROP: HardDropTetromino(game); break;
+    case FUZZ_TOGGLE_PAUSE: GAME_TogglePause(game); break;
+    case FUZZ_RESET: ResetGame(fuzzGame); break;
+    case FUZZ_GARBAGE: GAME_QueueGarbage(game, 1); break;
+    case FUZZ_ITERATE: GAME_Iteration(game, SDL_MS_TO_NS(FUZZ_ITERATION_MS)); break;
+    default: break;
+    }
+}
+
+/**
+ * @brief Check every invariant of the game under test, after an operation has been applied.
+ *
+ * @param fuzzGame A pointer to the game under test.
+ *
+ * @return The name of the broken invariant, or NULL if every invariant held.
+ */
+static const char* CheckInvariants(FuzzGame* fuzzGame)
+{
+    const GameDataContext* game = &fuzzGame->game;
+
+    // Most operations only move the dropping tetromino, and an arena that has not changed still passed its last check
+    if (SDL_memcmp(game->arena, fuzzGame->previousArena, sizeof(game->arena)) != 0)
+    {
+        fuzzGame->expectedArenaHash = 0;
+        for (int row = 0; row < ARENA_HEIGHT; row++)
+        {
+            Uint16 mask = 0;
+            for (int col = 0; col < ARENA_WIDTH; col++)
+            {
+                const TetrominoIdentifier cell = game->arena[row][col];
+                if (cell < 0 || cell > GARBAGE) return "arena holds an invalid tetromino identifier";
+                if (cell != 0) mask |= (Uint16)(1u << col);
+            }
+
+            if (mask == (1u << ARENA_WIDTH) - 1) return "arena has a filled row that was not cleared";
+            fuzzGame->expectedArenaHash ^= ZOBRIST_RowKey(row, mask);
+        }
+
+        SDL_memcpy(fuzzGame->previousArena, game->arena, sizeof(game->arena));
+    }
+    if (game->arenaHash != fuzzGame->expectedArenaHash) return "arena hash does not match the arena";
+
+    // A tetromino spawning on top of the stack is how the game detects a loss, so it may only overlap once it is over
+    if (!game->isGameOver)
+    {
+        const DroppingTetromino* droppingTetromino = game->droppingTetromino;
+        const bool (*coordinates)[TETROMINO_MAX_SIZE] = droppingTetromino->shape->coordinates[droppingTetromino->orientation & 3];
+
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+        {
+            for (int j = 0; j < TETROMINO_MAX_SIZE; j++)
+            {
+                if (!coordinates[i][j]) continue;
+
+                const int x = droppingTetromino->x + j;
+                const int y = droppingTetromino->y + i;
+                if (x < 0 || x >= ARENA_WIDTH || y < 0 || y >= ARENA_HEIGHT) return "dropping tetromino is out of bounds";
+                if (game->arena[y][x] != 0) return "dropping tetromino overlaps the stack";
+            }
+        }
+    }
+
+    if (game->linesCleared - fuzzGame->previousLinesCleared > 4) return "more than four rows were cleared at once";
+    if (game->linesCleared < fuzzGame->previousLinesCleared) return "lines cleared decreased";
+    if (game->score < fuzzGame->previousScore) return "score decreased";
+    if (game->level < 1 || game->level > MAX_LEVEL) return "level is out of range";
+
+    int queueCount;
+    PeekTetrominoQueue(&game->tetrominoBag, &queueCount);
+    if (queueCount < TETROMINO_QUEUE_LENGTH || queueCount > TETROMINO_QUEUE_CAPACITY) return "next queue is the wrong length";
+
+    fuzzGame->previousScore = game->score;
+    fuzzGame->previousLinesCleared = game->linesCleared;
+    return NULL;
+}
+
+/**
+ * @brief Apply a sequence of operations to a game, checking the invariants after each one.
+ *
+ * @param fuzzGame A pointer to the game under test, which is reset with the seed first.
+ * @param seed The seed of the case.
+ * @param operations The operations.
+ * @param operationCount The number of operations.
+ * @param failedOperation A pointer to write the index of the failing operation to, or NULL.
+ *
+ * @return The name of the broken invariant, or NULL if every invariant held.
+ */
+static const char* RunCase(FuzzGame* fuzzGame, const Uint64 seed, const char* operations, const int operationCount, int* failedOperation)
+{
+    fuzzGame->seed = seed;
+    fuzzGame->resets = 0;
+    ResetGame(fuzzGame);
+    fuzzGame->game.isPaused = false;
+
+    for (int i = 0; i < operationCount; i++)
+    {
+        ApplyOperation(fuzzGame, operations[i]);
+
+        const char* invariant = CheckInvariants(fuzzGame);
+        if (invariant)
+        {
+            if (failedOperation) *failedOperation = i;
+            return invariant;
+        }
+
+        // Nothing but a reset changes a lost game, so start the next one straight away rather than waste operations
+        if (fuzzGame->game.isGameOver) ResetGame(fuzzGame);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Generate the random operations of a case.
+ *
+ * @details Pauses are always followed by a few operations and then an unpause, so that the game spends most of the
+ * case playing rather than ignoring input.
+ *
+ * @param seed The seed of the case.
+ * @param operations The buffer of FUZZ_CASE_OPERATIONS operations to write to.
+ */
+static void GenerateOperations(const Uint64 seed, char* operations)
+{
+    // Weighted so that pieces are moved around plenty before landing, and resets are rare. Random play almost never
+    // fills a row by itself, so garbage rows (each with a single hole) are mixed in to get rows cleared
+    static const struct
+    {
+        char operation;
+        int weight;
+    } WEIGHTS[] = {
+        {FUZZ_SHIFT_LEFT, 20},
+        {FUZZ_SHIFT_RIGHT, 20},
+        {FUZZ_ROTATE_CLOCKWISE, 12},
+        {FUZZ_ROTATE_ANTICLOCKWISE, 12},
+        {FUZZ_SOFT_DROP, 12},
+        {FUZZ_HARD_DROP, 6},
+        {FUZZ_ITERATE, 16},
+        {FUZZ_GARBAGE, 3},
+        {FUZZ_TOGGLE_PAUSE, 1},
+        {FUZZ_RESET, 1},
+    };
+
+    int totalWeight = 0;
+    for (size_t i = 0; i < SDL_arraysize(WEIGHTS); i++) totalWeight += WEIGHTS[i].weight;
+
+    Uint64 state = seed;
+    int unpauseAt = -1;
+
+    for (int i = 0; i < FUZZ_CASE_OPERATIONS; i++)
+    {
+        if (i == unpauseAt)
+        {
+            operations[i] = FUZZ_TOGGLE_PAUSE;
+            unpauseAt = -1;
+            continue;
+        }
+
+        int roll = SDL_rand_r(&state, totalWeight);
+        size_t choice = 0;
+        while (roll >= WEIGHTS[choice].weight) roll -= WEIGHTS[choice++].weight;
+
+        operations[i] = WEIGHTS[choice].operation;
+        if (operations[i] == FUZZ_TOGGLE_PAUSE)
+        {
+            if (unpauseAt >= 0) operations[i] = FUZZ_ITERATE;
+            else unpauseAt = i + 1 + SDL_rand_r(&state, 4);
+        }
+    }
+}
+
+/**
+ * @brief The entry point of a worker thread, which claims blocks of cases until every case has run or one fails.
+ *
+ * @param data A pointer to the FuzzWorker.
+ *
+ * @return Zero.
+ */
+static int SDLCALL FuzzWorkerThread(void* data)
+{
+    FuzzWorker* worker = data;
+    FuzzJob* job = worker->job;
+    char operations[FUZZ_CASE_OPERATIONS];
+
+    TRACE_NameThread("FuzzWorker");
+
+    while (!SDL_GetAtomicInt(&job->hasFailed))
+    {
+        const Uint64 firstCase = (Uint64)SDL_AddAtomicInt(&job->nextClaim, 1) * FUZZ_CASES_PER_CLAIM;
+        if (firstCase >= job->caseCount) break;
+
+        TRACE_BEGIN("FUZZ_RunCases");
+        const Uint64 lastCase = SDL_min(firstCase + FUZZ_CASES_PER_CLAIM, job->caseCount);
+        for (Uint64 n = firstCase; n < lastCase; n++)
+        {
+            const Uint64 seed = job->seed + n;
+            GenerateOperations(seed, operations);
+
+            int failedOperation = 0;
+            const char* invariant = RunCase(&worker->fuzzGame, seed, operations, FUZZ_CASE_OPERATIONS, &failedOperation);
+            worker->cases++;
+            worker->operations += (Uint64)(invariant ? failedOperation + 1 : FUZZ_CASE_OPERATIONS);
+
+            if (invariant)
+            {
+                worker->hasFailed = true;
+                worker->failedCase = n;
+                worker->failure.seed = seed;
+                worker->failure.invariant = invariant;
+                worker->failure.operationCount = failedOperation + 1;
+                SDL_memcpy(worker->failure.operations, operations, (size_t)worker->failure.operationCount);
+                worker->failure.operations[worker->failure.operationCount] = '\0';
+                SDL_SetAtomicInt(&job->hasFailed, 1);
+                break;
+            }
+        }
+        TRACE_END("FUZZ_RunCases");
+    }
+
+    SDL_AddAtomicInt(&job->finishedWorkers, 1);
+    return 0;
+}
+
+const char* FUZZ_RunOperations(const Uint64 seed, const char* operations, const int operationCount, int* failedOperation)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    FuzzGame fuzzGame = { 0 };
+    return RunCase(&fuzzGame, seed, operations, operationCount, failedOperation);
+}
+
+void FUZZ_Minimise(FuzzFailure* failure)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    FuzzGame fuzzGame = { 0 };
+    char candidate[FUZZ_CASE_OPERATIONS];
+    int failedOperation = 0;
+
+    // Only keep a removal if the same invariant still breaks, so that shrinking cannot wander off to a different bug.
+    // Each sweep tries halving chunk sizes down to single operations, until a whole sweep removes nothing.
+    bool hasShrunk = true;
+    while (hasShrunk)
+    {
+        hasShrunk = false;
+        for (int chunk = SDL_max(failure->operationCount / 2, 1); chunk >= 1; chunk /= 2)
+        {
+            for (int start = 0; start + chunk <= failure->operationCount;)
+            {
+                const int candidateCount = failure->operationCount - chunk;
+                SDL_memcpy(candidate, failure->operations, (size_t)start);
+                SDL_memcpy(candidate + start, failure->operations + start + chunk, (size_t)(candidateCount - start));
+
+                const char* invariant = RunCase(&fuzzGame, failure->seed, candidate, candidateCount, &failedOperation);
+                if (!invariant || SDL_strcmp(invariant, failure->invariant) != 0)
+                {
+                    start += chunk;
+                    continue;
+                }
+
+                failure->operationCount = failedOperation + 1;
+                SDL_memcpy(failure->operations, candidate, (size_t)failure->operationCount);
+                failure->operations[failure->operationCount] = '\0';
+                hasShrunk = true;
+            }
+        }
+    }
+}
+
+bool FUZZ_Run(const Uint64 caseCount, int threadCount, const Uint64 seed, FuzzResult* result)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (threadCount <= 0) threadCount = SDL_GetNumLogicalCPUCores();
+    if (threadCount > FUZZ_MAX_THREADS) threadCount = FUZZ_MAX_THREADS;
+    if (threadCount < 1) threadCount = 1;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Running %" SDL_PRIu64 " fuzz cases of %d operations on %d threads (seed=%" SDL_PRIu64 ")...", caseCount, FUZZ_CASE_OPERATIONS, threadCount, seed);
+
+    *result = (FuzzResult){ 0 };
+    FuzzJob job = { .caseCount = caseCount, .seed = seed };
+    FuzzWorker* workers = SDL_calloc((size_t)threadCount, sizeof(FuzzWorker));
+    if (!workers) return false;
+
+    const Uint64 startTicks = SDL_GetTicksNS();
+    bool success = true;
+    int startedWorkers = 0;
+    Uint64 failedCase = 0;
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers[i].job = &job;
+        workers[i].thread = SDL_CreateThread(FuzzWorkerThread, "FuzzWorker", &workers[i]);
+        if (!workers[i].thread)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create fuzz worker thread: %s", SDL_GetError());
+            success = false;
+            continue;
+        }
+        startedWorkers++;
+    }
+
+    // Runs can last hours, so report how far along they are rather than going quiet until the end
+    Uint64 lastProgressTicks = startTicks;
+    while (SDL_GetAtomicInt(&job.finishedWorkers) < startedWorkers)
+    {
+        SDL_Delay(100);
+        if (SDL_GetTicksNS() - lastProgressTicks < SDL_MS_TO_NS(FUZZ_PROGRESS_INTERVAL_MS)) continue;
+        lastProgressTicks = SDL_GetTicksNS();
+
+        const Uint64 claimed = SDL_min((Uint64)SDL_GetAtomicInt(&job.nextClaim) * FUZZ_CASES_PER_CLAIM, caseCount);
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Fuzzing: %" SDL_PRIu64 " of %" SDL_PRIu64 " cases started after %.0fs...", claimed, caseCount, (double)(lastProgressTicks - startTicks) / SDL_NS_PER_SECOND);
+    }
+
+    for (int i = 0; i < threadCount; i++)
+    {
+        if (workers[i].thread) SDL_WaitThread(workers[i].thread, NULL);
+
+        result->cases += workers[i].cases;
+        result->operations += workers[i].operations;
+
+        // Report the earliest failing case, so that the same run always reports the same failure
+        if (workers[i].hasFailed && (!result->hasFailed || workers[i].failedCase < failedCase))
+        {
+            result->hasFailed = true;
+            failedCase = workers[i].failedCase;
+            result->failure = workers[i].failure;
+        }
+    }
+
+    result->elapsedNS = SDL_GetTicksNS() - startTicks;
+    SDL_free(workers);
+
+    if (result->hasFailed)
+    {
+        const int originalCount = result->failure.operationCount;
+        FUZZ_Minimise(&result->failure);
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Fuzz case with seed %" SDL_PRIu64 " broke an invariant: %s (minimised from %d to %d operations).",
+            result->failure.seed, result->failure.invariant, originalCount, result->failure.operationCount);
+    }
+
+    return success && !result->hasFailed;
+}
@@ -2,14 +2,132 @@
 
 #include "util.h"
 #include "tetromino.h"
+#include "metrics.h"
+#include "zobrist.h"
+
+/**
+ * @brief Use outgoing garbage to cancel out queued incoming garbage, oldest attack first.
+ *
+ * @param garbageQueue The queue of incoming garbage.
+ * @param lines The number of outgoing garbage rows.
+ *
+ * @return The number of outgoing garbage rows left over after cancelling.
+ */
+static int CancelGarbage(GarbageQueue* garbageQueue, int lines);
+
+/**
+ * @brief Insert every queued garbage row at the bottom of the arena, shifting the whole stack upwards.
+ *
+ * @details If any block would be pushed above the top of the arena, the player has topped out and the game is over.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ */
+static void InsertGarbageRows(GameDataContext* gameDataContext);
+
+/**
+ * @brief Get the time (in nanoseconds) gravity takes to drop the tetromino one row at a level.
+ *
+ * @note This follows the guideline curve of (0.8 - (level - 1) * 0.007)^(level - 1) seconds per row, see
+ * https://tetris.wiki/Marathon
+ *
+ * @param level The level, from 1 to MAX_LEVEL.
+ *
+ * @return The time per row.
+ */
+static Uint64 GetGravityNS(const int level)
+{
+    const double secondsPerRow = SDL_pow(0.8 - (double)(level - 1) * 0.007, (double)(level - 1));
+    return (Uint64)(secondsPerRow * (double)SDL_NS_PER_SECOND);
+}
 
+/**
+ * @brief Drop the tetromino as many rows as gravity has built up, starting the lock down once it lands.
+ *
+ * @details Elapsed time is accumulated, and every full gravityNS of it drops the tetromino one row, so the fall speed
+ * is the same however the time is split into iterations. Gravity drops score nothing, unlike soft drops.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ * @param elapsedNS The game clock time (in nanoseconds) since the last iteration.
+ */
+static void ApplyGravity(GameDataContext* gameDataContext, const Uint64 elapsedNS)
+{
+    DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+
+    int rows;
+    if (gameDataContext->gravityNS <= GRAVITY_20G_NS)
+    {
+        rows = ARENA_HEIGHT;
+    }
+    else
+    {
+        gameDataContext->gravityAccumulatorNS += elapsedNS;
+        const Uint64 dueRows = gameDataContext->gravityAccumulatorNS / gameDataContext->gravityNS;
+        gameDataContext->gravityAccumulatorNS -= dueRows * gameDataContext->gravityNS;
+        rows = (int)SDL_min(dueRows, (Uint64)ARENA_HEIGHT);
+    }
+    if (rows == 0) return;
+
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Dropping tetromino up to %d rows at time=%dms", rows, (int)SDL_NS_TO_MS(gameDataContext->clockNS));
+    while (rows > 0 && !WillDroppingTetrominoCollide(gameDataContext, 0, 1, 0))
+    {
+        droppingTetromino->y++;
+        rows--;
+    }
+
+    // A landed tetromino does not bank gravity, so it falls a whole row's time after it is moved off a ledge
+    if (rows > 0)
+    {
+        gameDataContext->gravityAccumulatorNS = 0;
+        if (droppingTetromino->terminationTick == 0) droppingTetromino->terminationTick = gameDataContext->clockNS;
+    }
+}
+
+/**
+ * @brief Tell every listener of a game about an event, filling in the state of the game it happened in.
+ *
+ * @param gameDataContext A struct containing the game data.
+ * @param type The type of event.
+ * @param event A pointer to the event, with only its event-specific fields set, or NULL if it has none.
+ */
+static void EmitEvent(const GameDataContext* gameDataContext, const GameEventType type, GameEvent* event)
+{
+    if (gameDataContext->eventListenerCount == 0) return;
+
+    GameEvent emptyEvent = { 0 };
+    if (!event) event = &emptyEvent;
+
+    event->type = type;
+    event->clockNS = gameDataContext->clockNS;
+    event->seed = gameDataContext->seed;
+    event->level = gameDataContext->level;
+    event->score = gameDataContext->score;
+
+    for (int i = 0; i < gameDataContext->eventListenerCount; i++) gameDataContext->eventListeners[i](gameDataContext->eventListenerData[i], event);
+}
+
+/**
+ * @brief Tell every listener of a game about an event of its dropping tetromino.
+ *
+ * @param gameDataContext A struct containing the game data.
+ * @param type The type of event.
+ */
+static void EmitTetrominoEvent(const GameDataContext* gameDataContext, const GameEventType type)
+{
+    const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+    GameEvent event = {
+        .piece = droppingTetromino->shape->identifier,
+        .x = droppingTetromino->x,
+        .y = droppingTetromino->y,
+        .orientation = droppingTetromino->orientation,
+    };
+    EmitEvent(gameDataContext, type, &event);
+}
 
 bool GAME_Init(GameDataContext* gameDataContext)
 {
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
     SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Initialising Tetris game...");
-    gameDataContext->droppingTetromino = NULL;
     return GAME_Reset(gameDataContext);
 }
 
@@ -25,16 +143,35 @@ bool GAME_Reset(GameDataContext* gameDataContext)
 {
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
+    return GAME_ResetWithSeed(gameDataContext, SDL_GetPerformanceCounter());
+}
+
+bool GAME_ResetWithSeed(GameDataContext* gameDataContext, const Uint64 seed)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
     gameDataContext->isGameOver = false;
 
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Initialising arena to zero...");
     memset(gameDataContext->arena, 0,sizeof(gameDataContext->arena[0][0]) * ARENA_HEIGHT * ARENA_WIDTH);
+    gameDataContext->arenaHash = 0;
 
     gameDataContext->score = 0;
     gameDataContext->level = 1;
-
-    // Reset tetromino bag
-    InitTetrominoBag(&gameDataContext->tetrominoBag);
+    gameDataContext->levelLinesCleared = 0;
+    gameDataContext->linesCleared = 0;
+    gameDataContext->piecesLocked = 0;
+    gameDataContext->gravityNS = GetGravityNS(gameDataContext->level);
+    gameDataContext->gravityAccumulatorNS = 0;
+    gameDataContext->clockNS = 0;
+    gameDataContext->garbageSent = 0;
+    memset(&gameDataContext->incomingGarbage, 0, sizeof(gameDataContext->incomingGarbage));
+
+    // Reset tetromino bag, and seed the garbage generator differently so the holes do not follow the bag order
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Seeding game with seed=%" SDL_PRIu64 "...", seed);
+    gameDataContext->seed = seed;
+    gameDataContext->garbageRandomState = seed ^ 0x9E3779B97F4A7C15ULL;
+    SeedTetrominoBag(&gameDataContext->tetrominoBag, seed);
 
     if (gameDataContext->droppingTetromino == NULL) {
         SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Dropping tetromino does not exist, so allocating memory for it...");
@@ -48,15 +185,40 @@ bool GAME_Reset(GameDataContext* gameDataContext)
     gameDataContext->droppingTetromino->orientation = NORTH;
     gameDataContext->droppingTetromino->terminationTick = 0;
 
+    EmitEvent(gameDataContext, GAME_EVENT_START, NULL);
+    EmitTetrominoEvent(gameDataContext, GAME_EVENT_SPAWN);
     return true;
 }
 
+bool GAME_AddEventListener(GameDataContext* gameDataContext, const GameEventListener listener, void* userData)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (gameDataContext->eventListenerCount >= GAME_MAX_EVENT_LISTENERS)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Game already has %d event listeners!", GAME_MAX_EVENT_LISTENERS);
+        return false;
+    }
+
+    gameDataContext->eventListeners[gameDataContext->eventListenerCount] = listener;
+    gameDataContext->eventListenerData[gameDataContext->eventListenerCount] = userData;
+    gameDataContext->eventListenerCount++;
+    return true;
+}
+
+const char* GAME_GetEventName(const GameEventType type)
+{
+    static const char* EVENT_NAMES[GAME_EVENT_COUNT] = { "start", "spawn", "lock", "line_clear", "level_up", "pause", "resume", "game_over", "hard_drop", "move", "rotate" };
+    return (type >= 0 && type < GAME_EVENT_COUNT) ? EVENT_NAMES[type] : "unknown";
+}
+
 void GAME_TogglePause(void* data)
 {
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
     GameDataContext* gameDataContext = (GameDataContext*)data;
     gameDataContext->isPaused = !gameDataContext->isPaused;
+    EmitEvent(gameDataContext, gameDataContext->isPaused ? GAME_EVENT_PAUSE : GAME_EVENT_RESUME, NULL);
 }
 
 void GAME_Quit(void* data)
@@ -67,18 +229,14 @@ void GAME_Quit(void* data)
     gameDataContext->isRunning = false;
 }
 
-void GAME_Iteration(GameDataContext* gameDataContext)
+void GAME_Iteration(GameDataContext* gameDataContext, const Uint64 elapsedNS)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
     if (gameDataContext->isPaused || gameDataContext->isGameOver) return;
 
-    // The time (in milliseconds) to drop a tetromino one cell (i.e. speed) for each of the tetris levels
-    static Uint64 gravityValues[MAX_LEVEL] = { 1000, 793, 618, 473, 355, 262, 190, 135, 94, 64, 43, 28, 18, 11, 7, 5, 4, 3, 2, 1 };
-
-    // Number of lines cleared on a particular level
-    static int levelLinesCleared = 0;
-    levelLinesCleared += ClearLines(gameDataContext);
+    gameDataContext->clockNS += elapsedNS;
+    const Uint64 now = gameDataContext->clockNS;
 
     // Check dropping tetromino is marked for termination (See https://tetris.wiki/Tetris_Guideline#LockDown)
     if (gameDataContext->droppingTetromino->terminationTick)
@@ -94,41 +252,38 @@ void GAME_Iteration(GameDataContext* gameDataContext)
             SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Cancel tetromino lockdown...");
             gameDataContext->droppingTetromino->terminationTick = 0;
         }
-        else if (SDL_GetTicks() > (gameDataContext->droppingTetromino->terminationTick + lockDownTime))
+        else if (now > (gameDataContext->droppingTetromino->terminationTick + SDL_MS_TO_NS(lockDownTime)))
         {
-            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Lockdown ended after %d ticks!", (int)(SDL_GetTicks() - gameDataContext->droppingTetromino->terminationTick));
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Lockdown ended after %dms!", (int)SDL_NS_TO_MS(now - gameDataContext->droppingTetromino->terminationTick));
             ResetDroppingTetromino(gameDataContext);
         }
     }
 
-    // Based on gravity, every n-ticks, drop tetromino and run tetromino operations
-    static Uint64 oldTick = 0;
-    if (SDL_GetTicks() - oldTick >= gravityValues[gameDataContext->level - 1])
-    {SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Cancel tetromino lockdown...");
-        if (levelLinesCleared >= 10)
+    if (gameDataContext->levelLinesCleared >= 10)
+    {
+        gameDataContext->levelLinesCleared = 0;
+        if (gameDataContext->level < MAX_LEVEL)
         {
-            levelLinesCleared = 0;
-            if (gameDataContext->level - 1 < MAX_LEVEL)
-            {
-                SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Increasing level (%d->%d)...", gameDataContext->level, gameDataContext->level + 1);
-                gameDataContext->level++;
-            }
-            else
-            {
-                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Max level reached!");
-            }
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Increasing level (%d->%d)...", gameDataContext->level, gameDataContext->level + 1);
+            gameDataContext->level++;
+            gameDataContext->gravityNS = GetGravityNS(gameDataContext->level);
+            EmitEvent(gameDataContext, GAME_EVENT_LEVEL_UP, NULL);
+        }
+        else
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Max level reached!");
         }
-        SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Dropping tetromino at tick=%d", (int)SDL_GetTicks());
-        SoftDropTetromino(gameDataContext);
-
-        oldTick = SDL_GetTicks();
     }
+
+    ApplyGravity(gameDataContext, elapsedNS);
 }
 
 bool WillDroppingTetrominoCollide(const GameDataContext* gameDataContext, int translationX, int translationY, const int rotationAmount)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
+    METRICS_Add(METRIC_COLLISION_CHECKS, 1);
+
     // DEV NOTE: & 3 Does the same as wrapping 0-3, but makes for cleaner code as rotationAmount can be negative
     // and in C, you can't easily use modulus to wrap negatives. This trick only works when % is a power of two.
     const bool (*droppingTetrominoRotatedCoordinates)[TETROMINO_MAX_SIZE] = gameDataContext->droppingTetromino->shape->coordinates[((gameDataContext->droppingTetromino->orientation + rotationAmount) & 3)];
@@ -172,14 +327,41 @@ void ResetDroppingTetromino(GameDataContext* gameDataContext)
     const int droppingTetrominoY = gameDataContext->droppingTetromino->y;
     const bool (*droppingTetrominoRotatedCoordinates)[TETROMINO_MAX_SIZE] = gameDataContext->droppingTetromino->shape->coordinates[gameDataContext->droppingTetromino->orientation];
 
-    // Update the arena with the location of the tetromino where it has collided
+    // Update the arena with the location of the tetromino where it has collided, re-keying only the rows it lands in
     for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
     {
+        const int row = droppingTetrominoY + i;
+        if (row < 0 || row >= ARENA_HEIGHT) continue;
+
+        const Uint64 previousRowKey = ZOBRIST_ArenaRowKey(gameDataContext->arena, row);
         for (int j = 0; j < TETROMINO_MAX_SIZE; j++)
         {
             if (!droppingTetrominoRotatedCoordinates[i][j]) continue;
-            SDL_LogTrace(SDL_LOG_CATEGORY_APPLICATION, "Setting arena[%d][%d] to Tetromino with ID %d", droppingTetrominoY + i, droppingTetrominoX + j, gameDataContext->droppingTetromino->shape->identifier);
-            gameDataContext->arena[droppingTetrominoY + i][droppingTetrominoX + j] = gameDataContext->droppingTetromino->shape->identifier;
+            SDL_LogTrace(SDL_LOG_CATEGORY_APPLICATION, "Setting arena[%d][%d] to Tetromino with ID %d", row, droppingTetrominoX + j, gameDataContext->droppingTetromino->shape->identifier);
+            gameDataContext->arena[row][droppingTetrominoX + j] = gameDataContext->droppingTetromino->shape->identifier;
+        }
+        gameDataContext->arenaHash ^= previousRowKey ^ ZOBRIST_ArenaRowKey(gameDataContext->arena, row);
+    }
+    EmitTetrominoEvent(gameDataContext, GAME_EVENT_LOCK);
+
+    const int numClearedRows = ClearLines(gameDataContext);
+    SDL_assert(gameDataContext->arenaHash == ZOBRIST_HashArena(gameDataContext->arena));
+
+    gameDataContext->levelLinesCleared += numClearedRows;
+    gameDataContext->linesCleared += numClearedRows;
+    gameDataContext->piecesLocked++;
+
+    METRICS_Add(METRIC_PIECES_LOCKED, 1);
+    if (numClearedRows > 0) METRICS_Add(METRIC_SINGLES + SDL_min(numClearedRows, 4) - 1, 1);
+
+    // Garbage only rises when a tetromino locks without clearing any lines (See https://tetris.wiki/Garbage)
+    if (numClearedRows == 0 && gameDataContext->incomingGarbage.lines > 0)
+    {
+        InsertGarbageRows(gameDataContext);
+        if (gameDataContext->isGameOver)
+        {
+            EmitEvent(gameDataContext, GAME_EVENT_GAME_OVER, NULL);
+            return;
         }
     }
 
@@ -193,122 +375,169 @@ void ResetDroppingTetromino(GameDataContext* gameDataContext)
     {
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Dropping tetromino has collided instantly upon spawning, indicating a game loss state!");
         gameDataContext->isGameOver = true;
+        EmitEvent(gameDataContext, GAME_EVENT_GAME_OVER, NULL);
+        return;
     }
+
+    EmitTetrominoEvent(gameDataContext, GAME_EVENT_SPAWN);
 }
 
-static void DropRows(TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH], const int dropToRow, const int dropAmount)
+void GAME_QueueGarbage(GameDataContext* gameDataContext, const int lines)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
-    // Start scanning for filled rows upwards from dropToRow
-    for (int row = dropToRow; row >= 0; row--)
+    if (lines <= 0) return;
+
+    GarbageQueue* garbageQueue = &gameDataContext->incomingGarbage;
+    const int holeColumn = SDL_rand_r(&gameDataContext->garbageRandomState, ARENA_WIDTH);
+
+    if (garbageQueue->count >= GARBAGE_QUEUE_SIZE)
     {
-        // Any rows at the top of the arena must be set to zero rather than filled with blocks above
-        // them (as there are none).
-        if (row - dropAmount < 0)
-        {
-            SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Setting row %d to zero!", row);
-            memset(arena[row], 0, ARENA_WIDTH * sizeof(arena[0][0]));
-            continue;
-        }
+        // The queue is full, so fold the attack into the newest one rather than losing it
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Garbage queue is full, merging %d lines into the newest attack...", lines);
+        garbageQueue->attacks[(garbageQueue->head + garbageQueue->count - 1) % GARBAGE_QUEUE_SIZE].lines += lines;
+    }
+    else
+    {
+        garbageQueue->attacks[(garbageQueue->head + garbageQueue->count) % GARBAGE_QUEUE_SIZE] = (GarbageAttack){ lines, holeColumn };
+        garbageQueue->count++;
+    }
 
-        int squareCount = 0;
-        for (int col = 0; col < ARENA_WIDTH; col++)
-        {
-            if (arena[row][col] != 0) squareCount++;
-            arena[row][col] = arena[row - dropAmount][col];
-        }
+    garbageQueue->lines += lines;
+}
 
-        // If we reach an empty row, then nothing above it to drop down
-        if (squareCount == 0)
+static int CancelGarbage(GarbageQueue* garbageQueue, int lines)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    while (lines > 0 && garbageQueue->count > 0)
+    {
+        GarbageAttack* attack = &garbageQueue->attacks[garbageQueue->head];
+        const int cancelled = (attack->lines < lines) ? attack->lines : lines;
+
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Cancelling %d incoming garbage lines...", cancelled);
+        attack->lines -= cancelled;
+        garbageQueue->lines -= cancelled;
+        lines -= cancelled;
+
+        if (attack->lines == 0)
         {
-            SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Reached empty row (%d), exiting...", row);
-            break;
+            garbageQueue->head = (garbageQueue->head + 1) % GARBAGE_QUEUE_SIZE;
+            garbageQueue->count--;
         }
     }
+
+    return lines;
 }
 
-int ClearLines(GameDataContext* gameDataContext)
+static void InsertGarbageRows(GameDataContext* gameDataContext)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
-    // Number of sequential rows that have been filled
-    int numFilledRows = 0;
-
-    // Sliding window technique
-    int bottomPointer = ARENA_HEIGHT - 1; // Points to the bottom
-    int topPointer = ARENA_HEIGHT - 2; // Points to the penultimate bottom row
+    GarbageQueue* garbageQueue = &gameDataContext->incomingGarbage;
 
-    while (topPointer >= 0 && topPointer < bottomPointer)
+    while (garbageQueue->count > 0)
     {
-        int topPointerSquareCount = 0;
-        int bottomPointerSquareCount = 0;
+        const GarbageAttack attack = garbageQueue->attacks[garbageQueue->head];
+        garbageQueue->head = (garbageQueue->head + 1) % GARBAGE_QUEUE_SIZE;
+        garbageQueue->count--;
+        garbageQueue->lines -= attack.lines;
 
-        for (int col = 0; col < ARENA_WIDTH; col++)
+        const int lines = (attack.lines < ARENA_HEIGHT) ? attack.lines : ARENA_HEIGHT;
+
+        // Any block in the rows that are about to be pushed off the top of the arena means the player has topped out
+        for (int row = 0; row < lines; row++)
         {
-            if (gameDataContext->arena[topPointer][col] != 0) topPointerSquareCount++;
-            if (gameDataContext->arena[bottomPointer][col] != 0) bottomPointerSquareCount++;
+            for (int col = 0; col < ARENA_WIDTH; col++)
+            {
+                if (gameDataContext->arena[row][col] == 0) continue;
+
+                SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Garbage pushed the stack above the arena, indicating a game loss state!");
+                memset(garbageQueue, 0, sizeof(*garbageQueue));
+                gameDataContext->arenaHash = ZOBRIST_HashArena(gameDataContext->arena);
+                gameDataContext->isGameOver = true;
+                return;
+            }
         }
 
-        const bool topRowFilled = (topPointerSquareCount >= ARENA_WIDTH);
-        const bool bottomRowFilled = (bottomPointerSquareCount >= ARENA_WIDTH);
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Inserting %d garbage lines with a hole at column %d...", lines, attack.holeColumn);
 
-        if (!topRowFilled && !bottomRowFilled)
+        // Shift the whole stack upwards in one move, then fill the freed rows at the bottom
+        memmove(gameDataContext->arena[0], gameDataContext->arena[lines], (ARENA_HEIGHT - lines) * sizeof(gameDataContext->arena[0]));
+        for (int row = ARENA_HEIGHT - lines; row < ARENA_HEIGHT; row++)
         {
-            // Neither row is full so we move both upwards
-            topPointer--;
-            bottomPointer--;
-            continue;
+            for (int col = 0; col < ARENA_WIDTH; col++)
+            {
+                gameDataContext->arena[row][col] = (col == attack.holeColumn) ? 0 : GARBAGE;
+            }
         }
+    }
 
-        if (topRowFilled)
-        {
-            // Top row is full so we move the top upwards
-            topPointer--;
-        }
-        else
+    // Every row moved, so the arena is re-hashed in full
+    gameDataContext->arenaHash = ZOBRIST_HashArena(gameDataContext->arena);
+}
+
+int ClearLines(GameDataContext* gameDataContext)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    // Compact the stack in a single pass from the bottom up, copying each row that is not full down over the full ones
+    int numFilledRows = 0;
+    int lowestFilledRow = -1;
+    Uint32 filledRowMask = 0;
+    for (int row = ARENA_HEIGHT - 1; row >= 0; row--)
+    {
+        int squareCount = 0;
+        for (int col = 0; col < ARENA_WIDTH; col++)
         {
-            // Top row is not full but bottom row is full so we found our range
-            numFilledRows = bottomPointer - topPointer;
-            break;
+            if (gameDataContext->arena[row][col] != 0) squareCount++;
         }
 
-        if (!bottomRowFilled)
+        if (squareCount >= ARENA_WIDTH)
         {
-            // Bottom row is not full so we move bottom upwards
-            bottomPointer--;
+            if (lowestFilledRow < 0) lowestFilledRow = row;
+            filledRowMask |= 1u << row;
+            numFilledRows++;
+            continue;
         }
+
+        if (numFilledRows > 0) SDL_memcpy(gameDataContext->arena[row + numFilledRows], gameDataContext->arena[row], sizeof(gameDataContext->arena[0]));
     }
 
-    if (bottomPointer == 0) return 0;
+    if (numFilledRows == 0) return 0;
 
-    // Clear the cleared rows and drop the rows above
-    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Dropping Rows - Drop to: %d, Drop by: %d", bottomPointer, numFilledRows);
-    DropRows(gameDataContext->arena, bottomPointer, numFilledRows);
+    // Any rows at the top of the arena must be set to zero rather than filled with blocks above them (as there are none)
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Cleared %d rows, the lowest being %d", numFilledRows, lowestFilledRow);
+    SDL_memset(gameDataContext->arena[0], 0, (size_t)numFilledRows * sizeof(gameDataContext->arena[0]));
 
-    // Scoring for different levels
-    switch (numFilledRows)
+    // Every row from the lowest cleared one upwards may have moved, so the arena is re-hashed in full
+    gameDataContext->arenaHash = ZOBRIST_HashArena(gameDataContext->arena);
+
+    // The base score (multiplied by the level) and the garbage sent to the opponent, indexed by the number of rows
+    // cleared at once, whether or not they were adjacent (See https://tetris.wiki/Scoring and https://tetris.wiki/Garbage)
+    static const int LINE_CLEAR_SCORE[] = { 0, 100, 300, 500, 800 };
+    static const int LINE_CLEAR_GARBAGE[] = { 0, 0, 1, 2, 4 };
+
+    if (numFilledRows >= (int)SDL_arraysize(LINE_CLEAR_SCORE))
     {
-    case 1:
-        gameDataContext->score += 100 * (gameDataContext->level);
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Adding %d to score...", 100 * gameDataContext->level);
-        break;
-    case 2:
-        gameDataContext->score += 300 * (gameDataContext->level);
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Adding %d to score...", 300 * gameDataContext->level);
-        break;
-    case 3:
-        gameDataContext->score += 500 * (gameDataContext->level);
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Adding %d to score...", 500 * gameDataContext->level);
-        break;
-    case 4:
-        gameDataContext->score += 800 * (gameDataContext->level);
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Adding %d to score...", 800 * gameDataContext->level);
-        break;
-    default:
-        break;
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cleared an impossible number of rows (%d)!", numFilledRows);
+        return numFilledRows;
+    }
+
+    gameDataContext->score += LINE_CLEAR_SCORE[numFilledRows] * gameDataContext->level;
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Adding %d to score...", LINE_CLEAR_SCORE[numFilledRows] * gameDataContext->level);
+
+    // Outgoing garbage cancels our own incoming garbage first, and only the remainder reaches the opponent
+    const int garbage = CancelGarbage(&gameDataContext->incomingGarbage, LINE_CLEAR_GARBAGE[numFilledRows]);
+    if (garbage > 0 && gameDataContext->opponent)
+    {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Sending %d garbage lines to opponent...", garbage);
+        GAME_QueueGarbage(gameDataContext->opponent, garbage);
+        gameDataContext->garbageSent += garbage;
     }
 
+    GameEvent event = { .lines = numFilledRows, .row = lowestFilledRow, .rowMask = filledRowMask };
+    EmitEvent(gameDataContext, GAME_EVENT_LINE_CLEAR, &event);
     return numFilledRows;
 }
 
@@ -346,6 +575,8 @@ bool WallKickDroppingTetromino(GameDataContext* gameDataContext, const int rotat
     // Valid parameter checks
     if (!(rotationDirection == -1 || rotationDirection == 1)) return false;
 
+    METRICS_Add(METRIC_ROTATIONS, 1);
+
     // One of eight possible orientation state changes
     // (In numerical order: NORTH->EAST, EAST->NORTH, EAST->SOUTH, SOUTH->EAST, SOUTH->WEST, WEST->SOUTH, WEST->NORTH, NORTH->WEST)
     int rotationStateChange = 0;
@@ -380,11 +611,13 @@ bool WallKickDroppingTetromino(GameDataContext* gameDataContext, const int rotat
         const int8_t dx = wallKickData[rotationStateChange][i][0];
         const int8_t dy = wallKickData[rotationStateChange][i][1];
 
+        METRICS_Add(METRIC_WALL_KICK_ATTEMPTS, 1);
         if (!WillDroppingTetrominoCollide(gameDataContext, dx, dy, rotationDirection))
         {
             gameDataContext->droppingTetromino->x += dx;
             gameDataContext->droppingTetromino->y += dy;
             RotateDroppingTetromino(gameDataContext->droppingTetromino, rotationDirection);
+            EmitTetrominoEvent(gameDataContext, GAME_EVENT_ROTATE);
             return true;
         }
     }
@@ -398,12 +631,26 @@ void HardDropTetromino(GameDataContext* gameDataContext)
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
     if (gameDataContext->isPaused || gameDataContext->isGameOver) return;
+    const int startY = gameDataContext->droppingTetromino->y;
     while (!WillDroppingTetrominoCollide(gameDataContext, 0, 1, 0))
     {
         gameDataContext->score += 2;
         gameDataContext->droppingTetromino->y++;
     }
 
+    if (gameDataContext->eventListenerCount > 0)
+    {
+        const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+        GameEvent event = {
+            .piece = droppingTetromino->shape->identifier,
+            .x = droppingTetromino->x,
+            .y = droppingTetromino->y,
+            .orientation = droppingTetromino->orientation,
+            .lines = droppingTetromino->y - startY,
+        };
+        EmitEvent(gameDataContext, GAME_EVENT_HARD_DROP, &event);
+    }
+
     ResetDroppingTetromino(gameDataContext);
 }
 
@@ -414,7 +661,7 @@ void SoftDropTetromino(GameDataContext* gameDataContext)
     if (gameDataContext->isPaused || gameDataContext->isGameOver) return;
     if (WillDroppingTetrominoCollide(gameDataContext, 0, 1, 0))
     {
-        if (gameDataContext->droppingTetromino->terminationTick == 0) gameDataContext->droppingTetromino->terminationTick = SDL_GetTicks();
+        if (gameDataContext->droppingTetromino->terminationTick == 0) gameDataContext->droppingTetromino->terminationTick = gameDataContext->clockNS;
     }
     else
     {
@@ -428,5 +675,8 @@ void ShiftTetromino(GameDataContext* gameDataContext, const int translation)
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
     if (gameDataContext->isPaused || gameDataContext->isGameOver) return;
-    if (!WillDroppingTetrominoCollide(gameDataContext, translation, 0, 0)) gameDataContext->droppingTetromino->x += translation;
+    if (WillDroppingTetrominoCollide(gameDataContext, translation, 0, 0)) return;
+
+    gameDataContext->droppingTetromino->x += translation;
+    EmitTetrominoEvent(gameDataContext, GAME_EVENT_MOVE);
 }
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "gif.h"
+
+/**
+ * @brief Write a little endian 16-bit value.
+ *
+ * @param encoder A pointer to the encoder.
+ * @param value The value to write.
+ */
+static void WriteU16(GifEncoder* encoder, const Uint16 value)
+{
+    if (!SDL_WriteU16LE(encoder->stream, value)) encoder->hasFailed = true;
+}
+
+/**
+ * @brief Write raw bytes.
+ *
+ * @param encoder A pointer to the encoder.
+ * @param bytes The bytes to write.
+ * @param length The number of bytes.
+ */
+static void WriteBytes(GifEncoder* encoder, const void* bytes, const size_t length)
+{
+    if (SDL_WriteIO(encoder->stream, bytes, length) != length) encoder->hasFailed = true;
+}
+
+/**
+ * @brief Write the data sub-block being filled, if it is not empty.
+ *
+ * @param encoder A pointer to the encoder.
+ */
+static void FlushSubBlock(GifEncoder* encoder)
+{
+    if (encoder->subBlockLength == 0) return;
+
+    const Uint8 length = (Uint8)encoder->subBlockLength;
+    WriteBytes(encoder, &length, 1);
+    WriteBytes(encoder, encoder->subBlock, (size_t)encoder->subBlockLength);
+    encoder->subBlockLength = 0;
+}
+
+/**
+ * @brief Pack an LZW code into the image data.
+ *
+ * @param encoder A pointer to the encoder.
+ * @param code The code to write.
+ * @param codeSize The number of bits in the code.
+ */
+static void WriteCode(GifEncoder* encoder, const int code, const int codeSize)
+{
+    encoder->bitBuffer |= (Uint32)code << encoder->bitCount;
+    encoder->bitCount += codeSize;
+
+    while (encoder->bitCount >= 8)
+    {
+        encoder->subBlock[encoder->subBlockLength++] = (Uint8)(encoder->bitBuffer & 0xFF);
+        encoder->bitBuffer >>= 8;
+        encoder->bitCount -= 8;
+        if (encoder->subBlockLength == GIF_SUB_BLOCK_SIZE) FlushSubBlock(encoder);
+    }
+}
+
+/**
+ * @brief Empty the LZW dictionary.
+ *
+ * @param encoder A pointer to the encoder.
+ */
+static void ClearDictionary(GifEncoder* encoder)
+{
+    for (int i = 0; i < GIF_HASH_SIZE; i++) encoder->hashKeys[i] = -1;
+}
+
+bool GIF_Begin(GifEncoder* encoder, const char* path, const int width, const int height, const Uint16 delay)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    encoder->width = width;
+    encoder->height = height;
+    encoder->delay = delay;
+    encoder->frameCount = 0;
+    encoder->bitBuffer = 0;
+    encoder->bitCount = 0;
+    encoder->subBlockLength = 0;
+    encoder->hasFailed = false;
+
+    encoder->stream = SDL_IOFromFile(path, "wb");
+    if (!encoder->stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open GIF file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    // Header and logical screen descriptor, with a global colour table of 2^(7 + 1) entries
+    WriteBytes(encoder, "GIF89a", 6);
+    WriteU16(encoder, (Uint16)width);
+    WriteU16(encoder, (Uint16)height);
+    const Uint8 screenDescriptor[3] = { 0xF7, 0, 0 };
+    WriteBytes(encoder, screenDescriptor, sizeof(screenDescriptor));
+
+    // The fixed palette, a uniform grid of colours with the unused entries left black
+    Uint8 colorTable[GIF_COLOR_TABLE_SIZE * 3] = { 0 };
+    int index = 0;
+    for (int r = 0; r < GIF_PALETTE_RED_LEVELS; r++)
+    {
+        for (int g = 0; g < GIF_PALETTE_GREEN_LEVELS; g++)
+        {
+            for (int b = 0; b < GIF_PALETTE_BLUE_LEVELS; b++)
+            {
+                colorTable[index * 3 + 0] = (Uint8)(r * 255 / (GIF_PALETTE_RED_LEVELS - 1));
+                colorTable[index * 3 + 1] = (Uint8)(g * 255 / (GIF_PALETTE_GREEN_LEVELS - 1));
+                colorTable[index * 3 + 2] = (Uint8)(b * 255 / (GIF_PALETTE_BLUE_LEVELS - 1));
+                index++;
+            }
+        }
+    }
+    WriteBytes(encoder, colorTable, sizeof(colorTable));
+
+    // Loop forever
+    const Uint8 loopExtension[19] = { 0x21, 0xFF, 11, 'N', 'E', 'T', 'S', 'C', 'A', 'P', 'E', '2', '.', '0', 3, 1, 0, 0, 0 };
+    WriteBytes(encoder, loopExtension, sizeof(loopExtension));
+
+    return !encoder->hasFailed;
+}
+
+void GIF_QuantizeFrame(const SDL_Surface* frame, Uint8* indices)
+{
+    for (int y = 0; y < frame->h; y++)
+    {
+        const Uint8* row = (const Uint8*)frame->pixels + (size_t)y * (size_t)frame->pitch;
+        Uint8* rowIndices = indices + (size_t)y * (size_t)frame->w;
+
+        for (int x = 0; x < frame->w; x++)
+        {
+            // Round each channel to its nearest level
+            const int r = (row[x * 4 + 0] * (GIF_PALETTE_RED_LEVELS - 1) + 127) / 255;
+            const int g = (row[x * 4 + 1] * (GIF_PALETTE_GREEN_LEVELS - 1) + 127) / 255;
+            const int b = (row[x * 4 + 2] * (GIF_PALETTE_BLUE_LEVELS - 1) + 127) / 255;
+            rowIndices[x] = (Uint8)((r * GIF_PALETTE_GREEN_LEVELS + g) * GIF_PALETTE_BLUE_LEVELS + b);
+        }
+    }
+}
+
+bool GIF_WriteFrame(GifEncoder* encoder, const Uint8* indices)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    // Graphic control extension, holding the frame delay
+    const Uint8 controlExtension[4] = { 0x21, 0xF9, 4, 0x04 };
+    WriteBytes(encoder, controlExtension, sizeof(controlExtension));
+    WriteU16(encoder, encoder->delay);
+    const Uint8 controlExtensionEnd[2] = { 0, 0 };
+    WriteBytes(encoder, controlExtensionEnd, sizeof(controlExtensionEnd));
+
+    // Image descriptor, covering the whole screen and using the global colour table
+    const Uint8 imageSeparator = 0x2C;
+    WriteBytes(encoder, &imageSeparator, 1);
+    WriteU16(encoder, 0);
+    WriteU16(encoder, 0);
+    WriteU16(encoder, (Uint16)encoder->width);
+    WriteU16(encoder, (Uint16)encoder->height);
+    const Uint8 imageHeader[2] = { 0, GIF_MIN_CODE_SIZE };
+    WriteBytes(encoder, imageHeader, sizeof(imageHeader));
+
+    // LZW compress the indices, looking up each (prefix, next index) string in a hash table
+    const int clearCode = 1 << GIF_MIN_CODE_SIZE;
+    const int endCode = clearCode + 1;
+    int codeSize = GIF_MIN_CODE_SIZE + 1;
+    int maxCode = endCode;
+
+    ClearDictionary(encoder);
+    WriteCode(encoder, clearCode, codeSize);
+
+    const size_t pixelCount = (size_t)encoder->width * (size_t)encoder->height;
+    int prefix = indices[0];
+
+    for (size_t i = 1; i < pixelCount; i++)
+    {
+        const int next = indices[i];
+        const Sint32 key = (prefix << 8) | next;
+
+        int slot = (int)(((Uint32)next << 4 ^ (Uint32)prefix) % GIF_HASH_SIZE);
+        while (encoder->hashKeys[slot] != -1 && encoder->hashKeys[slot] != key) slot = (slot + 1) % GIF_HASH_SIZE;
+
+        if (encoder->hashKeys[slot] == key)
+        {
+            prefix = encoder->hashCodes[slot];
+            continue;
+        }
+
+        WriteCode(encoder, prefix, codeSize);
+
+        encoder->hashKeys[slot] = key;
+        encoder->hashCodes[slot] = (Uint16)++maxCode;
+        if (maxCode >= (1 << codeSize)) codeSize++;
+
+        // Once the dictionary is full, start again rather than growing the codes past 12 bits
+        if (maxCode == GIF_MAX_CODE)
+        {
+            WriteCode(encoder, clearCode, codeSize);
+            ClearDictionary(encoder);
+            codeSize = GIF_MIN_CODE_SIZE + 1;
+            maxCode = endCode;
+        }
+
+        prefix = next;
+    }
+
+    WriteCode(encoder, prefix, codeSize);
+    WriteCode(encoder, clearCode, codeSize);
+    WriteCode(encoder, endCode, GIF_MIN_CODE_SIZE + 1);
+    if (encoder->bitCount > 0) WriteCode(encoder, 0, 8 - encoder->bitCount);
+    FlushSubBlock(encoder);
+
+    const Uint8 blockTerminator = 0;
+    WriteBytes(encoder, &blockTerminator, 1);
+
+    encoder->frameCount++;
+    return !encoder->hasFailed;
+}
+
+bool GIF_End(GifEncoder* encoder)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!encoder->stream) return false;
+
+    const Uint8 trailer = 0x3B;
+    WriteBytes(encoder, &trailer, 1);
+    if (!SDL_CloseIO(encoder->stream)) encoder->hasFailed = true;
+    encoder->stream = NULL;
+
+    return !encoder->hasFailed;
+}
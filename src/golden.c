@@ -0,0 +1,271 @@
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <SDL3_ttf/SDL_ttf.h>
+
+#include "golden.h"
+
+#include "bot.h"
+#include "game.h"
+#include "graphics.h"
+#include "trace.h"
+
+/**
+ * @brief A game state to render, built by playing a script from a seeded reset.
+ */
+typedef struct GoldenScene
+{
+    /** @brief The name of the scene, which is also the name of its golden image. */
+    const char* name;
+
+    /** @brief The seed the game is reset with before playing the script. */
+    Uint64 seed;
+
+    /**
+     * @brief The moves to play. Each is a character, optionally preceded by a repeat count: 'L' and 'R' shift,
+     * 'W' rotates, 'S' soft drops, 'H' hard drops, 'B' plays the bot's placement, 'G' queues a garbage line and 'P'
+     * toggles pause. Spaces are ignored.
+     */
+    const char* script;
+} GoldenScene;
+
+/** @brief The scenes rendered by the golden image test, covering the arena, sidebar and game over screen. */
+static const GoldenScene GOLDEN_SCENES[] = {
+    { "empty", 1, "" },
+    { "opening", 2, "3LH 2RH WH W4RH WW2LH S" },
+    { "bot-midgame", 3, "30B" },
+    { "garbage", 4, "6G 3B" },
+    { "paused", 5, "12B P" },
+    { "game-over", 6, "40H" },
+};
+
+/**
+ * @brief Reset a game and play a scene's script on it.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ * @param scene The scene to play.
+ */
+static void PlayScene(GameDataContext* gameDataContext, const GoldenScene* scene)
+{
+    // Resetting does not unpause, so a scene never inherits the previous scene's pause
+    GAME_ResetWithSeed(gameDataContext, scene->seed);
+    gameDataContext->isRunning = true;
+    gameDataContext->isPaused = false;
+
+    int count = 0;
+    for (const char* move = scene->script; *move; move++)
+    {
+        if (*move >= '0' && *move <= '9')
+        {
+            count = count * 10 + (*move - '0');
+            continue;
+        }
+
+        const int repeats = (count > 0) ? count : 1;
+        count = 0;
+
+        for (int i = 0; i < repeats; i++)
+        {
+            BotPlacement placement;
+
+            switch (*move)
+            {
+            case 'L': ShiftTetromino(gameDataContext, -1); break;
+            case 'R': ShiftTetromino(gameDataContext, 1); break;
+            case 'W': WallKickDroppingTetromino(gameDataContext, 1); break;
+            case 'S': SoftDropTetromino(gameDataContext); break;
+            case 'H': HardDropTetromino(gameDataContext); break;
+            case 'B':
+                if (!gameDataContext->isGameOver && BOT_FindPlacement(gameDataContext, &placement)) BOT_PlayPlacement(gameDataContext, &placement);
+                break;
+            case 'G': GAME_QueueGarbage(gameDataContext, 1); break;
+            case 'P': GAME_TogglePause(gameDataContext); break;
+            default: break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Read back the rendered frame in a fixed pixel format.
+ *
+ * @param graphicsDataContext A struct containing the graphics data context.
+ *
+ * @return The frame, which the caller must destroy, or NULL on failure.
+ */
+static SDL_Surface* ReadFrame(const GraphicsDataContext* graphicsDataContext)
+{
+    SDL_Surface* pixels = SDL_RenderReadPixels(graphicsDataContext->renderer, NULL);
+    if (!pixels) return NULL;
+
+    SDL_Surface* frame = SDL_ConvertSurface(pixels, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(pixels);
+    return frame;
+}
+
+/**
+ * @brief Compare a rendered frame against its golden image.
+ *
+ * @param actual The rendered frame, in SDL_PIXELFORMAT_RGBA32.
+ * @param expected The golden image, in SDL_PIXELFORMAT_RGBA32.
+ * @param differentPixels A pointer to write the number of pixels differing by more than the tolerance to.
+ * @param maxDifference A pointer to write the largest difference in any channel to.
+ *
+ * @return True if the frames match within the tolerance, false otherwise.
+ */
+static bool CompareFrames(const SDL_Surface* actual, const SDL_Surface* expected, int* differentPixels, int* maxDifference)
+{
+    *differentPixels = 0;
+    *maxDifference = 0;
+
+    if (actual->w != expected->w || actual->h != expected->h)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Frame is %dx%d, but golden image is %dx%d!", actual->w, actual->h, expected->w, expected->h);
+        return false;
+    }
+
+    for (int y = 0; y < actual->h; y++)
+    {
+        const Uint8* actualRow = (const Uint8*)actual->pixels + (size_t)y * (size_t)actual->pitch;
+        const Uint8* expectedRow = (const Uint8*)expected->pixels + (size_t)y * (size_t)expected->pitch;
+
+        for (int x = 0; x < actual->w; x++)
+        {
+            int pixelDifference = 0;
+            for (int channel = 0; channel < 4; channel++)
+            {
+                const int difference = SDL_abs((int)actualRow[x * 4 + channel] - (int)expectedRow[x * 4 + channel]);
+                if (difference > pixelDifference) pixelDifference = difference;
+            }
+
+            if (pixelDifference > *maxDifference) *maxDifference = pixelDifference;
+            if (pixelDifference > GOLDEN_CHANNEL_TOLERANCE) (*differentPixels)++;
+        }
+    }
+
+    const Sint64 allowedPixels = (Sint64)actual->w * actual->h * GOLDEN_MAX_DIFFERENT_PIXELS_PER_MILLION / 1000000;
+    return *differentPixels <= allowedPixels;
+}
+
+/**
+ * @brief Compare a rendered frame against its golden image, or overwrite the golden image with it.
+ *
+ * @param frame The rendered frame, in SDL_PIXELFORMAT_RGBA32.
+ * @param directory The directory containing the golden images.
+ * @param scene The scene the frame was rendered from.
+ * @param isUpdating Whether to overwrite the golden image rather than compare against it.
+ *
+ * @return True if the frame matched (or was written), false otherwise.
+ */
+static bool CheckFrame(SDL_Surface* frame, const char* directory, const GoldenScene* scene, const bool isUpdating)
+{
+    char path[GOLDEN_MAX_PATH_LENGTH];
+    SDL_snprintf(path, sizeof(path), "%s/%s.png", directory, scene->name);
+
+    if (isUpdating)
+    {
+        if (!IMG_SavePNG(frame, path))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write golden image '%s': %s", path, SDL_GetError());
+            return false;
+        }
+
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote golden image '%s'.", path);
+        return true;
+    }
+
+    SDL_Surface* loaded = IMG_Load(path);
+    if (!loaded)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load golden image '%s' (run with --update-golden to create it): %s", path, SDL_GetError());
+        return false;
+    }
+
+    SDL_Surface* expected = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    if (!expected) return false;
+
+    int differentPixels;
+    int maxDifference;
+    const bool isMatch = CompareFrames(frame, expected, &differentPixels, &maxDifference);
+    SDL_DestroySurface(expected);
+
+    if (isMatch)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Scene '%s' matches (%d pixels over tolerance, max channel difference %d).", scene->name, differentPixels, maxDifference);
+        return true;
+    }
+
+    // Keep the failing frame so that it can be inspected, or promoted to the new golden image
+    SDL_snprintf(path, sizeof(path), "%s/%s.actual.png", directory, scene->name);
+    IMG_SavePNG(frame, path);
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Scene '%s' does not match: %d pixels over tolerance, max channel difference %d. Wrote '%s'.", scene->name, differentPixels, maxDifference, path);
+    return false;
+}
+
+bool GOLDEN_Run(const char* directory, const bool isUpdating, GoldenResult* result)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *result = (GoldenResult){ 0 };
+
+    static GameDataContext gameDataContext = { 0 };
+    static DroppingTetromino droppingTetromino = { 0 };
+    static GraphicsDataContext graphicsDataContext = { 0 };
+    static Fonts fonts = { 0 };
+
+    gameDataContext.droppingTetromino = &droppingTetromino;
+    if (!GAME_Init(&gameDataContext)) return false;
+
+    if (!GFX_InitHeadless(&graphicsDataContext, &gameDataContext, &fonts, GOLDEN_FRAME_WIDTH, GOLDEN_FRAME_HEIGHT))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to initialise headless graphics: %s", SDL_GetError());
+        return false;
+    }
+    if (!GFX_LoadTetrominoTextures(&graphicsDataContext))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to load tetromino textures: %s", SDL_GetError());
+        return false;
+    }
+
+    bool success = true;
+
+    for (size_t i = 0; i < SDL_arraysize(GOLDEN_SCENES); i++)
+    {
+        const GoldenScene* scene = &GOLDEN_SCENES[i];
+        PlayScene(&gameDataContext, scene);
+        result->scenes++;
+
+        if (!GFX_RenderGame(&graphicsDataContext, &gameDataContext, &fonts)) return false;
+
+        SDL_Surface* frame = ReadFrame(&graphicsDataContext);
+        if (!frame)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to read frame: %s", SDL_GetError());
+            return false;
+        }
+
+        if (CheckFrame(frame, directory, scene, isUpdating)) result->passed++;
+        else success = false;
+
+        SDL_DestroySurface(frame);
+
+        // Measure throughput separately from the checks, so that reading back and comparing frames is not included
+        TRACE_BEGIN("GOLDEN_Benchmark");
+        const Uint64 start = SDL_GetTicksNS();
+        for (int frameIndex = 0; frameIndex < GOLDEN_BENCHMARK_FRAMES; frameIndex++)
+        {
+            GFX_RenderGame(&graphicsDataContext, &gameDataContext, &fonts);
+            SDL_FlushRenderer(graphicsDataContext.renderer);
+        }
+        result->benchmarkNS += SDL_GetTicksNS() - start;
+        result->benchmarkFrames += GOLDEN_BENCHMARK_FRAMES;
+        TRACE_END("GOLDEN_Benchmark");
+    }
+
+    SDL_DestroyRenderer(graphicsDataContext.renderer);
+    SDL_DestroySurface(graphicsDataContext.targetSurface);
+    TTF_CloseFont(fonts.mainFont);
+    TTF_CloseFont(fonts.secondaryFont);
+
+    return success;
+}
@@ -5,25 +5,56 @@
 
 #include "graphics.h"
 
+#include "metrics.h"
+#include "particles.h"
+#include "profiler.h"
+#include "scores.h"
 #include "util.h"
 #include "game.h"
 #include "tetromino.h"
 
-bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts)
+/**
+ * @brief The image of each block, indexed by ::TetrominoIdentifier, including GARBAGE for garbage blocks.
+ */
+static const char* BLOCK_IMAGE_PATHS[GARBAGE + 1] = {
+    NULL,
+    "resources/images/blocks/cyan.png",
+    "resources/images/blocks/yellow.png",
+    "resources/images/blocks/purple.png",
+    "resources/images/blocks/red.png",
+    "resources/images/blocks/green.png",
+    "resources/images/blocks/orange.png",
+    "resources/images/blocks/blue.png",
+    "resources/images/blocks/black.png",
+};
+
+/**
+ * @brief Load the fonts and set up the sidebar UI, which is shared by windowed and headless rendering.
+ *
+ * @param graphicsDataContext A struct containing the graphics data to initialise.
+ * @param gameDataContext A struct containing the game data context.
+ * @param fonts A pointer to the fonts struct to load the fonts to.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool InitFontsAndSidebar(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts)
 {
-    SDL_LogInfo(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
-
     // Load fonts
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Loading fonts...");
     if (!(fonts->mainFont = TTF_OpenFont("resources/fonts/doto_extra_bold.ttf", 150))) return false;
     if (!(fonts->secondaryFont = TTF_OpenFont("resources/fonts/doto_regular.ttf", 150))) return false;
 
-    SidebarUI* sidebar = SDL_calloc(1, sizeof(SidebarUI));
+    SidebarUI* sidebar = graphicsDataContext->sidebarUI;
+    if (!sidebar)
+    {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Sidebar UI does not exist, so allocating memory for it...");
+        if (!(sidebar = SDL_calloc(1, sizeof(SidebarUI)))) return false;
+    }
 
     // TODO Store all other sidebar data here, i.e. the size of the bar and its location etc.
 
     sidebar->restartButton = (Button){
-        .gridRect = {(float)ARENA_WIDTH, 7, 3, 1},
+        .gridRect = {(float)ARENA_WIDTH, 17, 3, 1},
         .color = {40, 40, 40, 255},
         .hoverColor = {80, 80, 80, 255},
         .textColor = {255, 255, 255, 255},
@@ -35,7 +66,7 @@ bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDat
     };
 
     sidebar->pauseButton = (Button){
-        .gridRect = {(float)ARENA_WIDTH, 8, 3, 1},
+        .gridRect = {(float)ARENA_WIDTH, 18, 3, 1},
         .color = {40, 40, 40, 255},
         .hoverColor = {80, 80, 80, 255},
         .textColor = {255, 255, 255, 255},
@@ -47,7 +78,7 @@ bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDat
     };
 
     sidebar->quitButton = (Button){
-        .gridRect = {(float)ARENA_WIDTH, 9, 3, 1},
+        .gridRect = {(float)ARENA_WIDTH, 19, 3, 1},
         .color = {40, 40, 40, 255},
         .hoverColor = {80, 80, 80, 255},
         .textColor = {255, 255, 255, 255},
@@ -67,6 +98,15 @@ bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDat
     // Initialise UI objects
     graphicsDataContext->sidebarUI = sidebar;
 
+    return true;
+}
+
+bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    if (!InitFontsAndSidebar(graphicsDataContext, gameDataContext, fonts)) return false;
+
     // Default size of 60
     graphicsDataContext->gridSquareSize = 60;
 
@@ -90,22 +130,47 @@ bool GFX_Init(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDat
     Assert(graphicsDataContext->window, "Window creation failed!\n");
     Assert(graphicsDataContext->renderer, "Renderer creation failed!\n");
 
+    // Dynamic text is drawn from an atlas, so that it never creates textures during play
+    SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Building glyph atlas...");
+    if (!BuildGlyphAtlas(graphicsDataContext, fonts->secondaryFont, &fonts->secondaryFontAtlas)) return false;
+
     return true;
 } 
 
-bool GFX_LoadTetrominoTextures(const GraphicsDataContext* graphicsDataContext)
+bool GFX_InitHeadless(GraphicsDataContext* graphicsDataContext, GameDataContext* gameDataContext, Fonts* fonts, const int width, const int height)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    if (!InitFontsAndSidebar(graphicsDataContext, gameDataContext, fonts)) return false;
+
+    ResizeGridSquares(graphicsDataContext, width, height);
+
+    // Render into a surface in system memory, so that no window, display or GPU is needed
+    SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Creating %dx%d software render target...", width, height);
+    if (!(graphicsDataContext->targetSurface = SDL_CreateSurface(width, height, SDL_PIXELFORMAT_RGBA32))) return false;
+    if (!(graphicsDataContext->renderer = SDL_CreateSoftwareRenderer(graphicsDataContext->targetSurface))) return false;
+    graphicsDataContext->window = NULL;
+
+    SDL_SetRenderDrawBlendMode(graphicsDataContext->renderer, SDL_BLENDMODE_BLEND);
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Building glyph atlas...");
+    if (!BuildGlyphAtlas(graphicsDataContext, fonts->secondaryFont, &fonts->secondaryFontAtlas)) return false;
+
+    return true;
+}
+
+bool GFX_LoadTetrominoTextures(GraphicsDataContext* graphicsDataContext)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
 
     // Load tetromino textures
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Loading tetromino textures...");
-    if (!(GetTetrominoShapeByIdentifier(I)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/cyan.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(O)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/yellow.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(T)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/purple.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(Z)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/red.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(S)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/green.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(L)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/orange.png"))) return false;
-    if (!(GetTetrominoShapeByIdentifier(J)->texture = IMG_LoadTexture(graphicsDataContext->renderer, "resources/images/blocks/blue.png"))) return false;
+    SDL_Texture** blockTextures = graphicsDataContext->blockTextures;
+    for (TetrominoIdentifier identifier = I; identifier <= GARBAGE; identifier++)
+    {
+        if (!(blockTextures[identifier] = IMG_LoadTexture(graphicsDataContext->renderer, BLOCK_IMAGE_PATHS[identifier]))) return false;
+        METRICS_AddGauge(METRIC_GAUGE_TEXTURE_BYTES, GetTextureBytes(blockTextures[identifier]));
+    }
 
     return true;
 }
@@ -117,11 +182,31 @@ bool GFX_RenderGame(GraphicsDataContext* graphicsDataContext, GameDataContext* g
     SDL_LogTrace(SDL_LOG_CATEGORY_RENDER, "Clearing screen...");
     SDL_SetRenderDrawColor(graphicsDataContext->renderer, 17, 17, 17, 255);
     SDL_RenderClear(graphicsDataContext->renderer);
+    PROFILER_CountDrawCall();
 
+    PROFILER_BeginStage(PROFILER_STAGE_DRAW_DROPPING_TETROMINO);
     Assert(DrawDroppingTetromino(graphicsDataContext, gameDataContext), "Failed to draw dropping tetromino!\n");
+    PROFILER_EndStage(PROFILER_STAGE_DRAW_DROPPING_TETROMINO);
+
+    PROFILER_BeginStage(PROFILER_STAGE_DRAW_DROPPING_TETROMINO_GHOST);
     Assert(DrawDroppingTetrominoGhost(graphicsDataContext, gameDataContext), "Failed to draw dropping tetromino ghost!\n");
+    PROFILER_EndStage(PROFILER_STAGE_DRAW_DROPPING_TETROMINO_GHOST);
+
+    PROFILER_BeginStage(PROFILER_STAGE_DRAW_ARENA);
     Assert(DrawArena(graphicsDataContext, gameDataContext), "Failed to draw arena!\n");
+    PROFILER_EndStage(PROFILER_STAGE_DRAW_ARENA);
+
+    PROFILER_BeginStage(PROFILER_STAGE_DRAW_SIDEBAR);
     Assert(DrawSidebar(graphicsDataContext, fonts, gameDataContext), "Failed to draw sidebar!\n");
+    PROFILER_EndStage(PROFILER_STAGE_DRAW_SIDEBAR);
+
+    if (graphicsDataContext->particles)
+    {
+        PROFILER_BeginStage(PROFILER_STAGE_DRAW_EFFECTS);
+        PARTICLES_Update(graphicsDataContext->particles, SDL_GetTicksNS());
+        Assert(PARTICLES_Draw(graphicsDataContext->particles, graphicsDataContext), "Failed to draw effects!\n");
+        PROFILER_EndStage(PROFILER_STAGE_DRAW_EFFECTS);
+    }
 
     if (gameDataContext->isGameOver)
     {
@@ -153,6 +238,7 @@ bool DrawBlock(GraphicsDataContext* graphicsDataContext, SDL_Texture* texture, c
 
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Drawing block on grid @ (%d, %d)...", x, y);
     if (!SDL_SetTextureAlphaMod(texture, alpha)) return false;
+    PROFILER_CountDrawCall();
     if (!SDL_RenderTexture(graphicsDataContext->renderer, texture, NULL, &rect)) return false;
     return true;
 }
@@ -168,13 +254,13 @@ bool DrawArena(GraphicsDataContext* graphicsDataContext, const GameDataContext*
             // Draw only filled blocks
             if (gameDataContext->arena[row][col])
             {
-                const TetrominoShape* shape = GetTetrominoShapeByIdentifier(gameDataContext->arena[row][col]);
-                DrawBlock(graphicsDataContext, shape->texture, 255, col, row);
+                DrawBlock(graphicsDataContext, graphicsDataContext->blockTextures[gameDataContext->arena[row][col]], 255, col, row);
             }
 
             // Draw grid
             SDL_SetRenderDrawColor(graphicsDataContext->renderer, 32, 32, 32, 255); // Grey
             SDL_FRect rect = FGridRectToFRect(graphicsDataContext, (FGridRect){ (float)col, (float)row, 1, 1 }, 0);
+            PROFILER_CountDrawCall();
             if (!SDL_RenderRect(graphicsDataContext->renderer, &rect))
                 return false;
         }
@@ -193,7 +279,7 @@ bool DrawDroppingTetromino(GraphicsDataContext* graphicsDataContext, const GameD
         return false;
     }
 
-    SDL_Texture* droppingTetrominoTexture = droppingTetromino->shape->texture;
+    SDL_Texture* droppingTetrominoTexture = graphicsDataContext->blockTextures[droppingTetromino->shape->identifier];
     const int droppingTetrominoX = droppingTetromino->x;
     const int droppingTetrominoY = droppingTetromino->y;
     const bool (*droppingTetrominoRotatedCoordinates)[TETROMINO_MAX_SIZE] = droppingTetromino->shape->coordinates[gameDataContext->droppingTetromino->orientation];
@@ -225,7 +311,7 @@ bool DrawDroppingTetrominoGhost(GraphicsDataContext* graphicsDataContext, GameDa
         return false;
     }
 
-    SDL_Texture* droppingTetrominoTexture = droppingTetromino->shape->texture;
+    SDL_Texture* droppingTetrominoTexture = graphicsDataContext->blockTextures[droppingTetromino->shape->identifier];
     const int droppingTetrominoX = droppingTetromino->x;
     const bool (*droppingTetrominoRotatedCoordinates)[TETROMINO_MAX_SIZE] = droppingTetromino->shape->coordinates[gameDataContext->droppingTetromino->orientation];
 
@@ -260,13 +346,13 @@ bool DrawSidebar(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, c
     SDL_SetRenderDrawColor(graphicsDataContext->renderer, 20, 20, 20, 255); // Grey
     FGridRect gridRect = { ARENA_WIDTH, 0, (float)graphicsDataContext->sidebarUI->width, WINDOW_GRID_HEIGHT };
     const SDL_FRect backgroundRect = FGridRectToFRect(graphicsDataContext, gridRect, 0);
+    PROFILER_CountDrawCall();
     if (!SDL_RenderRect(graphicsDataContext->renderer, &backgroundRect)) return false;
 
     const SDL_Color colorWhite = { 255, 255, 255, 255 };
     gridRect.h = 2;
 
-    static TextCache cache001 = { 0 };
-    if (!RenderText(graphicsDataContext, gridRect, 0.1f, "TETRIS", &cache001, fonts->mainFont, colorWhite)) return false;
+    if (!RenderText(graphicsDataContext, gridRect, 0.1f, "TETRIS", &graphicsDataContext->sidebarTitleCache, fonts->mainFont, colorWhite)) return false;
 
     // Draw score
     char text[MAX_STRING_LENGTH];
@@ -278,8 +364,7 @@ bool DrawSidebar(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, c
 
     gridRect.h = 1;
     gridRect.y += 2;
-    static TextCache cache002 = { 0 };
-    if (!RenderText(graphicsDataContext, gridRect, 0.1f, text, &cache002, fonts->secondaryFont, colorWhite)) return false;
+    if (!RenderDynamicText(graphicsDataContext, gridRect, 0.1f, text, &fonts->secondaryFontAtlas, colorWhite)) return false;
 
     // Draw level
     if (SDL_snprintf(text, 8, "LVL %03d", gameDataContext->level) < 0)
@@ -289,8 +374,15 @@ bool DrawSidebar(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, c
     }
 
     gridRect.y++;
-    static TextCache cache003 = { 0 };
-    if (!RenderText(graphicsDataContext, gridRect, 0.1f, text, &cache003, fonts->secondaryFont, colorWhite)) return false;
+    if (!RenderDynamicText(graphicsDataContext, gridRect, 0.1f, text, &fonts->secondaryFontAtlas, colorWhite)) return false;
+
+    // Draw next queue
+    gridRect.y++;
+    if (!RenderDynamicText(graphicsDataContext, gridRect, 0.2f, "NEXT", &fonts->secondaryFontAtlas, colorWhite)) return false;
+
+    gridRect.y++;
+    gridRect.h = 1.5f * NEXT_QUEUE_PREVIEW_COUNT;
+    if (!DrawNextQueue(graphicsDataContext, gameDataContext, gridRect)) return false;
 
     if (!RenderButton(graphicsDataContext, &graphicsDataContext->sidebarUI->restartButton)) return false;
 
@@ -309,6 +401,61 @@ bool DrawSidebar(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, c
     return true;
 }
 
+bool DrawNextQueue(GraphicsDataContext* graphicsDataContext, const GameDataContext* gameDataContext, const FGridRect gridRect)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    int count;
+    const TetrominoIdentifier* queue = PeekTetrominoQueue(&gameDataContext->tetrominoBag, &count);
+    if (count > NEXT_QUEUE_PREVIEW_COUNT) count = NEXT_QUEUE_PREVIEW_COUNT;
+
+    // Leave a block's width of margin around the widest tetromino
+    const float blockSize = gridRect.w / (TETROMINO_MAX_SIZE + 1);
+    const float slotHeight = gridRect.h / NEXT_QUEUE_PREVIEW_COUNT;
+
+    for (int i = 0; i < count; i++)
+    {
+        const TetrominoShape* shape = GetTetrominoShapeByIdentifier(queue[i]);
+        if (!shape) return false;
+
+        SDL_Texture* texture = graphicsDataContext->blockTextures[shape->identifier];
+        if (!SDL_SetTextureAlphaMod(texture, 255)) return false;
+
+        // Find the filled bounds of the spawn orientation, so that the tetromino can be centred in its slot
+        const bool (*coordinates)[TETROMINO_MAX_SIZE] = shape->coordinates[NORTH];
+        int minRow = TETROMINO_MAX_SIZE, maxRow = -1, minCol = TETROMINO_MAX_SIZE, maxCol = -1;
+        for (int row = 0; row < TETROMINO_MAX_SIZE; row++)
+        {
+            for (int col = 0; col < TETROMINO_MAX_SIZE; col++)
+            {
+                if (!coordinates[row][col]) continue;
+                minRow = SDL_min(minRow, row);
+                maxRow = SDL_max(maxRow, row);
+                minCol = SDL_min(minCol, col);
+                maxCol = SDL_max(maxCol, col);
+            }
+        }
+
+        const float originX = gridRect.x + 0.5f * (gridRect.w - (float)(maxCol - minCol + 1) * blockSize);
+        const float originY = gridRect.y + (float)i * slotHeight + 0.5f * (slotHeight - (float)(maxRow - minRow + 1) * blockSize);
+
+        for (int row = minRow; row <= maxRow; row++)
+        {
+            for (int col = minCol; col <= maxCol; col++)
+            {
+                if (!coordinates[row][col]) continue;
+
+                const FGridRect blockRect = { originX + (float)(col - minCol) * blockSize, originY + (float)(row - minRow) * blockSize, blockSize, blockSize };
+                const SDL_FRect rect = FGridRectToFRect(graphicsDataContext, blockRect, 0);
+                PROFILER_CountDrawCall();
+                if (!SDL_RenderTexture(graphicsDataContext->renderer, texture, NULL, &rect)) return false;
+            }
+        }
+    }
+
+    return true;
+}
+
 bool DrawGameOverScreen(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, GameDataContext* gameDataContext)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
@@ -318,11 +465,64 @@ bool DrawGameOverScreen(GraphicsDataContext* graphicsDataContext, const Fonts* f
     // Draw menu background
     SDL_SetRenderDrawColor(graphicsDataContext->renderer, 10, 10, 10, 200); // Grey
     const SDL_FRect backgroundRect = FGridRectToFRect(graphicsDataContext, (FGridRect){ 0, 0, ARENA_WIDTH, ARENA_HEIGHT }, 0);
+    PROFILER_CountDrawCall();
     if (!SDL_RenderFillRect(graphicsDataContext->renderer, &backgroundRect)) return false;
 
-    // Draw title
-    static TextCache cache001 = { 0 };
-    if (!RenderText(graphicsDataContext, (FGridRect){ 0, 0, ARENA_WIDTH, ARENA_HEIGHT }, 0.5f, "GAME OVER", &cache001, fonts->mainFont, colorWhite)) return false;
+    // Draw title, which fills the arena unless there are high scores to make room for
+    if (!graphicsDataContext->scoreStore)
+    {
+        return RenderText(graphicsDataContext, (FGridRect){ 0, 0, ARENA_WIDTH, ARENA_HEIGHT }, 0.5f, "GAME OVER", &graphicsDataContext->gameOverTitleCache, fonts->mainFont, colorWhite);
+    }
+    if (!RenderText(graphicsDataContext, (FGridRect){ 0, 0, ARENA_WIDTH, 5 }, 0.5f, "GAME OVER", &graphicsDataContext->gameOverTitleCache, fonts->mainFont, colorWhite)) return false;
+
+    // The table is indexed as games are written, so drawing it costs the same however many games have been recorded
+    const ScoreTable* table = SCORES_AcquireTable(graphicsDataContext->scoreStore);
+    const SDL_Color colorHighlight = { 255, 215, 0, 255 }; // Gold
+    if (!RenderDynamicText(graphicsDataContext, (FGridRect){ 0, 5, ARENA_WIDTH, 1.5f }, 0.2f, "HIGH SCORES", &fonts->secondaryFontAtlas, colorWhite)) return false;
+
+    char text[64];
+    for (int i = 0; i < table->topCount; i++)
+    {
+        // The finished game may still be on its way to the writer thread, in which case it appears a frame or so later
+        const ScoreRecord* record = &table->top[i];
+        const bool isCurrentGame = record->seed == gameDataContext->seed && record->score == (Uint32)gameDataContext->score;
+
+        SDL_snprintf(text, sizeof(text), "%2d. %7" SDL_PRIu32 "  L%-2" SDL_PRIu32, i + 1, record->score, record->level);
+        if (!RenderDynamicText(graphicsDataContext, (FGridRect){ 0.5f, 7 + (float)i, ARENA_WIDTH - 1, 1 }, 0.1f, text, &fonts->secondaryFontAtlas, isCurrentGame ? colorHighlight : colorWhite)) return false;
+    }
+
+    SDL_snprintf(text, sizeof(text), "%" SDL_PRIu64 " GAMES  %" SDL_PRIu64 " LINES", table->totals.games, table->totals.lines);
+    if (!RenderDynamicText(graphicsDataContext, (FGridRect){ 0.5f, ARENA_HEIGHT - 2.5f, ARENA_WIDTH - 1, 1 }, 0.1f, text, &fonts->secondaryFontAtlas, colorWhite)) return false;
+
+    return true;
+}
+
+bool DrawTextOverlay(GraphicsDataContext* graphicsDataContext, const Fonts* fonts, TextOverlay* overlay)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    if (overlay->lineCount <= 0) return true;
+
+    const SDL_Color colorWhite = { 255, 255, 255, 255 };
+
+    // Draw overlay background
+    SDL_SetRenderDrawColor(graphicsDataContext->renderer, 0, 0, 0, 180);
+    const SDL_FRect backgroundRect = FGridRectToFRect(graphicsDataContext, overlay->gridRect, 0);
+    PROFILER_CountDrawCall();
+    if (!SDL_RenderFillRect(graphicsDataContext->renderer, &backgroundRect)) return false;
+
+    const int lineCount = (overlay->lineCount < OVERLAY_MAX_LINES) ? overlay->lineCount : OVERLAY_MAX_LINES;
+    FGridRect lineRect = overlay->gridRect;
+    lineRect.h = overlay->gridRect.h / (float)lineCount;
+
+    for (int i = 0; i < lineCount; i++)
+    {
+        if (overlay->lines[i][0] != '\0')
+        {
+            if (!RenderDynamicText(graphicsDataContext, lineRect, 0.05f, overlay->lines[i], &fonts->secondaryFontAtlas, colorWhite)) return false;
+        }
+        lineRect.y += lineRect.h;
+    }
 
     return true;
 }
@@ -378,70 +578,253 @@ bool RenderText(GraphicsDataContext* graphicsDataContext, const FGridRect gridRe
         scaledHeight,
     };
 
+    PROFILER_CountDrawCall();
     if (!SDL_RenderTexture(graphicsDataContext->renderer, texture, NULL, &rect)) return false;
     return true;
 }
 
-bool RenderButton(GraphicsDataContext* graphicsDataContext, Button* button)
+int BuildTextGeometry(const GlyphAtlas* atlas, const SDL_FRect bounds, const char* text, const SDL_Color color, SDL_Vertex* vertices)
+{
+    // Look up each glyph, and measure the text
+    int glyphIndices[MAX_STRING_LENGTH];
+    int glyphCount = 0;
+    float textWidth = 0;
+
+    for (; glyphCount < MAX_STRING_LENGTH && text[glyphCount] != '\0'; glyphCount++)
+    {
+        int index = (unsigned char)text[glyphCount] - GLYPH_ATLAS_FIRST_CHARACTER;
+        if (index < 0 || index >= GLYPH_ATLAS_CHARACTER_COUNT) index = '?' - GLYPH_ATLAS_FIRST_CHARACTER;
+
+        glyphIndices[glyphCount] = index;
+        textWidth += atlas->glyphs[index].w;
+    }
+
+    if (glyphCount == 0 || textWidth <= 0) return 0;
+
+    // Fit and center the text inside the bounds, the same as RenderText
+    const float widthRatio = bounds.w / textWidth;
+    const float heightRatio = bounds.h / atlas->lineHeight;
+    const float ratio = (widthRatio <= heightRatio) ? widthRatio : heightRatio;
+
+    float x = bounds.x + (bounds.w - textWidth * ratio) / 2;
+    const float y = bounds.y + (bounds.h - atlas->lineHeight * ratio) / 2;
+
+    const SDL_FColor vertexColor = { (float)color.r / 255.0f, (float)color.g / 255.0f, (float)color.b / 255.0f, (float)color.a / 255.0f };
+    const float atlasWidth = (float)atlas->texture->w;
+    const float atlasHeight = (float)atlas->texture->h;
+
+    for (int i = 0; i < glyphCount; i++)
+    {
+        const SDL_FRect* glyph = &atlas->glyphs[glyphIndices[i]];
+        const float width = glyph->w * ratio;
+        const float height = atlas->lineHeight * ratio;
+
+        const float u0 = glyph->x / atlasWidth;
+        const float v0 = glyph->y / atlasHeight;
+        const float u1 = (glyph->x + glyph->w) / atlasWidth;
+        const float v1 = (glyph->y + glyph->h) / atlasHeight;
+
+        SDL_Vertex* quad = &vertices[i * 4];
+        quad[0] = (SDL_Vertex){ { x, y }, vertexColor, { u0, v0 } };
+        quad[1] = (SDL_Vertex){ { x + width, y }, vertexColor, { u1, v0 } };
+        quad[2] = (SDL_Vertex){ { x + width, y + height }, vertexColor, { u1, v1 } };
+        quad[3] = (SDL_Vertex){ { x, y + height }, vertexColor, { u0, v1 } };
+
+        x += width;
+    }
+
+    return glyphCount;
+}
+
+bool RenderDynamicText(GraphicsDataContext* graphicsDataContext, const FGridRect gridRect, const float margin, const char* text, const GlyphAtlas* atlas, const SDL_Color color)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
 
-    const SDL_Color buttonColor = button->isHovered ? button->hoverColor : button->color;
+    const SDL_FRect bounds = {
+        (gridRect.x + margin) * graphicsDataContext->gridSquareSize,
+        (gridRect.y + margin) * graphicsDataContext->gridSquareSize,
+        (gridRect.w - margin * 2) * graphicsDataContext->gridSquareSize,
+        (gridRect.h - margin * 2) * graphicsDataContext->gridSquareSize
+    };
 
-    if (!SDL_SetRenderDrawColor(graphicsDataContext->renderer, buttonColor.r, buttonColor.g, buttonColor.b, buttonColor.a)) return false;
-    const SDL_FRect rect = FGridRectToFRect(graphicsDataContext, button->gridRect, 0.1f);
-    if (!SDL_RenderFillRect(graphicsDataContext->renderer, &rect)) return false;
+    // Build a quad for each glyph, so the whole string is a single draw call
+    SDL_Vertex vertices[MAX_STRING_LENGTH * 4];
+    int indices[MAX_STRING_LENGTH * 6];
+    const int glyphCount = BuildTextGeometry(atlas, bounds, text, color, vertices);
+    if (glyphCount == 0) return true;
 
-    if (!RenderText(graphicsDataContext, button->gridRect, 0.25f, button->text, &button->cache, button->font, button->textColor)) return false;
+    for (int i = 0; i < glyphCount; i++)
+    {
+        int* quadIndices = &indices[i * 6];
+        quadIndices[0] = i * 4;
+        quadIndices[1] = i * 4 + 1;
+        quadIndices[2] = i * 4 + 2;
+        quadIndices[3] = i * 4;
+        quadIndices[4] = i * 4 + 2;
+        quadIndices[5] = i * 4 + 3;
+    }
 
-    return true;
+    PROFILER_CountDrawCall();
+    return SDL_RenderGeometry(graphicsDataContext->renderer, atlas->texture, vertices, glyphCount * 4, indices, glyphCount * 6);
 }
 
-void HandleButtonEvent(GraphicsDataContext* graphicsDataContext, SDL_Event* event, Button* button)
+bool BuildGlyphAtlas(GraphicsDataContext* graphicsDataContext, TTF_Font* font, GlyphAtlas* atlas)
 {
-    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
 
-    const SDL_FRect rect = FGridRectToFRect(graphicsDataContext, button->gridRect, 0);
+    const SDL_Color colorWhite = { 255, 255, 255, 255 };
+    const int lineHeight = TTF_GetFontHeight(font);
+
+    // Render every glyph first, so the atlas can be sized to fit the widest
+    SDL_Surface* glyphSurfaces[GLYPH_ATLAS_CHARACTER_COUNT] = { 0 };
+    int glyphWidths[GLYPH_ATLAS_CHARACTER_COUNT] = { 0 };
+    int cellWidth = 1;
+
+    for (int i = 0; i < GLYPH_ATLAS_CHARACTER_COUNT; i++)
+    {
+        const Uint32 character = (Uint32)(GLYPH_ATLAS_FIRST_CHARACTER + i);
+
+        // Glyphs without any pixels (i.e. space) have no surface, but still advance the text
+        glyphSurfaces[i] = TTF_RenderGlyph_Blended(font, character, colorWhite);
+        if (glyphSurfaces[i])
+        {
+            glyphWidths[i] = glyphSurfaces[i]->w;
+        }
+        else if (!TTF_GetGlyphMetrics(font, character, NULL, NULL, NULL, NULL, &glyphWidths[i]))
+        {
+            glyphWidths[i] = 0;
+        }
+
+        if (glyphWidths[i] > cellWidth) cellWidth = glyphWidths[i];
+    }
+
+    const int rows = (GLYPH_ATLAS_CHARACTER_COUNT + GLYPH_ATLAS_COLUMNS - 1) / GLYPH_ATLAS_COLUMNS;
+    SDL_Surface* atlasSurface = SDL_CreateSurface(cellWidth * GLYPH_ATLAS_COLUMNS, lineHeight * rows, SDL_PIXELFORMAT_RGBA32);
+
+    bool success = atlasSurface != NULL;
+    for (int i = 0; i < GLYPH_ATLAS_CHARACTER_COUNT; i++)
+    {
+        const int x = (i % GLYPH_ATLAS_COLUMNS) * cellWidth;
+        const int y = (i / GLYPH_ATLAS_COLUMNS) * lineHeight;
+        atlas->glyphs[i] = (SDL_FRect){ (float)x, (float)y, (float)glyphWidths[i], (float)lineHeight };
+
+        if (success && glyphSurfaces[i])
+        {
+            // Copy the glyph's alpha as-is, rather than blending it onto the transparent atlas
+            SDL_SetSurfaceBlendMode(glyphSurfaces[i], SDL_BLENDMODE_NONE);
+            const SDL_Rect sourceRect = { 0, 0, glyphSurfaces[i]->w, SDL_min(glyphSurfaces[i]->h, lineHeight) };
+            success = SDL_BlitSurface(glyphSurfaces[i], &sourceRect, atlasSurface, &(SDL_Rect){ x, y, sourceRect.w, sourceRect.h });
+        }
+        SDL_DestroySurface(glyphSurfaces[i]);
+    }
 
-    if (event->type == SDL_EVENT_MOUSE_MOTION)
+    if (success)
     {
-        button->isHovered = SDL_PointInRectFloat(&(SDL_FPoint) { event->motion.x, event->motion.y }, &rect);
-        if (button->isHovered) SDL_LogTrace(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) is hovered!", button->text);
+        atlas->texture = SDL_CreateTextureFromSurface(graphicsDataContext->renderer, atlasSurface);
+        atlas->lineHeight = (float)lineHeight;
+        success = atlas->texture != NULL;
+        METRICS_AddGauge(METRIC_GAUGE_TEXTURE_BYTES, GetTextureBytes(atlas->texture));
     }
-    else if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN && button->isHovered)
+    SDL_DestroySurface(atlasSurface);
+
+    if (!success) SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to build glyph atlas: %s", SDL_GetError());
+    return success;
+}
+
+bool BuildBlockAtlas(GraphicsDataContext* graphicsDataContext)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    SDL_Surface* atlasSurface = SDL_CreateSurface(BLOCK_ATLAS_CELL_SIZE * (GARBAGE + 1), BLOCK_ATLAS_CELL_SIZE, SDL_PIXELFORMAT_RGBA32);
+    bool success = atlasSurface != NULL;
+
+    // The first cell is solid white, so that plain coloured quads can be tinted and drawn in the same batch as blocks
+    if (success)
     {
-        button->isPressed = true;
-        SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) is pressed!", button->text);
+        const SDL_Rect whiteRect = { 0, 0, BLOCK_ATLAS_CELL_SIZE, BLOCK_ATLAS_CELL_SIZE };
+        success = SDL_FillSurfaceRect(atlasSurface, &whiteRect, SDL_MapSurfaceRGBA(atlasSurface, 255, 255, 255, 255));
     }
-    else if (event->type == SDL_EVENT_MOUSE_BUTTON_UP)
+
+    for (TetrominoIdentifier identifier = I; success && identifier <= GARBAGE; identifier++)
     {
-        // Callback
-        if (button->isHovered && button->isPressed && button->onClick)
+        SDL_Surface* blockSurface = IMG_Load(BLOCK_IMAGE_PATHS[identifier]);
+        success = blockSurface != NULL;
+        if (success)
         {
-            SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) has activated and called callback method!", button->text);
-            button->onClick(button->userData);
+            SDL_SetSurfaceBlendMode(blockSurface, SDL_BLENDMODE_NONE);
+            const SDL_Rect cellRect = { (int)identifier * BLOCK_ATLAS_CELL_SIZE, 0, BLOCK_ATLAS_CELL_SIZE, BLOCK_ATLAS_CELL_SIZE };
+            success = SDL_BlitSurfaceScaled(blockSurface, NULL, atlasSurface, &cellRect, SDL_SCALEMODE_LINEAR);
         }
-        button->isPressed = false;
+        SDL_DestroySurface(blockSurface);
+    }
+
+    if (success)
+    {
+        graphicsDataContext->blockAtlas = SDL_CreateTextureFromSurface(graphicsDataContext->renderer, atlasSurface);
+        success = graphicsDataContext->blockAtlas != NULL;
+        if (success) METRICS_AddGauge(METRIC_GAUGE_TEXTURE_BYTES, GetTextureBytes(graphicsDataContext->blockAtlas));
     }
+    SDL_DestroySurface(atlasSurface);
+
+    if (!success) SDL_LogError(SDL_LOG_CATEGORY_RENDER, "Failed to build block atlas: %s", SDL_GetError());
+    return success;
+}
+
+bool RenderButton(GraphicsDataContext* graphicsDataContext, Button* button)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    const SDL_Color buttonColor = button->isHovered ? button->hoverColor : button->color;
+
+    if (!SDL_SetRenderDrawColor(graphicsDataContext->renderer, buttonColor.r, buttonColor.g, buttonColor.b, buttonColor.a)) return false;
+    const SDL_FRect rect = FGridRectToFRect(graphicsDataContext, button->gridRect, 0.1f);
+    PROFILER_CountDrawCall();
+    if (!SDL_RenderFillRect(graphicsDataContext->renderer, &rect)) return false;
+
+    if (!RenderText(graphicsDataContext, button->gridRect, 0.25f, button->text, &button->cache, button->font, button->textColor)) return false;
+
+    return true;
 }
 
 SDL_FRect FGridRectToFRect(const GraphicsDataContext* graphicsDataContext, const FGridRect gridRect, const float margin)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
 
+    // The window's alignment grid is the scaled grid starting at the window's corner
+    const ScaledGrid grid = { 0, 0, graphicsDataContext->gridSquareSize };
+    return ScaledGridRectToFRect(grid, gridRect, margin);
+}
+
+SDL_FRect ScaledGridRectToFRect(const ScaledGrid grid, const FGridRect gridRect, const float margin)
+{
     Assert((margin * 2) < gridRect.w, "Invalid margin!\n");
     Assert((margin * 2) < gridRect.h, "Invalid margin!\n");
 
     const SDL_FRect rect = {
-    (gridRect.x + margin) * graphicsDataContext->gridSquareSize,
-    (gridRect.y + margin) * graphicsDataContext->gridSquareSize,
-    (gridRect.w - margin * 2) * graphicsDataContext->gridSquareSize,
-    (gridRect.h - margin * 2) * graphicsDataContext->gridSquareSize
+    grid.x + (gridRect.x + margin) * grid.squareSize,
+    grid.y + (gridRect.y + margin) * grid.squareSize,
+    (gridRect.w - margin * 2) * grid.squareSize,
+    (gridRect.h - margin * 2) * grid.squareSize
     };
 
     return rect;
 }
 
+ScaledGrid FitScaledGrid(const SDL_FRect bounds, const float gridWidth, const float gridHeight)
+{
+    const float widthBasedSize = bounds.w / gridWidth;
+    const float heightBasedSize = bounds.h / gridHeight;
+    const float squareSize = (widthBasedSize < heightBasedSize) ? widthBasedSize : heightBasedSize;
+
+    const ScaledGrid grid = {
+        bounds.x + (bounds.w - gridWidth * squareSize) / 2,
+        bounds.y + (bounds.h - gridHeight * squareSize) / 2,
+        squareSize
+    };
+
+    return grid;
+}
+
 SDL_Texture* GenerateTextTexture(const GraphicsDataContext* graphicsDataContext, const char* text, TextCache* cache, TTF_Font* font, const SDL_Color color)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
@@ -450,16 +833,23 @@ SDL_Texture* GenerateTextTexture(const GraphicsDataContext* graphicsDataContext,
     if (cache->valid && !strcmp(text, cache->text))
     {
         SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Cache hit! Returning cached texture...");
+        METRICS_Add(METRIC_TEXT_CACHE_HITS, 1);
         return cache->texture;
     }
 
     // Cache miss
     SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Cache miss! Generating new texture and cache object...");
+    PROFILER_BeginStage(PROFILER_STAGE_TEXT_CACHE_MISS);
+    METRICS_Add(METRIC_TEXT_CACHE_MISSES, 1);
 
+    METRICS_AddGauge(METRIC_GAUGE_TEXTURE_BYTES, -GetTextureBytes(cache->texture));
     SDL_DestroyTexture(cache->texture);
     SDL_Surface* surface = TTF_RenderText_Blended(font, text, 0, color);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(graphicsDataContext->renderer, surface);
     SDL_DestroySurface(surface);
+    METRICS_AddGauge(METRIC_GAUGE_TEXTURE_BYTES, GetTextureBytes(texture));
+
+    PROFILER_EndStage(PROFILER_STAGE_TEXT_CACHE_MISS);
 
     if (memcpy(cache->text, text, MAX_STRING_LENGTH) == NULL)
     {
@@ -470,4 +860,11 @@ SDL_Texture* GenerateTextTexture(const GraphicsDataContext* graphicsDataContext,
     cache->valid = true;
 
     return texture;
-}
\ No newline at end of file
+}
+
+Sint64 GetTextureBytes(const SDL_Texture* texture)
+{
+    if (!texture) return 0;
+
+    return (Sint64)texture->w * (Sint64)texture->h * 4;
+}
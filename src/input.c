@@ -0,0 +1,171 @@
+#include "input.h"
+
+#include "game.h"
+
+/**
+ * @brief Map a key to the action it auto-repeats.
+ *
+ * @param key The key code.
+ *
+ * @return The action, or INPUT_ACTION_COUNT if the key does not auto-repeat.
+ */
+static InputAction GetInputAction(const SDL_Keycode key)
+{
+    switch (key)
+    {
+    case SDLK_A:
+    case SDLK_LEFT:
+        return INPUT_ACTION_LEFT;
+    case SDLK_D:
+    case SDLK_RIGHT:
+        return INPUT_ACTION_RIGHT;
+    case SDLK_S:
+    case SDLK_DOWN:
+        return INPUT_ACTION_SOFT_DROP;
+    default:
+        return INPUT_ACTION_COUNT;
+    }
+}
+
+/**
+ * @brief Apply an action to the dropping tetromino a number of times.
+ *
+ * @param gameDataContext A struct containing the game data context.
+ * @param action The action to apply.
+ * @param count The number of times to apply it.
+ */
+static void ApplyAction(GameDataContext* gameDataContext, const InputAction action, Uint64 count)
+{
+    // No move can be repeated more times than there are cells to move across
+    if (count > ARENA_HEIGHT) count = ARENA_HEIGHT;
+
+    for (Uint64 i = 0; i < count; i++)
+    {
+        switch (action)
+        {
+        case INPUT_ACTION_LEFT:
+            ShiftTetromino(gameDataContext, -1);
+            break;
+        case INPUT_ACTION_RIGHT:
+            ShiftTetromino(gameDataContext, 1);
+            break;
+        case INPUT_ACTION_SOFT_DROP:
+            SoftDropTetromino(gameDataContext);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Apply every repeat of a single action that has become due by a given time.
+ *
+ * @param inputState A struct containing the input state.
+ * @param gameDataContext A struct containing the game data context.
+ * @param action The action to repeat.
+ * @param timestamp The time (in nanoseconds) to apply repeats up to.
+ */
+static void ApplyRepeats(InputState* inputState, GameDataContext* gameDataContext, const InputAction action, const Uint64 timestamp)
+{
+    HeldKey* heldKey = &inputState->keys[action];
+    if (!heldKey->isHeld) return;
+
+    // Only the most recently pressed shift direction repeats
+    if (action != INPUT_ACTION_SOFT_DROP && action != inputState->activeShift) return;
+
+    // Soft drop has no initial delay, it simply repeats at its own rate
+    const Uint64 delayNS = (action == INPUT_ACTION_SOFT_DROP) ? inputState->settings.softDropRateNS : inputState->settings.delayedAutoShiftNS;
+    const Uint64 rateNS = (action == INPUT_ACTION_SOFT_DROP) ? inputState->settings.softDropRateNS : inputState->settings.autoRepeatRateNS;
+
+    if (timestamp < heldKey->pressTimestamp + delayNS) return;
+
+    // Repeats that fall due while the game is paused or over are dropped, rather than all applied on resume
+    const bool canMove = !gameDataContext->isPaused && !gameDataContext->isGameOver;
+
+    // A rate of zero moves as far as possible every update, so that newly spawned tetrominoes are moved too
+    if (rateNS == 0)
+    {
+        if (canMove) ApplyAction(gameDataContext, action, ARENA_HEIGHT);
+        return;
+    }
+
+    const Uint64 repeatsDue = 1 + (timestamp - heldKey->pressTimestamp - delayNS) / rateNS;
+    if (repeatsDue <= heldKey->repeatsApplied) return;
+
+    if (canMove)
+    {
+        SDL_LogTrace(SDL_LOG_CATEGORY_INPUT, "Applying %d repeats of action %d...", (int)(repeatsDue - heldKey->repeatsApplied), action);
+        ApplyAction(gameDataContext, action, repeatsDue - heldKey->repeatsApplied);
+    }
+
+    heldKey->repeatsApplied = repeatsDue;
+}
+
+void INPUT_Init(InputState* inputState, const InputSettings* settings)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_INPUT, "Calling %s...", __func__);
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_INPUT, "Input settings: DAS=%dms, ARR=%dms, soft drop rate=%dms.",
+        (int)SDL_NS_TO_MS(settings->delayedAutoShiftNS),
+        (int)SDL_NS_TO_MS(settings->autoRepeatRateNS),
+        (int)SDL_NS_TO_MS(settings->softDropRateNS));
+
+    memset(inputState, 0, sizeof(*inputState));
+    inputState->settings = *settings;
+    inputState->activeShift = INPUT_ACTION_RIGHT;
+}
+
+bool INPUT_HandleKeyEvent(InputState* inputState, GameDataContext* gameDataContext, const SDL_KeyboardEvent* event)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_INPUT, "Calling %s...", __func__);
+
+    const InputAction action = GetInputAction(event->key);
+    if (action == INPUT_ACTION_COUNT) return false;
+
+    // Repeats are generated from the timestamps, so the operating system's key repeat events are ignored
+    if (event->repeat) return true;
+
+    HeldKey* heldKey = &inputState->keys[action];
+
+    if (event->down)
+    {
+        if (heldKey->isHeld) return true;
+
+        // Catch up on everything that was due before this press, so events are applied in timestamp order
+        for (int i = 0; i < INPUT_ACTION_COUNT; i++) ApplyRepeats(inputState, gameDataContext, (InputAction)i, event->timestamp);
+
+        *heldKey = (HeldKey){ true, event->timestamp, 0 };
+        if (action != INPUT_ACTION_SOFT_DROP) inputState->activeShift = action;
+
+        ApplyAction(gameDataContext, action, 1);
+        return true;
+    }
+
+    if (!heldKey->isHeld) return true;
+
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) ApplyRepeats(inputState, gameDataContext, (InputAction)i, event->timestamp);
+    heldKey->isHeld = false;
+
+    // If the other shift key is still held, it takes over, charging its DAS from this release
+    if (action == inputState->activeShift)
+    {
+        const InputAction otherShift = (action == INPUT_ACTION_LEFT) ? INPUT_ACTION_RIGHT : INPUT_ACTION_LEFT;
+        HeldKey* otherKey = &inputState->keys[otherShift];
+        if (otherKey->isHeld)
+        {
+            inputState->activeShift = otherShift;
+            otherKey->pressTimestamp = event->timestamp;
+            otherKey->repeatsApplied = 0;
+        }
+    }
+
+    return true;
+}
+
+void INPUT_Update(InputState* inputState, GameDataContext* gameDataContext, const Uint64 timestamp)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_INPUT, "Calling %s...", __func__);
+
+    for (int i = 0; i < INPUT_ACTION_COUNT; i++) ApplyRepeats(inputState, gameDataContext, (InputAction)i, timestamp);
+}
@@ -0,0 +1,109 @@
+#include "latency.h"
+
+/**
+ * @brief Compare two Uint64 values, for use with SDL_qsort.
+ *
+ * @param a A pointer to the first value.
+ * @param b A pointer to the second value.
+ *
+ * @return A negative, zero or positive value if a is less than, equal to, or greater than b, respectively.
+ */
+static int CompareUint64(const void* a, const void* b)
+{
+    const Uint64 x = *(const Uint64*)a;
+    const Uint64 y = *(const Uint64*)b;
+    return (x > y) - (x < y);
+}
+
+void LATENCY_CalculateStats(const Uint64* samples, const int count, Uint64* sortBuffer, LatencyStats* stats)
+{
+    *stats = (LatencyStats){ 0 };
+    if (count <= 0) return;
+
+    memcpy(sortBuffer, samples, (size_t)count * sizeof(samples[0]));
+    SDL_qsort(sortBuffer, (size_t)count, sizeof(sortBuffer[0]), CompareUint64);
+
+    stats->count = count;
+    stats->p50 = sortBuffer[(count - 1) * 50 / 100];
+    stats->p90 = sortBuffer[(count - 1) * 90 / 100];
+    stats->p99 = sortBuffer[(count - 1) * 99 / 100];
+    stats->max = sortBuffer[count - 1];
+}
+
+void LATENCY_Init(LatencyTracker* latencyTracker, const bool isEnabled)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    memset(latencyTracker, 0, sizeof(*latencyTracker));
+    latencyTracker->isEnabled = isEnabled;
+}
+
+void LATENCY_TagInput(LatencyTracker* latencyTracker, const Uint64 eventTimestamp)
+{
+    if (!latencyTracker->isEnabled) return;
+
+    if (latencyTracker->pendingCount >= LATENCY_PENDING_CAPACITY)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Too many inputs are waiting to be presented, dropping latency sample!");
+        return;
+    }
+
+    latencyTracker->pending[latencyTracker->pendingCount++] = (PendingInput){ eventTimestamp, 0 };
+}
+
+void LATENCY_MarkApplied(LatencyTracker* latencyTracker, const Uint64 lastEventTimestamp, const Uint64 timestamp)
+{
+    if (!latencyTracker->isEnabled) return;
+
+    for (int i = 0; i < latencyTracker->pendingCount; i++)
+    {
+        PendingInput* input = &latencyTracker->pending[i];
+        if (input->appliedTimestamp == 0 && input->eventTimestamp <= lastEventTimestamp) input->appliedTimestamp = timestamp;
+    }
+}
+
+void LATENCY_MarkPresented(LatencyTracker* latencyTracker, const Uint64 timestamp)
+{
+    if (!latencyTracker->isEnabled) return;
+
+    int remaining = 0;
+    for (int i = 0; i < latencyTracker->pendingCount; i++)
+    {
+        const PendingInput input = latencyTracker->pending[i];
+
+        // Inputs that have not been applied yet are not part of this frame, so keep waiting for the next one
+        if (input.appliedTimestamp == 0)
+        {
+            latencyTracker->pending[remaining++] = input;
+            continue;
+        }
+
+        latencyTracker->appliedLatencies[latencyTracker->nextSample] = input.appliedTimestamp - input.eventTimestamp;
+        latencyTracker->presentedLatencies[latencyTracker->nextSample] = timestamp - input.eventTimestamp;
+        latencyTracker->nextSample = (latencyTracker->nextSample + 1) % LATENCY_SAMPLE_CAPACITY;
+        if (latencyTracker->sampleCount < LATENCY_SAMPLE_CAPACITY) latencyTracker->sampleCount++;
+    }
+
+    latencyTracker->pendingCount = remaining;
+}
+
+void LATENCY_GetStats(LatencyTracker* latencyTracker, LatencyStats* applied, LatencyStats* presented)
+{
+    LATENCY_CalculateStats(latencyTracker->appliedLatencies, latencyTracker->sampleCount, latencyTracker->sortBuffer, applied);
+    LATENCY_CalculateStats(latencyTracker->presentedLatencies, latencyTracker->sampleCount, latencyTracker->sortBuffer, presented);
+}
+
+void LATENCY_LogStats(LatencyTracker* latencyTracker)
+{
+    if (!latencyTracker->isEnabled) return;
+
+    LatencyStats applied;
+    LatencyStats presented;
+    LATENCY_GetStats(latencyTracker, &applied, &presented);
+
+    SDL_Log("Input latency over %d inputs (ms):", presented.count);
+    SDL_Log("  input->applied: p50=%.3f p90=%.3f p99=%.3f max=%.3f",
+        (double)applied.p50 / SDL_NS_PER_MS, (double)applied.p90 / SDL_NS_PER_MS, (double)applied.p99 / SDL_NS_PER_MS, (double)applied.max / SDL_NS_PER_MS);
+    SDL_Log("  input->present: p50=%.3f p90=%.3f p99=%.3f max=%.3f",
+        (double)presented.p50 / SDL_NS_PER_MS, (double)presented.p90 / SDL_NS_PER_MS, (double)presented.p99 / SDL_NS_PER_MS, (double)presented.max / SDL_NS_PER_MS);
+}
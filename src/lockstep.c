@@ -0,0 +1,943 @@
+#include "lockstep.h"
+
+/**
+ * @brief The tetromino of every lane in a group, moved and rotated for a collision check.
+ */
+typedef struct LockstepPiece
+{
+    /** @brief The row masks of each lane's tetromino, from the top of its matrix, shifted to its column. */
+    Uint16 rows[TETROMINO_MAX_SIZE][LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The arena row of the top of each lane's tetromino matrix. */
+    Sint16 top[LOCKSTEP_GROUP_SIZE];
+
+    /** @brief 0xFFFF for each lane whose tetromino has a cell left or right of the arena, 0 otherwise. */
+    Uint16 isOutside[LOCKSTEP_GROUP_SIZE];
+
+    /** @brief The range of arena rows that any lane's tetromino matrix covers, which is empty if firstRow > lastRow. */
+    int firstRow;
+    int lastRow;
+} LockstepPiece;
+
+/**
+ * @brief Shift a 4-bit tetromino row mask to a column, noting whether any of its cells fall outside the arena.
+ *
+ * @param row The row mask, with bit j set for column j of the tetromino matrix.
+ * @param x The arena column of the left of the tetromino matrix.
+ * @param isOutside A pointer to set to 0xFFFF if a cell falls outside the arena.
+ *
+ * @return The row mask in arena columns, without any cells outside the arena.
+ */
+static Uint16 ShiftPieceRow(const Uint8 row, const int x, Uint16* isOutside)
+{
+    if (row == 0) return 0;
+
+    if (x <= -TETROMINO_MAX_SIZE || x >= ARENA_WIDTH)
+    {
+        *isOutside = 0xFFFF;
+        return 0;
+    }
+
+    if (x < 0)
+    {
+        if (row & ((1u << -x) - 1)) *isOutside = 0xFFFF;
+        return (Uint16)(row >> -x);
+    }
+
+    const Uint32 shifted = (Uint32)row << x;
+    if (shifted & ~(Uint32)LOCKSTEP_FULL_ROW) *isOutside = 0xFFFF;
+    return (Uint16)(shifted & LOCKSTEP_FULL_ROW);
+}
+
+/**
+ * @brief Recompute the cached row masks of a lane's dropping tetromino after it moves.
+ *
+ * @param boards A pointer to the boards.
+ * @param group A pointer to the group.
+ * @param lane The lane.
+ */
+static void UpdatePieceRows(const LockstepBoards* boards, LockstepGroup* group, const int lane)
+{
+    // A dropping tetromino is always inside the arena, so there is nothing to note
+    Uint16 isOutside = 0;
+    const Uint8* shapeRows = boards->shapeRows[group->identifier[lane]][group->orientation[lane] & 3];
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++) group->pieceRows[i][lane] = ShiftPieceRow(shapeRows[i], group->x[lane], &isOutside);
+}
+
+/**
+ * @brief Move and rotate the tetromino of every lane in a group by the same amounts.
+ *
+ * @param boards A pointer to the boards.
+ * @param group A pointer to the group.
+ * @param translationX How far to move each tetromino horizontally.
+ * @param translationY How far to move each tetromino vertically.
+ * @param rotationAmount How many quarter turns clockwise to rotate each tetromino.
+ * @param piece A pointer to the piece to write to.
+ */
+static void PreparePiece(const LockstepBoards* boards, const LockstepGroup* group, const int translationX, const int translationY, const int rotationAmount, LockstepPiece* piece)
+{
+    int minTop = ARENA_HEIGHT;
+    int maxTop = -TETROMINO_MAX_SIZE;
+
+    for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++)
+    {
+        const Uint8* shapeRows = boards->shapeRows[group->identifier[lane]][(group->orientation[lane] + rotationAmount) & 3];
+        const int x = group->x[lane] + translationX;
+        const int top = group->y[lane] + translationY;
+
+        piece->isOutside[lane] = 0;
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++) piece->rows[i][lane] = ShiftPieceRow(shapeRows[i], x, &piece->isOutside[lane]);
+        piece->top[lane] = (Sint16)top;
+
+        if (top < minTop) minTop = top;
+        if (top > maxTop) maxTop = top;
+    }
+
+    piece->firstRow = SDL_max(minTop, 0);
+    piece->lastRow = SDL_min(maxTop + TETROMINO_MAX_SIZE - 1, ARENA_HEIGHT - 1);
+}
+
+/**
+ * @brief Find the highest and lowest dropping tetromino among a group's lanes in play.
+ *
+ * @param group A pointer to the group.
+ * @param minTop A pointer to write the highest arena row the top of a tetromino matrix is on to.
+ * @param maxTop A pointer to write the lowest arena row the top of a tetromino matrix is on to.
+ *
+ * @return True if any lane is in play, false otherwise.
+ */
+static bool GetPlayingTops(const LockstepGroup* group, int* minTop, int* maxTop)
+{
+    *minTop = ARENA_HEIGHT;
+    *maxTop = -TETROMINO_MAX_SIZE;
+
+    for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++)
+    {
+        if (!group->isPlaying[lane]) continue;
+        if (group->y[lane] < *minTop) *minTop = group->y[lane];
+        if (group->y[lane] > *maxTop) *maxTop = group->y[lane];
+    }
+
+    return *minTop < ARENA_HEIGHT;
+}
+
+/**
+ * @brief Copy the dropping tetromino of every lane in a group where it is, for a collision check.
+ *
+ * @param group A pointer to the group.
+ * @param minTop The highest arena row the top of a tetromino matrix is on.
+ * @param maxTop The lowest arena row the top of a tetromino matrix is on.
+ * @param piece A pointer to the piece to write to.
+ */
+static void CopyPiece(const LockstepGroup* group, const int minTop, const int maxTop, LockstepPiece* piece)
+{
+    SDL_memcpy(piece->rows, group->pieceRows, sizeof(piece->rows));
+    SDL_memcpy(piece->top, group->y, sizeof(piece->top));
+    SDL_memset(piece->isOutside, 0, sizeof(piece->isOutside));
+    piece->firstRow = SDL_max(minTop, 0);
+    piece->lastRow = SDL_min(maxTop + TETROMINO_MAX_SIZE - 1, ARENA_HEIGHT - 1);
+}
+
+/**
+ * @brief Check whether a single lane's tetromino overlaps the arena bounds or stack.
+ *
+ * @param group A pointer to the group.
+ * @param lane The lane.
+ * @param pieceRows The row masks of the lane's tetromino, LOCKSTEP_GROUP_SIZE apart.
+ * @param top The arena row of the top of the tetromino matrix.
+ *
+ * @return True if the tetromino collides, false otherwise.
+ */
+static bool CollidesScalar(const LockstepGroup* group, const int lane, const Uint16* pieceRows, const int top)
+{
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        const Uint16 pieceRow = pieceRows[i * LOCKSTEP_GROUP_SIZE];
+        if (!pieceRow) continue;
+
+        const int row = top + i;
+        if (row < 0 || row >= ARENA_HEIGHT || (group->rows[row][lane] & pieceRow)) return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Remove every filled row from a single lane's arena in one pass, as ClearLines does.
+ *
+ * @param group A pointer to the group.
+ * @param lane The lane.
+ */
+static void ClearRowsScalar(LockstepGroup* group, const int lane)
+{
+    int filledRows = 0;
+    for (int row = ARENA_HEIGHT - 1; row >= 0; row--)
+    {
+        if (group->rows[row][lane] == LOCKSTEP_FULL_ROW) filledRows++;
+        else if (filledRows > 0) group->rows[row + filledRows][lane] = group->rows[row][lane];
+    }
+
+    for (int row = 0; row < filledRows; row++) group->rows[row][lane] = 0;
+    group->linesCleared[lane] += (Uint16)filledRows;
+}
+
+/**
+ * @brief Check every lane of a group for collisions, one lane at a time.
+ *
+ * @param group A pointer to the group.
+ * @param piece A pointer to the moved tetrominoes.
+ * @param hits The array to write whether each lane collides to, as 0xFFFF or 0.
+ */
+static void CollideGroupScalar(const LockstepGroup* group, const LockstepPiece* piece, Uint16 hits[LOCKSTEP_GROUP_SIZE])
+{
+    for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++)
+    {
+        hits[lane] = (piece->isOutside[lane] || CollidesScalar(group, lane, &piece->rows[0][lane], piece->top[lane])) ? 0xFFFF : 0;
+    }
+}
+
+/**
+ * @brief Drop the tetromino of every lane in play of a group, one lane at a time.
+ *
+ * @param group A pointer to the group.
+ */
+static void DropGroupScalar(LockstepGroup* group)
+{
+    for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++)
+    {
+        if (!group->isPlaying[lane]) continue;
+        while (!CollidesScalar(group, lane, &group->pieceRows[0][lane], group->y[lane] + 1)) group->y[lane]++;
+    }
+}
+
+/**
+ * @brief Lock the tetromino of every lane in play of a group into its arena and clear filled rows, one lane at a time.
+ *
+ * @param group A pointer to the group.
+ */
+static void LockGroupScalar(LockstepGroup* group)
+{
+    for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++)
+    {
+        if (!group->isPlaying[lane]) continue;
+
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+        {
+            const int row = group->y[lane] + i;
+            if (row >= 0 && row < ARENA_HEIGHT) group->rows[row][lane] |= group->pieceRows[i][lane];
+        }
+
+        ClearRowsScalar(group, lane);
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+/**
+ * @brief Find which of 8 lanes' tetrominoes overlap the arena bounds or stack.
+ *
+ * @param group A pointer to the group.
+ * @param firstLane The first of the 8 lanes.
+ * @param pieceRows The row masks of each lane's tetromino.
+ * @param top The arena row of the top of each lane's tetromino matrix.
+ * @param hits The collisions found so far, which are kept.
+ * @param firstRow The first arena row any tetromino covers.
+ * @param lastRow The last arena row any tetromino covers.
+ *
+ * @return Each lane's collisions, which are non-zero for a lane that collides.
+ */
+SDL_TARGETING("sse2") static __m128i CollideSSE2(const LockstepGroup* group, const int firstLane, const __m128i pieceRows[TETROMINO_MAX_SIZE], const __m128i top, __m128i hits, const int firstRow, const int lastRow)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lastArenaRow = _mm_set1_epi16(ARENA_HEIGHT - 1);
+
+    // A cell above or below the arena collides with its bounds
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        const __m128i row = _mm_add_epi16(top, _mm_set1_epi16((short)i));
+        const __m128i isOutside = _mm_or_si128(_mm_cmpgt_epi16(zero, row), _mm_cmpgt_epi16(row, lastArenaRow));
+        hits = _mm_or_si128(hits, _mm_and_si128(isOutside, pieceRows[i]));
+    }
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        // Pick out the tetromino row of each lane that lies on this arena row, if any
+        const __m128i offset = _mm_sub_epi16(_mm_set1_epi16((short)row), top);
+        __m128i pieceRow = _mm_and_si128(_mm_cmpeq_epi16(offset, zero), pieceRows[0]);
+        for (int i = 1; i < TETROMINO_MAX_SIZE; i++) pieceRow = _mm_or_si128(pieceRow, _mm_and_si128(_mm_cmpeq_epi16(offset, _mm_set1_epi16((short)i)), pieceRows[i]));
+
+        hits = _mm_or_si128(hits, _mm_and_si128(pieceRow, _mm_loadu_si128((const __m128i*)&group->rows[row][firstLane])));
+    }
+
+    return hits;
+}
+
+/**
+ * @brief Check every lane of a group for collisions, 8 lanes at a time.
+ *
+ * @param group A pointer to the group.
+ * @param piece A pointer to the moved tetrominoes.
+ * @param hits The array to write whether each lane collides to, as 0xFFFF or 0.
+ */
+SDL_TARGETING("sse2") static void CollideGroupSSE2(const LockstepGroup* group, const LockstepPiece* piece, Uint16 hits[LOCKSTEP_GROUP_SIZE])
+{
+    for (int firstLane = 0; firstLane < LOCKSTEP_GROUP_SIZE; firstLane += 8)
+    {
+        __m128i pieceRows[TETROMINO_MAX_SIZE];
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm_loadu_si128((const __m128i*)&piece->rows[i][firstLane]);
+
+        const __m128i top = _mm_loadu_si128((const __m128i*)&piece->top[firstLane]);
+        const __m128i isOutside = _mm_loadu_si128((const __m128i*)&piece->isOutside[firstLane]);
+        const __m128i laneHits = CollideSSE2(group, firstLane, pieceRows, top, isOutside, piece->firstRow, piece->lastRow);
+
+        _mm_storeu_si128((__m128i*)&hits[firstLane], _mm_xor_si128(_mm_cmpeq_epi16(laneHits, _mm_setzero_si128()), _mm_set1_epi16(-1)));
+    }
+}
+
+/**
+ * @brief Drop the tetromino of every lane in play of a group, moving 8 lanes down a row at a time.
+ *
+ * @param group A pointer to the group.
+ * @param minTop The highest arena row the top of a tetromino matrix in play is on.
+ * @param maxTop The lowest arena row the top of a tetromino matrix in play is on.
+ */
+SDL_TARGETING("sse2") static void DropGroupSSE2(LockstepGroup* group, const int minTop, const int maxTop)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    for (int firstLane = 0; firstLane < LOCKSTEP_GROUP_SIZE; firstLane += 8)
+    {
+        __m128i pieceRows[TETROMINO_MAX_SIZE];
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm_loadu_si128((const __m128i*)&group->pieceRows[i][firstLane]);
+
+        __m128i isMoving = _mm_loadu_si128((const __m128i*)&group->isPlaying[firstLane]);
+        __m128i y = _mm_loadu_si128((const __m128i*)&group->y[firstLane]);
+
+        // Every lane still moving has moved down once per step, so only the rows just below them need checking
+        for (int step = 1;; step++)
+        {
+            const __m128i below = _mm_add_epi16(y, _mm_set1_epi16(1));
+            const int firstRow = SDL_max(minTop + step, 0);
+            const int lastRow = SDL_min(maxTop + step + TETROMINO_MAX_SIZE - 1, ARENA_HEIGHT - 1);
+            const __m128i hits = CollideSSE2(group, firstLane, pieceRows, below, zero, firstRow, lastRow);
+
+            // A moving lane is all ones, so subtracting it moves the lane down a row, and a lane that stops stays put
+            isMoving = _mm_and_si128(_mm_cmpeq_epi16(hits, zero), isMoving);
+            if (_mm_movemask_epi8(isMoving) == 0) break;
+            y = _mm_sub_epi16(y, isMoving);
+        }
+
+        _mm_storeu_si128((__m128i*)&group->y[firstLane], y);
+    }
+}
+
+/**
+ * @brief Lock the tetromino of every lane in play of a group into its arena and clear filled rows, 8 lanes at a time.
+ *
+ * @param group A pointer to the group.
+ * @param firstRow The first arena row any tetromino in play covers.
+ * @param lastRow The last arena row any tetromino in play covers.
+ */
+SDL_TARGETING("sse2") static void LockGroupSSE2(LockstepGroup* group, const int firstRow, const int lastRow)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i fullRow = _mm_set1_epi16(LOCKSTEP_FULL_ROW);
+
+    for (int firstLane = 0; firstLane < LOCKSTEP_GROUP_SIZE; firstLane += 8)
+    {
+        const __m128i isPlaying = _mm_loadu_si128((const __m128i*)&group->isPlaying[firstLane]);
+        const __m128i top = _mm_loadu_si128((const __m128i*)&group->y[firstLane]);
+
+        __m128i pieceRows[TETROMINO_MAX_SIZE];
+        for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm_and_si128(_mm_loadu_si128((const __m128i*)&group->pieceRows[i][firstLane]), isPlaying);
+
+        for (int row = firstRow; row <= lastRow; row++)
+        {
+            const __m128i offset = _mm_sub_epi16(_mm_set1_epi16((short)row), top);
+            __m128i pieceRow = _mm_and_si128(_mm_cmpeq_epi16(offset, zero), pieceRows[0]);
+            for (int i = 1; i < TETROMINO_MAX_SIZE; i++) pieceRow = _mm_or_si128(pieceRow, _mm_and_si128(_mm_cmpeq_epi16(offset, _mm_set1_epi16((short)i)), pieceRows[i]));
+
+            __m128i* arenaRow = (__m128i*)&group->rows[row][firstLane];
+            _mm_storeu_si128(arenaRow, _mm_or_si128(_mm_loadu_si128(arenaRow), pieceRow));
+        }
+
+        __m128i linesCleared = _mm_loadu_si128((const __m128i*)&group->linesCleared[firstLane]);
+        for (;;)
+        {
+            // A lane clears a row while it has any filled row, as ClearLines clears every one of them
+            __m128i isClearing = zero;
+            for (int row = 0; row < ARENA_HEIGHT; row++)
+            {
+                isClearing = _mm_or_si128(isClearing, _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)&group->rows[row][firstLane]), fullRow));
+            }
+            isClearing = _mm_and_si128(isClearing, isPlaying);
+            if (_mm_movemask_epi8(isClearing) == 0) break;
+
+            // Remove the lowest filled row of each clearing lane, moving every row above it down one
+            __m128i isBelowClear = zero;
+            for (int row = ARENA_HEIGHT - 1; row >= 0; row--)
+            {
+                __m128i* arenaRow = (__m128i*)&group->rows[row][firstLane];
+                const __m128i current = _mm_loadu_si128(arenaRow);
+                const __m128i above = (row > 0) ? _mm_loadu_si128((const __m128i*)&group->rows[row - 1][firstLane]) : zero;
+
+                isBelowClear = _mm_or_si128(isBelowClear, _mm_and_si128(_mm_cmpeq_epi16(current, fullRow), isClearing));
+                _mm_storeu_si128(arenaRow, _mm_or_si128(_mm_and_si128(isBelowClear, above), _mm_andnot_si128(isBelowClear, current)));
+            }
+
+            linesCleared = _mm_sub_epi16(linesCleared, isClearing);
+        }
+
+        _mm_storeu_si128((__m128i*)&group->linesCleared[firstLane], linesCleared);
+    }
+}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+/**
+ * @brief Find which of a group's 16 lanes' tetrominoes overlap the arena bounds or stack.
+ *
+ * @param group A pointer to the group.
+ * @param pieceRows The row masks of each lane's tetromino.
+ * @param top The arena row of the top of each lane's tetromino matrix.
+ * @param hits The collisions found so far, which are kept.
+ * @param firstRow The first arena row any tetromino covers.
+ * @param lastRow The last arena row any tetromino covers.
+ *
+ * @return Each lane's collisions, which are non-zero for a lane that collides.
+ */
+SDL_TARGETING("avx2") static __m256i CollideAVX2(const LockstepGroup* group, const __m256i pieceRows[TETROMINO_MAX_SIZE], const __m256i top, __m256i hits, const int firstRow, const int lastRow)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lastArenaRow = _mm256_set1_epi16(ARENA_HEIGHT - 1);
+
+    // A cell above or below the arena collides with its bounds
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        const __m256i row = _mm256_add_epi16(top, _mm256_set1_epi16((short)i));
+        const __m256i isOutside = _mm256_or_si256(_mm256_cmpgt_epi16(zero, row), _mm256_cmpgt_epi16(row, lastArenaRow));
+        hits = _mm256_or_si256(hits, _mm256_and_si256(isOutside, pieceRows[i]));
+    }
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        // Pick out the tetromino row of each lane that lies on this arena row, if any
+        const __m256i offset = _mm256_sub_epi16(_mm256_set1_epi16((short)row), top);
+        __m256i pieceRow = _mm256_and_si256(_mm256_cmpeq_epi16(offset, zero), pieceRows[0]);
+        for (int i = 1; i < TETROMINO_MAX_SIZE; i++) pieceRow = _mm256_or_si256(pieceRow, _mm256_and_si256(_mm256_cmpeq_epi16(offset, _mm256_set1_epi16((short)i)), pieceRows[i]));
+
+        hits = _mm256_or_si256(hits, _mm256_and_si256(pieceRow, _mm256_loadu_si256((const __m256i*)group->rows[row])));
+    }
+
+    return hits;
+}
+
+/**
+ * @brief Check every lane of a group for collisions, 16 lanes at a time.
+ *
+ * @param group A pointer to the group.
+ * @param piece A pointer to the moved tetrominoes.
+ * @param hits The array to write whether each lane collides to, as 0xFFFF or 0.
+ */
+SDL_TARGETING("avx2") static void CollideGroupAVX2(const LockstepGroup* group, const LockstepPiece* piece, Uint16 hits[LOCKSTEP_GROUP_SIZE])
+{
+    __m256i pieceRows[TETROMINO_MAX_SIZE];
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm256_loadu_si256((const __m256i*)piece->rows[i]);
+
+    const __m256i top = _mm256_loadu_si256((const __m256i*)piece->top);
+    const __m256i isOutside = _mm256_loadu_si256((const __m256i*)piece->isOutside);
+    const __m256i laneHits = CollideAVX2(group, pieceRows, top, isOutside, piece->firstRow, piece->lastRow);
+
+    _mm256_storeu_si256((__m256i*)hits, _mm256_xor_si256(_mm256_cmpeq_epi16(laneHits, _mm256_setzero_si256()), _mm256_set1_epi16(-1)));
+}
+
+/**
+ * @brief Drop the tetromino of every lane in play of a group, moving all 16 lanes down a row at a time.
+ *
+ * @param group A pointer to the group.
+ * @param minTop The highest arena row the top of a tetromino matrix in play is on.
+ * @param maxTop The lowest arena row the top of a tetromino matrix in play is on.
+ */
+SDL_TARGETING("avx2") static void DropGroupAVX2(LockstepGroup* group, const int minTop, const int maxTop)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i pieceRows[TETROMINO_MAX_SIZE];
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm256_loadu_si256((const __m256i*)group->pieceRows[i]);
+
+    __m256i isMoving = _mm256_loadu_si256((const __m256i*)group->isPlaying);
+    __m256i y = _mm256_loadu_si256((const __m256i*)group->y);
+
+    // Every lane still moving has moved down once per step, so only the rows just below them need checking
+    for (int step = 1;; step++)
+    {
+        const __m256i below = _mm256_add_epi16(y, _mm256_set1_epi16(1));
+        const int firstRow = SDL_max(minTop + step, 0);
+        const int lastRow = SDL_min(maxTop + step + TETROMINO_MAX_SIZE - 1, ARENA_HEIGHT - 1);
+        const __m256i hits = CollideAVX2(group, pieceRows, below, zero, firstRow, lastRow);
+
+        // A moving lane is all ones, so subtracting it moves the lane down a row, and a lane that stops stays put
+        isMoving = _mm256_and_si256(_mm256_cmpeq_epi16(hits, zero), isMoving);
+        if (_mm256_testz_si256(isMoving, isMoving)) break;
+        y = _mm256_sub_epi16(y, isMoving);
+    }
+
+    _mm256_storeu_si256((__m256i*)group->y, y);
+}
+
+/**
+ * @brief Lock the tetromino of every lane in play of a group into its arena and clear filled rows, 16 lanes at a time.
+ *
+ * @param group A pointer to the group.
+ * @param firstRow The first arena row any tetromino in play covers.
+ * @param lastRow The last arena row any tetromino in play covers.
+ */
+SDL_TARGETING("avx2") static void LockGroupAVX2(LockstepGroup* group, const int firstRow, const int lastRow)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i fullRow = _mm256_set1_epi16(LOCKSTEP_FULL_ROW);
+    const __m256i isPlaying = _mm256_loadu_si256((const __m256i*)group->isPlaying);
+    const __m256i top = _mm256_loadu_si256((const __m256i*)group->y);
+
+    __m256i pieceRows[TETROMINO_MAX_SIZE];
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++) pieceRows[i] = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)group->pieceRows[i]), isPlaying);
+
+    for (int row = firstRow; row <= lastRow; row++)
+    {
+        const __m256i offset = _mm256_sub_epi16(_mm256_set1_epi16((short)row), top);
+        __m256i pieceRow = _mm256_and_si256(_mm256_cmpeq_epi16(offset, zero), pieceRows[0]);
+        for (int i = 1; i < TETROMINO_MAX_SIZE; i++) pieceRow = _mm256_or_si256(pieceRow, _mm256_and_si256(_mm256_cmpeq_epi16(offset, _mm256_set1_epi16((short)i)), pieceRows[i]));
+
+        __m256i* arenaRow = (__m256i*)group->rows[row];
+        _mm256_storeu_si256(arenaRow, _mm256_or_si256(_mm256_loadu_si256(arenaRow), pieceRow));
+    }
+
+    __m256i linesCleared = _mm256_loadu_si256((const __m256i*)group->linesCleared);
+    for (;;)
+    {
+        // A lane clears a row while it has any filled row, as ClearLines clears every one of them
+        __m256i isClearing = zero;
+        for (int row = 0; row < ARENA_HEIGHT; row++)
+        {
+            isClearing = _mm256_or_si256(isClearing, _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i*)group->rows[row]), fullRow));
+        }
+        isClearing = _mm256_and_si256(isClearing, isPlaying);
+        if (_mm256_testz_si256(isClearing, isClearing)) break;
+
+        // Remove the lowest filled row of each clearing lane, moving every row above it down one
+        __m256i isBelowClear = zero;
+        for (int row = ARENA_HEIGHT - 1; row >= 0; row--)
+        {
+            __m256i* arenaRow = (__m256i*)group->rows[row];
+            const __m256i current = _mm256_loadu_si256(arenaRow);
+            const __m256i above = (row > 0) ? _mm256_loadu_si256((const __m256i*)group->rows[row - 1]) : zero;
+
+            isBelowClear = _mm256_or_si256(isBelowClear, _mm256_and_si256(_mm256_cmpeq_epi16(current, fullRow), isClearing));
+            _mm256_storeu_si256(arenaRow, _mm256_blendv_epi8(current, above, isBelowClear));
+        }
+
+        linesCleared = _mm256_sub_epi16(linesCleared, isClearing);
+    }
+
+    _mm256_storeu_si256((__m256i*)group->linesCleared, linesCleared);
+}
+#endif
+
+/**
+ * @brief Check every lane of a group for collisions with the boards' implementation.
+ *
+ * @param boards A pointer to the boards.
+ * @param group A pointer to the group.
+ * @param piece A pointer to the moved tetrominoes.
+ * @param hits The array to write whether each lane collides to, as 0xFFFF or 0.
+ */
+static void CollideGroup(const LockstepBoards* boards, const LockstepGroup* group, const LockstepPiece* piece, Uint16 hits[LOCKSTEP_GROUP_SIZE])
+{
+    switch (boards->implementation)
+    {
+#ifdef SDL_AVX2_INTRINSICS
+    case LOCKSTEP_AVX2: CollideGroupAVX2(group, piece, hits); return;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+    case LOCKSTEP_SSE2: CollideGroupSSE2(group, piece, hits); return;
+#endif
+    default: CollideGroupScalar(group, piece, hits); return;
+    }
+}
+
+LockstepImplementation LOCKSTEP_GetBestImplementation(void)
+{
+#ifdef SDL_AVX2_INTRINSICS
+    if (SDL_HasAVX2()) return LOCKSTEP_AVX2;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+    if (SDL_HasSSE2()) return LOCKSTEP_SSE2;
+#endif
+    return LOCKSTEP_SCALAR;
+}
+
+const char* LOCKSTEP_GetImplementationName(const LockstepImplementation implementation)
+{
+    static const char* const IMPLEMENTATION_NAMES[LOCKSTEP_IMPLEMENTATION_COUNT] = { "scalar", "SSE2", "AVX2" };
+    return IMPLEMENTATION_NAMES[implementation];
+}
+
+bool LOCKSTEP_Init(LockstepBoards* boards, const int count, const LockstepImplementation implementation)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *boards = (LockstepBoards){ 0 };
+
+    if (count <= 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid lockstep board count %d!", count);
+        return false;
+    }
+
+    // Every implementation the CPU supports is no faster than the best one, so anything above that is unsupported
+    if (implementation > LOCKSTEP_GetBestImplementation())
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "The CPU does not support %s lockstep boards!", LOCKSTEP_GetImplementationName(implementation));
+        return false;
+    }
+
+    boards->count = count;
+    boards->groupCount = (count + LOCKSTEP_GROUP_SIZE - 1) / LOCKSTEP_GROUP_SIZE;
+    boards->implementation = implementation;
+
+    // Vector loads of a row never cross a cache line when the groups are aligned
+    boards->groups = SDL_aligned_alloc(32, (size_t)boards->groupCount * sizeof(LockstepGroup));
+    if (!boards->groups)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate %d lockstep boards!", count);
+        return false;
+    }
+    SDL_memset(boards->groups, 0, (size_t)boards->groupCount * sizeof(LockstepGroup));
+
+    for (int identifier = I; identifier <= TETROMINO_COUNT; identifier++)
+    {
+        const TetrominoShape* shape = GetTetrominoShapeByIdentifier((TetrominoIdentifier)identifier);
+        for (int orientation = 0; orientation < 4; orientation++)
+        {
+            for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+            {
+                Uint8 row = 0;
+                for (int j = 0; j < TETROMINO_MAX_SIZE; j++) row |= (Uint8)(shape->coordinates[orientation][i][j] << j);
+                boards->shapeRows[identifier][orientation][i] = row;
+            }
+        }
+    }
+
+    return true;
+}
+
+void LOCKSTEP_Destroy(LockstepBoards* boards)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_aligned_free(boards->groups);
+    *boards = (LockstepBoards){ 0 };
+}
+
+void LOCKSTEP_LoadGame(LockstepBoards* boards, const int index, const GameDataContext* gameDataContext)
+{
+    LockstepGroup* group = &boards->groups[index / LOCKSTEP_GROUP_SIZE];
+    const int lane = index % LOCKSTEP_GROUP_SIZE;
+
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        Uint16 rowMask = 0;
+        for (int col = 0; col < ARENA_WIDTH; col++) rowMask |= (Uint16)((gameDataContext->arena[row][col] != 0) << col);
+        group->rows[row][lane] = rowMask;
+    }
+
+    const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+    group->x[lane] = (Sint16)droppingTetromino->x;
+    group->y[lane] = (Sint16)droppingTetromino->y;
+    group->identifier[lane] = (Uint8)droppingTetromino->shape->identifier;
+    group->orientation[lane] = (Uint8)droppingTetromino->orientation;
+    group->isPlaying[lane] = gameDataContext->isGameOver ? 0 : 0xFFFF;
+    group->linesCleared[lane] = (Uint16)gameDataContext->linesCleared;
+    UpdatePieceRows(boards, group, lane);
+}
+
+void LOCKSTEP_GetRows(const LockstepBoards* boards, const int index, Uint16 rows[ARENA_HEIGHT])
+{
+    const LockstepGroup* group = &boards->groups[index / LOCKSTEP_GROUP_SIZE];
+    const int lane = index % LOCKSTEP_GROUP_SIZE;
+
+    for (int row = 0; row < ARENA_HEIGHT; row++) rows[row] = group->rows[row][lane];
+}
+
+void LOCKSTEP_SetPiece(LockstepBoards* boards, const int index, const int x, const int y, const int orientation)
+{
+    LockstepGroup* group = &boards->groups[index / LOCKSTEP_GROUP_SIZE];
+    const int lane = index % LOCKSTEP_GROUP_SIZE;
+
+    group->x[lane] = (Sint16)x;
+    group->y[lane] = (Sint16)y;
+    group->orientation[lane] = (Uint8)(orientation & 3);
+    UpdatePieceRows(boards, group, lane);
+}
+
+void LOCKSTEP_WillCollide(const LockstepBoards* boards, const int translationX, const int translationY, const int rotationAmount, Uint8* collisions)
+{
+    for (int g = 0; g < boards->groupCount; g++)
+    {
+        const LockstepGroup* group = &boards->groups[g];
+
+        LockstepPiece piece;
+        PreparePiece(boards, group, translationX, translationY, rotationAmount, &piece);
+
+        Uint16 hits[LOCKSTEP_GROUP_SIZE];
+        CollideGroup(boards, group, &piece, hits);
+
+        const int laneCount = SDL_min(LOCKSTEP_GROUP_SIZE, boards->count - g * LOCKSTEP_GROUP_SIZE);
+        for (int lane = 0; lane < laneCount; lane++) collisions[g * LOCKSTEP_GROUP_SIZE + lane] = hits[lane] != 0;
+    }
+}
+
+void LOCKSTEP_HardDrop(LockstepBoards* boards)
+{
+    for (int g = 0; g < boards->groupCount; g++)
+    {
+        LockstepGroup* group = &boards->groups[g];
+
+        int minTop;
+        int maxTop;
+        if (!GetPlayingTops(group, &minTop, &maxTop)) continue;
+
+        switch (boards->implementation)
+        {
+#ifdef SDL_AVX2_INTRINSICS
+        case LOCKSTEP_AVX2: DropGroupAVX2(group, minTop, maxTop); break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+        case LOCKSTEP_SSE2: DropGroupSSE2(group, minTop, maxTop); break;
+#endif
+        default: DropGroupScalar(group); break;
+        }
+    }
+}
+
+void LOCKSTEP_Lock(LockstepBoards* boards, const Uint8* nextIdentifiers)
+{
+    for (int g = 0; g < boards->groupCount; g++)
+    {
+        LockstepGroup* group = &boards->groups[g];
+
+        int minTop;
+        int maxTop;
+        if (!GetPlayingTops(group, &minTop, &maxTop)) continue;
+
+        const int firstRow = SDL_max(minTop, 0);
+        const int lastRow = SDL_min(maxTop + TETROMINO_MAX_SIZE - 1, ARENA_HEIGHT - 1);
+
+        switch (boards->implementation)
+        {
+#ifdef SDL_AVX2_INTRINSICS
+        case LOCKSTEP_AVX2: LockGroupAVX2(group, firstRow, lastRow); break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+        case LOCKSTEP_SSE2: LockGroupSSE2(group, firstRow, lastRow); break;
+#endif
+        default: LockGroupScalar(group); break;
+        }
+
+        // Spawn the next tetromino where ResetDroppingTetromino does, then end the games it does not fit in
+        const int laneCount = SDL_min(LOCKSTEP_GROUP_SIZE, boards->count - g * LOCKSTEP_GROUP_SIZE);
+        for (int lane = 0; lane < laneCount; lane++)
+        {
+            if (!group->isPlaying[lane]) continue;
+
+            const Uint8 identifier = nextIdentifiers[g * LOCKSTEP_GROUP_SIZE + lane];
+            group->identifier[lane] = identifier;
+            group->x[lane] = ((ARENA_WIDTH - TETROMINO_MAX_SIZE / 2) - 1) / 2;
+            group->y[lane] = (identifier == I) ? -1 : 0;
+            group->orientation[lane] = NORTH;
+            UpdatePieceRows(boards, group, lane);
+        }
+
+        // Every spawned tetromino's matrix starts in the top rows
+        LockstepPiece piece;
+        CopyPiece(group, -1, 0, &piece);
+
+        Uint16 hits[LOCKSTEP_GROUP_SIZE];
+        CollideGroup(boards, group, &piece, hits);
+        for (int lane = 0; lane < LOCKSTEP_GROUP_SIZE; lane++) group->isPlaying[lane] &= (Uint16)~hits[lane];
+    }
+}
+
+/**
+ * @brief A reference game played alongside the lockstep boards.
+ */
+typedef struct LockstepGame
+{
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+    Uint64 seed;
+} LockstepGame;
+
+/**
+ * @brief Compare a board with the game it mirrors.
+ *
+ * @param boards A pointer to the boards.
+ * @param index The index of the board.
+ * @param gameDataContext A struct containing the game data to compare with.
+ *
+ * @return What differs, or NULL if the board matches the game.
+ */
+static const char* CompareBoard(const LockstepBoards* boards, const int index, const GameDataContext* gameDataContext)
+{
+    const LockstepGroup* group = &boards->groups[index / LOCKSTEP_GROUP_SIZE];
+    const int lane = index % LOCKSTEP_GROUP_SIZE;
+
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        for (int col = 0; col < ARENA_WIDTH; col++)
+        {
+            if (((group->rows[row][lane] >> col) & 1) != (gameDataContext->arena[row][col] != 0)) return "arena differs";
+        }
+    }
+
+    if (group->linesCleared[lane] != (Uint16)gameDataContext->linesCleared) return "lines cleared differ";
+    if ((group->isPlaying[lane] == 0) != gameDataContext->isGameOver) return "game over differs";
+
+    const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+    if (group->x[lane] != droppingTetromino->x || group->y[lane] != droppingTetromino->y) return "tetromino position differs";
+    if (group->orientation[lane] != droppingTetromino->orientation) return "tetromino orientation differs";
+    if (group->identifier[lane] != droppingTetromino->shape->identifier) return "tetromino shape differs";
+
+    return NULL;
+}
+
+bool LOCKSTEP_RunSelfCheck(const int boardCount, const int rounds, const Uint64 seed, LockstepCheckResult* result)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *result = (LockstepCheckResult){ 0 };
+
+    LockstepGame* games = SDL_calloc((size_t)boardCount, sizeof(LockstepGame));
+    Uint8* collisions = SDL_malloc((size_t)boardCount);
+    Uint8* expectedCollisions = SDL_malloc((size_t)boardCount);
+    Uint8* nextIdentifiers = SDL_malloc((size_t)boardCount);
+    LockstepBoards implementations[LOCKSTEP_IMPLEMENTATION_COUNT] = { 0 };
+
+    bool isReady = games && collisions && expectedCollisions && nextIdentifiers;
+    for (int i = 0; isReady && i < boardCount; i++)
+    {
+        games[i].game.droppingTetromino = &games[i].droppingTetromino;
+        games[i].seed = seed + (Uint64)i;
+        GAME_ResetWithSeed(&games[i].game, games[i].seed);
+    }
+
+    const LockstepImplementation bestImplementation = LOCKSTEP_GetBestImplementation();
+    for (int k = 0; isReady && k <= (int)bestImplementation; k++)
+    {
+        isReady = LOCKSTEP_Init(&implementations[k], boardCount, (LockstepImplementation)k);
+        result->isChecked[k] = isReady;
+        for (int i = 0; isReady && i < boardCount; i++) LOCKSTEP_LoadGame(&implementations[k], i, &games[i].game);
+    }
+
+    Uint64 randomState = seed;
+    for (int round = 0; isReady && round < rounds && !result->mismatch; round++)
+    {
+        // Move each tetromino to whichever of a few random spots it fits in lands lowest, which stacks tidily enough
+        // to clear lines now and then
+        for (int i = 0; i < boardCount; i++)
+        {
+            GameDataContext* game = &games[i].game;
+            DroppingTetromino* droppingTetromino = game->droppingTetromino;
+            const int spawnX = droppingTetromino->x;
+            const int spawnOrientation = droppingTetromino->orientation;
+            int bestX = spawnX;
+            int bestOrientation = spawnOrientation;
+            int bestLandingY = -1;
+
+            for (int candidate = 0; candidate < LOCKSTEP_CHECK_CANDIDATES; candidate++)
+            {
+                droppingTetromino->x = SDL_rand_r(&randomState, ARENA_WIDTH + 2) - 2;
+                droppingTetromino->orientation = SDL_rand_r(&randomState, 4);
+                if (WillDroppingTetrominoCollide(game, 0, 0, 0)) continue;
+
+                int landingY = droppingTetromino->y;
+                while (!WillDroppingTetrominoCollide(game, 0, landingY + 1 - droppingTetromino->y, 0)) landingY++;
+                if (landingY <= bestLandingY) continue;
+
+                bestX = droppingTetromino->x;
+                bestOrientation = droppingTetromino->orientation;
+                bestLandingY = landingY;
+            }
+
+            droppingTetromino->x = bestX;
+            droppingTetromino->orientation = bestOrientation;
+
+            for (int k = 0; k <= (int)bestImplementation; k++) LOCKSTEP_SetPiece(&implementations[k], i, droppingTetromino->x, droppingTetromino->y, droppingTetromino->orientation);
+        }
+
+        // Every board is probed with the same move, including ones that leave the arena
+        const int translationX = SDL_rand_r(&randomState, 2 * ARENA_WIDTH + 1) - ARENA_WIDTH;
+        const int translationY = SDL_rand_r(&randomState, ARENA_HEIGHT + 1) - TETROMINO_MAX_SIZE;
+        const int rotationAmount = SDL_rand_r(&randomState, 7) - 3;
+        for (int i = 0; i < boardCount; i++) expectedCollisions[i] = WillDroppingTetrominoCollide(&games[i].game, translationX, translationY, rotationAmount);
+
+        Uint64 startTick = SDL_GetTicksNS();
+        for (int i = 0; i < boardCount; i++)
+        {
+            GameDataContext* game = &games[i].game;
+            while (!WillDroppingTetrominoCollide(game, 0, 1, 0)) game->droppingTetromino->y++;
+            ResetDroppingTetromino(game);
+            nextIdentifiers[i] = (Uint8)game->droppingTetromino->shape->identifier;
+        }
+        result->referenceNS += SDL_GetTicksNS() - startTick;
+        result->pieces += (Uint64)boardCount;
+
+        for (int k = 0; k <= (int)bestImplementation && !result->mismatch; k++)
+        {
+            LockstepBoards* boards = &implementations[k];
+            LOCKSTEP_WillCollide(boards, translationX, translationY, rotationAmount, collisions);
+
+            startTick = SDL_GetTicksNS();
+            LOCKSTEP_HardDrop(boards);
+            LOCKSTEP_Lock(boards, nextIdentifiers);
+            result->implementationNS[k] += SDL_GetTicksNS() - startTick;
+
+            for (int i = 0; i < boardCount && !result->mismatch; i++)
+            {
+                const char* mismatch = (collisions[i] != expectedCollisions[i]) ? "collision differs" : CompareBoard(boards, i, &games[i].game);
+                if (!mismatch) continue;
+
+                result->mismatch = mismatch;
+                result->mismatchImplementation = (LockstepImplementation)k;
+                result->mismatchBoard = i;
+                result->mismatchRound = round;
+            }
+        }
+
+        // Lost games start over with their next seed on every board
+        for (int i = 0; i < boardCount && !result->mismatch; i++)
+        {
+            if (!games[i].game.isGameOver) continue;
+
+            result->linesCleared += (Uint64)games[i].game.linesCleared;
+            games[i].seed += (Uint64)boardCount;
+            GAME_ResetWithSeed(&games[i].game, games[i].seed);
+            for (int k = 0; k <= (int)bestImplementation; k++) LOCKSTEP_LoadGame(&implementations[k], i, &games[i].game);
+        }
+    }
+
+    for (int i = 0; isReady && i < boardCount; i++) result->linesCleared += (Uint64)games[i].game.linesCleared;
+
+    for (int k = 0; k < LOCKSTEP_IMPLEMENTATION_COUNT; k++) LOCKSTEP_Destroy(&implementations[k]);
+    SDL_free(nextIdentifiers);
+    SDL_free(expectedCollisions);
+    SDL_free(collisions);
+    SDL_free(games);
+
+    if (!isReady)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to set up the lockstep self-check!");
+        return false;
+    }
+
+    return result->mismatch == NULL;
+}
@@ -7,9 +7,32 @@
 #include <stdlib.h>
 
 #include "util.h"
+#include "allocator.h"
+#include "audio.h"
+#include "bot.h"
+#include "clip.h"
+#include "dataset.h"
+#include "eventlog.h"
+#include "env.h"
 #include "tetromino.h"
+#include "fuzz.h"
 #include "game.h"
+#include "golden.h"
 #include "graphics.h"
+#include "input.h"
+#include "latency.h"
+#include "lockstep.h"
+#include "metrics.h"
+#include "particles.h"
+#include "profiler.h"
+#include "replay.h"
+#include "scores.h"
+#include "simulation.h"
+#include "spectate.h"
+#include "tournament.h"
+#include "trace.h"
+#include "ui.h"
+#include "versus.h"
 
 
 static const struct
@@ -23,6 +46,230 @@ static const struct
     {SDL_PROP_APP_METADATA_TYPE_STRING, "Tetris"}
 };
 
+/**
+ * @brief A struct containing the options parsed from the command line.
+ */
+typedef struct
+{
+    /** @brief The number of headless bot-vs-bot versus games to play instead of opening a window, or 0 to play normally. */
+    int versusGames;
+
+    /** @brief The number of random fuzz cases to run against the game rules instead of opening a window, or 0 to play normally. */
+    Uint64 fuzzCases;
+
+    /** @brief A sequence of fuzz operations to replay with the seed and check, or NULL to play normally. */
+    const char* fuzzOperations;
+
+    /** @brief The number of boards to differentially check the lockstep engine with instead of opening a window, or 0. */
+    int lockstepBoards;
+
+    /** @brief The name of a shared memory region to serve environments to a trainer through, or NULL to play normally. */
+    const char* envServerName;
+
+    /** @brief The number of environments to serve. */
+    int envCount;
+
+    /** @brief The number of worker threads to use for headless modes, or 0 for one per logical CPU core. */
+    int threads;
+
+    /** @brief The seed to start headless modes with. */
+    Uint64 seed;
+
+    /** @brief The player's key repeat settings. */
+    InputSettings inputSettings;
+
+    /** @brief Whether to measure input-to-photon latency, showing it in an overlay and logging it on exit. */
+    bool measureLatency;
+
+    /** @brief The path to write a Chrome trace to, or NULL to disable tracing. */
+    const char* tracePath;
+
+    /** @brief The path to write the metrics to as JSON on exit, or NULL to only log them. */
+    const char* metricsPath;
+
+    /** @brief The directory of golden images to render headless and compare against, or NULL to play normally. */
+    const char* goldenDirectory;
+
+    /** @brief Whether to overwrite the golden images with the rendered frames rather than compare against them. */
+    bool isUpdatingGolden;
+
+    /** @brief The path to record a replay of the game to, or NULL to not record. */
+    const char* recordPath;
+
+    /** @brief Whether to record finished games in the score log and show the high scores when a game ends. */
+    bool isKeepingScores;
+
+    /** @brief The path of the score log, or NULL for scores.log in the user's preferences directory. */
+    const char* scoresPath;
+
+    /** @brief Whether to play music and sound effects. */
+    bool isPlayingAudio;
+
+    /** @brief The path of a WAV file to loop as music, NULL to play the built-in theme, or "none" for no music. */
+    const char* musicPath;
+
+    /** @brief Whether to draw particle effects when lines are cleared and tetrominoes are hard dropped. */
+    bool isDrawingEffects;
+
+    /** @brief The path to log every gameplay event to, or NULL to not log events. */
+    const char* eventLogPath;
+
+    /** @brief The format to write the event log in, and how hard to push it towards the disk. */
+    EventLogFormat eventLogFormat;
+    EventLogSyncPolicy eventLogSyncPolicy;
+
+    /** @brief The address to broadcast the game to spectators on, or NULL to not broadcast. */
+    const char* broadcastAddress;
+
+    /** @brief The address of a broadcast to watch instead of playing, or NULL to play normally. */
+    const char* spectateAddress;
+
+    /** @brief The number of boards to show on a tournament wall instead of playing, or 0 to play normally. */
+    int tournamentBoards;
+
+    /** @brief The replays to play back on the tournament wall's first boards. The rest are played by the bot. */
+    const char* tournamentReplays[TOURNAMENT_MAX_BOARDS];
+    int tournamentReplayCount;
+
+    /** @brief The options for exporting a replay as a GIF, where a NULL replay path plays normally. */
+    ClipOptions clip;
+
+    /** @brief The options for exporting a dataset of positions, where a NULL output path plays normally. */
+    DatasetOptions dataset;
+
+    /** @brief Whether the search bot plays the game instead of the player. */
+    bool isBotPlaying;
+
+    /** @brief The settings of the search bot, whose threads are taken from the threads option. */
+    BotSearchSettings bot;
+} AppOptions;
+
+/**
+ * @brief Parse the command line arguments into a set of options.
+ *
+ * @param options A pointer to the options to write to.
+ * @param argc The number of arguments.
+ * @param argv The arguments.
+ *
+ * @return True on success, false if an argument was not recognised.
+ */
+static bool ParseArguments(AppOptions* options, const int argc, char* argv[])
+{
+    *options = (AppOptions){
+        .versusGames = 0,
+        .fuzzCases = 0,
+        .fuzzOperations = NULL,
+        .lockstepBoards = 0,
+        .envServerName = NULL,
+        .envCount = 64,
+        .threads = 0,
+        .seed = 1,
+        .measureLatency = false,
+        .tracePath = NULL,
+        .metricsPath = NULL,
+        .goldenDirectory = NULL,
+        .isUpdatingGolden = false,
+        .recordPath = NULL,
+        .isKeepingScores = true,
+        .scoresPath = NULL,
+        .isPlayingAudio = true,
+        .musicPath = NULL,
+        .isDrawingEffects = true,
+        .eventLogPath = NULL,
+        .eventLogFormat = EVENTLOG_FORMAT_BINARY,
+        .eventLogSyncPolicy = EVENTLOG_SYNC_FLUSH,
+        .broadcastAddress = NULL,
+        .spectateAddress = NULL,
+        .tournamentBoards = 0,
+        .tournamentReplayCount = 0,
+        .clip = {
+            .replayPath = NULL,
+            .outputPath = "clip.gif",
+            .speed = 1.0f,
+            .scale = 1.0f,
+            .threads = 0,
+        },
+        .dataset = {
+            .outputPath = NULL,
+            .gameCount = 1000,
+            .replayCount = 0,
+        },
+        .isBotPlaying = false,
+        .bot = {
+            .depth = 4,
+            .beamWidth = 64,
+            .preview = BOT_DEFAULT_PREVIEW,
+            .budgetNS = SDL_MS_TO_NS(2),
+            .threads = 0,
+        },
+        .inputSettings = {
+            .delayedAutoShiftNS = SDL_MS_TO_NS(150),
+            .autoRepeatRateNS = SDL_MS_TO_NS(30),
+            .softDropRateNS = SDL_MS_TO_NS(30),
+        },
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool hasValue = (i + 1 < argc);
+
+        if (!SDL_strcmp(argv[i], "--versus-headless") && hasValue) options->versusGames = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--fuzz") && hasValue) options->fuzzCases = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--fuzz-repro") && hasValue) options->fuzzOperations = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--lockstep-check") && hasValue) options->lockstepBoards = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--env-server") && hasValue) options->envServerName = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--env-count") && hasValue) options->envCount = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--threads") && hasValue) options->threads = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--seed") && hasValue) options->seed = SDL_strtoull(argv[++i], NULL, 10);
+        else if (!SDL_strcmp(argv[i], "--latency")) options->measureLatency = true;
+        else if (!SDL_strcmp(argv[i], "--trace") && hasValue) options->tracePath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--metrics") && hasValue) options->metricsPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--golden-test") && hasValue) options->goldenDirectory = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--update-golden")) options->isUpdatingGolden = true;
+        else if (!SDL_strcmp(argv[i], "--record") && hasValue) options->recordPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--scores") && hasValue) options->scoresPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--no-scores")) options->isKeepingScores = false;
+        else if (!SDL_strcmp(argv[i], "--no-audio")) options->isPlayingAudio = false;
+        else if (!SDL_strcmp(argv[i], "--music") && hasValue) options->musicPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--no-effects")) options->isDrawingEffects = false;
+        else if (!SDL_strcmp(argv[i], "--event-log") && hasValue) options->eventLogPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--event-format") && hasValue && EVENTLOG_ParseFormat(argv[i + 1], &options->eventLogFormat)) i++;
+        else if (!SDL_strcmp(argv[i], "--event-sync") && hasValue && EVENTLOG_ParseSyncPolicy(argv[i + 1], &options->eventLogSyncPolicy)) i++;
+        else if (!SDL_strcmp(argv[i], "--broadcast") && hasValue) options->broadcastAddress = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--spectate") && hasValue) options->spectateAddress = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--tournament") && hasValue) options->tournamentBoards = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--tournament-replay") && hasValue && options->tournamentReplayCount < TOURNAMENT_MAX_BOARDS)
+        {
+            options->tournamentReplays[options->tournamentReplayCount++] = argv[++i];
+        }
+        else if (!SDL_strcmp(argv[i], "--export-clip") && hasValue) options->clip.replayPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--out") && hasValue) options->clip.outputPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--speed") && hasValue) options->clip.speed = (float)SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--scale") && hasValue) options->clip.scale = (float)SDL_atof(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--export-dataset") && hasValue) options->dataset.outputPath = argv[++i];
+        else if (!SDL_strcmp(argv[i], "--dataset-games") && hasValue) options->dataset.gameCount = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--dataset-replay") && hasValue && options->dataset.replayCount < DATASET_MAX_REPLAYS)
+        {
+            options->dataset.replayPaths[options->dataset.replayCount++] = argv[++i];
+        }
+        else if (!SDL_strcmp(argv[i], "--bot")) options->isBotPlaying = true;
+        else if (!SDL_strcmp(argv[i], "--bot-depth") && hasValue) options->bot.depth = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--bot-beam") && hasValue) options->bot.beamWidth = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--bot-preview") && hasValue) options->bot.preview = SDL_atoi(argv[++i]);
+        else if (!SDL_strcmp(argv[i], "--bot-budget") && hasValue) options->bot.budgetNS = (Uint64)(SDL_atof(argv[++i]) * SDL_NS_PER_MS);
+        else if (!SDL_strcmp(argv[i], "--das") && hasValue) options->inputSettings.delayedAutoShiftNS = SDL_MS_TO_NS(SDL_atoi(argv[++i]));
+        else if (!SDL_strcmp(argv[i], "--arr") && hasValue) options->inputSettings.autoRepeatRateNS = SDL_MS_TO_NS(SDL_atoi(argv[++i]));
+        else if (!SDL_strcmp(argv[i], "--sdr") && hasValue) options->inputSettings.softDropRateNS = SDL_MS_TO_NS(SDL_atoi(argv[++i]));
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unrecognised argument '%s'!", argv[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * @brief A struct containing the main state of the program.
  */
@@ -30,13 +277,248 @@ typedef struct
 {
     GameDataContext* gameDataContext;
     GraphicsDataContext* graphicsDataContext;
+    InputState* inputState;
+    LatencyTracker* latencyTracker;
+    TextOverlay* latencyOverlay;
+    WidgetRegistry* widgetRegistry;
+    Simulation* simulation;
+    BotSearch* bot;
+    ScoreStore* scores;
+    EventLog* eventLog;
+    ParticleSystem* particles;
+    AudioEngine* audio;
+    SpectateServer* spectateServer;
+    SpectateViewer* spectateViewer;
+    TournamentWall* tournament;
     Fonts* fonts;
+    const char* metricsPath;
 } AppState;
 
+/**
+ * @brief The arena holding every object that lives as long as the app, including the AppState itself.
+ */
+static Arena appArena = { 0 };
+
+/**
+ * @brief Refresh the latency overlay text with the latest percentiles, at most a few times a second.
+ *
+ * @param latencyTracker A struct containing the latency tracker.
+ * @param overlay A pointer to the overlay to update.
+ */
+static void UpdateLatencyOverlay(LatencyTracker* latencyTracker, TextOverlay* overlay)
+{
+    // How long (in milliseconds) to wait between updates, as each update regenerates the overlay's text textures
+    const Uint64 updateInterval = 250;
+    if (overlay->lineCount > 0 && SDL_GetTicks() - overlay->lastUpdateTick < updateInterval) return;
+    overlay->lastUpdateTick = SDL_GetTicks();
+
+    LatencyStats applied;
+    LatencyStats presented;
+    LATENCY_GetStats(latencyTracker, &applied, &presented);
+
+    overlay->lineCount = 4;
+    overlay->gridRect = (FGridRect){ 0, 0, ARENA_WIDTH, 0.5f * (float)overlay->lineCount };
+    SDL_snprintf(overlay->lines[0], MAX_STRING_LENGTH, "LATENCY MS (%d INPUTS)", presented.count);
+    SDL_snprintf(overlay->lines[1], MAX_STRING_LENGTH, "APPLY P50 %.2f P99 %.2f", (double)applied.p50 / SDL_NS_PER_MS, (double)applied.p99 / SDL_NS_PER_MS);
+    SDL_snprintf(overlay->lines[2], MAX_STRING_LENGTH, "PRESENT P50 %.2f P90 %.2f", (double)presented.p50 / SDL_NS_PER_MS, (double)presented.p90 / SDL_NS_PER_MS);
+    SDL_snprintf(overlay->lines[3], MAX_STRING_LENGTH, "PRESENT P99 %.2f MAX %.2f", (double)presented.p99 / SDL_NS_PER_MS, (double)presented.max / SDL_NS_PER_MS);
+}
+
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
 {
     SDL_SetLogPriorities(SDL_LOG_PRIORITY_DEBUG);
 
+    AppOptions options;
+    if (!ParseArguments(&options, argc, argv)) return SDL_APP_FAILURE;
+    if (options.tracePath && !TRACE_Init(options.tracePath)) return SDL_APP_FAILURE;
+    METRICS_Init();
+
+    // Headless modes never open a window, so run them to completion and quit
+    if (options.versusGames > 0)
+    {
+        // Per-move logging would dominate the run time, so only report warnings until the games are done
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        VersusResult result;
+        const bool success = VS_RunHeadless(options.versusGames, options.threads, options.seed, &result);
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        TRACE_Flush();
+
+        const double seconds = (double)result.elapsedNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Played %d versus games in %.3fs (%.0f games/s, %.0f pieces/s): P1 %d wins, P2 %d wins, %d draws, %" SDL_PRIu64 " garbage lines sent.",
+            result.games, seconds,
+            (seconds > 0) ? (double)result.games / seconds : 0.0,
+            (seconds > 0) ? (double)result.pieces / seconds : 0.0,
+            result.wins[0], result.wins[1], result.draws, result.garbageSent);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (options.fuzzCases > 0)
+    {
+        // Per-move logging would dominate the run time, so only report warnings until the cases are done
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        FuzzResult result;
+        const bool success = FUZZ_Run(options.fuzzCases, options.threads, options.seed, &result);
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        TRACE_Flush();
+
+        const double seconds = (double)result.elapsedNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Ran %" SDL_PRIu64 " fuzz cases (%" SDL_PRIu64 " operations) in %.3fs (%.0f operations/s): %s.",
+            result.cases, result.operations, seconds,
+            (seconds > 0) ? (double)result.operations / seconds : 0.0,
+            result.hasFailed ? result.failure.invariant : "every invariant held");
+        if (result.hasFailed) SDL_Log("Reproduce with: --seed %" SDL_PRIu64 " --fuzz-repro %s", result.failure.seed, result.failure.operations);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (options.fuzzOperations)
+    {
+        const int operationCount = (int)SDL_strlen(options.fuzzOperations);
+        int failedOperation = 0;
+        const char* invariant = FUZZ_RunOperations(options.seed, options.fuzzOperations, operationCount, &failedOperation);
+
+        if (invariant) SDL_Log("Operation %d of %d broke an invariant: %s.", failedOperation + 1, operationCount, invariant);
+        else SDL_Log("All %d operations passed.", operationCount);
+
+        return invariant ? SDL_APP_FAILURE : SDL_APP_SUCCESS;
+    }
+
+    if (options.lockstepBoards > 0)
+    {
+        // Per-move logging would dominate the run time, so only report warnings until the check is done
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        LockstepCheckResult result;
+        const bool success = LOCKSTEP_RunSelfCheck(options.lockstepBoards, LOCKSTEP_CHECK_ROUNDS, options.seed, &result);
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        TRACE_Flush();
+
+        const double referenceSeconds = (double)result.referenceNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Locked %" SDL_PRIu64 " pieces (%" SDL_PRIu64 " lines cleared) on each of %d boards' engines: GameDataContext at %.0f pieces/s.",
+            result.pieces, result.linesCleared, options.lockstepBoards,
+            (referenceSeconds > 0) ? (double)result.pieces / referenceSeconds : 0.0);
+
+        for (int k = 0; k < LOCKSTEP_IMPLEMENTATION_COUNT; k++)
+        {
+            if (!result.isChecked[k]) continue;
+
+            const double seconds = (double)result.implementationNS[k] / (double)SDL_NS_PER_SECOND;
+            SDL_Log("Lockstep %s at %.0f pieces/s (%.1fx).", LOCKSTEP_GetImplementationName((LockstepImplementation)k),
+                (seconds > 0) ? (double)result.pieces / seconds : 0.0,
+                (seconds > 0) ? referenceSeconds / seconds : 0.0);
+        }
+
+        if (result.mismatch)
+        {
+            SDL_Log("Lockstep %s board %d broke on piece %d: %s.", LOCKSTEP_GetImplementationName(result.mismatchImplementation),
+                result.mismatchBoard, result.mismatchRound + 1, result.mismatch);
+        }
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (options.envServerName)
+    {
+        EnvBatch* batch = ENV_CreateShared(options.envServerName, options.envCount, options.seed);
+        if (!batch) return SDL_APP_FAILURE;
+
+        // Per-move logging would dominate the run time, so only report warnings until the trainer is done
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        const Uint64 startTick = SDL_GetTicksNS();
+        const Sint64 steps = ENV_ServeShared(batch, NULL);
+        const double seconds = (double)(SDL_GetTicksNS() - startTick) / (double)SDL_NS_PER_SECOND;
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        ENV_Destroy(batch);
+        TRACE_Flush();
+
+        SDL_Log("Served %" SDL_PRIs64 " batch steps of %d environments in %.3fs (%.0f environment steps/s).",
+            steps, options.envCount, seconds,
+            (seconds > 0) ? (double)steps * options.envCount / seconds : 0.0);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return SDL_APP_SUCCESS;
+    }
+
+    if (options.goldenDirectory)
+    {
+        Assert(TTF_Init(), "Failed to initialise TTF!\n");
+
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        GoldenResult result;
+        const bool success = GOLDEN_Run(options.goldenDirectory, options.isUpdatingGolden, &result);
+        TRACE_Flush();
+
+        const double seconds = (double)result.benchmarkNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Golden test %s: %d of %d scenes %s, rendering at %.0f frames/s.",
+            success ? "passed" : "failed", result.passed, result.scenes, options.isUpdatingGolden ? "written" : "matched",
+            (seconds > 0) ? (double)result.benchmarkFrames / seconds : 0.0);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (options.clip.replayPath)
+    {
+        Assert(TTF_Init(), "Failed to initialise TTF!\n");
+
+        // Per-frame logging would dominate the run time, so only report warnings until the clip is done
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        options.clip.threads = options.threads;
+        ClipResult result;
+        const bool success = CLIP_Export(&options.clip, &result);
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        TRACE_Flush();
+
+        const double seconds = (double)result.elapsedNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Exported %" SDL_PRIu64 " frames (%.1fs of replay) to '%s' in %.3fs (%.0f frames/s).",
+            result.frames, (double)result.replayNS / (double)SDL_NS_PER_SECOND, options.clip.outputPath, seconds,
+            (seconds > 0) ? (double)result.frames / seconds : 0.0);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    if (options.dataset.outputPath)
+    {
+        // Every bot move logs, so only report warnings until the dataset is written
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        options.dataset.threads = options.threads;
+        options.dataset.seed = options.seed;
+        DatasetResult result;
+        bool success = DATASET_Export(&options.dataset, &result);
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+        TRACE_Flush();
+
+        const double seconds = (double)result.elapsedNS / (double)SDL_NS_PER_SECOND;
+        SDL_Log("Exported %" SDL_PRIu64 " positions from %" SDL_PRIu64 " games in %" SDL_PRIu64 " chunks to '%s' in %.3fs (%.0f positions/s).",
+            result.records, result.games, result.chunks, options.dataset.outputPath, seconds,
+            (seconds > 0) ? (double)result.records / seconds : 0.0);
+        SDL_Log("Dataset is %" SDL_PRIu64 " bytes (%.1f per position), %.1fx smaller than its raw columns.",
+            result.fileBytes, (result.records > 0) ? (double)result.fileBytes / (double)result.records : 0.0,
+            (result.fileBytes > 0) ? (double)result.rawBytes / (double)result.fileBytes : 0.0);
+
+        // Read the file back, so that a change to the encoder that its decoder cannot undo fails the export
+        Uint64 verifiedRecords = 0;
+        success = success && DATASET_Verify(options.dataset.outputPath, &verifiedRecords);
+        if (success) SDL_Log("Verified %" SDL_PRIu64 " positions decode and encode back to the same file.", verifiedRecords);
+
+        if (options.metricsPath) METRICS_WriteJSON(options.metricsPath);
+
+        return success ? SDL_APP_SUCCESS : SDL_APP_FAILURE;
+    }
+
+    // Count allocations from here on, so that any made during steady-state play are caught
+    Assert(ALLOC_InstallHooks(), "Failed to install allocation hooks!\n");
+
     // Setup application metadata
     Assert(SDL_SetAppMetadata("TETRIS", "1.0", "Tetris"), "Failed to initialise app metadata!\n");
 
@@ -49,28 +531,212 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
     Assert(SDL_Init(SDL_INIT_VIDEO), "Failed to initialise SDL!\n");
     Assert(TTF_Init(), "Failed to initialise TTF!\n");
 
-    // Initialise subsystems
-    Fonts* fonts = SDL_calloc(1, sizeof(Fonts));
-    GameDataContext* gameDataContext = SDL_calloc(1, sizeof(GameDataContext));
-    GraphicsDataContext* graphicsDataContext = SDL_calloc(1, sizeof(GraphicsDataContext));
-
-    AppState* state = SDL_calloc(1, sizeof(AppState));
+    // Initialise subsystems, allocating everything that lives as long as the app from a single arena
+    Assert(ALLOC_ArenaInit(&appArena, APP_ARENA_CAPACITY), "Failed to allocate app arena!\n");
+    Fonts* fonts = ALLOC_ArenaAlloc(&appArena, sizeof(Fonts));
+    GameDataContext* gameDataContext = ALLOC_ArenaAlloc(&appArena, sizeof(GameDataContext));
+    GraphicsDataContext* graphicsDataContext = ALLOC_ArenaAlloc(&appArena, sizeof(GraphicsDataContext));
+    InputState* inputState = ALLOC_ArenaAlloc(&appArena, sizeof(InputState));
+    LatencyTracker* latencyTracker = ALLOC_ArenaAlloc(&appArena, sizeof(LatencyTracker));
+    TextOverlay* latencyOverlay = ALLOC_ArenaAlloc(&appArena, sizeof(TextOverlay));
+    WidgetRegistry* widgetRegistry = ALLOC_ArenaAlloc(&appArena, sizeof(WidgetRegistry));
+    Simulation* simulation = ALLOC_ArenaAlloc(&appArena, sizeof(Simulation));
+
+    AppState* state = ALLOC_ArenaAlloc(&appArena, sizeof(AppState));
     if (!state) return SDL_APP_FAILURE;
 
+    // GAME_Init and GFX_Init only allocate these if they have not been provided
+    gameDataContext->droppingTetromino = ALLOC_ArenaAlloc(&appArena, sizeof(DroppingTetromino));
+    graphicsDataContext->sidebarUI = ALLOC_ArenaAlloc(&appArena, sizeof(SidebarUI));
+    if (!gameDataContext->droppingTetromino || !graphicsDataContext->sidebarUI) return SDL_APP_FAILURE;
+
+    // A spectator only watches, and a tournament wall runs its own games, so neither plays, records or keeps anything
+    if (options.spectateAddress || options.tournamentBoards > 0)
+    {
+        options.eventLogPath = NULL;
+        options.isDrawingEffects = false;
+        options.isPlayingAudio = false;
+        options.isBotPlaying = false;
+        options.recordPath = NULL;
+        options.isKeepingScores = false;
+        options.broadcastAddress = NULL;
+    }
+
+    // The log listens before the game is initialised, so that it sees the first game start
+    if (options.eventLogPath)
+    {
+        EventLog* eventLog = ALLOC_ArenaAlloc(&appArena, sizeof(EventLog));
+        Assert(eventLog && EVENTLOG_Open(eventLog, options.eventLogPath, options.eventLogFormat, options.eventLogSyncPolicy), "Failed to open event log!\n");
+        Assert(GAME_AddEventListener(gameDataContext, EVENTLOG_Listen, eventLog), "Failed to listen to game events!\n");
+        state->eventLog = eventLog;
+    }
+
+    // Effects are not essential, so the game is still played without them if the pool cannot be allocated
+    if (options.isDrawingEffects)
+    {
+        ParticleSystem* particles = ALLOC_ArenaAlloc(&appArena, sizeof(ParticleSystem));
+        if (particles && PARTICLES_Init(particles, options.seed))
+        {
+            Assert(GAME_AddEventListener(gameDataContext, PARTICLES_Listen, particles), "Failed to listen to game events!\n");
+            graphicsDataContext->particles = particles;
+            state->particles = particles;
+            PROFILER_SetStageBudget(PROFILER_STAGE_DRAW_EFFECTS, PARTICLES_BUDGET_NS);
+        }
+        else SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to create particle effects, so none will be drawn!");
+    }
+
+    // Audio is not essential either, so the game is still played silently if there is no device
+    if (options.isPlayingAudio)
+    {
+        AudioEngine* audio = ALLOC_ArenaAlloc(&appArena, sizeof(AudioEngine));
+        if (audio && AUDIO_Open(audio, options.musicPath))
+        {
+            Assert(GAME_AddEventListener(gameDataContext, AUDIO_Listen, audio), "Failed to listen to game events!\n");
+            state->audio = audio;
+        }
+        else SDL_LogWarn(SDL_LOG_CATEGORY_AUDIO, "Failed to open audio, so the game will be silent!");
+    }
+
     Assert(GAME_Init(gameDataContext), "Failed to initialise game data!\n");
+    TRACE_BEGIN("GFX_Init");
     Assert(GFX_Init(graphicsDataContext, gameDataContext, fonts), "Failed to initialise graphics data!\n");
+    TRACE_END("GFX_Init");
+    TRACE_BEGIN("GFX_LoadTetrominoTextures");
     Assert(GFX_LoadTetrominoTextures(graphicsDataContext), "Failed to load tetromino textures!\n");
+    TRACE_END("GFX_LoadTetrominoTextures");
+    INPUT_Init(inputState, &options.inputSettings);
+
+    UI_Init(widgetRegistry);
+    Assert(UI_RegisterButton(widgetRegistry, &graphicsDataContext->sidebarUI->restartButton), "Failed to register restart button!\n");
+    Assert(UI_RegisterButton(widgetRegistry, &graphicsDataContext->sidebarUI->pauseButton), "Failed to register pause button!\n");
+    Assert(UI_RegisterButton(widgetRegistry, &graphicsDataContext->sidebarUI->quitButton), "Failed to register quit button!\n");
+    UI_UpdateLayout(widgetRegistry, graphicsDataContext);
+    LATENCY_Init(latencyTracker, options.measureLatency);
 
     state->graphicsDataContext = graphicsDataContext;
+    state->inputState = inputState;
+    state->latencyTracker = latencyTracker;
+    state->latencyOverlay = latencyOverlay;
+    state->widgetRegistry = widgetRegistry;
+    state->simulation = simulation;
     state->gameDataContext = gameDataContext;
     state->fonts = fonts;
+    state->metricsPath = options.metricsPath;
 
     state->gameDataContext->isRunning = true;
     *appstate = state;
 
+    // A spectator draws the broadcast game instead of running its own, so only the quit button does anything
+    if (options.spectateAddress)
+    {
+        SpectateViewer* viewer = SPECTATE_Connect(options.spectateAddress);
+        Assert(viewer, "Failed to watch broadcast!\n");
+        state->spectateViewer = viewer;
+
+        SidebarUI* sidebarUI = graphicsDataContext->sidebarUI;
+        sidebarUI->restartButton.onClick = NULL;
+        sidebarUI->pauseButton.onClick = NULL;
+        sidebarUI->quitButton.onClick = SPECTATE_StopViewing;
+        sidebarUI->quitButton.userData = viewer;
+
+        return SDL_APP_CONTINUE;
+    }
+
+    // A tournament wall fills the whole window with its boards, which it runs itself, so only quitting does anything
+    if (options.tournamentBoards > 0)
+    {
+        TournamentWall* tournament = ALLOC_ArenaAlloc(&appArena, sizeof(TournamentWall));
+        Assert(tournament && BuildBlockAtlas(graphicsDataContext), "Failed to build block atlas!\n");
+        Assert(TOURNAMENT_Init(tournament, options.tournamentBoards, options.tournamentReplays, options.tournamentReplayCount, options.seed), "Failed to create tournament wall!\n");
+        state->tournament = tournament;
+
+        SDL_SetWindowAspectRatio(graphicsDataContext->window, 0, 0);
+        SDL_MaximizeWindow(graphicsDataContext->window);
+
+        SidebarUI* sidebarUI = graphicsDataContext->sidebarUI;
+        sidebarUI->restartButton.onClick = NULL;
+        sidebarUI->pauseButton.onClick = NULL;
+        sidebarUI->quitButton.onClick = NULL;
+
+        // Per-move logging from every board would dominate the frame time, so only report warnings while it runs
+        SDL_SetLogPriorities(SDL_LOG_PRIORITY_WARN);
+        return SDL_APP_CONTINUE;
+    }
+
+    // The game now belongs to the simulation thread, so the buttons must send it commands rather than change it directly
+    SidebarUI* sidebarUI = graphicsDataContext->sidebarUI;
+    sidebarUI->restartButton.onClick = SIM_Restart;
+    sidebarUI->restartButton.userData = simulation;
+    sidebarUI->pauseButton.onClick = SIM_TogglePause;
+    sidebarUI->pauseButton.userData = simulation;
+    sidebarUI->quitButton.onClick = SIM_Quit;
+    sidebarUI->quitButton.userData = simulation;
+
+    if (options.isBotPlaying)
+    {
+        options.bot.threads = options.threads;
+        BotSearch* bot = ALLOC_ArenaAlloc(&appArena, sizeof(BotSearch));
+        Assert(bot && BOT_InitSearch(bot, &options.bot), "Failed to start search bot!\n");
+        simulation->bot = bot;
+        state->bot = bot;
+    }
+
+    // The bot's moves are not commands, so a replay of a game it played would not play back the same
+    if (options.recordPath && options.isBotPlaying)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Replays cannot be recorded while the bot is playing, so not recording!");
+    }
+    else if (options.recordPath)
+    {
+        ReplayRecorder* recorder = ALLOC_ArenaAlloc(&appArena, sizeof(ReplayRecorder));
+        Assert(recorder && REPLAY_BeginRecording(recorder, options.recordPath, gameDataContext->seed, &options.inputSettings), "Failed to start recording replay!\n");
+        simulation->recorder = recorder;
+    }
+
+    // The bot's games would crowd the player's out of the high score table, so only the player's games are kept
+    if (options.isKeepingScores && !options.isBotPlaying)
+    {
+        char* prefPath = options.scoresPath ? NULL : SDL_GetPrefPath("benlewisss", "Tetris");
+        char scoresPath[1024];
+        SDL_snprintf(scoresPath, sizeof(scoresPath), "%s%s", prefPath ? prefPath : "", options.scoresPath ? options.scoresPath : "scores.log");
+        SDL_free(prefPath);
+
+        // Scores are not essential, so the game is still played without them if the log cannot be opened
+        ScoreStore* scores = ALLOC_ArenaAlloc(&appArena, sizeof(ScoreStore));
+        if (scores && SCORES_Open(scores, scoresPath))
+        {
+            simulation->scores = scores;
+            graphicsDataContext->scoreStore = scores;
+            state->scores = scores;
+        }
+        else SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to open score log '%s', so scores will not be kept!", scoresPath);
+    }
+
+    if (options.broadcastAddress)
+    {
+        SpectateServer* server = SPECTATE_CreateServer(options.broadcastAddress);
+        Assert(server, "Failed to start broadcast!\n");
+        simulation->spectate = server;
+        state->spectateServer = server;
+    }
+
+    Assert(SIM_Start(simulation, gameDataContext, inputState), "Failed to start simulation!\n");
+
     return SDL_APP_CONTINUE;
 }
 
+/**
+ * @brief Ask the game to quit, stop watching if this is a spectator, or close the tournament wall.
+ *
+ * @param state A pointer to the app state.
+ */
+static void RequestQuit(const AppState* state)
+{
+    if (state->spectateViewer) SPECTATE_StopViewing(state->spectateViewer);
+    else if (state->tournament) state->gameDataContext->isRunning = false;
+    else SIM_PushCommand(state->simulation, SIM_COMMAND_QUIT);
+}
+
 SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 {
     AppState* state = appstate;
@@ -79,53 +745,60 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
     {
     case SDL_EVENT_QUIT:
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Game quit requested...");
-        state->gameDataContext->isRunning = false;
+        RequestQuit(state);
         break;
 
     case SDL_EVENT_WINDOW_CLOSE_REQUESTED:
         SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Window close requested...");
-        state->gameDataContext->isRunning = false;
+        RequestQuit(state);
         break;
 
     case SDL_EVENT_WINDOW_RESIZED:
         SDL_LogInfo(SDL_LOG_CATEGORY_VIDEO, "Window resize requested...");
         ResizeGridSquares(state->graphicsDataContext, event->window.data1, event->window.data2);
+        UI_UpdateLayout(state->widgetRegistry, state->graphicsDataContext);
+        ALLOC_ResetSteadyState();
         break;
 
     case SDL_EVENT_MOUSE_BUTTON_DOWN:
     case SDL_EVENT_MOUSE_BUTTON_UP:
         SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "User Input - Mouse Button.");
+        UI_HandleEvent(state->widgetRegistry, event);
+        break;
+
     case SDL_EVENT_MOUSE_MOTION:
-        HandleButtonEvent(state->graphicsDataContext, event, &state->graphicsDataContext->sidebarUI->quitButton);
-        HandleButtonEvent(state->graphicsDataContext, event, &state->graphicsDataContext->sidebarUI->pauseButton);
-        HandleButtonEvent(state->graphicsDataContext, event, &state->graphicsDataContext->sidebarUI->restartButton);
+        // Motion is only recorded here, and hit tested once per frame in SDL_AppIterate
+        UI_HandleEvent(state->widgetRegistry, event);
+        break;
+
+    case SDL_EVENT_KEY_UP:
+        if (!state->spectateViewer && !state->tournament) SIM_PushKeyEvent(state->simulation, &event->key);
         break;
 
     case SDL_EVENT_KEY_DOWN:
 
+        // Debug keys act on the main thread, and every other key is mapped to a game action on the simulation thread.
+        // Only forwarded keys are tagged, as only they are ever marked applied by a snapshot
+        if (!state->spectateViewer && !state->tournament && event->key.key != SDLK_F3 && event->key.key != SDLK_F4 && event->key.key != SDLK_F5 && event->key.key != SDLK_ESCAPE)
+        {
+            if (!event->key.repeat) LATENCY_TagInput(state->latencyTracker, event->key.timestamp);
+            SIM_PushKeyEvent(state->simulation, &event->key);
+        }
+        if (event->key.repeat) break;
+
         switch (event->key.key)
         {
-        case SDLK_D:
-        case SDLK_RIGHT:
-            ShiftTetromino(state->gameDataContext, 1);
+        case SDLK_F3:
+            PROFILER_ToggleOverlay();
+            ALLOC_ResetSteadyState();
             break;
-        case SDLK_A:
-        case SDLK_LEFT:
-            ShiftTetromino(state->gameDataContext, -1);
+        case SDLK_F4:
+            // Writing the trace allocates (SDL_IOprintf formats each event on the heap), so leave steady state
+            TRACE_Flush();
+            ALLOC_ResetSteadyState();
             break;
-        case SDLK_W:
-        case SDLK_UP:
-            Assert(WallKickDroppingTetromino(state->gameDataContext, 1), "Failed to wall kick tetromino!");
-            break;
-        case SDLK_S:
-        case SDLK_DOWN:
-            SoftDropTetromino(state->gameDataContext);
-            break;
-        case SDLK_SPACE:
-            HardDropTetromino(state->gameDataContext);
-            break;
-        case SDLK_P:
-            GAME_TogglePause(state->gameDataContext);
+        case SDLK_F5:
+            METRICS_Log();
             break;
         default:
             break;
@@ -134,11 +807,12 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
         if (event->key.key == SDLK_ESCAPE)
         {
             SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "ESC pressed, exiting!");
-            state->gameDataContext->isRunning = false;
+            RequestQuit(state);
         }
         else
         {
-            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "User Input - Key: %s.", SDL_GetKeyName(event->key.key));
+            // SDL_GetKeyName allocates the first time each name is requested, so use the (static) scancode name instead
+            SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "User Input - Key: %s.", SDL_GetScancodeName(event->key.scancode));
         }
 
         break;
@@ -154,11 +828,73 @@ SDL_AppResult SDL_AppIterate(void* appstate)
 {
     const AppState* state = (AppState*)appstate;
 
-    GFX_RenderGame(state->graphicsDataContext, state->gameDataContext, state->fonts);
-    Assert(SDL_RenderPresent(state->graphicsDataContext->renderer), "Failed to render previous draws!\n");
-    GAME_Iteration(state->gameDataContext);
+    // Draw the latest state published by the simulation thread, which never waits on this one, as a spectator the
+    // latest state received from the broadcast, or on a tournament wall every board (which are advanced here)
+    GameDataContext* game;
+    Uint64 worstStepNS = 0;
+    if (state->tournament)
+    {
+        game = state->gameDataContext;
+        TOURNAMENT_Update(state->tournament, SDL_GetTicksNS());
+    }
+    else if (state->spectateViewer)
+    {
+        game = SPECTATE_Receive(state->spectateViewer);
+    }
+    else
+    {
+        GameSnapshot* snapshot = SIM_AcquireSnapshot(state->simulation);
+        game = &snapshot->game;
+        LATENCY_MarkApplied(state->latencyTracker, snapshot->lastInputTimestamp, snapshot->publishTimestamp);
+        worstStepNS = snapshot->worstStepNS;
+    }
+
+    // Nothing would be seen while the window is hidden, so skip rendering (the game keeps running on its own thread)
+    const bool isHidden = SDL_GetWindowFlags(state->graphicsDataContext->window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_OCCLUDED);
 
-    return state->gameDataContext->isRunning ? SDL_APP_CONTINUE : SDL_APP_SUCCESS; // return SDL_APP_SUCCESS to quit
+    if (isHidden)
+    {
+        // Without presenting there is no vsync to pace the loop, so avoid spinning
+        SDL_Delay(10);
+    }
+    else
+    {
+        PROFILER_BeginFrame();
+        PROFILER_RecordStage(PROFILER_STAGE_GAME_ITERATION, worstStepNS);
+
+        UI_Update(state->widgetRegistry);
+
+        if (state->tournament)
+        {
+            PROFILER_BeginStage(PROFILER_STAGE_DRAW_ARENA);
+            Assert(TOURNAMENT_Render(state->tournament, state->graphicsDataContext, state->fonts), "Failed to draw tournament wall!\n");
+            PROFILER_EndStage(PROFILER_STAGE_DRAW_ARENA);
+        }
+        else
+        {
+            GFX_RenderGame(state->graphicsDataContext, game, state->fonts);
+        }
+
+        if (state->latencyTracker->isEnabled)
+        {
+            UpdateLatencyOverlay(state->latencyTracker, state->latencyOverlay);
+            Assert(DrawTextOverlay(state->graphicsDataContext, state->fonts, state->latencyOverlay), "Failed to draw latency overlay!\n");
+        }
+
+        Assert(PROFILER_DrawOverlay(state->graphicsDataContext, state->fonts), "Failed to draw profiler overlay!\n");
+
+        PROFILER_BeginStage(PROFILER_STAGE_RENDER_PRESENT);
+        Assert(SDL_RenderPresent(state->graphicsDataContext->renderer), "Failed to render previous draws!\n");
+        PROFILER_EndStage(PROFILER_STAGE_RENDER_PRESENT);
+        LATENCY_MarkPresented(state->latencyTracker, SDL_GetTicksNS());
+    }
+
+    METRICS_EndFrame(!isHidden);
+
+    const int allocations = ALLOC_EndFrame(!isHidden && game->isRunning && !game->isPaused && !game->isGameOver);
+    METRICS_Add(METRIC_ALLOCATIONS, (Uint64)allocations);
+
+    return game->isRunning ? SDL_APP_CONTINUE : SDL_APP_SUCCESS; // return SDL_APP_SUCCESS to quit
 }
 
 void SDL_AppQuit(void* appstate, SDL_AppResult result)
@@ -169,14 +905,39 @@ void SDL_AppQuit(void* appstate, SDL_AppResult result)
     {
         AppState* state = appstate;
 
+        // The simulation thread must not touch the game while it is being torn down
+        SIM_Stop(state->simulation);
+        if (state->spectateServer) SPECTATE_DestroyServer(state->spectateServer);
+        if (state->spectateViewer) SPECTATE_Disconnect(state->spectateViewer);
+        if (state->tournament)
+        {
+            SDL_SetLogPriorities(SDL_LOG_PRIORITY_INFO);
+            TOURNAMENT_Destroy(state->tournament);
+        }
+        if (state->simulation->recorder) REPLAY_EndRecording(state->simulation->recorder, state->simulation->tick, state->gameDataContext->score);
+        if (state->scores) SCORES_Close(state->scores);
+        if (state->eventLog) EVENTLOG_Close(state->eventLog);
+        if (state->particles) PARTICLES_Destroy(state->particles);
+        if (state->audio) AUDIO_Close(state->audio);
+
+        if (state->bot)
+        {
+            const BotSearchStats* stats = &state->bot->stats;
+            const double seconds = (double)stats->searchNS / (double)SDL_NS_PER_SECOND;
+            SDL_Log("Search bot ran %" SDL_PRIu64 " searches (%.3fms each) over %" SDL_PRIu64 " nodes (%.0f nodes/s), %" SDL_PRIu64 " ran out of time.",
+                stats->searches, (stats->searches > 0) ? seconds * 1000.0 / (double)stats->searches : 0.0,
+                stats->nodes, (seconds > 0) ? (double)stats->nodes / seconds : 0.0, stats->timeouts);
+            BOT_DestroySearch(state->bot);
+        }
+
+        LATENCY_LogStats(state->latencyTracker);
+        TRACE_Flush();
+        METRICS_Log();
+        if (state->metricsPath) METRICS_WriteJSON(state->metricsPath);
+
         SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Freeing state...");
         if (state->graphicsDataContext->renderer) SDL_DestroyRenderer(state->graphicsDataContext->renderer);
         if (state->graphicsDataContext->window) SDL_DestroyWindow(state->graphicsDataContext->window);
-        SDL_free(state->graphicsDataContext->sidebarUI);
-        SDL_free(state->gameDataContext->droppingTetromino);
-        SDL_free(state->gameDataContext);
-        SDL_free(state->graphicsDataContext);
-        SDL_free(state->fonts);
-        SDL_free(state);
+        ALLOC_ArenaDestroy(&appArena);
     }
 }
@@ -0,0 +1,273 @@
+#include "metrics.h"
+
+#include "util.h"
+
+/**
+ * @brief The counters and gauges of a single thread.
+ *
+ * @details Only the owning thread writes to the live values, so counting needs no atomics or locks. Readers never touch
+ * them: the owner copies them to the published values (under the metrics lock) with METRICS_Flush, and readers merge
+ * those. When the thread exits its final values are folded into the retired totals and the block is freed.
+ */
+typedef struct MetricsBlock
+{
+    Uint64 counters[METRIC_COUNTER_COUNT];
+    Sint64 gauges[METRIC_GAUGE_COUNT];
+
+    /** @brief The values as of the owner's last flush. Guarded by the metrics lock. */
+    Uint64 publishedCounters[METRIC_COUNTER_COUNT];
+    Sint64 publishedGauges[METRIC_GAUGE_COUNT];
+
+    struct MetricsBlock* next;
+} MetricsBlock;
+
+/** @brief The name of each counter, as used in logs and JSON. */
+static const char* COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+    "collisionChecks", "rotations", "wallKickAttempts", "singles", "doubles", "triples", "tetrises",
+    "textCacheHits", "textCacheMisses", "drawCalls", "framesRendered", "framesSkipped", "piecesLocked",
+    "allocations", "transpositionProbes", "transpositionHits",
+};
+
+/** @brief The name of each gauge, as used in logs and JSON. */
+static const char* GAUGE_NAMES[METRIC_GAUGE_COUNT] = {
+    "textureBytes", "collisionChecksLastFrame", "drawCallsLastFrame", "liveParticles",
+};
+
+/** @brief Guards the list of blocks, every block's published values and the retired totals. Only held briefly. */
+static SDL_SpinLock metricsLock = 0;
+
+/** @brief The head of the list of every running thread's block. */
+static MetricsBlock* metricsBlocks = NULL;
+
+/** @brief The final values of every thread that has exited, whose blocks have been freed. */
+static Uint64 retiredCounters[METRIC_COUNTER_COUNT];
+static Sint64 retiredGauges[METRIC_GAUGE_COUNT];
+
+/** @brief The thread local storage slot holding each thread's block, which frees it when the thread exits. */
+static SDL_TLSID metricsBlockTLS;
+
+/** @brief The calling thread's block, cached so that counting does not look up the TLS slot. */
+static THREAD_LOCAL MetricsBlock* threadBlock = NULL;
+
+/** @brief The merged counter values at the end of the previous frame, for the last frame gauges. Render thread only. */
+static Uint64 previousFrameCounters[METRIC_COUNTER_COUNT];
+
+/** @brief The timestamp (in nanoseconds) at which the metrics were initialised. */
+static Uint64 metricsStartTimestamp = 0;
+
+/**
+ * @brief Fold an exiting thread's final values into the retired totals, then unregister and free its block. This is
+ * an SDL_TLSDestructorCallback.
+ *
+ * @param data A pointer to the thread's block.
+ */
+static void SDLCALL RetireThreadBlock(void* data)
+{
+    MetricsBlock* block = data;
+    threadBlock = NULL;
+
+    SDL_LockSpinlock(&metricsLock);
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++) retiredCounters[counter] += block->counters[counter];
+    for (int gauge = 0; gauge < METRIC_GAUGE_COUNT; gauge++) retiredGauges[gauge] += block->gauges[gauge];
+
+    MetricsBlock** link = &metricsBlocks;
+    while (*link && *link != block) link = &(*link)->next;
+    if (*link) *link = block->next;
+    SDL_UnlockSpinlock(&metricsLock);
+
+    SDL_free(block);
+}
+
+/**
+ * @brief Create and register the calling thread's block, on its first use of the metrics.
+ *
+ * @return A pointer to the block, or NULL if it could not be allocated.
+ */
+static MetricsBlock* CreateThreadBlock(void)
+{
+    MetricsBlock* block = SDL_calloc(1, sizeof(MetricsBlock));
+    if (!block) return NULL;
+
+    if (!SDL_SetTLS(&metricsBlockTLS, block, RetireThreadBlock))
+    {
+        SDL_free(block);
+        return NULL;
+    }
+
+    SDL_LockSpinlock(&metricsLock);
+    block->next = metricsBlocks;
+    metricsBlocks = block;
+    SDL_UnlockSpinlock(&metricsLock);
+
+    threadBlock = block;
+    return block;
+}
+
+/**
+ * @brief Get the calling thread's block, creating it on first use.
+ *
+ * @return A pointer to the block, or NULL if it could not be allocated.
+ */
+static MetricsBlock* GetThreadBlock(void)
+{
+    return threadBlock ? threadBlock : CreateThreadBlock();
+}
+
+/**
+ * @brief Merge every thread's published counters, including those of threads that have exited.
+ *
+ * @param counters The array to write the merged counters to.
+ */
+static void MergeCounters(Uint64 counters[METRIC_COUNTER_COUNT])
+{
+    SDL_LockSpinlock(&metricsLock);
+    SDL_memcpy(counters, retiredCounters, sizeof(retiredCounters));
+    for (const MetricsBlock* block = metricsBlocks; block; block = block->next)
+    {
+        for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++) counters[counter] += block->publishedCounters[counter];
+    }
+    SDL_UnlockSpinlock(&metricsLock);
+}
+
+void METRICS_Init(void)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    metricsStartTimestamp = SDL_GetTicksNS();
+}
+
+void METRICS_Add(const MetricCounter counter, const Uint64 amount)
+{
+    MetricsBlock* block = GetThreadBlock();
+    if (block) block->counters[counter] += amount;
+}
+
+void METRICS_AddGauge(const MetricGauge gauge, const Sint64 amount)
+{
+    MetricsBlock* block = GetThreadBlock();
+    if (block) block->gauges[gauge] += amount;
+}
+
+void METRICS_Flush(void)
+{
+    MetricsBlock* block = threadBlock;
+    if (!block) return;
+
+    SDL_LockSpinlock(&metricsLock);
+    SDL_memcpy(block->publishedCounters, block->counters, sizeof(block->counters));
+    SDL_memcpy(block->publishedGauges, block->gauges, sizeof(block->gauges));
+    SDL_UnlockSpinlock(&metricsLock);
+}
+
+void METRICS_EndFrame(const bool isRendered)
+{
+    MetricsBlock* block = GetThreadBlock();
+    if (!block) return;
+
+    block->counters[isRendered ? METRIC_FRAMES_RENDERED : METRIC_FRAMES_SKIPPED]++;
+    METRICS_Flush();
+
+    // The game steps on another thread, so the last frame values are taken from every thread's counters merged
+    Uint64 counters[METRIC_COUNTER_COUNT];
+    MergeCounters(counters);
+
+    block->gauges[METRIC_GAUGE_COLLISION_CHECKS_LAST_FRAME] = (Sint64)(counters[METRIC_COLLISION_CHECKS] - previousFrameCounters[METRIC_COLLISION_CHECKS]);
+    block->gauges[METRIC_GAUGE_DRAW_CALLS_LAST_FRAME] = (Sint64)(counters[METRIC_DRAW_CALLS] - previousFrameCounters[METRIC_DRAW_CALLS]);
+    SDL_memcpy(previousFrameCounters, counters, sizeof(counters));
+
+    METRICS_Flush();
+}
+
+void METRICS_Read(MetricsSnapshot* snapshot)
+{
+    *snapshot = (MetricsSnapshot){ 0 };
+
+    // The calling thread's own values are always current
+    METRICS_Flush();
+
+    SDL_LockSpinlock(&metricsLock);
+    SDL_memcpy(snapshot->counters, retiredCounters, sizeof(retiredCounters));
+    SDL_memcpy(snapshot->gauges, retiredGauges, sizeof(retiredGauges));
+    for (const MetricsBlock* block = metricsBlocks; block; block = block->next)
+    {
+        for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++) snapshot->counters[counter] += block->publishedCounters[counter];
+        for (int gauge = 0; gauge < METRIC_GAUGE_COUNT; gauge++) snapshot->gauges[gauge] += block->publishedGauges[gauge];
+    }
+    SDL_UnlockSpinlock(&metricsLock);
+
+    snapshot->elapsedNS = SDL_GetTicksNS() - metricsStartTimestamp;
+
+    const double minutes = (double)snapshot->elapsedNS / (60.0 * (double)SDL_NS_PER_SECOND);
+    const Uint64 frames = snapshot->counters[METRIC_FRAMES_RENDERED] + snapshot->counters[METRIC_FRAMES_SKIPPED];
+
+    snapshot->piecesPerMinute = (minutes > 0) ? (double)snapshot->counters[METRIC_PIECES_LOCKED] / minutes : 0.0;
+    snapshot->wallKickAttemptsPerRotation = (snapshot->counters[METRIC_ROTATIONS] > 0)
+        ? (double)snapshot->counters[METRIC_WALL_KICK_ATTEMPTS] / (double)snapshot->counters[METRIC_ROTATIONS]
+        : 0.0;
+    snapshot->collisionChecksPerFrame = (frames > 0) ? (double)snapshot->counters[METRIC_COLLISION_CHECKS] / (double)frames : 0.0;
+    snapshot->drawCallsPerFrame = (snapshot->counters[METRIC_FRAMES_RENDERED] > 0)
+        ? (double)snapshot->counters[METRIC_DRAW_CALLS] / (double)snapshot->counters[METRIC_FRAMES_RENDERED]
+        : 0.0;
+}
+
+void METRICS_Log(void)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    MetricsSnapshot snapshot;
+    METRICS_Read(&snapshot);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Metrics after %.1fs:", (double)snapshot.elapsedNS / SDL_NS_PER_SECOND);
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %" SDL_PRIu64, COUNTER_NAMES[counter], snapshot.counters[counter]);
+    }
+    for (int gauge = 0; gauge < METRIC_GAUGE_COUNT; gauge++)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %" SDL_PRIs64, GAUGE_NAMES[gauge], snapshot.gauges[gauge]);
+    }
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %.2f", "piecesPerMinute", snapshot.piecesPerMinute);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %.2f", "wallKickAttemptsPerRotation", snapshot.wallKickAttemptsPerRotation);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %.2f", "collisionChecksPerFrame", snapshot.collisionChecksPerFrame);
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "  %-26s %.2f", "drawCallsPerFrame", snapshot.drawCallsPerFrame);
+}
+
+bool METRICS_WriteJSON(const char* path)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    MetricsSnapshot snapshot;
+    METRICS_Read(&snapshot);
+
+    SDL_IOStream* stream = SDL_IOFromFile(path, "w");
+    if (!stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open metrics file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    SDL_IOprintf(stream, "{\n  \"elapsedNS\": %" SDL_PRIu64 ",\n  \"counters\": {", snapshot.elapsedNS);
+    for (int counter = 0; counter < METRIC_COUNTER_COUNT; counter++)
+    {
+        SDL_IOprintf(stream, "%s\n    \"%s\": %" SDL_PRIu64, (counter > 0) ? "," : "", COUNTER_NAMES[counter], snapshot.counters[counter]);
+    }
+    SDL_IOprintf(stream, "\n  },\n  \"gauges\": {");
+    for (int gauge = 0; gauge < METRIC_GAUGE_COUNT; gauge++)
+    {
+        SDL_IOprintf(stream, "%s\n    \"%s\": %" SDL_PRIs64, (gauge > 0) ? "," : "", GAUGE_NAMES[gauge], snapshot.gauges[gauge]);
+    }
+    SDL_IOprintf(stream, "\n  },\n  \"rates\": {\n");
+    SDL_IOprintf(stream, "    \"piecesPerMinute\": %.3f,\n", snapshot.piecesPerMinute);
+    SDL_IOprintf(stream, "    \"wallKickAttemptsPerRotation\": %.3f,\n", snapshot.wallKickAttemptsPerRotation);
+    SDL_IOprintf(stream, "    \"collisionChecksPerFrame\": %.3f,\n", snapshot.collisionChecksPerFrame);
+    SDL_IOprintf(stream, "    \"drawCallsPerFrame\": %.3f\n  }\n}\n", snapshot.drawCallsPerFrame);
+
+    if (!SDL_CloseIO(stream))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write metrics file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Wrote metrics to '%s'.", path);
+    return true;
+}
@@ -0,0 +1,424 @@
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+
+#include "particles.h"
+
+#include "metrics.h"
+#include "profiler.h"
+#include "tetromino.h"
+
+/** @brief The downward acceleration (in grid squares per second squared) of every particle. */
+static const float PARTICLE_GRAVITY = 30.0f;
+
+/** @brief The width (in grid squares) of a particle when it is spawned, which shrinks to nothing as it dies. */
+static const float PARTICLE_SIZE = 0.18f;
+
+/** @brief The palette index of the white sparks of a line clear. The palette's other entries match the blocks. */
+static const Uint8 PARTICLE_COLOR_WHITE = 0;
+
+/** @brief The palette index of the gold sparks of a line clear. */
+static const Uint8 PARTICLE_COLOR_GOLD = GARBAGE + 1;
+
+/** @brief The colour of each palette index, where 1 to 7 are the colours of the tetromino blocks. */
+static const SDL_FColor PARTICLE_PALETTE[GARBAGE + 2] = {
+    { 1.00f, 1.00f, 1.00f, 1 },
+    [I] = { 0.30f, 0.90f, 1.00f, 1 },
+    [O] = { 1.00f, 0.90f, 0.25f, 1 },
+    [T] = { 0.75f, 0.35f, 1.00f, 1 },
+    [Z] = { 1.00f, 0.30f, 0.30f, 1 },
+    [S] = { 0.35f, 1.00f, 0.40f, 1 },
+    [L] = { 1.00f, 0.60f, 0.20f, 1 },
+    [J] = { 0.30f, 0.45f, 1.00f, 1 },
+    [GARBAGE] = { 0.50f, 0.50f, 0.50f, 1 },
+    { 1.00f, 0.80f, 0.30f, 1 },
+};
+
+/**
+ * @brief Get a random number in a range.
+ *
+ * @param particles A pointer to the particle system, whose random state is advanced.
+ * @param min The lowest number.
+ * @param max The highest number.
+ *
+ * @return A random number from min up to max.
+ */
+static float RandomRange(ParticleSystem* particles, const float min, const float max)
+{
+    return min + (max - min) * SDL_randf_r(&particles->randomState);
+}
+
+/**
+ * @brief Add a particle to the pool, unless it is full.
+ *
+ * @param particles A pointer to the particle system.
+ * @param x The x coordinate (in grid squares) to spawn at.
+ * @param y The y coordinate (in grid squares) to spawn at.
+ * @param velocityX The x velocity (in grid squares per second).
+ * @param velocityY The y velocity (in grid squares per second).
+ * @param life The time (in seconds) the particle lives for.
+ * @param color The palette index of the particle's colour.
+ *
+ * @return True on success, false if the pool was full.
+ */
+static bool SpawnParticle(ParticleSystem* particles, const float x, const float y, const float velocityX, const float velocityY, const float life, const Uint8 color)
+{
+    if (particles->count >= PARTICLES_CAPACITY)
+    {
+        particles->droppedParticles++;
+        return false;
+    }
+
+    const int i = particles->count++;
+    particles->x[i] = x;
+    particles->y[i] = y;
+    particles->velocityX[i] = velocityX;
+    particles->velocityY[i] = velocityY;
+    particles->life[i] = life;
+    particles->fade[i] = 1.0f / life;
+    particles->color[i] = color;
+    return true;
+}
+
+/**
+ * @brief Get the number of particles an effect spawns for each cell, scaled down while particles are over budget.
+ *
+ * @param particles A pointer to the particle system.
+ * @param perCell The number of particles spawned for each cell within budget.
+ *
+ * @return The number of particles to spawn for each cell, which is at least 1.
+ */
+static int GetScaledCount(const ParticleSystem* particles, const int perCell)
+{
+    const int count = (int)((float)perCell * particles->spawnScale);
+    return (count > 1) ? count : 1;
+}
+
+/**
+ * @brief Burst sparks out of every cell of the cleared rows.
+ *
+ * @param particles A pointer to the particle system.
+ * @param event The GAME_EVENT_LINE_CLEAR event.
+ */
+static void SpawnLineClear(ParticleSystem* particles, const GameEvent* event)
+{
+    const int perCell = GetScaledCount(particles, PARTICLES_PER_CLEARED_CELL);
+
+    for (int row = 0; row <= event->row; row++)
+    {
+        if (!(event->rowMask & (1u << row))) continue;
+
+        for (int col = 0; col < ARENA_WIDTH; col++)
+        {
+            for (int n = 0; n < perCell; n++)
+            {
+                const float x = (float)col + RandomRange(particles, 0.0f, 1.0f);
+                const float y = (float)row + RandomRange(particles, 0.0f, 1.0f);
+
+                // Fling sparks away from the middle of the rows, and upwards, so they arc over the stack
+                const float velocityX = (x - ARENA_WIDTH / 2.0f) * RandomRange(particles, 0.5f, 2.0f) + RandomRange(particles, -3.0f, 3.0f);
+                const float velocityY = RandomRange(particles, -14.0f, -2.0f);
+                const Uint8 color = (n & 1) ? PARTICLE_COLOR_GOLD : PARTICLE_COLOR_WHITE;
+
+                if (!SpawnParticle(particles, x, y, velocityX, velocityY, RandomRange(particles, 0.4f, 0.9f), color)) return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Leave a trail behind each block of a hard dropped tetromino, and kick up dust where it landed.
+ *
+ * @param particles A pointer to the particle system.
+ * @param event The GAME_EVENT_HARD_DROP event.
+ */
+static void SpawnHardDrop(ParticleSystem* particles, const GameEvent* event)
+{
+    const TetrominoShape* shape = GetTetrominoShapeByIdentifier(event->piece);
+    if (!shape || event->orientation < 0 || event->orientation >= 4) return;
+
+    const int perBlock = GetScaledCount(particles, PARTICLES_PER_DROPPED_BLOCK);
+    const float distance = (float)event->lines;
+    const Uint8 color = (Uint8)event->piece;
+
+    for (int i = 0; i < TETROMINO_MAX_SIZE; i++)
+    {
+        for (int j = 0; j < TETROMINO_MAX_SIZE; j++)
+        {
+            if (!shape->coordinates[event->orientation][i][j]) continue;
+
+            const float blockX = (float)(event->x + j);
+            const float blockY = (float)(event->y + i);
+
+            for (int n = 0; n < perBlock; n++)
+            {
+                float x, y, velocityX, velocityY, life;
+                if (n & 1)
+                {
+                    // Trail: a streak up the column the block fell through, drifting slowly
+                    x = blockX + RandomRange(particles, 0.1f, 0.9f);
+                    y = blockY + 1.0f - RandomRange(particles, 0.0f, distance + 1.0f);
+                    velocityX = RandomRange(particles, -0.5f, 0.5f);
+                    velocityY = RandomRange(particles, -3.0f, -0.5f);
+                    life = RandomRange(particles, 0.15f, 0.4f);
+                }
+                else
+                {
+                    // Dust: a puff out of the bottom of the block, sideways and upwards
+                    x = blockX + RandomRange(particles, 0.0f, 1.0f);
+                    y = blockY + 1.0f;
+                    velocityX = RandomRange(particles, -6.0f, 6.0f);
+                    velocityY = RandomRange(particles, -6.0f, -1.0f);
+                    life = RandomRange(particles, 0.2f, 0.5f);
+                }
+
+                if (!SpawnParticle(particles, x, y, velocityX, velocityY, life, color)) return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Advance every live particle, one at a time.
+ *
+ * @param particles A pointer to the particle system.
+ * @param first The first particle to advance.
+ * @param dt The time (in seconds) to advance by.
+ */
+static void AdvanceScalar(ParticleSystem* particles, const int first, const float dt)
+{
+    for (int i = first; i < particles->count; i++)
+    {
+        particles->velocityY[i] += PARTICLE_GRAVITY * dt;
+        particles->x[i] += particles->velocityX[i] * dt;
+        particles->y[i] += particles->velocityY[i] * dt;
+        particles->life[i] -= dt;
+    }
+}
+
+#ifdef SDL_SSE2_INTRINSICS
+/**
+ * @brief Advance every live particle, four at a time, finishing any left over one at a time.
+ *
+ * @param particles A pointer to the particle system.
+ * @param dt The time (in seconds) to advance by.
+ */
+SDL_TARGETING("sse2") static void AdvanceSSE2(ParticleSystem* particles, const float dt)
+{
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 gravityStep = _mm_set1_ps(PARTICLE_GRAVITY * dt);
+    const int vectorCount = particles->count & ~3;
+
+    for (int i = 0; i < vectorCount; i += 4)
+    {
+        const __m128 velocityY = _mm_add_ps(_mm_load_ps(&particles->velocityY[i]), gravityStep);
+        _mm_store_ps(&particles->velocityY[i], velocityY);
+        _mm_store_ps(&particles->x[i], _mm_add_ps(_mm_load_ps(&particles->x[i]), _mm_mul_ps(_mm_load_ps(&particles->velocityX[i]), step)));
+        _mm_store_ps(&particles->y[i], _mm_add_ps(_mm_load_ps(&particles->y[i]), _mm_mul_ps(velocityY, step)));
+        _mm_store_ps(&particles->life[i], _mm_sub_ps(_mm_load_ps(&particles->life[i]), step));
+    }
+
+    AdvanceScalar(particles, vectorCount, dt);
+}
+#endif
+
+/**
+ * @brief Remove every dead particle, by moving the last live particle into its place.
+ *
+ * @param particles A pointer to the particle system.
+ */
+static void RemoveDead(ParticleSystem* particles)
+{
+    int i = 0;
+    while (i < particles->count)
+    {
+        if (particles->life[i] > 0)
+        {
+            i++;
+            continue;
+        }
+
+        const int last = --particles->count;
+        particles->x[i] = particles->x[last];
+        particles->y[i] = particles->y[last];
+        particles->velocityX[i] = particles->velocityX[last];
+        particles->velocityY[i] = particles->velocityY[last];
+        particles->life[i] = particles->life[last];
+        particles->fade[i] = particles->fade[last];
+        particles->color[i] = particles->color[last];
+    }
+}
+
+bool PARTICLES_Init(ParticleSystem* particles, const Uint64 seed)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_zerop(particles);
+
+    // Each array is aligned, and a whole number of vectors long, so the update step can load and store them directly
+    const size_t floatBytes = sizeof(float) * PARTICLES_CAPACITY;
+    float** floatArrays[] = { &particles->x, &particles->y, &particles->velocityX, &particles->velocityY, &particles->life, &particles->fade };
+    for (size_t i = 0; i < SDL_arraysize(floatArrays); i++)
+    {
+        if (!(*floatArrays[i] = SDL_aligned_alloc(16, floatBytes)))
+        {
+            PARTICLES_Destroy(particles);
+            return false;
+        }
+        SDL_memset(*floatArrays[i], 0, floatBytes);
+    }
+
+    particles->color = SDL_calloc(PARTICLES_CAPACITY, sizeof(Uint8));
+    particles->vertices = SDL_malloc(sizeof(SDL_Vertex) * PARTICLES_CAPACITY * 4);
+    particles->indices = SDL_malloc(sizeof(int) * PARTICLES_CAPACITY * 6);
+    if (!particles->color || !particles->vertices || !particles->indices)
+    {
+        PARTICLES_Destroy(particles);
+        return false;
+    }
+
+    // Every particle is a quad of two triangles, so the indices never change
+    for (int i = 0; i < PARTICLES_CAPACITY; i++)
+    {
+        int* quadIndices = &particles->indices[i * 6];
+        quadIndices[0] = i * 4;
+        quadIndices[1] = i * 4 + 1;
+        quadIndices[2] = i * 4 + 2;
+        quadIndices[3] = i * 4;
+        quadIndices[4] = i * 4 + 2;
+        quadIndices[5] = i * 4 + 3;
+    }
+
+    particles->spawnScale = 1.0f;
+    particles->randomState = seed;
+#ifdef SDL_SSE2_INTRINSICS
+    particles->hasSSE2 = SDL_HasSSE2();
+#endif
+    SDL_SetAtomicInt(&particles->triggerHead, 0);
+    SDL_SetAtomicInt(&particles->triggerTail, 0);
+    SDL_SetAtomicInt(&particles->droppedTriggers, 0);
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created a pool of %d particles (update step: %s)", PARTICLES_CAPACITY, particles->hasSSE2 ? "SSE2" : "scalar");
+    return true;
+}
+
+void PARTICLES_Destroy(ParticleSystem* particles)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    const int droppedTriggers = SDL_GetAtomicInt(&particles->droppedTriggers);
+    if (droppedTriggers > 0 || particles->droppedParticles > 0)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Dropped %d effects and %" SDL_PRIu64 " particles", droppedTriggers, particles->droppedParticles);
+    }
+
+    METRICS_AddGauge(METRIC_GAUGE_LIVE_PARTICLES, -particles->count);
+    SDL_aligned_free(particles->x);
+    SDL_aligned_free(particles->y);
+    SDL_aligned_free(particles->velocityX);
+    SDL_aligned_free(particles->velocityY);
+    SDL_aligned_free(particles->life);
+    SDL_aligned_free(particles->fade);
+    SDL_free(particles->color);
+    SDL_free(particles->vertices);
+    SDL_free(particles->indices);
+    SDL_zerop(particles);
+}
+
+void PARTICLES_Listen(void* userData, const GameEvent* event)
+{
+    if (event->type != GAME_EVENT_LINE_CLEAR && event->type != GAME_EVENT_HARD_DROP) return;
+
+    ParticleSystem* particles = userData;
+    const int tail = SDL_GetAtomicInt(&particles->triggerTail);
+    if (tail - SDL_GetAtomicInt(&particles->triggerHead) >= PARTICLES_TRIGGER_CAPACITY)
+    {
+        SDL_AddAtomicInt(&particles->droppedTriggers, 1);
+        return;
+    }
+
+    particles->triggers[tail & (PARTICLES_TRIGGER_CAPACITY - 1)] = *event;
+    SDL_SetAtomicInt(&particles->triggerTail, tail + 1);
+}
+
+void PARTICLES_Update(ParticleSystem* particles, const Uint64 nowNS)
+{
+    particles->frameStartNS = SDL_GetTicksNS();
+    const int previousCount = particles->count;
+
+    // Spawn every queued effect
+    int head = SDL_GetAtomicInt(&particles->triggerHead);
+    const int tail = SDL_GetAtomicInt(&particles->triggerTail);
+    for (; head != tail; head++)
+    {
+        const GameEvent* event = &particles->triggers[head & (PARTICLES_TRIGGER_CAPACITY - 1)];
+        if (event->type == GAME_EVENT_LINE_CLEAR) SpawnLineClear(particles, event);
+        else SpawnHardDrop(particles, event);
+    }
+    SDL_SetAtomicInt(&particles->triggerHead, head);
+
+    // Advance by the time since the last update, but no further than PARTICLES_MAX_STEP_NS after a stall
+    Uint64 elapsedNS = (particles->lastUpdateNS != 0 && nowNS > particles->lastUpdateNS) ? nowNS - particles->lastUpdateNS : 0;
+    if (elapsedNS > PARTICLES_MAX_STEP_NS) elapsedNS = PARTICLES_MAX_STEP_NS;
+    particles->lastUpdateNS = nowNS;
+
+    const float dt = (float)elapsedNS / 1e9f;
+#ifdef SDL_SSE2_INTRINSICS
+    if (particles->hasSSE2) AdvanceSSE2(particles, dt);
+    else AdvanceScalar(particles, 0, dt);
+#else
+    AdvanceScalar(particles, 0, dt);
+#endif
+
+    RemoveDead(particles);
+    METRICS_AddGauge(METRIC_GAUGE_LIVE_PARTICLES, particles->count - previousCount);
+}
+
+bool PARTICLES_Draw(ParticleSystem* particles, GraphicsDataContext* graphicsDataContext)
+{
+    bool success = true;
+
+    if (particles->count > 0)
+    {
+        const float gridSquareSize = graphicsDataContext->gridSquareSize;
+        for (int i = 0; i < particles->count; i++)
+        {
+            // Shrink and fade each particle as it dies
+            const float remaining = particles->life[i] * particles->fade[i];
+            const float halfSize = PARTICLE_SIZE * 0.5f * remaining * gridSquareSize;
+            const float x = particles->x[i] * gridSquareSize;
+            const float y = particles->y[i] * gridSquareSize;
+
+            SDL_FColor color = PARTICLE_PALETTE[particles->color[i]];
+            color.a = remaining;
+
+            SDL_Vertex* quad = &particles->vertices[i * 4];
+            quad[0] = (SDL_Vertex){ { x - halfSize, y - halfSize }, color, { 0, 0 } };
+            quad[1] = (SDL_Vertex){ { x + halfSize, y - halfSize }, color, { 0, 0 } };
+            quad[2] = (SDL_Vertex){ { x + halfSize, y + halfSize }, color, { 0, 0 } };
+            quad[3] = (SDL_Vertex){ { x - halfSize, y + halfSize }, color, { 0, 0 } };
+        }
+
+        // Untextured geometry uses the draw blend mode, so glow additively and then put it back
+        SDL_BlendMode blendMode = SDL_BLENDMODE_BLEND;
+        SDL_GetRenderDrawBlendMode(graphicsDataContext->renderer, &blendMode);
+        SDL_SetRenderDrawBlendMode(graphicsDataContext->renderer, SDL_BLENDMODE_ADD);
+
+        PROFILER_CountDrawCall();
+        success = SDL_RenderGeometry(graphicsDataContext->renderer, NULL, particles->vertices, particles->count * 4, particles->indices, particles->count * 6);
+
+        SDL_SetRenderDrawBlendMode(graphicsDataContext->renderer, blendMode);
+    }
+
+    // Spawn fewer particles while over budget, and recover once comfortably under it
+    particles->lastCostNS = SDL_GetTicksNS() - particles->frameStartNS;
+    if (particles->lastCostNS > PARTICLES_BUDGET_NS)
+    {
+        if (particles->spawnScale > 1.0f / 16.0f) particles->spawnScale *= 0.5f;
+    }
+    else if (particles->lastCostNS < PARTICLES_BUDGET_NS / 2 && particles->spawnScale < 1.0f)
+    {
+        particles->spawnScale *= 2.0f;
+    }
+
+    return success;
+}
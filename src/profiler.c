@@ -0,0 +1,257 @@
+#include "profiler.h"
+
+#include "graphics.h"
+#include "metrics.h"
+#include "trace.h"
+
+/**
+ * @brief A struct containing the profiler state. Everything is fixed size, so profiling never allocates.
+ */
+typedef struct Profiler
+{
+    /** @brief The time (in nanoseconds) spent in each stage, for each frame in the ring buffer. */
+    Uint64 stageTimes[PROFILER_STAGE_COUNT][PROFILER_FRAME_CAPACITY];
+
+    /** @brief The number of draw calls made, for each frame in the ring buffer. */
+    Uint32 drawCalls[PROFILER_FRAME_CAPACITY];
+
+    /** @brief The time (in nanoseconds) each stage may take each frame, or 0 for none. */
+    Uint64 stageBudgets[PROFILER_STAGE_COUNT];
+
+    /** @brief The performance counter value at which each stage was last started. */
+    Uint64 stageStarts[PROFILER_STAGE_COUNT];
+
+    /** @brief The index of the current frame in the ring buffer. */
+    int currentFrame;
+
+    /**
+     * @brief The number of completed frames in the ring buffer, up to PROFILER_FRAME_CAPACITY - 1 as the current
+     * (incomplete) frame always takes a slot.
+     */
+    int frameCount;
+
+    /** @brief Scratch space for sorting timings when calculating percentiles. */
+    Uint64 sortBuffer[PROFILER_FRAME_CAPACITY];
+
+    /** @brief Whether the overlay is visible. */
+    bool isOverlayVisible;
+
+    /** @brief The text of the overlay, which is only updated a few times a second. */
+    TextOverlay overlay;
+
+    /** @brief The thread that began the last frame. Stages timed on other threads (e.g. offscreen renderers) are only traced. */
+    SDL_ThreadID frameThread;
+} Profiler;
+
+static Profiler profiler = { 0 };
+
+/** @brief The name of each stage in trace files. */
+static const char* STAGE_TRACE_NAMES[PROFILER_STAGE_COUNT] = {
+    "GameIteration", "DrawArena", "DrawDroppingTetromino", "DrawDroppingTetrominoGhost", "DrawSidebar",
+    "GenerateTextTexture (cache miss)", "SDL_RenderPresent", "DrawEffects", "Frame",
+};
+
+/**
+ * @brief Convert a performance counter interval into nanoseconds.
+ *
+ * @param counter The interval, in performance counter ticks.
+ *
+ * @return The interval, in nanoseconds.
+ */
+static Uint64 CounterToNS(const Uint64 counter)
+{
+    static Uint64 frequency = 0;
+    if (frequency == 0) frequency = SDL_GetPerformanceFrequency();
+
+    return (Uint64)((double)counter * (double)SDL_NS_PER_SECOND / (double)frequency);
+}
+
+/**
+ * @brief Compare two Uint64 values, for use with SDL_qsort.
+ *
+ * @param a A pointer to the first value.
+ * @param b A pointer to the second value.
+ *
+ * @return A negative, zero or positive value if a is less than, equal to, or greater than b, respectively.
+ */
+static int CompareUint64(const void* a, const void* b)
+{
+    const Uint64 x = *(const Uint64*)a;
+    const Uint64 y = *(const Uint64*)b;
+    return (x > y) - (x < y);
+}
+
+void PROFILER_BeginFrame(void)
+{
+    const Uint64 now = SDL_GetPerformanceCounter();
+
+    // The frame stage spans from the start of one frame to the start of the next, so it includes any waiting
+    if (profiler.stageStarts[PROFILER_STAGE_FRAME] != 0)
+    {
+        profiler.stageTimes[PROFILER_STAGE_FRAME][profiler.currentFrame] = CounterToNS(now - profiler.stageStarts[PROFILER_STAGE_FRAME]);
+        profiler.currentFrame = (profiler.currentFrame + 1) % PROFILER_FRAME_CAPACITY;
+        if (profiler.frameCount < PROFILER_FRAME_CAPACITY - 1) profiler.frameCount++;
+        TRACE_END(STAGE_TRACE_NAMES[PROFILER_STAGE_FRAME]);
+    }
+
+    for (int stage = 0; stage < PROFILER_STAGE_COUNT; stage++) profiler.stageTimes[stage][profiler.currentFrame] = 0;
+    profiler.drawCalls[profiler.currentFrame] = 0;
+    profiler.stageStarts[PROFILER_STAGE_FRAME] = now;
+    profiler.frameThread = SDL_GetCurrentThreadID();
+    TRACE_BEGIN(STAGE_TRACE_NAMES[PROFILER_STAGE_FRAME]);
+}
+
+void PROFILER_BeginStage(const ProfilerStage stage)
+{
+    TRACE_BEGIN(STAGE_TRACE_NAMES[stage]);
+    if (SDL_GetCurrentThreadID() != profiler.frameThread) return;
+    profiler.stageStarts[stage] = SDL_GetPerformanceCounter();
+}
+
+void PROFILER_EndStage(const ProfilerStage stage)
+{
+    if (SDL_GetCurrentThreadID() == profiler.frameThread)
+    {
+        profiler.stageTimes[stage][profiler.currentFrame] += CounterToNS(SDL_GetPerformanceCounter() - profiler.stageStarts[stage]);
+    }
+    TRACE_END(STAGE_TRACE_NAMES[stage]);
+}
+
+void PROFILER_RecordStage(const ProfilerStage stage, const Uint64 timeNS)
+{
+    if (SDL_GetCurrentThreadID() == profiler.frameThread) profiler.stageTimes[stage][profiler.currentFrame] += timeNS;
+}
+
+void PROFILER_CountDrawCall(void)
+{
+    if (SDL_GetCurrentThreadID() == profiler.frameThread) profiler.drawCalls[profiler.currentFrame]++;
+    METRICS_Add(METRIC_DRAW_CALLS, 1);
+}
+
+void PROFILER_GetStageStats(const ProfilerStage stage, ProfilerStats* stats)
+{
+    *stats = (ProfilerStats){ 0 };
+    const int count = profiler.frameCount;
+    if (count == 0) return;
+
+    // Only completed frames are included, which are every frame in the ring buffer other than the current one
+    int sortCount = 0;
+    Uint64 total = 0;
+    for (int i = 1; i <= count; i++)
+    {
+        const Uint64 time = profiler.stageTimes[stage][(profiler.currentFrame - i + PROFILER_FRAME_CAPACITY) % PROFILER_FRAME_CAPACITY];
+        profiler.sortBuffer[sortCount++] = time;
+        total += time;
+        if (profiler.stageBudgets[stage] != 0 && time > profiler.stageBudgets[stage]) stats->overBudget++;
+    }
+
+    SDL_qsort(profiler.sortBuffer, (size_t)sortCount, sizeof(profiler.sortBuffer[0]), CompareUint64);
+    stats->min = profiler.sortBuffer[0];
+    stats->average = total / (Uint64)sortCount;
+    stats->p99 = profiler.sortBuffer[(sortCount - 1) * 99 / 100];
+}
+
+void PROFILER_SetStageBudget(const ProfilerStage stage, const Uint64 budgetNS)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    profiler.stageBudgets[stage] = budgetNS;
+}
+
+void PROFILER_ToggleOverlay(void)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    profiler.isOverlayVisible = !profiler.isOverlayVisible;
+    profiler.overlay.lineCount = 0;
+}
+
+/**
+ * @brief Refresh the overlay text with the latest stage timings, at most a few times a second.
+ */
+static void UpdateOverlayText(void)
+{
+    // How long (in milliseconds) to wait between updates, as each update regenerates the overlay's text textures
+    const Uint64 updateInterval = 250;
+    if (profiler.overlay.lineCount > 0 && SDL_GetTicks() - profiler.overlay.lastUpdateTick < updateInterval) return;
+    profiler.overlay.lastUpdateTick = SDL_GetTicks();
+
+    static const char* STAGE_NAMES[PROFILER_STAGE_COUNT] = {
+        "GAME", "ARENA", "PIECE", "GHOST", "SIDEBAR", "TEXT MISS", "PRESENT", "EFFECTS", "FRAME",
+    };
+
+    int line = 0;
+    SDL_snprintf(profiler.overlay.lines[line++], MAX_STRING_LENGTH, "STAGE     MIN   AVG   P99 MS");
+    for (int stage = 0; stage < PROFILER_STAGE_COUNT; stage++)
+    {
+        ProfilerStats stats;
+        PROFILER_GetStageStats((ProfilerStage)stage, &stats);
+        SDL_snprintf(profiler.overlay.lines[line++], MAX_STRING_LENGTH, "%-9s %5.2f %5.2f %5.2f", STAGE_NAMES[stage],
+            (double)stats.min / SDL_NS_PER_MS, (double)stats.average / SDL_NS_PER_MS, (double)stats.p99 / SDL_NS_PER_MS);
+    }
+
+    // Budgeted stages, with how many of the frames in the ring buffer went over
+    for (int stage = 0; stage < PROFILER_STAGE_COUNT && line < OVERLAY_MAX_LINES - 1; stage++)
+    {
+        if (profiler.stageBudgets[stage] == 0) continue;
+
+        ProfilerStats stats;
+        PROFILER_GetStageStats((ProfilerStage)stage, &stats);
+        SDL_snprintf(profiler.overlay.lines[line++], MAX_STRING_LENGTH, "%-9s BUDGET %4.2f OVER %d/%d", STAGE_NAMES[stage],
+            (double)profiler.stageBudgets[stage] / SDL_NS_PER_MS, stats.overBudget, profiler.frameCount);
+    }
+
+    // Draw calls of the last completed frame
+    const int lastFrame = (profiler.currentFrame - 1 + PROFILER_FRAME_CAPACITY) % PROFILER_FRAME_CAPACITY;
+    SDL_snprintf(profiler.overlay.lines[line++], MAX_STRING_LENGTH, "DRAW CALLS %u", profiler.drawCalls[lastFrame]);
+
+    profiler.overlay.lineCount = line;
+    // Sit below the latency overlay, so both can be shown at once
+    profiler.overlay.gridRect = (FGridRect){ 0, 2.5f, ARENA_WIDTH, 0.5f * (float)line };
+}
+
+bool PROFILER_DrawOverlay(GraphicsDataContext* graphicsDataContext, const Fonts* fonts)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    if (!profiler.isOverlayVisible) return true;
+
+    UpdateOverlayText();
+    if (!DrawTextOverlay(graphicsDataContext, fonts, &profiler.overlay)) return false;
+
+    // Draw a rolling frame time graph along the bottom of the arena, where the full height is two 60Hz frames
+    const float graphHeight = 3;
+    const SDL_FRect graphRect = FGridRectToFRect(graphicsDataContext, (FGridRect){ 0, ARENA_HEIGHT - graphHeight, ARENA_WIDTH, graphHeight }, 0);
+    const double fullScaleNS = 2.0 * (double)SDL_NS_PER_SECOND / 60.0;
+
+    // The background is translucent, so blend it over the arena, then put back whatever blend mode was set before
+    SDL_BlendMode blendMode = SDL_BLENDMODE_NONE;
+    SDL_GetRenderDrawBlendMode(graphicsDataContext->renderer, &blendMode);
+    SDL_SetRenderDrawBlendMode(graphicsDataContext->renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(graphicsDataContext->renderer, 0, 0, 0, 180);
+    const bool isFilled = SDL_RenderFillRect(graphicsDataContext->renderer, &graphRect);
+    SDL_SetRenderDrawBlendMode(graphicsDataContext->renderer, blendMode);
+    if (!isFilled) return false;
+
+    SDL_FRect bars[PROFILER_FRAME_CAPACITY];
+    const float barWidth = graphRect.w / (float)PROFILER_FRAME_CAPACITY;
+    for (int i = 0; i < profiler.frameCount; i++)
+    {
+        // Oldest frame on the left, newest on the right
+        const int frame = (profiler.currentFrame - profiler.frameCount + i + PROFILER_FRAME_CAPACITY) % PROFILER_FRAME_CAPACITY;
+        const double fraction = SDL_min((double)profiler.stageTimes[PROFILER_STAGE_FRAME][frame] / fullScaleNS, 1.0);
+        const float barHeight = (float)fraction * graphRect.h;
+
+        bars[i] = (SDL_FRect){ graphRect.x + (float)(PROFILER_FRAME_CAPACITY - profiler.frameCount + i) * barWidth, graphRect.y + graphRect.h - barHeight, barWidth, barHeight };
+    }
+
+    SDL_SetRenderDrawColor(graphicsDataContext->renderer, 80, 200, 120, 255);
+    if (profiler.frameCount > 0 && !SDL_RenderFillRects(graphicsDataContext->renderer, bars, profiler.frameCount)) return false;
+
+    // Mark the 60Hz frame budget halfway up the graph
+    SDL_SetRenderDrawColor(graphicsDataContext->renderer, 200, 60, 60, 255);
+    const float budgetY = graphRect.y + graphRect.h / 2;
+    if (!SDL_RenderLine(graphicsDataContext->renderer, graphRect.x, budgetY, graphRect.x + graphRect.w, budgetY)) return false;
+
+    return true;
+}
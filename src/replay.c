@@ -0,0 +1,237 @@
+#include "replay.h"
+
+/**
+ * @brief Write a replay header at the current position of a stream.
+ *
+ * @param stream The stream to write to.
+ * @param header The header to write.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool WriteHeader(SDL_IOStream* stream, const ReplayHeader* header)
+{
+    bool success = true;
+    success &= SDL_WriteU32LE(stream, REPLAY_MAGIC);
+    success &= SDL_WriteU32LE(stream, REPLAY_VERSION);
+    success &= SDL_WriteU32LE(stream, header->tickRate);
+    success &= SDL_WriteU32LE(stream, header->eventCount);
+    success &= SDL_WriteU64LE(stream, header->seed);
+    success &= SDL_WriteU64LE(stream, header->tickCount);
+    success &= SDL_WriteU64LE(stream, header->inputSettings.delayedAutoShiftNS);
+    success &= SDL_WriteU64LE(stream, header->inputSettings.autoRepeatRateNS);
+    success &= SDL_WriteU64LE(stream, header->inputSettings.softDropRateNS);
+    success &= SDL_WriteU32LE(stream, header->finalScore);
+    return success;
+}
+
+/**
+ * @brief Read a replay header from the current position of a stream.
+ *
+ * @param stream The stream to read from.
+ * @param header A pointer to the header to read into.
+ *
+ * @return True on success, false if the stream is not a supported replay.
+ */
+static bool ReadHeader(SDL_IOStream* stream, ReplayHeader* header)
+{
+    Uint32 magic = 0;
+    Uint32 version = 0;
+    if (!SDL_ReadU32LE(stream, &magic) || magic != REPLAY_MAGIC) return SDL_SetError("Not a replay file");
+    if (!SDL_ReadU32LE(stream, &version) || version != REPLAY_VERSION) return SDL_SetError("Unsupported replay version %u", version);
+
+    bool success = true;
+    success &= SDL_ReadU32LE(stream, &header->tickRate);
+    success &= SDL_ReadU32LE(stream, &header->eventCount);
+    success &= SDL_ReadU64LE(stream, &header->seed);
+    success &= SDL_ReadU64LE(stream, &header->tickCount);
+    success &= SDL_ReadU64LE(stream, &header->inputSettings.delayedAutoShiftNS);
+    success &= SDL_ReadU64LE(stream, &header->inputSettings.autoRepeatRateNS);
+    success &= SDL_ReadU64LE(stream, &header->inputSettings.softDropRateNS);
+    success &= SDL_ReadU32LE(stream, &header->finalScore);
+    return success;
+}
+
+bool REPLAY_BeginRecording(ReplayRecorder* recorder, const char* path, const Uint64 seed, const InputSettings* inputSettings)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    recorder->header = (ReplayHeader){
+        .tickRate = SIM_TICK_RATE,
+        .eventCount = 0,
+        .seed = seed,
+        .tickCount = 0,
+        .inputSettings = *inputSettings,
+        .finalScore = 0,
+    };
+
+    recorder->stream = SDL_IOFromFile(path, "wb");
+    if (!recorder->stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open replay file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    // The counts are not known yet, so the header is written again when the recording ends
+    return WriteHeader(recorder->stream, &recorder->header);
+}
+
+void REPLAY_RecordCommand(ReplayRecorder* recorder, const Uint64 tick, const SimCommand* command)
+{
+    if (!recorder->stream) return;
+
+    SDL_IOStream* stream = recorder->stream;
+    bool success = true;
+    success &= SDL_WriteU64LE(stream, tick);
+    success &= SDL_WriteU8(stream, (Uint8)command->type);
+    success &= SDL_WriteU8(stream, command->key.down);
+    success &= SDL_WriteU8(stream, command->key.repeat);
+    success &= SDL_WriteU8(stream, 0);
+    success &= SDL_WriteU32LE(stream, command->key.key);
+    success &= SDL_WriteU32LE(stream, (Uint32)command->key.scancode);
+    success &= SDL_WriteU64LE(stream, command->timestamp);
+    success &= SDL_WriteU64LE(stream, command->seed);
+
+    if (!success)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write replay command, stopping recording: %s", SDL_GetError());
+        SDL_CloseIO(recorder->stream);
+        recorder->stream = NULL;
+        return;
+    }
+
+    recorder->header.eventCount++;
+}
+
+bool REPLAY_EndRecording(ReplayRecorder* recorder, const Uint64 tickCount, const int finalScore)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!recorder->stream) return false;
+
+    recorder->header.tickCount = tickCount;
+    recorder->header.finalScore = (Uint32)finalScore;
+
+    bool success = SDL_SeekIO(recorder->stream, 0, SDL_IO_SEEK_SET) == 0;
+    success = success && WriteHeader(recorder->stream, &recorder->header);
+    success &= SDL_CloseIO(recorder->stream);
+    recorder->stream = NULL;
+
+    if (!success)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to finish replay file: %s", SDL_GetError());
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Recorded %u commands over %.1fs.", recorder->header.eventCount, (double)tickCount / SIM_TICK_RATE);
+    return true;
+}
+
+bool REPLAY_Load(Replay* replay, const char* path)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *replay = (Replay){ 0 };
+
+    SDL_IOStream* stream = SDL_IOFromFile(path, "rb");
+    if (!stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open replay file '%s': %s", path, SDL_GetError());
+        return false;
+    }
+
+    bool success = ReadHeader(stream, &replay->header);
+    if (success && replay->header.tickRate != SIM_TICK_RATE)
+    {
+        success = SDL_SetError("Replay was recorded at %u ticks per second, but the simulation runs at %d", replay->header.tickRate, SIM_TICK_RATE);
+    }
+
+    if (success && replay->header.eventCount > 0)
+    {
+        replay->events = SDL_calloc(replay->header.eventCount, sizeof(ReplayEvent));
+        success = replay->events != NULL;
+    }
+
+    for (Uint32 i = 0; success && i < replay->header.eventCount; i++)
+    {
+        ReplayEvent* event = &replay->events[i];
+        Uint8 type = 0;
+        Uint8 down = 0;
+        Uint8 repeat = 0;
+        Uint8 reserved = 0;
+        Uint32 scancode = 0;
+
+        success &= SDL_ReadU64LE(stream, &event->tick);
+        success &= SDL_ReadU8(stream, &type);
+        success &= SDL_ReadU8(stream, &down);
+        success &= SDL_ReadU8(stream, &repeat);
+        success &= SDL_ReadU8(stream, &reserved);
+        success &= SDL_ReadU32LE(stream, &event->command.key.key);
+        success &= SDL_ReadU32LE(stream, &scancode);
+        success &= SDL_ReadU64LE(stream, &event->command.timestamp);
+        success &= SDL_ReadU64LE(stream, &event->command.seed);
+
+        event->command.type = (SimCommandType)type;
+        event->command.key.type = down ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+        event->command.key.timestamp = event->command.timestamp;
+        event->command.key.scancode = (SDL_Scancode)scancode;
+        event->command.key.down = down != 0;
+        event->command.key.repeat = repeat != 0;
+
+        if (success && i > 0 && event->tick < replay->events[i - 1].tick) success = SDL_SetError("Replay commands are out of order");
+    }
+
+    SDL_CloseIO(stream);
+
+    if (!success)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load replay file '%s': %s", path, SDL_GetError());
+        REPLAY_Destroy(replay);
+        return false;
+    }
+
+    return true;
+}
+
+void REPLAY_Destroy(Replay* replay)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_free(replay->events);
+    replay->events = NULL;
+}
+
+bool REPLAY_StartPlayback(ReplayPlayer* player, const Replay* replay)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    player->replay = replay;
+    player->tick = 0;
+    player->nextEvent = 0;
+
+    player->game = (GameDataContext){ 0 };
+    player->game.droppingTetromino = &player->droppingTetromino;
+    if (!GAME_ResetWithSeed(&player->game, replay->header.seed)) return false;
+    player->game.isRunning = true;
+
+    INPUT_Init(&player->inputState, &replay->header.inputSettings);
+    return true;
+}
+
+void REPLAY_AdvanceTo(ReplayPlayer* player, Uint64 tick)
+{
+    const Replay* replay = player->replay;
+    if (tick > replay->header.tickCount) tick = replay->header.tickCount;
+
+    // Each tick is played exactly as the simulation thread played it: its commands first, then the step
+    while (player->tick < tick)
+    {
+        while (player->nextEvent < replay->header.eventCount && replay->events[player->nextEvent].tick == player->tick)
+        {
+            SIM_ApplyCommand(&player->game, &player->inputState, &replay->events[player->nextEvent].command);
+            player->nextEvent++;
+        }
+
+        SIM_Tick(&player->game, &player->inputState, player->tick);
+        player->tick++;
+    }
+}
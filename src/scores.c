@@ -0,0 +1,774 @@
+#include "scores.h"
+
+#include "trace.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+typedef struct MappedFile
+{
+    /** @brief The contents of the file, or NULL if it is empty or does not exist. */
+    const Uint8* data;
+    size_t size;
+} MappedFile;
+
+/**
+ * @brief Write a 32-bit value as little endian.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void PutU32(Uint8* bytes, const Uint32 value)
+{
+    for (int i = 0; i < 4; i++) bytes[i] = (Uint8)(value >> (8 * i));
+}
+
+/**
+ * @brief Write a 64-bit value as little endian.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void PutU64(Uint8* bytes, const Uint64 value)
+{
+    for (int i = 0; i < 8; i++) bytes[i] = (Uint8)(value >> (8 * i));
+}
+
+/**
+ * @brief Read a little endian 32-bit value.
+ *
+ * @param bytes The bytes to read from.
+ *
+ * @return The value.
+ */
+static Uint32 GetU32(const Uint8* bytes)
+{
+    Uint32 value = 0;
+    for (int i = 0; i < 4; i++) value |= (Uint32)bytes[i] << (8 * i);
+    return value;
+}
+
+/**
+ * @brief Read a little endian 64-bit value.
+ *
+ * @param bytes The bytes to read from.
+ *
+ * @return The value.
+ */
+static Uint64 GetU64(const Uint8* bytes)
+{
+    Uint64 value = 0;
+    for (int i = 0; i < 8; i++) value |= (Uint64)bytes[i] << (8 * i);
+    return value;
+}
+
+/**
+ * @brief Pack a game into a record, including its checksum.
+ *
+ * @param record The game.
+ * @param bytes The record to write to.
+ */
+static void PackGame(const ScoreRecord* record, Uint8 bytes[SCORES_RECORD_SIZE])
+{
+    SDL_memset(bytes, 0, SCORES_RECORD_SIZE);
+    PutU32(bytes, SCORES_RECORD_GAME);
+    PutU32(bytes + 4, record->score);
+    PutU32(bytes + 8, record->level);
+    PutU32(bytes + 12, record->lines);
+    PutU32(bytes + 16, record->pieces);
+    PutU64(bytes + 24, record->durationNS);
+    PutU64(bytes + 32, record->seed);
+    PutU64(bytes + 40, (Uint64)record->finishedAt);
+    PutU32(bytes + SCORES_RECORD_SIZE - 4, SDL_crc32(0, bytes, SCORES_RECORD_SIZE - 4));
+}
+
+/**
+ * @brief Pack a set of totals into a record, including its checksum.
+ *
+ * @param totals The totals.
+ * @param bytes The record to write to.
+ */
+static void PackTotals(const ScoreTotals* totals, Uint8 bytes[SCORES_RECORD_SIZE])
+{
+    SDL_memset(bytes, 0, SCORES_RECORD_SIZE);
+    PutU32(bytes, SCORES_RECORD_TOTALS);
+    PutU64(bytes + 8, totals->games);
+    PutU64(bytes + 16, totals->lines);
+    PutU64(bytes + 24, totals->pieces);
+    PutU64(bytes + 32, totals->durationNS);
+    PutU32(bytes + SCORES_RECORD_SIZE - 4, SDL_crc32(0, bytes, SCORES_RECORD_SIZE - 4));
+}
+
+/**
+ * @brief Read the next record of a mapped log, stopping at the end of the log or at the first record that is cut short,
+ * fails its checksum or is of an unknown kind.
+ *
+ * @param mapped The mapped log.
+ * @param offset A pointer to the offset of the record, which is moved past it if it is valid.
+ * @param record A pointer to write a game record to.
+ * @param totals A pointer to write a totals record to.
+ *
+ * @return The ::ScoreRecordKind of the record, or 0 if there is no valid record at the offset.
+ */
+static int NextRecord(const MappedFile* mapped, size_t* offset, ScoreRecord* record, ScoreTotals* totals)
+{
+    if (*offset + SCORES_RECORD_SIZE > mapped->size) return 0;
+
+    const Uint8* bytes = mapped->data + *offset;
+    if (GetU32(bytes + SCORES_RECORD_SIZE - 4) != SDL_crc32(0, bytes, SCORES_RECORD_SIZE - 4)) return 0;
+
+    const int kind = (int)GetU32(bytes);
+    switch (kind)
+    {
+    case SCORES_RECORD_GAME:
+        record->score = GetU32(bytes + 4);
+        record->level = GetU32(bytes + 8);
+        record->lines = GetU32(bytes + 12);
+        record->pieces = GetU32(bytes + 16);
+        record->durationNS = GetU64(bytes + 24);
+        record->seed = GetU64(bytes + 32);
+        record->finishedAt = (Sint64)GetU64(bytes + 40);
+        break;
+    case SCORES_RECORD_TOTALS:
+        totals->games = GetU64(bytes + 8);
+        totals->lines = GetU64(bytes + 16);
+        totals->pieces = GetU64(bytes + 24);
+        totals->durationNS = GetU64(bytes + 32);
+        break;
+    default:
+        return 0;
+    }
+
+    *offset += SCORES_RECORD_SIZE;
+    return kind;
+}
+
+/**
+ * @brief Add one set of totals to another.
+ *
+ * @param totals A pointer to the totals to add to.
+ * @param other The totals to add.
+ */
+static void AddTotals(ScoreTotals* totals, const ScoreTotals* other)
+{
+    totals->games += other->games;
+    totals->lines += other->lines;
+    totals->pieces += other->pieces;
+    totals->durationNS += other->durationNS;
+}
+
+/**
+ * @brief Add a game to a table's totals, and to its high scores if it ranks among them.
+ *
+ * @details Games are added oldest first, so a game goes below every game already in the table with the same score.
+ *
+ * @param table A pointer to the table.
+ * @param record The game.
+ */
+static void AddGame(ScoreTable* table, const ScoreRecord* record)
+{
+    const ScoreTotals totals = { 1, record->lines, record->pieces, record->durationNS };
+    AddTotals(&table->totals, &totals);
+
+    int position = table->topCount;
+    while (position > 0 && table->top[position - 1].score < record->score) position--;
+    if (position >= SCORES_TOP_COUNT) return;
+
+    const int last = SDL_min(table->topCount, SCORES_TOP_COUNT - 1);
+    SDL_memmove(&table->top[position + 1], &table->top[position], (size_t)(last - position) * sizeof(ScoreRecord));
+    table->top[position] = *record;
+    if (table->topCount < SCORES_TOP_COUNT) table->topCount++;
+}
+
+/**
+ * @brief Check whether a game is one of a table's high scores.
+ *
+ * @param table The table.
+ * @param record The game.
+ *
+ * @return True if it is, false otherwise.
+ */
+static bool IsTopGame(const ScoreTable* table, const ScoreRecord* record)
+{
+    for (int i = 0; i < table->topCount; i++)
+    {
+        if (SDL_memcmp(&table->top[i], record, sizeof(ScoreRecord)) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Map a whole file for reading. A file that does not exist maps as empty.
+ *
+ * @param path The path of the file.
+ * @param mapped A pointer to the mapping to write to.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool MapFile(const char* path, MappedFile* mapped)
+{
+    mapped->data = NULL;
+    mapped->size = 0;
+
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return GetLastError() == ERROR_FILE_NOT_FOUND;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return true;
+    }
+
+    // The view keeps the file mapped, so neither handle is needed once it exists
+    const HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return false;
+
+    mapped->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!mapped->data) return false;
+
+    mapped->size = (size_t)size.QuadPart;
+    return true;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT;
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    if (status.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    // The mapping keeps the file open, so the descriptor is not needed once it is mapped
+    void* data = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+
+    mapped->data = data;
+    mapped->size = (size_t)status.st_size;
+    return true;
+#endif
+}
+
+/**
+ * @brief Unmap a file mapped by MapFile.
+ *
+ * @param mapped A pointer to the mapping.
+ */
+static void UnmapFile(MappedFile* mapped)
+{
+    if (mapped->data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(mapped->data);
+#else
+        munmap((void*)mapped->data, mapped->size);
+#endif
+    }
+
+    mapped->data = NULL;
+    mapped->size = 0;
+}
+
+/**
+ * @brief Check whether a mapped log starts with a valid header.
+ *
+ * @param mapped The mapped log.
+ *
+ * @return True if it does, false otherwise.
+ */
+static bool HasValidHeader(const MappedFile* mapped)
+{
+    return mapped->size >= SCORES_HEADER_SIZE && GetU32(mapped->data) == SCORES_MAGIC && GetU32(mapped->data + 4) == SCORES_VERSION;
+}
+
+/**
+ * @brief Write a log header to a stream.
+ *
+ * @param stream The stream.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool WriteHeader(SDL_IOStream* stream)
+{
+    Uint8 bytes[SCORES_HEADER_SIZE];
+    PutU32(bytes, SCORES_MAGIC);
+    PutU32(bytes + 4, SCORES_VERSION);
+    return SDL_WriteIO(stream, bytes, sizeof(bytes)) == sizeof(bytes);
+}
+
+/**
+ * @brief Read every valid record of the log into the store's table.
+ *
+ * @param store A pointer to the store.
+ * @param isNew A pointer to write whether the log is empty or does not exist, and so needs a header, to.
+ * @param isDamaged A pointer to write whether reading stopped before the end of the log to.
+ *
+ * @return True on success, false if the log could not be read or is not a score log.
+ */
+static bool ReadLog(ScoreStore* store, bool* isNew, bool* isDamaged)
+{
+    MappedFile mapped;
+    if (!MapFile(store->path, &mapped))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map score log '%s'!", store->path);
+        return false;
+    }
+
+    // A header cut short can only have come from a crash while the log was being created
+    *isNew = mapped.size < SCORES_HEADER_SIZE;
+    *isDamaged = false;
+    if (*isNew)
+    {
+        UnmapFile(&mapped);
+        return true;
+    }
+
+    if (!HasValidHeader(&mapped))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' is not a score log, so it will not be overwritten!", store->path);
+        UnmapFile(&mapped);
+        return false;
+    }
+
+    size_t offset = SCORES_HEADER_SIZE;
+    ScoreRecord record;
+    ScoreTotals totals;
+    int kind;
+    while ((kind = NextRecord(&mapped, &offset, &record, &totals)) != 0)
+    {
+        if (kind == SCORES_RECORD_GAME) AddGame(&store->table, &record);
+        else
+        {
+            AddTotals(&store->compactedTotals, &totals);
+            AddTotals(&store->table.totals, &totals);
+        }
+        store->recordCount++;
+    }
+
+    *isDamaged = offset != mapped.size;
+    if (*isDamaged) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Score log '%s' is damaged after %d records, dropping the last %zu bytes!", store->path, store->recordCount, mapped.size - offset);
+
+    UnmapFile(&mapped);
+    return true;
+}
+
+/**
+ * @brief Publish the writer thread's table for the render thread. Only called from the writer thread, or before it
+ * starts.
+ *
+ * @param store A pointer to the store.
+ */
+static void PublishTable(ScoreStore* store)
+{
+    store->tables[store->backTable] = store->table;
+
+    const int previous = SDL_SetAtomicInt(&store->sharedTable, store->backTable | SCORES_TABLE_FRESH);
+    store->backTable = previous & ~SCORES_TABLE_FRESH;
+}
+
+/**
+ * @brief Remove the oldest game from the queue. Only called from the writer thread.
+ *
+ * @param store A pointer to the store.
+ * @param record A pointer to write the game to.
+ *
+ * @return True if there was a game, false if the queue was empty.
+ */
+static bool PopRecord(ScoreStore* store, ScoreRecord* record)
+{
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&store->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&store->tail);
+    if (head == tail) return false;
+
+    *record = store->queue[head & (SCORES_QUEUE_CAPACITY - 1)];
+    SDL_SetAtomicInt(&store->head, (int)(head + 1));
+    return true;
+}
+
+/**
+ * @brief The writer thread, which appends queued games to the log until stopped.
+ *
+ * @param data A pointer to the store.
+ *
+ * @return Zero.
+ */
+static int SDLCALL ScoreWriterThread(void* data)
+{
+    ScoreStore* store = data;
+    TRACE_NameThread("ScoreWriter");
+
+    for (;;)
+    {
+        SDL_WaitSemaphore(store->pending);
+
+        // The stop flag is read before draining, so that every game queued before it was set is written
+        const bool isStopping = SDL_GetAtomicInt(&store->isStopping);
+
+        bool hasWritten = false;
+        ScoreRecord record;
+        while (PopRecord(store, &record))
+        {
+            Uint8 bytes[SCORES_RECORD_SIZE];
+            PackGame(&record, bytes);
+            if (!store->stream || SDL_WriteIO(store->stream, bytes, sizeof(bytes)) != sizeof(bytes))
+            {
+                SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write to score log '%s': %s", store->path, SDL_GetError());
+            }
+            else store->recordCount++;
+
+            AddGame(&store->table, &record);
+            hasWritten = true;
+        }
+
+        if (hasWritten)
+        {
+            if (store->stream) SDL_FlushIO(store->stream);
+            PublishTable(store);
+        }
+
+        if (store->recordCount >= SCORES_COMPACT_RECORDS) SCORES_Compact(store);
+        if (isStopping) break;
+    }
+
+    return 0;
+}
+
+bool SCORES_Open(ScoreStore* store, const char* path)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_zerop(store);
+    SDL_strlcpy(store->path, path, sizeof(store->path));
+
+    bool isNew, isDamaged;
+    if (!ReadLog(store, &isNew, &isDamaged)) return false;
+
+    if (isNew)
+    {
+        SDL_IOStream* stream = SDL_IOFromFile(path, "wb");
+        if (!stream || !WriteHeader(stream) || !SDL_FlushIO(stream))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create score log '%s': %s", path, SDL_GetError());
+            if (stream) SDL_CloseIO(stream);
+            return false;
+        }
+        SDL_CloseIO(stream);
+    }
+
+    // Compaction rewrites the log without the damaged tail and reopens it, so that new games are not appended after it
+    if (isDamaged)
+    {
+        if (!SCORES_Compact(store))
+        {
+            SCORES_Close(store);
+            return false;
+        }
+    }
+    else
+    {
+        store->stream = SDL_IOFromFile(path, "ab");
+        if (!store->stream)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open score log '%s': %s", path, SDL_GetError());
+            return false;
+        }
+    }
+
+    // Every table starts as the one just read, so the render thread always has something valid to draw
+    for (int i = 0; i < SCORES_TABLE_COUNT; i++) store->tables[i] = store->table;
+    store->backTable = 0;
+    SDL_SetAtomicInt(&store->sharedTable, 1);
+    store->frontTable = 2;
+
+    store->pending = SDL_CreateSemaphore(0);
+    if (store->pending) store->thread = SDL_CreateThread(ScoreWriterThread, "ScoreWriter", store);
+    if (!store->thread)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create score writer thread: %s", SDL_GetError());
+        SCORES_Close(store);
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Loaded %d score records (%" SDL_PRIu64 " games in total) from '%s'.", store->recordCount, store->table.totals.games, path);
+    return true;
+}
+
+void SCORES_Close(ScoreStore* store)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (store->thread)
+    {
+        SDL_SetAtomicInt(&store->isStopping, 1);
+        SDL_SignalSemaphore(store->pending);
+        SDL_WaitThread(store->thread, NULL);
+        store->thread = NULL;
+    }
+
+    if (store->pending)
+    {
+        SDL_DestroySemaphore(store->pending);
+        store->pending = NULL;
+    }
+
+    if (store->stream)
+    {
+        SDL_CloseIO(store->stream);
+        store->stream = NULL;
+    }
+
+    const int droppedRecords = SDL_GetAtomicInt(&store->droppedRecords);
+    if (droppedRecords > 0) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d games were not recorded because the score queue was full!", droppedRecords);
+}
+
+bool SCORES_Submit(ScoreStore* store, const GameDataContext* gameDataContext)
+{
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&store->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&store->tail);
+
+    if (tail - head >= SCORES_QUEUE_CAPACITY)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Score queue is full, dropping game!");
+        SDL_AddAtomicInt(&store->droppedRecords, 1);
+        return false;
+    }
+
+    SDL_Time finishedAt = 0;
+    SDL_GetCurrentTime(&finishedAt);
+
+    // The game must be written before the tail is published, which the atomic set guarantees
+    store->queue[tail & (SCORES_QUEUE_CAPACITY - 1)] = (ScoreRecord){
+        .score = (Uint32)gameDataContext->score,
+        .level = (Uint32)gameDataContext->level,
+        .lines = (Uint32)gameDataContext->linesCleared,
+        .pieces = (Uint32)gameDataContext->piecesLocked,
+        .durationNS = gameDataContext->clockNS,
+        .seed = gameDataContext->seed,
+        .finishedAt = finishedAt,
+    };
+    SDL_SetAtomicInt(&store->tail, (int)(tail + 1));
+    SDL_SignalSemaphore(store->pending);
+    return true;
+}
+
+const ScoreTable* SCORES_AcquireTable(ScoreStore* store)
+{
+    // Only swap if there is a newer table, otherwise keep drawing the current one
+    if (SDL_GetAtomicInt(&store->sharedTable) & SCORES_TABLE_FRESH)
+    {
+        const int previous = SDL_SetAtomicInt(&store->sharedTable, store->frontTable);
+        store->frontTable = previous & ~SCORES_TABLE_FRESH;
+    }
+
+    return &store->tables[store->frontTable];
+}
+
+/**
+ * @brief Force a file's contents to disk, so that it survives a power loss once it is renamed into place.
+ *
+ * @param path The path of the file.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool SyncFile(const char* path)
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    const bool isSynced = FlushFileBuffers(file);
+    CloseHandle(file);
+    return isSynced;
+#else
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    const bool isSynced = fsync(fd) == 0;
+    close(fd);
+    return isSynced;
+#endif
+}
+
+/**
+ * @brief Force the directory holding a file to disk, so that a rename into it survives a power loss.
+ *
+ * @note Windows cannot open a directory to flush it, and NTFS journals the rename itself, so this does nothing there.
+ *
+ * @param path The path of the file, whose directory is synced.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool SyncParentDirectory(const char* path)
+{
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    char directory[sizeof(((ScoreStore*)NULL)->path)];
+    SDL_strlcpy(directory, path, sizeof(directory));
+    char* separator = SDL_strrchr(directory, '/');
+    if (separator == directory) separator[1] = '\0';
+    else if (separator) *separator = '\0';
+    else SDL_strlcpy(directory, ".", sizeof(directory));
+
+    const int fd = open(directory, O_RDONLY);
+    if (fd < 0) return false;
+
+    const bool isSynced = fsync(fd) == 0;
+    close(fd);
+    return isSynced;
+#endif
+}
+
+/**
+ * @brief Write the compacted copy of a mapped log: a totals record of every game being folded away, then the high
+ * scores and the SCORES_KEEP_RECENT most recent games in their original order, so that games with the same score still
+ * rank the same.
+ *
+ * @param store A pointer to the store.
+ * @param mapped The mapped log.
+ * @param path The path to write the compacted log to.
+ * @param compactedTotals A pointer to write the totals of every game not kept, including earlier compactions, to.
+ * @param recordCount A pointer to write the number of records written to.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool WriteCompactedLog(const ScoreStore* store, const MappedFile* mapped, const char* path, ScoreTotals* compactedTotals, int* recordCount)
+{
+    // The first pass counts the games, so that the others know which are recent enough to keep
+    size_t offset = SCORES_HEADER_SIZE;
+    ScoreRecord record;
+    ScoreTotals totals;
+    int kind;
+    Uint64 gameCount = 0;
+    while ((kind = NextRecord(mapped, &offset, &record, &totals)) != 0)
+    {
+        if (kind == SCORES_RECORD_GAME) gameCount++;
+    }
+
+    const Uint64 firstRecent = (gameCount > SCORES_KEEP_RECENT) ? gameCount - SCORES_KEEP_RECENT : 0;
+    *compactedTotals = store->compactedTotals;
+    offset = SCORES_HEADER_SIZE;
+    for (Uint64 game = 0; (kind = NextRecord(mapped, &offset, &record, &totals)) != 0;)
+    {
+        if (kind != SCORES_RECORD_GAME) continue;
+        if (game++ < firstRecent && !IsTopGame(&store->table, &record))
+        {
+            const ScoreTotals folded = { 1, record.lines, record.pieces, record.durationNS };
+            AddTotals(compactedTotals, &folded);
+        }
+    }
+
+    SDL_IOStream* stream = SDL_IOFromFile(path, "wb");
+    if (!stream) return false;
+
+    Uint8 bytes[SCORES_RECORD_SIZE];
+    bool isWritten = WriteHeader(stream);
+    *recordCount = 0;
+    if (isWritten && compactedTotals->games > 0)
+    {
+        PackTotals(compactedTotals, bytes);
+        isWritten = SDL_WriteIO(stream, bytes, sizeof(bytes)) == sizeof(bytes);
+        (*recordCount)++;
+    }
+
+    offset = SCORES_HEADER_SIZE;
+    for (Uint64 game = 0; isWritten && (kind = NextRecord(mapped, &offset, &record, &totals)) != 0;)
+    {
+        if (kind != SCORES_RECORD_GAME) continue;
+        if (game++ < firstRecent && !IsTopGame(&store->table, &record)) continue;
+
+        PackGame(&record, bytes);
+        isWritten = SDL_WriteIO(stream, bytes, sizeof(bytes)) == sizeof(bytes);
+        (*recordCount)++;
+    }
+
+    if (isWritten) isWritten = SDL_FlushIO(stream);
+    isWritten = SDL_CloseIO(stream) && isWritten;
+
+    // The log is only renamed over the live one once every byte of it is on disk
+    return isWritten && SyncFile(path);
+}
+
+bool SCORES_Compact(ScoreStore* store)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    TRACE_BEGIN("SCORES_Compact");
+
+    if (store->stream)
+    {
+        SDL_CloseIO(store->stream);
+        store->stream = NULL;
+    }
+
+    char temporaryPath[sizeof(store->path) + 4];
+    SDL_snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", store->path);
+
+    bool isSuccessful = false;
+    MappedFile mapped;
+    if (!MapFile(store->path, &mapped) || !HasValidHeader(&mapped))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to map score log '%s' for compaction!", store->path);
+    }
+    else
+    {
+        ScoreTotals compactedTotals;
+        int recordCount;
+        const bool isWritten = WriteCompactedLog(store, &mapped, temporaryPath, &compactedTotals, &recordCount);
+
+        // The old log must be unmapped before it can be replaced on Windows
+        UnmapFile(&mapped);
+        if (!isWritten) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write '%s': %s", temporaryPath, SDL_GetError());
+        else if (!SDL_RenamePath(temporaryPath, store->path)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to replace score log '%s': %s", store->path, SDL_GetError());
+        else
+        {
+            // Until the directory is on disk, a power loss could still bring back the old log, which is safe
+            if (!SyncParentDirectory(store->path)) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to sync the directory of score log '%s'!", store->path);
+
+            SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Compacted score log '%s' from %d to %d records.", store->path, store->recordCount, recordCount);
+            store->compactedTotals = compactedTotals;
+            store->recordCount = recordCount;
+            isSuccessful = true;
+        }
+
+        if (!isSuccessful) SDL_RemovePath(temporaryPath);
+    }
+    UnmapFile(&mapped);
+
+    // Even if compaction failed, the old log is still intact and can be appended to
+    store->stream = SDL_IOFromFile(store->path, "ab");
+    if (!store->stream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to reopen score log '%s': %s", store->path, SDL_GetError());
+        isSuccessful = false;
+    }
+
+    TRACE_END("SCORES_Compact");
+    return isSuccessful;
+}
@@ -0,0 +1,336 @@
+#include "simulation.h"
+
+#include "bot.h"
+#include "metrics.h"
+#include "replay.h"
+#include "scores.h"
+#include "spectate.h"
+#include "trace.h"
+
+/**
+ * @brief Read the oldest command in the queue without removing it. Only called from the simulation thread.
+ *
+ * @param queue A pointer to the queue.
+ * @param command A pointer to write the command to.
+ *
+ * @return True if there was a command, false if the queue was empty.
+ */
+static bool PeekCommand(InputQueue* queue, SimCommand* command)
+{
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&queue->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&queue->tail);
+    if (head == tail) return false;
+
+    *command = queue->commands[head & (SIM_INPUT_QUEUE_CAPACITY - 1)];
+    return true;
+}
+
+/**
+ * @brief Remove the oldest command from the queue, after it has been peeked. Only called from the simulation thread.
+ *
+ * @param queue A pointer to the queue.
+ */
+static void PopCommand(InputQueue* queue)
+{
+    SDL_AddAtomicInt(&queue->head, 1);
+}
+
+/**
+ * @brief Add a command to the queue. Only called from the main thread.
+ *
+ * @param simulation A pointer to the simulation.
+ * @param command The command to add.
+ *
+ * @return True on success, false if the queue was full.
+ */
+static bool PushCommand(Simulation* simulation, const SimCommand* command)
+{
+    InputQueue* queue = &simulation->inputQueue;
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&queue->head);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&queue->tail);
+
+    if (tail - head >= SIM_INPUT_QUEUE_CAPACITY)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_INPUT, "Simulation input queue is full, dropping command!");
+        SDL_AddAtomicInt(&simulation->droppedCommands, 1);
+        return false;
+    }
+
+    // The command must be written before the tail is published, which the atomic set guarantees
+    queue->commands[tail & (SIM_INPUT_QUEUE_CAPACITY - 1)] = *command;
+    SDL_SetAtomicInt(&queue->tail, (int)(tail + 1));
+    return true;
+}
+
+/**
+ * @brief Apply a key event to the game, either as a repeating action or as a one-off action.
+ *
+ * @param gameDataContext The game to apply the event to.
+ * @param inputState The game's input state.
+ * @param event The key event.
+ */
+static void ApplyKeyEvent(GameDataContext* gameDataContext, InputState* inputState, const SDL_KeyboardEvent* event)
+{
+    // Shifting and soft dropping repeat using DAS/ARR rather than the operating system's key repeat
+    if (INPUT_HandleKeyEvent(inputState, gameDataContext, event)) return;
+    if (!event->down || event->repeat) return;
+
+    switch (event->key)
+    {
+    case SDLK_W:
+    case SDLK_UP:
+        if (!WallKickDroppingTetromino(gameDataContext, 1)) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to wall kick tetromino!");
+        break;
+    case SDLK_SPACE:
+        HardDropTetromino(gameDataContext);
+        break;
+    case SDLK_P:
+        GAME_TogglePause(gameDataContext);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Run a single tick of the game: apply the commands that happened up to the tick, then step the game.
+ *
+ * @param simulation A pointer to the simulation.
+ * @param tickTimestamp The time (in nanoseconds) the tick was scheduled for.
+ */
+static void Step(Simulation* simulation, const Uint64 tickTimestamp)
+{
+    TRACE_BEGIN("SIM_Step");
+
+    const Uint64 simulationTime = simulation->tick * SIM_TICK_NS;
+
+    SimCommand command;
+    while (PeekCommand(&simulation->inputQueue, &command) && command.timestamp <= tickTimestamp)
+    {
+        PopCommand(&simulation->inputQueue);
+        if (command.timestamp > simulation->lastInputTimestamp) simulation->lastInputTimestamp = command.timestamp;
+
+        // Move the command onto the simulation's own timeline, keeping how long before the tick it happened, so that
+        // a replay of the same commands steps the game identically
+        const Uint64 lag = SDL_min(tickTimestamp - command.timestamp, simulationTime);
+        command.timestamp = simulationTime - lag;
+        command.key.timestamp = command.timestamp;
+        if (command.type == SIM_COMMAND_RESTART) command.seed = SDL_GetPerformanceCounter();
+
+        SIM_ApplyCommand(simulation->game, simulation->inputState, &command);
+        if (simulation->recorder) REPLAY_RecordCommand(simulation->recorder, simulation->tick, &command);
+    }
+
+    // The bot places each tetromino on the tick it spawns, so it keeps up however fast gravity is, as long as each
+    // search stays within its budget
+    GameDataContext* game = simulation->game;
+    if (simulation->bot && game->isRunning && !game->isPaused && !game->isGameOver)
+    {
+        BotPlacement placement;
+        if (BOT_Search(simulation->bot, game, &placement)) BOT_PlayPlacement(game, &placement);
+    }
+
+    SIM_Tick(simulation->game, simulation->inputState, simulation->tick);
+    simulation->tick++;
+
+    if (simulation->scores && game->isGameOver && !simulation->wasGameOver) SCORES_Submit(simulation->scores, game);
+    simulation->wasGameOver = game->isGameOver;
+
+    if (simulation->spectate) SPECTATE_Publish(simulation->spectate, game, simulation->tick);
+
+    TRACE_END("SIM_Step");
+}
+
+/**
+ * @brief Copy the game into a snapshot.
+ *
+ * @param simulation A pointer to the simulation.
+ * @param snapshot A pointer to the snapshot to write to.
+ */
+static void WriteSnapshot(const Simulation* simulation, GameSnapshot* snapshot)
+{
+    snapshot->game = *simulation->game;
+    snapshot->droppingTetromino = *simulation->game->droppingTetromino;
+    snapshot->game.droppingTetromino = &snapshot->droppingTetromino;
+    snapshot->game.opponent = NULL;
+    snapshot->game.eventListenerCount = 0;
+
+    snapshot->tick = simulation->tick;
+    snapshot->lastInputTimestamp = simulation->lastInputTimestamp;
+    snapshot->publishTimestamp = SDL_GetTicksNS();
+    snapshot->worstStepNS = simulation->worstStepNS;
+}
+
+/**
+ * @brief Write the back snapshot, then swap it with the shared snapshot so the render thread can take it.
+ *
+ * @param simulation A pointer to the simulation.
+ */
+static void PublishSnapshot(Simulation* simulation)
+{
+    WriteSnapshot(simulation, &simulation->snapshots[simulation->backSnapshot]);
+    simulation->worstStepNS = 0;
+
+    const int previous = SDL_SetAtomicInt(&simulation->sharedSnapshot, simulation->backSnapshot | SIM_SNAPSHOT_FRESH);
+    simulation->backSnapshot = previous & ~SIM_SNAPSHOT_FRESH;
+}
+
+/**
+ * @brief The simulation thread, which steps the game at a fixed rate until stopped.
+ *
+ * @param data A pointer to the simulation.
+ *
+ * @return Zero.
+ */
+static int SDLCALL SimulationThread(void* data)
+{
+    Simulation* simulation = data;
+    TRACE_NameThread("Simulation");
+    SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_HIGH);
+
+    const Uint64 tickNS = SIM_TICK_NS;
+    Uint64 nextTick = SDL_GetTicksNS();
+
+    while (!SDL_GetAtomicInt(&simulation->isStopping))
+    {
+        Uint64 now = SDL_GetTicksNS();
+        if (now < nextTick)
+        {
+            SDL_DelayPrecise(nextTick - now);
+            continue;
+        }
+
+        // Run every tick that is due, so the game keeps time even if the thread was descheduled
+        int ticks = 0;
+        while (now >= nextTick && ticks < SIM_MAX_CATCH_UP_TICKS)
+        {
+            // Time each step for the profiler, which only runs on the render thread
+            const Uint64 stepStart = SDL_GetTicksNS();
+            Step(simulation, nextTick);
+            simulation->worstStepNS = SDL_max(simulation->worstStepNS, SDL_GetTicksNS() - stepStart);
+            nextTick += tickNS;
+            ticks++;
+        }
+
+        // If the game has fallen too far behind (e.g. the process was suspended), skip ahead rather than fast forward
+        if (now >= nextTick)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Simulation fell behind by %dms, skipping ahead!", (int)SDL_NS_TO_MS(now - nextTick));
+            nextTick = now + tickNS;
+        }
+
+        PublishSnapshot(simulation);
+        METRICS_Flush();
+    }
+
+    return 0;
+}
+
+bool SIM_Start(Simulation* simulation, GameDataContext* gameDataContext, InputState* inputState)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    simulation->game = gameDataContext;
+    simulation->inputState = inputState;
+    simulation->tick = 0;
+    simulation->lastInputTimestamp = 0;
+    simulation->worstStepNS = 0;
+    simulation->wasGameOver = gameDataContext->isGameOver;
+    SDL_SetAtomicInt(&simulation->inputQueue.head, 0);
+    SDL_SetAtomicInt(&simulation->inputQueue.tail, 0);
+    SDL_SetAtomicInt(&simulation->droppedCommands, 0);
+    SDL_SetAtomicInt(&simulation->isStopping, 0);
+
+    // Every snapshot starts as the initial state, so the render thread always has something valid to draw
+    for (int i = 0; i < SIM_SNAPSHOT_COUNT; i++) WriteSnapshot(simulation, &simulation->snapshots[i]);
+    simulation->backSnapshot = 0;
+    SDL_SetAtomicInt(&simulation->sharedSnapshot, 1);
+    simulation->frontSnapshot = 2;
+
+    simulation->thread = SDL_CreateThread(SimulationThread, "Simulation", simulation);
+    if (!simulation->thread)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create simulation thread: %s", SDL_GetError());
+        return false;
+    }
+
+    return true;
+}
+
+void SIM_Stop(Simulation* simulation)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!simulation->thread) return;
+
+    SDL_SetAtomicInt(&simulation->isStopping, 1);
+    SDL_WaitThread(simulation->thread, NULL);
+    simulation->thread = NULL;
+
+    const int droppedCommands = SDL_GetAtomicInt(&simulation->droppedCommands);
+    if (droppedCommands > 0) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d commands were dropped because the input queue was full!", droppedCommands);
+}
+
+void SIM_ApplyCommand(GameDataContext* gameDataContext, InputState* inputState, const SimCommand* command)
+{
+    switch (command->type)
+    {
+    case SIM_COMMAND_KEY:
+        ApplyKeyEvent(gameDataContext, inputState, &command->key);
+        break;
+    case SIM_COMMAND_TOGGLE_PAUSE:
+        GAME_TogglePause(gameDataContext);
+        break;
+    case SIM_COMMAND_RESTART:
+        GAME_ResetWithSeed(gameDataContext, command->seed);
+        break;
+    case SIM_COMMAND_QUIT:
+        GAME_Quit(gameDataContext);
+        break;
+    }
+}
+
+void SIM_Tick(GameDataContext* gameDataContext, InputState* inputState, const Uint64 tick)
+{
+    INPUT_Update(inputState, gameDataContext, tick * SIM_TICK_NS);
+    GAME_Iteration(gameDataContext, SIM_TICK_NS);
+}
+
+bool SIM_PushKeyEvent(Simulation* simulation, const SDL_KeyboardEvent* event)
+{
+    const SimCommand command = { SIM_COMMAND_KEY, event->timestamp, *event, 0 };
+    return PushCommand(simulation, &command);
+}
+
+bool SIM_PushCommand(Simulation* simulation, const SimCommandType type)
+{
+    const SimCommand command = { .type = type, .timestamp = SDL_GetTicksNS() };
+    return PushCommand(simulation, &command);
+}
+
+GameSnapshot* SIM_AcquireSnapshot(Simulation* simulation)
+{
+    // Only swap if there is a newer snapshot, otherwise keep drawing the current one
+    if (SDL_GetAtomicInt(&simulation->sharedSnapshot) & SIM_SNAPSHOT_FRESH)
+    {
+        const int previous = SDL_SetAtomicInt(&simulation->sharedSnapshot, simulation->frontSnapshot);
+        simulation->frontSnapshot = previous & ~SIM_SNAPSHOT_FRESH;
+    }
+
+    return &simulation->snapshots[simulation->frontSnapshot];
+}
+
+void SIM_Restart(void* data)
+{
+    SIM_PushCommand(data, SIM_COMMAND_RESTART);
+}
+
+void SIM_TogglePause(void* data)
+{
+    SIM_PushCommand(data, SIM_COMMAND_TOGGLE_PAUSE);
+}
+
+void SIM_Quit(void* data)
+{
+    SIM_PushCommand(data, SIM_COMMAND_QUIT);
+}
@@ -0,0 +1,986 @@
+#include "spectate.h"
+
+#include "graphics.h"
+#include "tetromino.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+typedef SOCKET SpectateSocket;
+#define SPECTATE_INVALID_SOCKET INVALID_SOCKET
+#else
+typedef int SpectateSocket;
+#define SPECTATE_INVALID_SOCKET (-1)
+#endif
+
+// A spectator that disconnects mid-send must not kill the broadcaster with SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define SPECTATE_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SPECTATE_SEND_FLAGS 0
+#endif
+
+/**
+ * @brief The sizes (in bytes) of each part of an encoded frame.
+ */
+enum SpectateLayout
+{
+    /** @brief The frame's size (Uint16), type (Uint8) and tick (Uint32). */
+    SPECTATE_HEADER_BYTES = 2 + 1 + 4,
+
+    /** @brief The mask of the arena rows the frame carries (Uint32). */
+    SPECTATE_ROW_MASK_BYTES = 4,
+
+    /** @brief The next queue, with two identifiers packed per byte. */
+    SPECTATE_NEXT_QUEUE_BYTES = (NEXT_QUEUE_PREVIEW_COUNT + 1) / 2,
+
+    /** @brief The flags, piece identifier and orientation, piece x and y, score (Uint32), level and lines (Uint16) and next queue. */
+    SPECTATE_STATE_BYTES = 1 + 1 + 1 + 1 + 4 + 2 + 2 + SPECTATE_NEXT_QUEUE_BYTES,
+
+    /** @brief An arena row, with two cells packed per byte. */
+    SPECTATE_ROW_BYTES = ARENA_WIDTH / 2,
+
+    /** @brief The smallest valid frame, which carries no arena rows. */
+    SPECTATE_MIN_FRAME_BYTES = SPECTATE_HEADER_BYTES + SPECTATE_ROW_MASK_BYTES + SPECTATE_STATE_BYTES,
+};
+
+SDL_COMPILE_TIME_ASSERT(SpectateRowsFitMask, ARENA_HEIGHT <= 32);
+SDL_COMPILE_TIME_ASSERT(SpectateCellsPackInPairs, ARENA_WIDTH % 2 == 0 && GARBAGE < 16);
+SDL_COMPILE_TIME_ASSERT(SpectateKeyframeFits, SPECTATE_MIN_FRAME_BYTES + ARENA_HEIGHT * SPECTATE_ROW_BYTES <= SPECTATE_MAX_FRAME_BYTES);
+
+/**
+ * @brief The bits of the flags byte of a frame's state.
+ */
+enum SpectateFlags
+{
+    SPECTATE_FLAG_RUNNING = 1 << 0,
+    SPECTATE_FLAG_PAUSED = 1 << 1,
+    SPECTATE_FLAG_GAME_OVER = 1 << 2,
+};
+
+/**
+ * @brief An encoded frame waiting to be sent.
+ */
+typedef struct SpectateFrame
+{
+    int size;
+    Uint8 bytes[SPECTATE_MAX_FRAME_BYTES];
+} SpectateFrame;
+
+/**
+ * @brief A connected spectator, and the frames it has not been sent yet.
+ */
+typedef struct SpectateClient
+{
+    SpectateSocket socket;
+
+    /** @brief Whether the spectator has been sent a keyframe, before which deltas would mean nothing to it. */
+    bool isSynced;
+
+    /** @brief The bytes waiting to be sent, from pendingStart up to pendingEnd. */
+    Uint8 pending[SPECTATE_CLIENT_BUFFER_BYTES];
+    int pendingStart;
+    int pendingEnd;
+} SpectateClient;
+
+/**
+ * @brief A parsed address to listen on or connect to.
+ */
+typedef struct SpectateAddress
+{
+    struct sockaddr_storage storage;
+    socklen_t length;
+    bool isTCP;
+} SpectateAddress;
+
+struct SpectateServer
+{
+    /** @brief The arena and state the last queued frame left spectators with, owned by the simulation thread. */
+    TetrominoIdentifier sentArena[ARENA_HEIGHT][ARENA_WIDTH];
+    Uint8 sentState[SPECTATE_STATE_BYTES];
+
+    /** @brief Whether a frame has been queued yet, and whether the next must be a keyframe because one was dropped. */
+    bool hasSent;
+    bool isKeyframeDue;
+    Uint64 lastKeyframeTick;
+
+    /** @brief Encoding counts and timings, owned by the simulation thread. */
+    Uint64 publishes;
+    Uint64 frames;
+    Uint64 keyframes;
+    Uint64 frameBytes;
+    Uint64 encodeNS;
+    Uint64 worstEncodeNS;
+
+    /** @brief Frames waiting to be sent. Only the simulation thread writes tail, and only the sender thread head. */
+    SpectateFrame queue[SPECTATE_FRAME_QUEUE_CAPACITY];
+    SDL_AtomicInt queueHead;
+    SDL_AtomicInt queueTail;
+    SDL_AtomicInt droppedFrames;
+
+    /** @brief Set by the sender thread when a spectator joins, so that the next frame is a keyframe. */
+    SDL_AtomicInt isKeyframeRequested;
+
+    /** @brief The listening socket and the connected spectators, owned by the sender thread. */
+    SpectateSocket listener;
+    bool isTCP;
+    char unixPath[108];
+    SpectateClient clients[SPECTATE_MAX_CLIENTS];
+    int clientCount;
+    int spectatorsServed;
+
+    /** @brief Signalled when the sender thread should stop. */
+    SDL_Semaphore* wake;
+
+    SDL_AtomicInt isStopping;
+    SDL_Thread* sender;
+};
+
+struct SpectateViewer
+{
+    SpectateSocket socket;
+
+    /** @brief The game decoded from the stream, whose droppingTetromino points to the one below. */
+    GameDataContext game;
+    DroppingTetromino droppingTetromino;
+
+    /** @brief Whether a keyframe has been received, before which deltas are ignored. */
+    bool isSynced;
+
+    /** @brief The bytes received but not yet applied, which end part way through a frame. */
+    Uint8 buffer[SPECTATE_CLIENT_BUFFER_BYTES];
+    int bufferSize;
+
+    Uint64 frames;
+    Uint64 bytes;
+};
+
+/**
+ * @brief Start the platform's sockets, which only needs doing on Windows.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool StartSockets(void)
+{
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start Winsock!");
+        return false;
+    }
+#endif
+    return true;
+}
+
+/**
+ * @brief Stop the platform's sockets, once for each successful call to StartSockets.
+ */
+static void StopSockets(void)
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+/**
+ * @brief Close a socket.
+ *
+ * @param socket The socket.
+ */
+static void CloseSocket(const SpectateSocket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+/**
+ * @brief Whether the last socket call failed only because it would have blocked.
+ *
+ * @return True if it would have blocked, false if it failed for any other reason.
+ */
+static bool WouldBlock(void)
+{
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+/**
+ * @brief Make a connected (or listening) socket non-blocking, and send small frames immediately over TCP.
+ *
+ * @param socket The socket.
+ * @param isTCP Whether the socket is TCP rather than a Unix domain socket.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool ConfigureSocket(const SpectateSocket socket, const bool isTCP)
+{
+#ifdef _WIN32
+    u_long isNonBlocking = 1;
+    if (ioctlsocket(socket, FIONBIO, &isNonBlocking) != 0) return false;
+#else
+    const int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) < 0) return false;
+#endif
+
+#ifdef SO_NOSIGPIPE
+    const int isNoSigPipe = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &isNoSigPipe, sizeof(isNoSigPipe));
+#endif
+
+    // Frames are small and sent as soon as they are encoded, so waiting to coalesce them would only add latency
+    if (isTCP)
+    {
+        const int isNoDelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&isNoDelay, sizeof(isNoDelay));
+    }
+
+    return true;
+}
+
+/**
+ * @brief Parse an address, which is either "tcp:PORT" on the loopback interface or the path of a Unix domain socket.
+ *
+ * @param text The address.
+ * @param address The parsed address to write to.
+ *
+ * @return True on success, false if the address is not valid.
+ */
+static bool ParseAddress(const char* text, SpectateAddress* address)
+{
+    SDL_zerop(address);
+
+    if (!SDL_strncmp(text, "tcp:", 4))
+    {
+        const int port = SDL_atoi(text + 4);
+        if (port <= 0 || port > 65535)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid spectator port in '%s'!", text);
+            return false;
+        }
+
+        // Spectators are local, so the broadcast is never exposed beyond the loopback interface
+        struct sockaddr_in* inet = (struct sockaddr_in*)&address->storage;
+        inet->sin_family = AF_INET;
+        inet->sin_port = htons((Uint16)port);
+        inet->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address->length = sizeof(*inet);
+        address->isTCP = true;
+        return true;
+    }
+
+#ifdef _WIN32
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Unix domain sockets are not supported on Windows, use 'tcp:PORT' instead of '%s'!", text);
+    return false;
+#else
+    struct sockaddr_un* local = (struct sockaddr_un*)&address->storage;
+    if (SDL_strlen(text) >= sizeof(local->sun_path))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Spectator socket path '%s' is too long!", text);
+        return false;
+    }
+
+    local->sun_family = AF_UNIX;
+    SDL_strlcpy(local->sun_path, text, sizeof(local->sun_path));
+    address->length = sizeof(*local);
+    address->isTCP = false;
+    return true;
+#endif
+}
+
+/**
+ * @brief Write a little-endian Uint16.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void WriteU16(Uint8* bytes, const Uint16 value)
+{
+    bytes[0] = (Uint8)value;
+    bytes[1] = (Uint8)(value >> 8);
+}
+
+/**
+ * @brief Write a little-endian Uint32.
+ *
+ * @param bytes The bytes to write to.
+ * @param value The value.
+ */
+static void WriteU32(Uint8* bytes, const Uint32 value)
+{
+    bytes[0] = (Uint8)value;
+    bytes[1] = (Uint8)(value >> 8);
+    bytes[2] = (Uint8)(value >> 16);
+    bytes[3] = (Uint8)(value >> 24);
+}
+
+/**
+ * @brief Read a little-endian Uint16.
+ *
+ * @param bytes The bytes to read from.
+ *
+ * @return The value.
+ */
+static Uint16 ReadU16(const Uint8* bytes)
+{
+    return (Uint16)(bytes[0] | bytes[1] << 8);
+}
+
+/**
+ * @brief Read a little-endian Uint32.
+ *
+ * @param bytes The bytes to read from.
+ *
+ * @return The value.
+ */
+static Uint32 ReadU32(const Uint8* bytes)
+{
+    return (Uint32)bytes[0] | (Uint32)bytes[1] << 8 | (Uint32)bytes[2] << 16 | (Uint32)bytes[3] << 24;
+}
+
+/**
+ * @brief Encode everything but the arena: the flags, the piece pose and the HUD values.
+ *
+ * @param gameDataContext The game.
+ * @param state The SPECTATE_STATE_BYTES bytes to write to.
+ */
+static void EncodeState(const GameDataContext* gameDataContext, Uint8* state)
+{
+    state[0] = (Uint8)((gameDataContext->isRunning ? SPECTATE_FLAG_RUNNING : 0)
+        | (gameDataContext->isPaused ? SPECTATE_FLAG_PAUSED : 0)
+        | (gameDataContext->isGameOver ? SPECTATE_FLAG_GAME_OVER : 0));
+
+    const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+    const int identifier = droppingTetromino->shape ? (int)droppingTetromino->shape->identifier : 0;
+    state[1] = (Uint8)(identifier | (int)droppingTetromino->orientation << 4);
+    state[2] = (Uint8)(Sint8)droppingTetromino->x;
+    state[3] = (Uint8)(Sint8)droppingTetromino->y;
+
+    WriteU32(&state[4], (Uint32)gameDataContext->score);
+    WriteU16(&state[8], (Uint16)gameDataContext->level);
+    WriteU16(&state[10], (Uint16)gameDataContext->linesCleared);
+
+    int count;
+    const TetrominoIdentifier* queue = PeekTetrominoQueue(&gameDataContext->tetrominoBag, &count);
+    if (count > NEXT_QUEUE_PREVIEW_COUNT) count = NEXT_QUEUE_PREVIEW_COUNT;
+
+    Uint8* next = &state[12];
+    SDL_memset(next, 0, SPECTATE_NEXT_QUEUE_BYTES);
+    for (int i = 0; i < count; i++) next[i / 2] |= (Uint8)(queue[i] << ((i & 1) * 4));
+}
+
+/**
+ * @brief Add the time a publish took to the encoding timings.
+ *
+ * @param server A pointer to the server.
+ * @param startNS The time (in nanoseconds) the publish started.
+ */
+static void AddEncodeTime(SpectateServer* server, const Uint64 startNS)
+{
+    const Uint64 elapsedNS = SDL_GetTicksNS() - startNS;
+    server->publishes++;
+    server->encodeNS += elapsedNS;
+    if (elapsedNS > server->worstEncodeNS) server->worstEncodeNS = elapsedNS;
+}
+
+void SPECTATE_Publish(SpectateServer* server, const GameDataContext* gameDataContext, const Uint64 tick)
+{
+    const Uint64 startNS = SDL_GetTicksNS();
+
+    Uint8 state[SPECTATE_STATE_BYTES];
+    EncodeState(gameDataContext, state);
+
+    // A spectator that has just joined needs a keyframe to start from, as does every spectator once a frame is dropped
+    const bool isRequested = SDL_GetAtomicInt(&server->isKeyframeRequested) && SDL_SetAtomicInt(&server->isKeyframeRequested, 0);
+    const bool isKeyframe = !server->hasSent || server->isKeyframeDue || isRequested
+        || tick - server->lastKeyframeTick >= SPECTATE_KEYFRAME_INTERVAL_TICKS;
+
+    // A row is only ARENA_WIDTH cells, so comparing them all each tick costs far less than sending anything
+    Uint32 rowMask = 0;
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        if (isKeyframe || SDL_memcmp(gameDataContext->arena[row], server->sentArena[row], sizeof(server->sentArena[row])) != 0)
+        {
+            rowMask |= 1u << row;
+        }
+    }
+
+    if (!isKeyframe && rowMask == 0 && !SDL_memcmp(state, server->sentState, sizeof(state)))
+    {
+        AddEncodeTime(server, startNS);
+        return;
+    }
+
+    const Uint32 head = (Uint32)SDL_GetAtomicInt(&server->queueHead);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&server->queueTail);
+    if (tail - head >= SPECTATE_FRAME_QUEUE_CAPACITY)
+    {
+        // Later deltas would build on this one, so spectators are resynced with a keyframe once there is room
+        SDL_AddAtomicInt(&server->droppedFrames, 1);
+        server->isKeyframeDue = true;
+        AddEncodeTime(server, startNS);
+        return;
+    }
+
+    SpectateFrame* frame = &server->queue[tail & (SPECTATE_FRAME_QUEUE_CAPACITY - 1)];
+    Uint8* bytes = frame->bytes;
+    bytes[2] = (Uint8)(isKeyframe ? SPECTATE_FRAME_KEYFRAME : SPECTATE_FRAME_DELTA);
+    WriteU32(&bytes[3], (Uint32)tick);
+    WriteU32(&bytes[SPECTATE_HEADER_BYTES], rowMask);
+    SDL_memcpy(&bytes[SPECTATE_HEADER_BYTES + SPECTATE_ROW_MASK_BYTES], state, sizeof(state));
+
+    int size = SPECTATE_MIN_FRAME_BYTES;
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        if (!(rowMask & (1u << row))) continue;
+
+        const TetrominoIdentifier* cells = gameDataContext->arena[row];
+        for (int col = 0; col < ARENA_WIDTH; col += 2) bytes[size++] = (Uint8)(cells[col] | cells[col + 1] << 4);
+        SDL_memcpy(server->sentArena[row], cells, sizeof(server->sentArena[row]));
+    }
+
+    WriteU16(bytes, (Uint16)size);
+    frame->size = size;
+    SDL_memcpy(server->sentState, state, sizeof(state));
+
+    server->hasSent = true;
+    server->isKeyframeDue = false;
+    if (isKeyframe)
+    {
+        server->lastKeyframeTick = tick;
+        server->keyframes++;
+    }
+    server->frames++;
+    server->frameBytes += (Uint64)size;
+
+    // The frame must be written before the tail is published, which the atomic set guarantees
+    SDL_SetAtomicInt(&server->queueTail, (int)(tail + 1));
+
+    AddEncodeTime(server, startNS);
+}
+
+/**
+ * @brief Disconnect a spectator, replacing it with the last so the spectators stay packed.
+ *
+ * @param server A pointer to the server.
+ * @param index The index of the spectator.
+ */
+static void RemoveClient(SpectateServer* server, const int index)
+{
+    CloseSocket(server->clients[index].socket);
+
+    server->clientCount--;
+    if (index != server->clientCount) server->clients[index] = server->clients[server->clientCount];
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Spectator left, %d watching.", server->clientCount);
+}
+
+/**
+ * @brief Accept every spectator waiting to join, and ask for a keyframe so they can start watching.
+ *
+ * @param server A pointer to the server.
+ */
+static void AcceptClients(SpectateServer* server)
+{
+    for (;;)
+    {
+        const SpectateSocket socket = accept(server->listener, NULL, NULL);
+        if (socket == SPECTATE_INVALID_SOCKET) return;
+
+        if (server->clientCount >= SPECTATE_MAX_CLIENTS)
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d spectators are already watching, turning another away!", SPECTATE_MAX_CLIENTS);
+            CloseSocket(socket);
+            continue;
+        }
+
+        if (!ConfigureSocket(socket, server->isTCP))
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to configure spectator socket, turning it away!");
+            CloseSocket(socket);
+            continue;
+        }
+
+        SpectateClient* client = &server->clients[server->clientCount++];
+        client->socket = socket;
+        client->isSynced = false;
+        client->pendingStart = 0;
+        client->pendingEnd = 0;
+        server->spectatorsServed++;
+
+        SDL_SetAtomicInt(&server->isKeyframeRequested, 1);
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Spectator joined, %d watching.", server->clientCount);
+    }
+}
+
+/**
+ * @brief Add a frame to the bytes waiting to be sent to a spectator.
+ *
+ * @param client A pointer to the spectator.
+ * @param frame The frame.
+ *
+ * @return True on success, false if the spectator has fallen too far behind to hold it.
+ */
+static bool AppendFrame(SpectateClient* client, const SpectateFrame* frame)
+{
+    if (client->pendingEnd + frame->size > SPECTATE_CLIENT_BUFFER_BYTES)
+    {
+        const int pendingSize = client->pendingEnd - client->pendingStart;
+        SDL_memmove(client->pending, &client->pending[client->pendingStart], (size_t)pendingSize);
+        client->pendingStart = 0;
+        client->pendingEnd = pendingSize;
+
+        if (client->pendingEnd + frame->size > SPECTATE_CLIENT_BUFFER_BYTES) return false;
+    }
+
+    SDL_memcpy(&client->pending[client->pendingEnd], frame->bytes, (size_t)frame->size);
+    client->pendingEnd += frame->size;
+    return true;
+}
+
+/**
+ * @brief Take every queued frame and add it to each spectator's pending bytes, starting each from a keyframe.
+ *
+ * @param server A pointer to the server.
+ */
+static void DrainQueue(SpectateServer* server)
+{
+    Uint32 head = (Uint32)SDL_GetAtomicInt(&server->queueHead);
+    const Uint32 tail = (Uint32)SDL_GetAtomicInt(&server->queueTail);
+
+    for (; head != tail; head++)
+    {
+        const SpectateFrame* frame = &server->queue[head & (SPECTATE_FRAME_QUEUE_CAPACITY - 1)];
+        const bool isKeyframe = frame->bytes[2] == SPECTATE_FRAME_KEYFRAME;
+
+        int i = 0;
+        while (i < server->clientCount)
+        {
+            SpectateClient* client = &server->clients[i];
+            if (isKeyframe) client->isSynced = true;
+
+            if (client->isSynced && !AppendFrame(client, frame))
+            {
+                // Letting a slow spectator's backlog grow without bound would only make it fall further behind
+                SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Spectator fell too far behind, disconnecting it!");
+                RemoveClient(server, i);
+                continue;
+            }
+            i++;
+        }
+    }
+
+    SDL_SetAtomicInt(&server->queueHead, (int)head);
+}
+
+/**
+ * @brief Send as many pending bytes to each spectator as its socket takes without blocking.
+ *
+ * @param server A pointer to the server.
+ */
+static void SendPending(SpectateServer* server)
+{
+    int i = 0;
+    while (i < server->clientCount)
+    {
+        SpectateClient* client = &server->clients[i];
+        const int pendingSize = client->pendingEnd - client->pendingStart;
+        if (pendingSize == 0)
+        {
+            i++;
+            continue;
+        }
+
+        const int sent = (int)send(client->socket, (const char*)&client->pending[client->pendingStart], pendingSize, SPECTATE_SEND_FLAGS);
+        if (sent < 0 && !WouldBlock())
+        {
+            RemoveClient(server, i);
+            continue;
+        }
+
+        if (sent > 0) client->pendingStart += sent;
+        if (client->pendingStart == client->pendingEnd)
+        {
+            client->pendingStart = 0;
+            client->pendingEnd = 0;
+        }
+        i++;
+    }
+}
+
+/**
+ * @brief The sender thread, which owns every socket and sends the queued frames until stopped.
+ *
+ * @param data A pointer to the server.
+ *
+ * @return Zero.
+ */
+static int SDLCALL SenderThread(void* data)
+{
+    SpectateServer* server = data;
+    TRACE_NameThread("SpectateSender");
+
+    while (!SDL_GetAtomicInt(&server->isStopping))
+    {
+        AcceptClients(server);
+        DrainQueue(server);
+        SendPending(server);
+
+        SDL_WaitSemaphoreTimeout(server->wake, SPECTATE_SEND_INTERVAL_MS);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Open the non-blocking listening socket of a server.
+ *
+ * @param server A pointer to the server.
+ * @param text The address to listen on.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool OpenListener(SpectateServer* server, const char* text)
+{
+    SpectateAddress address;
+    if (!ParseAddress(text, &address)) return false;
+
+    server->isTCP = address.isTCP;
+    server->listener = socket(address.storage.ss_family, SOCK_STREAM, 0);
+    if (server->listener == SPECTATE_INVALID_SOCKET)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create spectator socket!");
+        return false;
+    }
+
+    if (address.isTCP)
+    {
+        const int isReusable = 1;
+        setsockopt(server->listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&isReusable, sizeof(isReusable));
+    }
+#ifndef _WIN32
+    else
+    {
+        // A broadcast that crashed leaves its socket behind, which would stop the path being bound again
+        struct stat info;
+        if (stat(text, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(text);
+        SDL_strlcpy(server->unixPath, text, sizeof(server->unixPath));
+    }
+#endif
+
+    if (bind(server->listener, (const struct sockaddr*)&address.storage, address.length) != 0 || listen(server->listener, SOMAXCONN) != 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to listen for spectators on '%s'!", text);
+        server->unixPath[0] = '\0';
+        return false;
+    }
+
+    if (!ConfigureSocket(server->listener, false))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to configure spectator socket!");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Close every socket a server has open, remove its Unix domain socket and free it.
+ *
+ * @param server A pointer to the server.
+ */
+static void FreeServer(SpectateServer* server)
+{
+    while (server->clientCount > 0) RemoveClient(server, server->clientCount - 1);
+    if (server->listener != SPECTATE_INVALID_SOCKET) CloseSocket(server->listener);
+#ifndef _WIN32
+    if (server->unixPath[0] != '\0') unlink(server->unixPath);
+#endif
+    if (server->wake) SDL_DestroySemaphore(server->wake);
+
+    SDL_free(server);
+    StopSockets();
+}
+
+SpectateServer* SPECTATE_CreateServer(const char* address)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!StartSockets()) return NULL;
+
+    SpectateServer* server = SDL_calloc(1, sizeof(SpectateServer));
+    if (!server)
+    {
+        StopSockets();
+        return NULL;
+    }
+    server->listener = SPECTATE_INVALID_SOCKET;
+
+    if (!OpenListener(server, address))
+    {
+        FreeServer(server);
+        return NULL;
+    }
+
+    server->wake = SDL_CreateSemaphore(0);
+    server->sender = server->wake ? SDL_CreateThread(SenderThread, "SpectateSender", server) : NULL;
+    if (!server->sender)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start spectator sender thread: %s", SDL_GetError());
+        FreeServer(server);
+        return NULL;
+    }
+
+    SDL_Log("Broadcasting to spectators on '%s'.", address);
+    return server;
+}
+
+void SPECTATE_DestroyServer(SpectateServer* server)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!server) return;
+
+    SDL_SetAtomicInt(&server->isStopping, 1);
+    SDL_SignalSemaphore(server->wake);
+    SDL_WaitThread(server->sender, NULL);
+
+    SDL_Log("Broadcast %" SDL_PRIu64 " frames (%" SDL_PRIu64 " keyframes, %.1f bytes each) to %d spectators, encoding in %.2fus per tick (worst %.2fus).",
+        server->frames, server->keyframes,
+        (server->frames > 0) ? (double)server->frameBytes / (double)server->frames : 0.0,
+        server->spectatorsServed,
+        (server->publishes > 0) ? (double)server->encodeNS / (double)server->publishes / 1000.0 : 0.0,
+        (double)server->worstEncodeNS / 1000.0);
+
+    const int droppedFrames = SDL_GetAtomicInt(&server->droppedFrames);
+    if (droppedFrames > 0) SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "%d spectator frames were dropped because the queue was full!", droppedFrames);
+
+    FreeServer(server);
+}
+
+/**
+ * @brief Stop a viewer's game and close its socket, once the broadcast has ended or sent something unreadable.
+ *
+ * @param viewer A pointer to the viewer.
+ */
+static void EndStream(SpectateViewer* viewer)
+{
+    if (viewer->socket != SPECTATE_INVALID_SOCKET) CloseSocket(viewer->socket);
+    viewer->socket = SPECTATE_INVALID_SOCKET;
+    viewer->game.isRunning = false;
+}
+
+/**
+ * @brief Decode everything but the arena into a viewer's game.
+ *
+ * @param viewer A pointer to the viewer.
+ * @param state The SPECTATE_STATE_BYTES bytes to read from.
+ */
+static void DecodeState(SpectateViewer* viewer, const Uint8* state)
+{
+    GameDataContext* game = &viewer->game;
+    game->isRunning = state[0] & SPECTATE_FLAG_RUNNING;
+    game->isPaused = state[0] & SPECTATE_FLAG_PAUSED;
+    game->isGameOver = state[0] & SPECTATE_FLAG_GAME_OVER;
+
+    const int identifier = state[1] & 0x0F;
+    if (identifier >= I && identifier <= J) viewer->droppingTetromino.shape = GetTetrominoShapeByIdentifier((TetrominoIdentifier)identifier);
+    viewer->droppingTetromino.orientation = (enum Orientation)((state[1] >> 4) & 3);
+    viewer->droppingTetromino.x = (Sint8)state[2];
+    viewer->droppingTetromino.y = (Sint8)state[3];
+
+    game->score = (int)ReadU32(&state[4]);
+    game->level = ReadU16(&state[8]);
+    game->linesCleared = ReadU16(&state[10]);
+
+    // The queue is rebuilt from its start each time, so it never needs refilling
+    TetrominoBag* bag = &game->tetrominoBag;
+    Uint32 count = 0;
+    for (int i = 0; i < NEXT_QUEUE_PREVIEW_COUNT; i++)
+    {
+        const int next = (state[12 + i / 2] >> ((i & 1) * 4)) & 0x0F;
+        if (next < I || next > J) break;
+
+        bag->queue[count] = (TetrominoIdentifier)next;
+        bag->queue[count + TETROMINO_QUEUE_CAPACITY] = (TetrominoIdentifier)next;
+        count++;
+    }
+    bag->drawCount = 0;
+    bag->queuedCount = count;
+}
+
+/**
+ * @brief Apply a whole frame to a viewer's game, ignoring deltas until the first keyframe.
+ *
+ * @param viewer A pointer to the viewer.
+ * @param bytes The frame.
+ * @param size The size (in bytes) of the frame, which has already been checked to be in range.
+ *
+ * @return True on success, false if the frame is malformed.
+ */
+static bool ApplyFrame(SpectateViewer* viewer, const Uint8* bytes, const int size)
+{
+    const int type = bytes[2];
+    if (type != SPECTATE_FRAME_KEYFRAME && type != SPECTATE_FRAME_DELTA) return false;
+    if (type == SPECTATE_FRAME_KEYFRAME) viewer->isSynced = true;
+    if (!viewer->isSynced) return true;
+
+    const Uint32 rowMask = ReadU32(&bytes[SPECTATE_HEADER_BYTES]);
+    int rowCount = 0;
+    for (int row = 0; row < ARENA_HEIGHT; row++) rowCount += (rowMask >> row) & 1;
+    if ((rowMask >> (ARENA_HEIGHT - 1)) > 1 || size != SPECTATE_MIN_FRAME_BYTES + rowCount * SPECTATE_ROW_BYTES) return false;
+
+    DecodeState(viewer, &bytes[SPECTATE_HEADER_BYTES + SPECTATE_ROW_MASK_BYTES]);
+
+    const Uint8* packed = &bytes[SPECTATE_MIN_FRAME_BYTES];
+    for (int row = 0; row < ARENA_HEIGHT; row++)
+    {
+        if (!(rowMask & (1u << row))) continue;
+
+        TetrominoIdentifier* cells = viewer->game.arena[row];
+        for (int col = 0; col < ARENA_WIDTH; col += 2)
+        {
+            // Cells index the block textures, so anything out of range would be read past them
+            const int left = *packed & 0x0F;
+            const int right = *packed >> 4;
+            if (left > GARBAGE || right > GARBAGE) return false;
+
+            cells[col] = (TetrominoIdentifier)left;
+            cells[col + 1] = (TetrominoIdentifier)right;
+            packed++;
+        }
+    }
+
+    viewer->frames++;
+    return true;
+}
+
+GameDataContext* SPECTATE_Receive(SpectateViewer* viewer)
+{
+    if (viewer->socket == SPECTATE_INVALID_SOCKET) return &viewer->game;
+
+    while (viewer->bufferSize < (int)sizeof(viewer->buffer))
+    {
+        const int received = (int)recv(viewer->socket, (char*)&viewer->buffer[viewer->bufferSize], (int)sizeof(viewer->buffer) - viewer->bufferSize, 0);
+        if (received > 0)
+        {
+            viewer->bufferSize += received;
+            viewer->bytes += (Uint64)received;
+            continue;
+        }
+        if (received < 0 && WouldBlock()) break;
+
+        SDL_Log("The broadcast has ended.");
+        EndStream(viewer);
+        break;
+    }
+
+    int offset = 0;
+    while (viewer->bufferSize - offset >= 2)
+    {
+        const int size = ReadU16(&viewer->buffer[offset]);
+        const bool isValidSize = size >= SPECTATE_MIN_FRAME_BYTES && size <= SPECTATE_MAX_FRAME_BYTES;
+        if (isValidSize && viewer->bufferSize - offset < size) break;
+
+        if (!isValidSize || !ApplyFrame(viewer, &viewer->buffer[offset], size))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Received a malformed spectator frame, so stopping watching!");
+            EndStream(viewer);
+            offset = viewer->bufferSize;
+            break;
+        }
+        offset += size;
+    }
+
+    // Keep the start of a frame that has not fully arrived for next time
+    SDL_memmove(viewer->buffer, &viewer->buffer[offset], (size_t)(viewer->bufferSize - offset));
+    viewer->bufferSize -= offset;
+
+    return &viewer->game;
+}
+
+SpectateViewer* SPECTATE_Connect(const char* address)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SpectateAddress parsed;
+    if (!ParseAddress(address, &parsed)) return NULL;
+    if (!StartSockets()) return NULL;
+
+    SpectateViewer* viewer = SDL_calloc(1, sizeof(SpectateViewer));
+    if (!viewer)
+    {
+        StopSockets();
+        return NULL;
+    }
+
+    viewer->socket = socket(parsed.storage.ss_family, SOCK_STREAM, 0);
+    if (viewer->socket == SPECTATE_INVALID_SOCKET || connect(viewer->socket, (const struct sockaddr*)&parsed.storage, parsed.length) != 0
+        || !ConfigureSocket(viewer->socket, parsed.isTCP))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to connect to broadcast on '%s'!", address);
+        SPECTATE_Disconnect(viewer);
+        return NULL;
+    }
+
+    // Nothing is drawn until the first keyframe, so the game only needs to be valid enough to be drawn after it
+    viewer->game.droppingTetromino = &viewer->droppingTetromino;
+    viewer->droppingTetromino.shape = GetTetrominoShapeByIdentifier(I);
+    viewer->game.isRunning = true;
+
+    // The server sends a keyframe as soon as it sees a spectator join, so this is normally only a few milliseconds
+    const Uint64 deadline = SDL_GetTicks() + SPECTATE_CONNECT_TIMEOUT_MS;
+    while (!viewer->isSynced && viewer->game.isRunning && SDL_GetTicks() < deadline)
+    {
+        SPECTATE_Receive(viewer);
+        if (!viewer->isSynced) SDL_Delay(1);
+    }
+
+    if (!viewer->isSynced)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Broadcast on '%s' did not send a keyframe!", address);
+        SPECTATE_Disconnect(viewer);
+        return NULL;
+    }
+
+    SDL_Log("Watching broadcast on '%s'.", address);
+    return viewer;
+}
+
+void SPECTATE_Disconnect(SpectateViewer* viewer)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!viewer) return;
+
+    if (viewer->frames > 0) SDL_Log("Watched %" SDL_PRIu64 " frames (%" SDL_PRIu64 " bytes).", viewer->frames, viewer->bytes);
+
+    if (viewer->socket != SPECTATE_INVALID_SOCKET) CloseSocket(viewer->socket);
+    SDL_free(viewer);
+    StopSockets();
+}
+
+void SPECTATE_StopViewing(void* data)
+{
+    SpectateViewer* viewer = data;
+    EndStream(viewer);
+}
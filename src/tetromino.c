@@ -3,7 +3,7 @@
 
 #include "tetromino.h"
 
-TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifier)
+const TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifier)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
@@ -11,7 +11,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceI =
     {
         I,
-        NULL,
         {
             {
                 {0, 0, 0, 0},
@@ -44,7 +43,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceO =
     {
         O,
-        NULL,
         {
             {
                 {0, 1, 1, 0},
@@ -76,7 +74,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceT =
     {
         T,
-        NULL,
         {
             {
                 {0, 1, 0, 0},
@@ -108,7 +105,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceZ =
     {
         Z,
-        NULL,
         {
             {
                 {1, 1, 0, 0},
@@ -140,7 +136,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceS =
     {
         S,
-        NULL,
         {
             {
                 {0, 1, 1, 0},
@@ -172,7 +167,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceL =
     {
         L,
-        NULL,
         {
             {
                 {0, 0, 1, 0},
@@ -204,7 +198,6 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     static TetrominoShape pieceJ =
     {
         J,
-        NULL,
         {
             {
                 {1, 0, 0, 0},
@@ -244,33 +237,74 @@ TetrominoShape* GetTetrominoShapeByIdentifier(const TetrominoIdentifier identifi
     return tetrominoes[identifier - 1]; // Identifiers are 1-indexed, array is 0-indexed
 }
 
-void InitTetrominoBag(TetrominoBag* bag)
+void SeedTetrominoBag(TetrominoBag* bag, const Uint64 seed)
 {
     SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
-    bag->dropCount = 0;
+    bag->randomState = seed;
+    InitTetrominoBag(bag);
+}
+
+/**
+ * @brief Shuffle a new bag onto the end of the next queue.
+ *
+ * @param bag A pointer to the TetrominoBag state.
+ */
+static void QueueShuffledBag(TetrominoBag* bag)
+{
+    SDL_LogTrace(SDL_LOG_CATEGORY_APPLICATION, "Shuffling bag");
+
+    int pieces[TETROMINO_COUNT];
     for (int i = 0; i < TETROMINO_COUNT; i++) {
-        bag->bag[i] = (TetrominoIdentifier)(i + 1);
+        pieces[i] = i + 1;
     }
-    SDL_LogTrace(SDL_LOG_CATEGORY_APPLICATION, "Shuffling bag");
-    Shuffle(bag->bag, TETROMINO_COUNT);
+    Shuffle(pieces, TETROMINO_COUNT, &bag->randomState);
+
+    for (int i = 0; i < TETROMINO_COUNT; i++) {
+        const Uint32 index = (bag->queuedCount + (Uint32)i) & (TETROMINO_QUEUE_CAPACITY - 1);
+        bag->queue[index] = (TetrominoIdentifier)pieces[i];
+        bag->queue[index + TETROMINO_QUEUE_CAPACITY] = (TetrominoIdentifier)pieces[i];
+    }
+    bag->queuedCount += TETROMINO_COUNT;
+}
+
+void InitTetrominoBag(TetrominoBag* bag)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    bag->drawCount = 0;
+    bag->queuedCount = 0;
+    while (bag->queuedCount < TETROMINO_QUEUE_LENGTH) QueueShuffledBag(bag);
 }
 
 const TetrominoShape* NextTetrominoFromBag(TetrominoBag* bag)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
-    if (bag->dropCount >= TETROMINO_COUNT) {
-        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Reached end of tetromino bag, regenerating bag...");
-        InitTetrominoBag(bag); // reshuffle
-    }
+    const TetrominoShape* tetromino = GetTetrominoShapeByIdentifier(bag->queue[bag->drawCount & (TETROMINO_QUEUE_CAPACITY - 1)]);
+    bag->drawCount++;
 
-    const TetrominoShape* tetromino = GetTetrominoShapeByIdentifier(bag->bag[bag->dropCount]);
+    // Bags are shuffled in the same order as they would be if each were shuffled only once the last was empty, so
+    // the sequence of tetrominoes for a seed does not depend on how far ahead the queue looks
+    if (bag->queuedCount - bag->drawCount < TETROMINO_QUEUE_LENGTH) {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Next queue running short, queueing another bag...");
+        QueueShuffledBag(bag);
+    }
 
-    bag->dropCount++;
     return tetromino;
 }
 
+const TetrominoIdentifier* PeekTetrominoQueue(const TetrominoBag* bag, int* count)
+{
+    *count = (int)(bag->queuedCount - bag->drawCount);
+    return &bag->queue[bag->drawCount & (TETROMINO_QUEUE_CAPACITY - 1)];
+}
+
+int GetTetrominoBagPosition(const TetrominoBag* bag)
+{
+    return (int)(bag->drawCount % TETROMINO_COUNT);
+}
+
 void RotateDroppingTetromino(DroppingTetromino* droppingTetromino, const int rotationAmount)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
@@ -280,7 +314,7 @@ void RotateDroppingTetromino(DroppingTetromino* droppingTetromino, const int rot
     droppingTetromino->orientation = (droppingTetromino->orientation + rotationAmount) & 3;
 }
 
-void Shuffle(int* array, const size_t n)
+void Shuffle(int* array, const size_t n, Uint64* randomState)
 {
     SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
 
@@ -290,7 +324,7 @@ void Shuffle(int* array, const size_t n)
         for (size_t i = 0; i < n - 1; i++)
         {
             // Pick a random index from i to n-1
-            const size_t j = i + SDL_rand(n - i);
+            const size_t j = i + SDL_rand_r(randomState, (Sint32)(n - i));
 
             // Swap array[i] and array[j]
             const int t = array[j];
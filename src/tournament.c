@@ -0,0 +1,358 @@
+#include "tournament.h"
+
+#include "bot.h"
+#include "profiler.h"
+#include "util.h"
+
+/**
+ * @brief Get the game shown on a board.
+ *
+ * @param board A pointer to the board.
+ *
+ * @return The replay's game if the board plays one back, or the bot's game otherwise.
+ */
+static GameDataContext* GetBoardGame(TournamentBoard* board)
+{
+    return board->replay ? &board->player.game : &board->game;
+}
+
+/**
+ * @brief Start a board's next game: the next seed for the bot, or its replay again from the start.
+ *
+ * @param wall A pointer to the wall.
+ * @param index The index of the board.
+ *
+ * @return True on success, false otherwise.
+ */
+static bool StartBoardGame(TournamentWall* wall, const int index)
+{
+    TournamentBoard* board = &wall->boards[index];
+    board->startTick = wall->tick;
+    board->games++;
+
+    if (board->replay) return REPLAY_StartPlayback(&board->player, board->replay);
+
+    // Stagger the bots' first moves across a move interval, so that they do not all search on the same frame
+    board->nextMoveTick = wall->tick + (Uint64)(TOURNAMENT_BOT_MOVE_TICKS * index / wall->boardCount) + 1;
+    board->game.droppingTetromino = &board->droppingTetromino;
+    if (!GAME_ResetWithSeed(&board->game, wall->seed + (Uint64)index + (board->games - 1) * (Uint64)wall->boardCount)) return false;
+    board->game.isRunning = true;
+    return true;
+}
+
+/**
+ * @brief Count a finished game towards the wall's totals.
+ *
+ * @param wall A pointer to the wall.
+ * @param game The finished game.
+ */
+static void RecordFinishedGame(TournamentWall* wall, const GameDataContext* game)
+{
+    wall->finishedGames++;
+    wall->linesCleared += (Uint64)game->linesCleared;
+    if (game->score > wall->bestScore) wall->bestScore = game->score;
+}
+
+bool TOURNAMENT_Init(TournamentWall* wall, const int boardCount, const char* const* replayPaths, const int replayCount, const Uint64 seed)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (boardCount < TOURNAMENT_MIN_BOARDS || boardCount > TOURNAMENT_MAX_BOARDS || replayCount < 0 || replayCount > boardCount)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "A tournament wall needs %d to %d boards, and no more replays than boards!", TOURNAMENT_MIN_BOARDS, TOURNAMENT_MAX_BOARDS);
+        return false;
+    }
+
+    wall->boardCount = boardCount;
+    wall->seed = seed;
+
+    // Every board is drawn with the same number of quads, so both buffers are sized once for the whole wall
+    const int quadCount = boardCount * TOURNAMENT_BOARD_QUADS;
+    wall->vertices = SDL_malloc(sizeof(SDL_Vertex) * (size_t)quadCount * 4);
+    wall->indices = SDL_malloc(sizeof(int) * (size_t)quadCount * 6);
+    wall->labelVertices = SDL_malloc(sizeof(SDL_Vertex) * (size_t)boardCount * MAX_STRING_LENGTH * 4);
+    if (!wall->vertices || !wall->indices || !wall->labelVertices)
+    {
+        TOURNAMENT_Destroy(wall);
+        return false;
+    }
+
+    // Every quad is two triangles, so the indices never change
+    for (int i = 0; i < quadCount; i++)
+    {
+        int* quadIndices = &wall->indices[i * 6];
+        quadIndices[0] = i * 4;
+        quadIndices[1] = i * 4 + 1;
+        quadIndices[2] = i * 4 + 2;
+        quadIndices[3] = i * 4;
+        quadIndices[4] = i * 4 + 2;
+        quadIndices[5] = i * 4 + 3;
+    }
+
+    for (int i = 0; i < replayCount; i++)
+    {
+        if (!REPLAY_Load(&wall->replays[i], replayPaths[i]))
+        {
+            TOURNAMENT_Destroy(wall);
+            return false;
+        }
+        wall->replayCount++;
+        wall->boards[i].replay = &wall->replays[i];
+    }
+
+    for (int i = 0; i < boardCount; i++)
+    {
+        if (!StartBoardGame(wall, i))
+        {
+            TOURNAMENT_Destroy(wall);
+            return false;
+        }
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Created a tournament wall of %d boards (%d replays, %d bots).", boardCount, replayCount, boardCount - replayCount);
+    return true;
+}
+
+void TOURNAMENT_Destroy(TournamentWall* wall)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (wall->tick > 0)
+    {
+        SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Tournament wall ran %d boards for %.1fs: %" SDL_PRIu64 " games finished, best score %d, %" SDL_PRIu64 " lines cleared.",
+            wall->boardCount, (double)wall->tick / SIM_TICK_RATE, wall->finishedGames, wall->bestScore, wall->linesCleared);
+    }
+
+    for (int i = 0; i < wall->replayCount; i++) REPLAY_Destroy(&wall->replays[i]);
+    SDL_free(wall->vertices);
+    SDL_free(wall->indices);
+    SDL_free(wall->labelVertices);
+    SDL_zerop(wall);
+}
+
+void TOURNAMENT_Update(TournamentWall* wall, const Uint64 nowNS)
+{
+    // Advance by whole ticks only, carrying the remainder, and never by more than the simulation would catch up
+    if (wall->lastTickNS == 0) wall->lastTickNS = nowNS;
+    Uint64 ticks = (nowNS - wall->lastTickNS) / SIM_TICK_NS;
+    wall->lastTickNS += ticks * SIM_TICK_NS;
+    if (ticks > SIM_MAX_CATCH_UP_TICKS)
+    {
+        ticks = SIM_MAX_CATCH_UP_TICKS;
+        wall->lastTickNS = nowNS;
+    }
+    if (ticks == 0) return;
+
+    wall->tick += ticks;
+
+    for (int i = 0; i < wall->boardCount; i++)
+    {
+        TournamentBoard* board = &wall->boards[i];
+
+        if (board->replay)
+        {
+            // A replay that has finished is held on its last frame, then played again
+            const Uint64 replayTicks = board->replay->header.tickCount;
+            if (board->player.tick < replayTicks)
+            {
+                REPLAY_AdvanceTo(&board->player, wall->tick - board->startTick);
+                if (board->player.tick >= replayTicks) RecordFinishedGame(wall, &board->player.game);
+            }
+            else if (wall->tick - board->startTick >= replayTicks + TOURNAMENT_GAME_OVER_TICKS)
+            {
+                StartBoardGame(wall, i);
+            }
+            continue;
+        }
+
+        GameDataContext* game = &board->game;
+        if (game->isGameOver)
+        {
+            if (wall->tick >= board->nextMoveTick) StartBoardGame(wall, i);
+            continue;
+        }
+
+        GAME_Iteration(game, ticks * SIM_TICK_NS);
+
+        if (!game->isGameOver && wall->tick >= board->nextMoveTick)
+        {
+            BotPlacement placement;
+            if (BOT_FindPlacement(game, &placement)) BOT_PlayPlacement(game, &placement);
+            board->nextMoveTick = wall->tick + TOURNAMENT_BOT_MOVE_TICKS;
+        }
+
+        // Gravity or the bot's move may have ended the game, which is then shown for a while before the next starts
+        if (game->isGameOver)
+        {
+            RecordFinishedGame(wall, game);
+            board->nextMoveTick = wall->tick + TOURNAMENT_GAME_OVER_TICKS;
+        }
+    }
+}
+
+/**
+ * @brief Work out how many columns of boards fill the render output with the largest boards, and where the wall goes.
+ *
+ * @param wall A pointer to the wall.
+ * @param width The width (in pixels) of the render output.
+ * @param height The height (in pixels) of the render output.
+ */
+static void UpdateLayout(TournamentWall* wall, const int width, const int height)
+{
+    const SDL_FRect bounds = { 0, 0, (float)width, (float)height };
+    float bestSquareSize = -1;
+
+    for (int columns = 1; columns <= wall->boardCount; columns++)
+    {
+        const int rows = (wall->boardCount + columns - 1) / columns;
+        const ScaledGrid grid = FitScaledGrid(bounds, (float)(columns * TOURNAMENT_BOARD_GRID_WIDTH), (float)(rows * TOURNAMENT_BOARD_GRID_HEIGHT));
+        if (grid.squareSize > bestSquareSize)
+        {
+            bestSquareSize = grid.squareSize;
+            wall->columns = columns;
+            wall->wallGrid = grid;
+        }
+    }
+
+    wall->layoutWidth = width;
+    wall->layoutHeight = height;
+    SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Laid out %d boards in %d columns with grid squares of %f...", wall->boardCount, wall->columns, bestSquareSize);
+}
+
+/**
+ * @brief Write a quad covering a rectangle, textured with a cell of the block atlas.
+ *
+ * @param quad The four vertices to write.
+ * @param rect The rectangle (in pixels).
+ * @param cell The cell of the block atlas, which is a ::TetrominoIdentifier, or 0 for solid white.
+ * @param color The color the cell is multiplied by.
+ */
+static void WriteAtlasQuad(SDL_Vertex* quad, const SDL_FRect rect, const int cell, const SDL_FColor color)
+{
+    // Sample half a texel inside the cell, so that filtering never bleeds in its neighbours
+    const float cellWidth = 1.0f / (float)(GARBAGE + 1);
+    const float insetU = 0.5f / (float)(BLOCK_ATLAS_CELL_SIZE * (GARBAGE + 1));
+    const float insetV = 0.5f / (float)BLOCK_ATLAS_CELL_SIZE;
+    const float u0 = (float)cell * cellWidth + insetU;
+    const float u1 = (float)(cell + 1) * cellWidth - insetU;
+
+    quad[0] = (SDL_Vertex){ { rect.x, rect.y }, color, { u0, insetV } };
+    quad[1] = (SDL_Vertex){ { rect.x + rect.w, rect.y }, color, { u1, insetV } };
+    quad[2] = (SDL_Vertex){ { rect.x + rect.w, rect.y + rect.h }, color, { u1, 1.0f - insetV } };
+    quad[3] = (SDL_Vertex){ { rect.x, rect.y + rect.h }, color, { u0, 1.0f - insetV } };
+}
+
+/**
+ * @brief Write the quads of a tetromino, in its orientation, at a position on a board.
+ *
+ * @param quads The four quads to write, of which those for blocks left out are made empty.
+ * @param grid The board's grid.
+ * @param droppingTetromino The tetromino.
+ * @param y The row of the tetromino's matrix.
+ * @param color The color the blocks are multiplied by.
+ */
+static void WriteTetrominoQuads(SDL_Vertex* quads, const ScaledGrid grid, const DroppingTetromino* droppingTetromino, const int y, const SDL_FColor color)
+{
+    const bool (*coordinates)[TETROMINO_MAX_SIZE] = droppingTetromino->shape->coordinates[droppingTetromino->orientation];
+    int block = 0;
+
+    for (int i = 0; i < TETROMINO_MAX_SIZE && block < 4; i++)
+    {
+        for (int j = 0; j < TETROMINO_MAX_SIZE && block < 4; j++)
+        {
+            if (!coordinates[i][j]) continue;
+
+            // Blocks above the arena (as a tetromino spawns) are left out, the same as DrawBlock refuses them
+            const int col = droppingTetromino->x + j;
+            const int row = y + i;
+            const bool isInArena = col >= 0 && col < ARENA_WIDTH && row >= 0 && row < ARENA_HEIGHT;
+            const SDL_FRect rect = isInArena ? ScaledGridRectToFRect(grid, (FGridRect){ (float)col, (float)row, 1, 1 }, 0) : (SDL_FRect){ 0 };
+            WriteAtlasQuad(&quads[block * 4], rect, droppingTetromino->shape->identifier, color);
+            block++;
+        }
+    }
+
+    for (; block < 4; block++) WriteAtlasQuad(&quads[block * 4], (SDL_FRect){ 0 }, 0, color);
+}
+
+bool TOURNAMENT_Render(TournamentWall* wall, GraphicsDataContext* graphicsDataContext, const Fonts* fonts)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_RENDER, "Calling %s...", __func__);
+
+    SDL_SetRenderDrawColor(graphicsDataContext->renderer, 17, 17, 17, 255);
+    SDL_RenderClear(graphicsDataContext->renderer);
+    PROFILER_CountDrawCall();
+
+    int width = 0;
+    int height = 0;
+    if (!SDL_GetCurrentRenderOutputSize(graphicsDataContext->renderer, &width, &height)) return false;
+    if (width != wall->layoutWidth || height != wall->layoutHeight) UpdateLayout(wall, width, height);
+
+    // The same colours as DrawArena: grey grid lines between dark empty cells, and the ghost at the same alpha
+    const SDL_FColor gridColor = { 32.0f / 255.0f, 32.0f / 255.0f, 32.0f / 255.0f, 1.0f };
+    const SDL_FColor emptyColor = { 17.0f / 255.0f, 17.0f / 255.0f, 17.0f / 255.0f, 1.0f };
+    const SDL_FColor blockColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const SDL_FColor overColor = { 0.35f, 0.35f, 0.35f, 1.0f };
+    const SDL_FColor ghostColor = { 1.0f, 1.0f, 1.0f, 50.0f / 255.0f };
+    const SDL_Color labelColor = { 255, 255, 255, 255 };
+    const float squareSize = wall->wallGrid.squareSize;
+    const float cellMargin = 0.04f;
+
+    int labelQuads = 0;
+
+    for (int i = 0; i < wall->boardCount; i++)
+    {
+        const GameDataContext* game = GetBoardGame(&wall->boards[i]);
+        SDL_Vertex* quads = &wall->vertices[i * TOURNAMENT_BOARD_QUADS * 4];
+
+        // Each board is on its own grid, offset from the wall's by its place in the layout and half a square of padding
+        const int column = i % wall->columns;
+        const int row = i / wall->columns;
+        const ScaledGrid grid = {
+            wall->wallGrid.x + ((float)(column * TOURNAMENT_BOARD_GRID_WIDTH) + 0.5f) * squareSize,
+            wall->wallGrid.y + ((float)(row * TOURNAMENT_BOARD_GRID_HEIGHT) + 0.5f) * squareSize,
+            squareSize
+        };
+
+        WriteAtlasQuad(quads, ScaledGridRectToFRect(grid, (FGridRect){ 0, 0, ARENA_WIDTH, ARENA_HEIGHT }, 0), 0, gridColor);
+        quads += 4;
+
+        // A finished game is dimmed while it is shown
+        const SDL_FColor cellColor = game->isGameOver ? overColor : blockColor;
+        for (int y = 0; y < ARENA_HEIGHT; y++)
+        {
+            for (int x = 0; x < ARENA_WIDTH; x++)
+            {
+                const TetrominoIdentifier identifier = game->arena[y][x];
+                const float margin = identifier ? 0 : cellMargin;
+                WriteAtlasQuad(quads, ScaledGridRectToFRect(grid, (FGridRect){ (float)x, (float)y, 1, 1 }, margin), (int)identifier, identifier ? cellColor : emptyColor);
+                quads += 4;
+            }
+        }
+
+        const DroppingTetromino* droppingTetromino = game->droppingTetromino;
+        int ghostY = droppingTetromino->y;
+        if (!game->isGameOver)
+        {
+            int translationY = 0;
+            while (!WillDroppingTetrominoCollide(game, 0, translationY + 1, 0)) translationY++;
+            ghostY += translationY;
+        }
+        WriteTetrominoQuads(quads, grid, droppingTetromino, ghostY, ghostColor);
+        WriteTetrominoQuads(quads + 4 * 4, grid, droppingTetromino, droppingTetromino->y, cellColor);
+
+        char label[MAX_STRING_LENGTH];
+        SDL_snprintf(label, sizeof(label), "%s %d  %d", wall->boards[i].replay ? "REPLAY" : "BOT", i + 1, game->score);
+        const SDL_FRect labelBounds = ScaledGridRectToFRect(grid, (FGridRect){ 0, ARENA_HEIGHT, ARENA_WIDTH, 1 }, 0.1f);
+        labelQuads += BuildTextGeometry(&fonts->secondaryFontAtlas, labelBounds, label, labelColor, &wall->labelVertices[labelQuads * 4]);
+    }
+
+    const int quadCount = wall->boardCount * TOURNAMENT_BOARD_QUADS;
+    PROFILER_CountDrawCall();
+    if (!SDL_RenderGeometry(graphicsDataContext->renderer, graphicsDataContext->blockAtlas, wall->vertices, quadCount * 4, wall->indices, quadCount * 6)) return false;
+
+    if (labelQuads == 0) return true;
+
+    PROFILER_CountDrawCall();
+    return SDL_RenderGeometry(graphicsDataContext->renderer, fonts->secondaryFontAtlas.texture, wall->labelVertices, labelQuads * 4, wall->indices, labelQuads * 6);
+}
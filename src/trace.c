@@ -0,0 +1,294 @@
+#include "trace.h"
+
+#include "util.h"
+
+/**
+ * @brief A single begin or end event.
+ */
+typedef struct TraceEvent
+{
+    const char* name;
+    Uint64 timestamp;
+    char phase;
+} TraceEvent;
+
+/**
+ * @brief The events recorded by a single thread, in a ring that each flush drains.
+ *
+ * @details Only the owning thread writes events. It publishes each one by incrementing head after the event is
+ * written, and a flush (holding the trace lock) writes every event from tail up to head and then advances tail, so the
+ * two never touch the same slot. The counters only ever increase, wrapping, so head - tail is the number waiting.
+ */
+typedef struct TraceBuffer
+{
+    SDL_ThreadID threadId;
+    const char* threadName;
+
+    /** @brief Whether the thread's name has been written to the file. Guarded by the trace lock. */
+    bool isNameWritten;
+
+    SDL_AtomicU32 head;
+    SDL_AtomicU32 tail;
+    SDL_AtomicInt droppedCount;
+    struct TraceBuffer* next;
+    TraceEvent events[TRACE_BUFFER_CAPACITY];
+} TraceBuffer;
+
+bool traceEnabled = false;
+
+/** @brief The path of the trace file. */
+static char tracePath[256];
+
+/** @brief The trace file, open from TRACE_Init onwards. Each flush appends to it. */
+static SDL_IOStream* traceStream = NULL;
+
+/** @brief Whether an event has been written to the file yet, so that the rest are preceded by a comma. */
+static bool isFirstEventWritten = false;
+
+/** @brief Guards the file, the list of buffers and the draining of each buffer. */
+static SDL_Mutex* traceLock = NULL;
+
+/** @brief The head of the list of every running thread's buffer. */
+static TraceBuffer* traceBuffers = NULL;
+
+/** @brief The thread local storage slot holding each thread's buffer, which frees it when the thread exits. */
+static SDL_TLSID traceBufferTLS;
+
+/** @brief The calling thread's buffer, cached so that recording does not look up the TLS slot. */
+static THREAD_LOCAL TraceBuffer* threadBuffer = NULL;
+
+/** @brief The timestamp (in nanoseconds) of the first event, so timestamps in the file start near zero. */
+static Uint64 traceStartTimestamp = 0;
+
+/**
+ * @brief Write a string to the trace file as a JSON string, escaping any quotes, backslashes and control characters.
+ *
+ * @param string The string.
+ */
+static void WriteJSONString(const char* string)
+{
+    char escaped[256];
+    size_t length = 0;
+
+    escaped[length++] = '"';
+    for (const char* c = string; *c && length < sizeof(escaped) - 8; c++)
+    {
+        const unsigned char character = (unsigned char)*c;
+        if (character == '"' || character == '\\')
+        {
+            escaped[length++] = '\\';
+            escaped[length++] = (char)character;
+        }
+        else if (character < 0x20)
+        {
+            length += (size_t)SDL_snprintf(escaped + length, sizeof(escaped) - length, "\\u%04x", character);
+        }
+        else
+        {
+            escaped[length++] = (char)character;
+        }
+    }
+    escaped[length++] = '"';
+
+    SDL_WriteIO(traceStream, escaped, length);
+}
+
+/**
+ * @brief Write the separator before an entry of the trace file's array.
+ */
+static void WriteSeparator(void)
+{
+    SDL_WriteIO(traceStream, isFirstEventWritten ? ",\n" : "\n", isFirstEventWritten ? 2 : 1);
+    isFirstEventWritten = true;
+}
+
+/**
+ * @brief Write a buffer's thread name (if it has not been already) and every event waiting in it to the trace file,
+ * leaving the buffer empty. The trace lock must be held.
+ *
+ * @param buffer A pointer to the buffer.
+ *
+ * @return The number of events written.
+ */
+static int DrainBuffer(TraceBuffer* buffer)
+{
+    const Uint64 threadId = (Uint64)buffer->threadId;
+
+    if (buffer->threadName && !buffer->isNameWritten)
+    {
+        WriteSeparator();
+        SDL_IOprintf(traceStream, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"args\":{\"name\":", threadId);
+        WriteJSONString(buffer->threadName);
+        SDL_IOprintf(traceStream, "}}");
+        buffer->isNameWritten = true;
+    }
+
+    const Uint32 head = SDL_GetAtomicU32(&buffer->head);
+    const Uint32 tail = SDL_GetAtomicU32(&buffer->tail);
+    for (Uint32 i = tail; i != head; i++)
+    {
+        const TraceEvent* event = &buffer->events[i % TRACE_BUFFER_CAPACITY];
+        const Uint64 timestamp = (event->timestamp > traceStartTimestamp) ? event->timestamp - traceStartTimestamp : 0;
+
+        // Timestamps are in microseconds
+        WriteSeparator();
+        SDL_IOprintf(traceStream, "{\"name\":");
+        WriteJSONString(event->name);
+        SDL_IOprintf(traceStream, ",\"ph\":\"%c\",\"pid\":1,\"tid\":%" SDL_PRIu64 ",\"ts\":%" SDL_PRIu64 ".%03d}",
+            event->phase, threadId, timestamp / 1000, (int)(timestamp % 1000));
+    }
+
+    // Only now can the owning thread reuse the slots
+    SDL_SetAtomicU32(&buffer->tail, head);
+
+    const int dropped = SDL_SetAtomicInt(&buffer->droppedCount, 0);
+    if (dropped > 0)
+    {
+        SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Trace buffer of thread %" SDL_PRIu64 " was full, %d events were dropped!", threadId, dropped);
+    }
+
+    return (int)(head - tail);
+}
+
+/**
+ * @brief Write an exiting thread's remaining events to the trace file, then unregister and free its buffer. This is
+ * an SDL_TLSDestructorCallback.
+ *
+ * @param data A pointer to the thread's buffer.
+ */
+static void SDLCALL ReleaseThreadBuffer(void* data)
+{
+    TraceBuffer* buffer = data;
+    threadBuffer = NULL;
+
+    SDL_LockMutex(traceLock);
+    DrainBuffer(buffer);
+
+    TraceBuffer** link = &traceBuffers;
+    while (*link && *link != buffer) link = &(*link)->next;
+    if (*link) *link = buffer->next;
+    SDL_UnlockMutex(traceLock);
+
+    SDL_free(buffer);
+}
+
+/**
+ * @brief Get the calling thread's buffer, creating and registering it on first use.
+ *
+ * @return A pointer to the buffer, or NULL if it could not be allocated.
+ */
+static TraceBuffer* GetThreadBuffer(void)
+{
+    if (threadBuffer) return threadBuffer;
+
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Allocating trace buffer for thread %" SDL_PRIu64 "...", (Uint64)SDL_GetCurrentThreadID());
+    TraceBuffer* buffer = SDL_calloc(1, sizeof(TraceBuffer));
+    if (!buffer) return NULL;
+
+    buffer->threadId = SDL_GetCurrentThreadID();
+    if (!SDL_SetTLS(&traceBufferTLS, buffer, ReleaseThreadBuffer))
+    {
+        SDL_free(buffer);
+        return NULL;
+    }
+
+    SDL_LockMutex(traceLock);
+    buffer->next = traceBuffers;
+    traceBuffers = buffer;
+    SDL_UnlockMutex(traceLock);
+
+    threadBuffer = buffer;
+    return buffer;
+}
+
+/**
+ * @brief Record an event on the calling thread.
+ *
+ * @param name The name of the scope.
+ * @param phase The Chrome Trace Event phase, 'B' for begin or 'E' for end.
+ */
+static void RecordEvent(const char* name, const char phase)
+{
+    TraceBuffer* buffer = GetThreadBuffer();
+    if (!buffer) return;
+
+    const Uint32 head = SDL_GetAtomicU32(&buffer->head);
+    if (head - SDL_GetAtomicU32(&buffer->tail) >= TRACE_BUFFER_CAPACITY)
+    {
+        SDL_AddAtomicInt(&buffer->droppedCount, 1);
+        return;
+    }
+
+    buffer->events[head % TRACE_BUFFER_CAPACITY] = (TraceEvent){ name, SDL_GetTicksNS(), phase };
+    SDL_SetAtomicU32(&buffer->head, head + 1);
+}
+
+bool TRACE_Init(const char* path)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (SDL_strlcpy(tracePath, path, sizeof(tracePath)) >= sizeof(tracePath))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Trace file path is too long!");
+        return false;
+    }
+
+    traceLock = SDL_CreateMutex();
+    if (!traceLock) return false;
+
+    traceStream = SDL_IOFromFile(tracePath, "w");
+    if (!traceStream)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open trace file '%s': %s", tracePath, SDL_GetError());
+        return false;
+    }
+
+    // The JSON array format allows the closing bracket to be left out, so the file is valid after every flush
+    SDL_IOprintf(traceStream, "[");
+
+    traceStartTimestamp = SDL_GetTicksNS();
+    traceEnabled = true;
+    TRACE_NameThread("Main");
+
+    return true;
+}
+
+void TRACE_Begin(const char* name)
+{
+    RecordEvent(name, 'B');
+}
+
+void TRACE_End(const char* name)
+{
+    RecordEvent(name, 'E');
+}
+
+void TRACE_NameThread(const char* name)
+{
+    if (!traceEnabled) return;
+
+    TraceBuffer* buffer = GetThreadBuffer();
+    if (buffer) buffer->threadName = name;
+}
+
+bool TRACE_Flush(void)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!traceEnabled) return true;
+
+    SDL_LockMutex(traceLock);
+    int totalEvents = 0;
+    for (TraceBuffer* buffer = traceBuffers; buffer; buffer = buffer->next) totalEvents += DrainBuffer(buffer);
+    const bool success = SDL_FlushIO(traceStream);
+    SDL_UnlockMutex(traceLock);
+
+    if (!success)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write trace file '%s': %s", tracePath, SDL_GetError());
+        return false;
+    }
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Appended %d trace events to '%s'.", totalEvents, tracePath);
+    return true;
+}
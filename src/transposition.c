@@ -0,0 +1,101 @@
+#include "transposition.h"
+
+#include "metrics.h"
+
+/**
+ * @brief Pack an entry into the 64 bits stored in a slot.
+ *
+ * @param entry The entry.
+ *
+ * @return The packed entry.
+ */
+static Uint64 PackEntry(const TranspositionEntry* entry)
+{
+    Uint32 evaluation;
+    SDL_memcpy(&evaluation, &entry->evaluation, sizeof(evaluation));
+
+    return (Uint64)evaluation
+        | (Uint64)(Uint8)entry->x << 32
+        | (Uint64)(Uint8)entry->y << 40
+        | (Uint64)entry->orientation << 48
+        | (Uint64)entry->depth << 56;
+}
+
+/**
+ * @brief Unpack the 64 bits stored in a slot into an entry.
+ *
+ * @param data The packed entry.
+ * @param entry A pointer to the entry to write to.
+ */
+static void UnpackEntry(const Uint64 data, TranspositionEntry* entry)
+{
+    const Uint32 evaluation = (Uint32)data;
+    SDL_memcpy(&entry->evaluation, &evaluation, sizeof(evaluation));
+
+    entry->x = (Sint8)(Uint8)(data >> 32);
+    entry->y = (Sint8)(Uint8)(data >> 40);
+    entry->orientation = (Uint8)(data >> 48);
+    entry->depth = (Uint8)(data >> 56);
+}
+
+bool TT_Init(TranspositionTable* table, int log2Entries)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (log2Entries <= 0) log2Entries = TRANSPOSITION_DEFAULT_LOG2_ENTRIES;
+    if (log2Entries > TRANSPOSITION_MAX_LOG2_ENTRIES) log2Entries = TRANSPOSITION_MAX_LOG2_ENTRIES;
+
+    const size_t slotCount = (size_t)1 << log2Entries;
+    table->mask = slotCount - 1;
+
+    // A zeroed slot decodes to a hash of 0, which only an empty arena with no piece could have, so it reads as a miss
+    table->slots = SDL_calloc(slotCount, sizeof(TranspositionSlot));
+    if (!table->slots)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate a transposition table of %zu entries!", slotCount);
+        return false;
+    }
+
+    return true;
+}
+
+void TT_Destroy(TranspositionTable* table)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_free(table->slots);
+    table->slots = NULL;
+    table->mask = 0;
+}
+
+void TT_Clear(TranspositionTable* table)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    SDL_memset((void*)table->slots, 0, (size_t)(table->mask + 1) * sizeof(TranspositionSlot));
+}
+
+bool TT_Probe(const TranspositionTable* table, const Uint64 hash, TranspositionEntry* entry)
+{
+    METRICS_Add(METRIC_TRANSPOSITION_PROBES, 1);
+
+    const TranspositionSlot* slot = &table->slots[hash & table->mask];
+    const Uint64 data = slot->data;
+    if ((slot->check ^ data) != hash || hash == 0) return false;
+
+    METRICS_Add(METRIC_TRANSPOSITION_HITS, 1);
+    UnpackEntry(data, entry);
+    return true;
+}
+
+void TT_Store(TranspositionTable* table, const Uint64 hash, const TranspositionEntry* entry)
+{
+    TranspositionSlot* slot = &table->slots[hash & table->mask];
+
+    const Uint64 previousData = slot->data;
+    if ((slot->check ^ previousData) == hash && (Uint8)(previousData >> 56) > entry->depth) return;
+
+    const Uint64 data = PackEntry(entry);
+    slot->check = hash ^ data;
+    slot->data = data;
+}
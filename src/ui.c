@@ -0,0 +1,140 @@
+#include "ui.h"
+
+/**
+ * @brief Set which widget is hovered, updating the hover state of the widgets.
+ *
+ * @param registry A pointer to the registry.
+ * @param widget The index of the hovered widget, or UI_NO_WIDGET.
+ */
+static void SetHoveredWidget(WidgetRegistry* registry, const int widget)
+{
+    if (widget == registry->hoveredWidget) return;
+
+    if (registry->hoveredWidget != UI_NO_WIDGET) registry->widgets[registry->hoveredWidget]->isHovered = false;
+    if (widget != UI_NO_WIDGET)
+    {
+        registry->widgets[widget]->isHovered = true;
+        SDL_LogTrace(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) is hovered!", registry->widgets[widget]->text);
+    }
+
+    registry->hoveredWidget = widget;
+}
+
+void UI_Init(WidgetRegistry* registry)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    *registry = (WidgetRegistry){ 0 };
+    registry->hoveredWidget = UI_NO_WIDGET;
+    registry->pressedWidget = UI_NO_WIDGET;
+}
+
+bool UI_RegisterButton(WidgetRegistry* registry, Button* button)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Registering button (text=%s)...", button->text);
+
+    if (registry->widgetCount >= UI_MAX_WIDGETS)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Widget registry is full!");
+        return false;
+    }
+
+    registry->widgets[registry->widgetCount++] = button;
+    return true;
+}
+
+void UI_UpdateLayout(WidgetRegistry* registry, const GraphicsDataContext* graphicsDataContext)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    registry->gridSquareSize = graphicsDataContext->gridSquareSize;
+    SDL_memset(registry->cellWidgets, 0, sizeof(registry->cellWidgets));
+
+    for (int widget = 0; widget < registry->widgetCount; widget++)
+    {
+        const FGridRect gridRect = registry->widgets[widget]->gridRect;
+        registry->bounds[widget] = FGridRectToFRect(graphicsDataContext, gridRect, 0);
+
+        // Add the widget to every cell it touches. Where widgets share a cell, UI_HitTest checks the bounds of each
+        const int firstColumn = SDL_max((int)SDL_floorf(gridRect.x), 0);
+        const int firstRow = SDL_max((int)SDL_floorf(gridRect.y), 0);
+        const int lastColumn = SDL_min((int)SDL_ceilf(gridRect.x + gridRect.w), WINDOW_GRID_WIDTH);
+        const int lastRow = SDL_min((int)SDL_ceilf(gridRect.y + gridRect.h), WINDOW_GRID_HEIGHT);
+
+        for (int row = firstRow; row < lastRow; row++)
+        {
+            for (int column = firstColumn; column < lastColumn; column++) registry->cellWidgets[row][column] |= (Uint16)(1u << widget);
+        }
+    }
+
+    // The widget under the mouse may have moved
+    registry->hasPendingMotion = true;
+}
+
+int UI_HitTest(const WidgetRegistry* registry, const SDL_FPoint point)
+{
+    if (registry->gridSquareSize <= 0 || point.x < 0 || point.y < 0) return UI_NO_WIDGET;
+
+    const int column = (int)(point.x / registry->gridSquareSize);
+    const int row = (int)(point.y / registry->gridSquareSize);
+    if (column >= WINDOW_GRID_WIDTH || row >= WINDOW_GRID_HEIGHT) return UI_NO_WIDGET;
+
+    // Later widgets are drawn over earlier ones, so check from the last registered down
+    const Uint16 cellWidgets = registry->cellWidgets[row][column];
+    for (int widget = registry->widgetCount - 1; widget >= 0; widget--)
+    {
+        if ((cellWidgets & (1u << widget)) && SDL_PointInRectFloat(&point, &registry->bounds[widget])) return widget;
+    }
+
+    return UI_NO_WIDGET;
+}
+
+void UI_HandleEvent(WidgetRegistry* registry, const SDL_Event* event)
+{
+    switch (event->type)
+    {
+    case SDL_EVENT_MOUSE_MOTION:
+        registry->pendingMotion = (SDL_FPoint){ event->motion.x, event->motion.y };
+        registry->hasPendingMotion = true;
+        break;
+
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        registry->pressedWidget = UI_HitTest(registry, (SDL_FPoint){ event->button.x, event->button.y });
+        if (registry->pressedWidget != UI_NO_WIDGET)
+        {
+            registry->widgets[registry->pressedWidget]->isPressed = true;
+            SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) is pressed!", registry->widgets[registry->pressedWidget]->text);
+        }
+        break;
+
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+    {
+        if (registry->pressedWidget == UI_NO_WIDGET) break;
+
+        Button* button = registry->widgets[registry->pressedWidget];
+        button->isPressed = false;
+
+        // Only click if the mouse was released over the same widget it was pressed on
+        if (UI_HitTest(registry, (SDL_FPoint){ event->button.x, event->button.y }) == registry->pressedWidget && button->onClick)
+        {
+            SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Button (text=%s) has activated and called callback method!", button->text);
+            button->onClick(button->userData);
+        }
+        registry->pressedWidget = UI_NO_WIDGET;
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+void UI_Update(WidgetRegistry* registry)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (!registry->hasPendingMotion) return;
+
+    registry->hasPendingMotion = false;
+    SetHoveredWidget(registry, UI_HitTest(registry, registry->pendingMotion));
+}
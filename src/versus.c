@@ -0,0 +1,162 @@
+#include "versus.h"
+
+#include "bot.h"
+#include "game.h"
+#include "trace.h"
+
+/**
+ * @brief The state of a single headless worker thread.
+ */
+typedef struct VersusWorker
+{
+    SDL_Thread* thread;
+    int firstGame;
+    int gameCount;
+    Uint64 seed;
+    VersusResult result;
+    bool success;
+} VersusWorker;
+
+bool VS_Init(VersusMatch* match)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; i++)
+    {
+        if (!GAME_Init(&match->players[i])) return false;
+        match->players[i].isRunning = true;
+    }
+
+    match->players[0].opponent = &match->players[1];
+    match->players[1].opponent = &match->players[0];
+
+    return true;
+}
+
+void VS_Destroy(VersusMatch* match)
+{
+    SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; i++)
+    {
+        SDL_free(match->players[i].droppingTetromino);
+        match->players[i].droppingTetromino = NULL;
+    }
+}
+
+void VS_PlayHeadlessGame(VersusMatch* match, const Uint64 seed, VersusResult* result)
+{
+    SDL_LogVerbose(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    // Each player gets their own sequence, otherwise two identical bots would play identical games
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; i++) GAME_ResetWithSeed(&match->players[i], seed ^ ((Uint64)i << 32));
+
+    int winner = -1;
+    for (int piece = 0; piece < VERSUS_MAX_PIECES && winner < 0; piece++)
+    {
+        for (int i = 0; i < VERSUS_PLAYER_COUNT; i++)
+        {
+            GameDataContext* player = &match->players[i];
+
+            BotPlacement placement;
+            if (BOT_FindPlacement(player, &placement)) BOT_PlayPlacement(player, &placement);
+            else player->isGameOver = true;
+
+            result->pieces++;
+
+            if (player->isGameOver)
+            {
+                winner = (i + 1) % VERSUS_PLAYER_COUNT;
+                break;
+            }
+        }
+    }
+
+    result->games++;
+    if (winner < 0) result->draws++;
+    else result->wins[winner]++;
+
+    for (int i = 0; i < VERSUS_PLAYER_COUNT; i++) result->garbageSent += (Uint64)match->players[i].garbageSent;
+}
+
+/**
+ * @brief The entry point of a headless worker thread, which plays a contiguous range of games.
+ *
+ * @param data A pointer to the VersusWorker.
+ *
+ * @return Zero on success, non-zero otherwise.
+ */
+static int SDLCALL VersusWorkerThread(void* data)
+{
+    VersusWorker* worker = (VersusWorker*)data;
+    TRACE_NameThread("VersusWorker");
+
+    VersusMatch match = { 0 };
+    if (!VS_Init(&match))
+    {
+        VS_Destroy(&match);
+        return 1;
+    }
+
+    for (int game = 0; game < worker->gameCount; game++)
+    {
+        TRACE_BEGIN("VS_PlayHeadlessGame");
+        VS_PlayHeadlessGame(&match, worker->seed + (Uint64)(worker->firstGame + game), &worker->result);
+        TRACE_END("VS_PlayHeadlessGame");
+    }
+
+    VS_Destroy(&match);
+    worker->success = true;
+    return 0;
+}
+
+bool VS_RunHeadless(const int gameCount, int threadCount, const Uint64 seed, VersusResult* result)
+{
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Calling %s...", __func__);
+
+    if (threadCount <= 0) threadCount = SDL_GetNumLogicalCPUCores();
+    if (threadCount > VERSUS_MAX_THREADS) threadCount = VERSUS_MAX_THREADS;
+    if (threadCount > gameCount) threadCount = gameCount;
+    if (threadCount < 1) threadCount = 1;
+
+    SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Playing %d headless versus games on %d threads (seed=%" SDL_PRIu64 ")...", gameCount, threadCount, seed);
+
+    VersusWorker workers[VERSUS_MAX_THREADS] = { 0 };
+    const Uint64 startTicks = SDL_GetTicksNS();
+
+    int firstGame = 0;
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers[i].firstGame = firstGame;
+        workers[i].gameCount = gameCount / threadCount + ((i < gameCount % threadCount) ? 1 : 0);
+        workers[i].seed = seed;
+        firstGame += workers[i].gameCount;
+
+        workers[i].thread = SDL_CreateThread(VersusWorkerThread, "VersusWorker", &workers[i]);
+        if (!workers[i].thread) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create versus worker thread: %s", SDL_GetError());
+    }
+
+    bool success = true;
+    *result = (VersusResult){ 0 };
+    for (int i = 0; i < threadCount; i++)
+    {
+        if (!workers[i].thread)
+        {
+            success = false;
+            continue;
+        }
+
+        SDL_WaitThread(workers[i].thread, NULL);
+        success = success && workers[i].success;
+
+        result->games += workers[i].result.games;
+        result->draws += workers[i].result.draws;
+        result->pieces += workers[i].result.pieces;
+        result->garbageSent += workers[i].result.garbageSent;
+        for (int p = 0; p < VERSUS_PLAYER_COUNT; p++) result->wins[p] += workers[i].result.wins[p];
+    }
+
+    result->elapsedNS = SDL_GetTicksNS() - startTicks;
+
+    return success;
+}
@@ -0,0 +1,80 @@
+#include "zobrist.h"
+
+/**
+ * @brief Values that separate the key spaces of each kind of feature, so that no two features share a key.
+ */
+enum ZobristFeature
+{
+    ZOBRIST_FEATURE_ROW = 1,
+    ZOBRIST_FEATURE_PIECE = 2,
+    ZOBRIST_FEATURE_BAG = 3,
+};
+
+/**
+ * @brief Turn a feature into a 64-bit key, using the SplitMix64 finaliser so every input bit affects every output bit.
+ *
+ * @note See https://prng.di.unimi.it/splitmix64.c
+ *
+ * @param feature The kind of feature.
+ * @param value The value of the feature.
+ *
+ * @return The key.
+ */
+static Uint64 MixKey(const enum ZobristFeature feature, const Uint64 value)
+{
+    Uint64 key = ((Uint64)feature << 56) ^ value;
+    key += 0x9E3779B97F4A7C15ULL;
+    key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    key = (key ^ (key >> 27)) * 0x94D049BB133111EBULL;
+    return key ^ (key >> 31);
+}
+
+Uint64 ZOBRIST_RowKey(const int row, const Uint16 mask)
+{
+    if (mask == 0) return 0;
+    return MixKey(ZOBRIST_FEATURE_ROW, ((Uint64)row << 16) | mask);
+}
+
+Uint64 ZOBRIST_ArenaRowKey(const TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH], const int row)
+{
+    Uint16 mask = 0;
+    for (int col = 0; col < ARENA_WIDTH; col++)
+    {
+        if (arena[row][col] != 0) mask |= (Uint16)(1u << col);
+    }
+
+    return ZOBRIST_RowKey(row, mask);
+}
+
+Uint64 ZOBRIST_HashArena(const TetrominoIdentifier arena[ARENA_HEIGHT][ARENA_WIDTH])
+{
+    Uint64 hash = 0;
+    for (int row = 0; row < ARENA_HEIGHT; row++) hash ^= ZOBRIST_ArenaRowKey(arena, row);
+    return hash;
+}
+
+Uint64 ZOBRIST_PieceKey(const TetrominoIdentifier identifier, const enum Orientation orientation)
+{
+    return MixKey(ZOBRIST_FEATURE_PIECE, ((Uint64)identifier << 2) | ((Uint64)orientation & 3));
+}
+
+Uint64 ZOBRIST_BagKey(const TetrominoBag* bag)
+{
+    // The pieces already drawn cannot affect what comes next, so only the remaining ones (and where they are) count
+    const int position = GetTetrominoBagPosition(bag);
+    int count;
+    const TetrominoIdentifier* pieces = PeekTetrominoQueue(bag, &count);
+
+    Uint64 hash = MixKey(ZOBRIST_FEATURE_BAG, (Uint64)position);
+    for (int i = position; i < TETROMINO_COUNT; i++) hash ^= MixKey(ZOBRIST_FEATURE_BAG, ((Uint64)(i + 1) << 8) | (Uint64)pieces[i - position]);
+    return hash;
+}
+
+Uint64 ZOBRIST_HashPosition(const GameDataContext* gameDataContext)
+{
+    const DroppingTetromino* droppingTetromino = gameDataContext->droppingTetromino;
+
+    return gameDataContext->arenaHash
+        ^ ZOBRIST_PieceKey(droppingTetromino->shape->identifier, droppingTetromino->orientation)
+        ^ ZOBRIST_BagKey(&gameDataContext->tetrominoBag);
+}